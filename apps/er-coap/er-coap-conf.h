@@ -53,6 +53,31 @@
 #define COAP_MAX_OPEN_TRANSACTIONS     4
 #endif /* COAP_MAX_OPEN_TRANSACTIONS */
 
+/* Number of hash buckets used to look up open transactions by MID. */
+#ifndef COAP_TRANSACTION_HASH_SIZE
+#define COAP_TRANSACTION_HASH_SIZE     8
+#endif /* COAP_TRANSACTION_HASH_SIZE */
+
+/*
+ * Retransmissions are driven by a timer wheel with one slot per tick.
+ * The number of slots must be a power of two.
+ */
+#ifndef COAP_TIMER_WHEEL_SIZE
+#define COAP_TIMER_WHEEL_SIZE          16
+#endif /* COAP_TIMER_WHEEL_SIZE */
+
+#ifndef COAP_TIMER_WHEEL_TICK
+#define COAP_TIMER_WHEEL_TICK          (CLOCK_SECOND / 4 > 0 ? CLOCK_SECOND / 4 : 1)
+#endif /* COAP_TIMER_WHEEL_TICK */
+
+/*
+ * Number of Block2 requests kept outstanding by a windowed client request
+ * (COAP_WINDOWED_REQUEST). Each takes one open transaction.
+ */
+#ifndef COAP_BLOCK_WINDOW
+#define COAP_BLOCK_WINDOW              4
+#endif /* COAP_BLOCK_WINDOW */
+
 /* Maximum number of failed request attempts before action */
 #ifndef COAP_MAX_ATTEMPTS
 #define COAP_MAX_ATTEMPTS              4
@@ -68,6 +93,22 @@
 #define COAP_MAX_OBSERVERS    COAP_MAX_OPEN_TRANSACTIONS - 1
 #endif /* COAP_MAX_OBSERVERS */
 
+/* Number of hash buckets used to look up observers by endpoint and by URL. */
+#ifndef COAP_OBSERVER_HASH_SIZE
+#define COAP_OBSERVER_HASH_SIZE        8
+#endif /* COAP_OBSERVER_HASH_SIZE */
+
+/*
+ * Honor the pmin/pmax query parameters of an observe registration: changes
+ * within pmin seconds of the last notification are delayed, and a
+ * notification is sent at least every pmax seconds. Both are limited to
+ * half the range of clock_time_t, e.g. 255 seconds with a 16-bit clock
+ * at 128 ticks per second.
+ */
+#ifndef COAP_OBSERVE_RATE_LIMITING
+#define COAP_OBSERVE_RATE_LIMITING     1
+#endif /* COAP_OBSERVE_RATE_LIMITING */
+
 /* Interval in notifies in which NON notifies are changed to CON notifies to check client. */
 #define COAP_OBSERVE_REFRESH_INTERVAL  20
 
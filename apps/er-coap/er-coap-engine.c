@@ -208,10 +208,12 @@ coap_receive(void)
                 /* serialize response */
             }
             if(erbium_status_code == NO_ERROR) {
-              if((transaction->packet_len = coap_serialize_message(response,
-                                                                   transaction->
-                                                                   packet)) ==
-                 0) {
+              /* the payload stays where the handler put it */
+              if((transaction->packet_len =
+                    coap_serialize_message_in_place(response,
+                                                    transaction->packet,
+                                                    &transaction->
+                                                    packet_offset)) == 0) {
                 erbium_status_code = PACKET_SERIALIZATION_ERROR;
               }
             }
@@ -240,7 +242,9 @@ coap_receive(void)
                                       UIP_UDP_BUF->srcport, message->mid);
         }
 
-        if((transaction = coap_get_transaction_by_mid(message->mid))) {
+        if((transaction = coap_get_transaction(message->mid,
+                                               &UIP_IP_BUF->srcipaddr,
+                                               UIP_UDP_BUF->srcport))) {
           /* free transaction memory before callback, as it may create a new transaction */
           restful_response_handler callback = transaction->callback;
           void *callback_data = transaction->callback_data;
@@ -434,6 +438,192 @@ PT_THREAD(coap_blocking_request
   PT_END(&state->pt);
 }
 /*---------------------------------------------------------------------------*/
+static void
+coap_windowed_request_callback(void *callback_data, void *response)
+{
+  struct window_slot_t *slot = (struct window_slot_t *)callback_data;
+  struct window_request_state_t *state = slot->state;
+  coap_packet_t *const res = (coap_packet_t *)response;
+  uint32_t res_block = 0;
+  uint8_t more = 0;
+  uint16_t size = 0;
+
+  slot->transaction = NULL;
+  process_poll(state->process);
+
+  /* requests past the final block are expected to fail */
+  if((state->last_known && slot->block_num > state->last_block)
+     || (state->end_known && slot->block_num >= state->end_block)) {
+    return;
+  }
+
+  if(res == NULL) {
+    PRINTF("Server not responding to #%lu\n", slot->block_num);
+    if(++state->block_errors >= COAP_MAX_ATTEMPTS) {
+      state->failed = 1;
+    } else {
+      slot->retry = 1;
+    }
+    return;
+  }
+
+  if(res->code >= BAD_REQUEST_4_00 && slot->block_num > 0) {
+    /*
+     * The window may request blocks past the end of the representation
+     * before the final block has arrived. The server refuses those
+     * (4.02, 4.08, ...), so the representation ends before this block.
+     */
+    PRINTF("No block #%lu (%u.%02u)\n", slot->block_num,
+           res->code >> 5, res->code & 0x1f);
+    if(!state->end_known || slot->block_num < state->end_block) {
+      state->end_known = 1;
+      state->end_block = slot->block_num;
+    }
+    return;
+  }
+
+  /* a response without Block2 carries the whole representation */
+  coap_get_header_block2(res, &res_block, &more, &size, NULL);
+
+  if(res->code >= BAD_REQUEST_4_00) {
+    /* an error for the first block is the response to the request */
+    more = 0;
+    res_block = 0;
+  } else if(res_block != slot->block_num) {
+    PRINTF("WRONG BLOCK %lu/%lu\n", res_block, slot->block_num);
+    if(++state->block_errors >= COAP_MAX_ATTEMPTS) {
+      state->failed = 1;
+    } else {
+      slot->retry = 1;
+    }
+    return;
+  }
+
+  PRINTF("Received #%lu%s (%u bytes)\n", res_block, more ? "+" : "",
+         res->payload_len);
+
+  if(slot->block_num == 0 && size > 0 && size < state->block_size) {
+    /* server negotiated a smaller block size */
+    state->block_size = size;
+  }
+  if(!more) {
+    state->last_known = 1;
+    state->last_block = res_block;
+  }
+  ++(state->received);
+  state->request_callback(response);
+}
+/*---------------------------------------------------------------------------*/
+static int
+coap_windowed_send(struct window_slot_t *slot, uip_ipaddr_t *remote_ipaddr,
+                   uint16_t remote_port, coap_packet_t *request)
+{
+  request->mid = coap_get_mid();
+  if((slot->transaction = coap_new_transaction(request->mid, remote_ipaddr,
+                                               remote_port)) == NULL) {
+    return 0;
+  }
+  slot->transaction->callback = coap_windowed_request_callback;
+  slot->transaction->callback_data = slot;
+  slot->retry = 0;
+
+  coap_set_header_block2(request, slot->block_num, 0,
+                         slot->state->block_size);
+  slot->transaction->packet_len = coap_serialize_message(request,
+                                                         slot->transaction->
+                                                         packet);
+  coap_send_transaction(slot->transaction);
+  PRINTF("Requested #%lu (MID %u)\n", slot->block_num, request->mid);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_windowed_cancel(struct window_request_state_t *state)
+{
+  int i;
+
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    if(state->slots[i].transaction != NULL) {
+      coap_clear_transaction(state->slots[i].transaction);
+      state->slots[i].transaction = NULL;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PT_THREAD(coap_windowed_request
+            (struct window_request_state_t *state, process_event_t ev,
+            uip_ipaddr_t *remote_ipaddr, uint16_t remote_port,
+            coap_packet_t *request,
+            blocking_response_handler request_callback))
+{
+  static int i;
+  static int outstanding;
+
+  PT_BEGIN(&state->pt);
+
+  memset(state->slots, 0, sizeof(state->slots));
+  for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+    state->slots[i].state = state;
+  }
+  state->process = PROCESS_CURRENT();
+  state->request_callback = request_callback;
+  state->next_block = 0;
+  state->last_block = 0;
+  state->received = 0;
+  state->block_size = REST_MAX_CHUNK_SIZE;
+  state->last_known = 0;
+  state->end_block = 0;
+  state->end_known = 0;
+  state->block_errors = 0;
+  state->failed = 0;
+
+  while(!state->failed
+        && !(state->last_known && state->received > state->last_block)) {
+    /* refill the window; it opens once the first block has arrived */
+    outstanding = 0;
+    for(i = 0; i < COAP_BLOCK_WINDOW; i++) {
+      struct window_slot_t *slot = &state->slots[i];
+
+      if(slot->transaction == NULL) {
+        if(slot->retry) {
+          coap_windowed_send(slot, remote_ipaddr, remote_port, request);
+        } else if(state->next_block == 0
+                  || (state->received > 0
+                      && (!state->last_known
+                          || state->next_block <= state->last_block)
+                      && (!state->end_known
+                          || state->next_block < state->end_block))) {
+          slot->block_num = state->next_block;
+          if(coap_windowed_send(slot, remote_ipaddr, remote_port, request)) {
+            ++(state->next_block);
+          }
+        }
+      }
+      if(slot->transaction != NULL) {
+        ++outstanding;
+      }
+    }
+
+    if(outstanding == 0) {
+      /* all blocks before the end have been answered, none was final */
+      PRINTF("Could not complete the transfer\n");
+      state->failed = 1;
+      break;
+    }
+
+    PT_YIELD_UNTIL(&state->pt, ev == PROCESS_EVENT_POLL);
+  }
+
+  /* drop requests for blocks past the end or left after a failure */
+  coap_windowed_cancel(state);
+
+  if(state->failed) {
+    state->request_callback(NULL);
+  }
+
+  PT_END(&state->pt);
+}
+/*---------------------------------------------------------------------------*/
 /*- REST Engine Interface ---------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 const struct rest_implementation coap_rest_implementation = {
@@ -51,6 +51,8 @@
 typedef coap_packet_t rest_request_t;
 typedef coap_packet_t rest_response_t;
 
+PROCESS_NAME(coap_engine);
+
 void coap_init_engine(void);
 
 /*---------------------------------------------------------------------------*/
@@ -82,5 +84,62 @@ PT_THREAD(coap_blocking_request
              ); \
   }
 /*---------------------------------------------------------------------------*/
+/*
+ * Windowed (pipelined) Block2 retrieval: up to COAP_BLOCK_WINDOW block
+ * requests are outstanding at a time. The chunk handler is called from the
+ * CoAP engine as soon as a block arrives, so blocks may be delivered out of
+ * order; use coap_get_header_block2() on the response to get its offset.
+ *
+ * Error responses to blocks past the end of the representation mark its
+ * end and are not passed on. An error response to the first block is
+ * passed to the chunk handler like any other response.
+ *
+ * If the transfer fails, the chunk handler is called once more with NULL
+ * before the request returns, and the failed field of the state is set.
+ * A transfer fails after COAP_MAX_ATTEMPTS timed-out or wrong blocks in
+ * total, or when the server refuses a block before it has sent the final
+ * one.
+ */
+struct window_request_state_t;
+
+struct window_slot_t {
+  struct window_request_state_t *state;
+  coap_transaction_t *transaction;
+  uint32_t block_num;
+  uint8_t retry;
+};
+
+struct window_request_state_t {
+  struct pt pt;
+  struct process *process;
+  blocking_response_handler request_callback;
+  struct window_slot_t slots[COAP_BLOCK_WINDOW];
+  uint32_t next_block;
+  uint32_t last_block;
+  uint32_t received;
+  uint16_t block_size;
+  uint32_t end_block;
+  uint8_t last_known;
+  uint8_t end_known;
+  uint8_t block_errors;
+  uint8_t failed;
+};
+
+PT_THREAD(coap_windowed_request
+            (struct window_request_state_t *state, process_event_t ev,
+            uip_ipaddr_t *remote_ipaddr, uint16_t remote_port,
+            coap_packet_t *request,
+            blocking_response_handler request_callback));
+
+#define COAP_WINDOWED_REQUEST(server_addr, server_port, request, chunk_handler) \
+  { \
+    static struct window_request_state_t window_state; \
+    PT_SPAWN(process_pt, &window_state.pt, \
+             coap_windowed_request(&window_state, ev, \
+                                   server_addr, server_port, \
+                                   request, chunk_handler) \
+             ); \
+  }
+/*---------------------------------------------------------------------------*/
 
 #endif /* ER_COAP_ENGINE_H_ */
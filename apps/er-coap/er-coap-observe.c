@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "er-coap-observe.h"
+#include "er-coap-engine.h"
 
 #define DEBUG 0
 #if DEBUG
@@ -55,6 +56,54 @@
 /*---------------------------------------------------------------------------*/
 MEMB(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 LIST(observers_list);
+static coap_observer_t *observers_tail;
+
+/*
+ * Observers hashed by endpoint and by URL, chained through endpoint_next
+ * and url_next. The list and the URL chains are linked both ways, as all
+ * observers of a resource share a URL bucket, so that removing an observer
+ * does not scan them.
+ */
+static coap_observer_t *endpoint_hash[COAP_OBSERVER_HASH_SIZE];
+static coap_observer_t *url_hash[COAP_OBSERVER_HASH_SIZE];
+
+/* representation shared by all observers notified for the same change */
+static uint8_t notification_buffer[REST_MAX_CHUNK_SIZE];
+
+#if COAP_OBSERVE_RATE_LIMITING
+/* The longest pmin or pmax, in seconds, that a difference of two
+   clock_time() values can hold */
+#define PERIOD_MAX_TICKS ((clock_time_t)~(clock_time_t)0 / 2)
+#define PERIOD_MAX (PERIOD_MAX_TICKS / CLOCK_SECOND < 0xffff ? \
+                    PERIOD_MAX_TICKS / CLOCK_SECOND : 0xffff)
+
+static struct ctimer rate_timer;
+static void rate_timer_start(void);
+#endif /* COAP_OBSERVE_RATE_LIMITING */
+/*---------------------------------------------------------------------------*/
+static coap_observer_t **
+endpoint_bucket(const uip_ipaddr_t *addr, uint16_t port)
+{
+  uint16_t h = port;
+  int i;
+
+  /* the interface identifier tells the peers of a prefix apart */
+  for(i = 8; i < 16; i++) {
+    h = (h << 5) + h + addr->u8[i];
+  }
+  return &endpoint_hash[h % COAP_OBSERVER_HASH_SIZE];
+}
+/*---------------------------------------------------------------------------*/
+static coap_observer_t **
+url_bucket(const char *url)
+{
+  uint16_t h = 5381;
+
+  while(*url) {
+    h = (h << 5) + h + (uint8_t)*url++;
+  }
+  return &url_hash[h % COAP_OBSERVER_HASH_SIZE];
+}
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -66,6 +115,7 @@ add_observer(uip_ipaddr_t *addr, uint16_t port, const uint8_t *token,
   coap_remove_observer_by_uri(addr, port, uri);
 
   coap_observer_t *o = memb_alloc(&observers_memb);
+  coap_observer_t **bucket;
 
   if(o) {
     int max = sizeof(o->url) - 1;
@@ -79,26 +129,88 @@ add_observer(uip_ipaddr_t *addr, uint16_t port, const uint8_t *token,
     o->token_len = token_len;
     memcpy(o->token, token, token_len);
     o->last_mid = 0;
+    o->has_accept = 0;
+    o->due = 0;
+#if COAP_OBSERVE_RATE_LIMITING
+    o->resource = NULL;
+    o->last_notify = clock_time();
+    o->pmin = 0;
+    o->pmax = 0;
+    o->pending = 0;
+    o->hold = 0;
+#endif /* COAP_OBSERVE_RATE_LIMITING */
 
     PRINTF("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
            list_length(observers_list) + 1, COAP_MAX_OBSERVERS,
            o->url, o->token[0], o->token[1]);
-    list_add(observers_list, o);
+    /* append, without the scan of list_add() */
+    o->next = NULL;
+    o->prev = observers_tail;
+    if(observers_tail != NULL) {
+      observers_tail->next = o;
+    } else {
+      *observers_list = o;
+    }
+    observers_tail = o;
+
+    bucket = endpoint_bucket(addr, port);
+    o->endpoint_next = *bucket;
+    *bucket = o;
+    bucket = url_bucket(o->url);
+    o->url_prev = NULL;
+    o->url_next = *bucket;
+    if(*bucket != NULL) {
+      (*bucket)->url_prev = o;
+    }
+    *bucket = o;
   }
 
   return o;
 }
 /*---------------------------------------------------------------------------*/
+list_t
+coap_get_observers(void)
+{
+  return observers_list;
+}
+/*---------------------------------------------------------------------------*/
 /*- Removal -----------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 void
 coap_remove_observer(coap_observer_t *o)
 {
+  coap_observer_t **p;
+
   PRINTF("Removing observer for /%s [0x%02X%02X]\n", o->url, o->token[0],
          o->token[1]);
 
+  for(p = endpoint_bucket(&o->addr, o->port); *p != NULL;
+      p = &(*p)->endpoint_next) {
+    if(*p == o) {
+      *p = o->endpoint_next;
+      break;
+    }
+  }
+  if(o->url_prev != NULL) {
+    o->url_prev->url_next = o->url_next;
+  } else {
+    *url_bucket(o->url) = o->url_next;
+  }
+  if(o->url_next != NULL) {
+    o->url_next->url_prev = o->url_prev;
+  }
+  if(o->prev != NULL) {
+    o->prev->next = o->next;
+  } else {
+    *observers_list = o->next;
+  }
+  if(o->next != NULL) {
+    o->next->prev = o->prev;
+  } else {
+    observers_tail = o->prev;
+  }
+
   memb_free(&observers_memb, o);
-  list_remove(observers_list, o);
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -106,9 +218,10 @@ coap_remove_observer_by_client(uip_ipaddr_t *addr, uint16_t port)
 {
   int removed = 0;
   coap_observer_t *obs = NULL;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  for(obs = *endpoint_bucket(addr, port); obs; obs = next) {
+    next = obs->endpoint_next;
     PRINTF("Remove check client ");
     PRINT6ADDR(addr);
     PRINTF(":%u\n", port);
@@ -126,9 +239,10 @@ coap_remove_observer_by_token(uip_ipaddr_t *addr, uint16_t port,
 {
   int removed = 0;
   coap_observer_t *obs = NULL;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  for(obs = *endpoint_bucket(addr, port); obs; obs = next) {
+    next = obs->endpoint_next;
     PRINTF("Remove check Token 0x%02X%02X\n", token[0], token[1]);
     if(uip_ipaddr_cmp(&obs->addr, addr) && obs->port == port
        && obs->token_len == token_len
@@ -146,9 +260,13 @@ coap_remove_observer_by_uri(uip_ipaddr_t *addr, uint16_t port,
 {
   int removed = 0;
   coap_observer_t *obs = NULL;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  /* without an endpoint, any observer can match */
+  for(obs = addr != NULL ? *endpoint_bucket(addr, port)
+        : (coap_observer_t *)list_head(observers_list);
+      obs; obs = next) {
+    next = addr != NULL ? obs->endpoint_next : obs->next;
     PRINTF("Remove check URL %p\n", uri);
     if((addr == NULL
         || (uip_ipaddr_cmp(&obs->addr, addr) && obs->port == port))
@@ -165,9 +283,10 @@ coap_remove_observer_by_mid(uip_ipaddr_t *addr, uint16_t port, uint16_t mid)
 {
   int removed = 0;
   coap_observer_t *obs = NULL;
+  coap_observer_t *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  for(obs = *endpoint_bucket(addr, port); obs; obs = next) {
+    next = obs->endpoint_next;
     PRINTF("Remove check MID %u\n", mid);
     if(uip_ipaddr_cmp(&obs->addr, addr) && obs->port == port
        && obs->last_mid == mid) {
@@ -180,11 +299,202 @@ coap_remove_observer_by_mid(uip_ipaddr_t *addr, uint16_t port, uint16_t mid)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+static void
+send_notification(coap_observer_t *obs, coap_packet_t *notification)
+{
+  coap_transaction_t *transaction = NULL;
+
+  /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
+
+  if((transaction = coap_new_transaction(coap_get_mid(), &obs->addr, obs->port))) {
+    if(obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0) {
+      PRINTF("           Force Confirmable for\n");
+      notification->type = COAP_TYPE_CON;
+    } else {
+      notification->type = COAP_TYPE_NON;
+    }
+
+    PRINTF("           Observer ");
+    PRINT6ADDR(&obs->addr);
+    PRINTF(":%u\n", obs->port);
+
+    /* update last MID for RST matching */
+    obs->last_mid = transaction->mid;
+
+    /* prepare response */
+    notification->mid = transaction->mid;
+
+    if(notification->code < BAD_REQUEST_4_00) {
+      coap_set_header_observe(notification, (obs->obs_counter)++);
+    }
+    coap_set_token(notification, obs->token, obs->token_len);
+
+    transaction->packet_len =
+      coap_serialize_message(notification, transaction->packet);
+
+    coap_send_transaction(transaction);
+
+#if COAP_OBSERVE_RATE_LIMITING
+    obs->last_notify = clock_time();
+    obs->pending = 0;
+    if(obs->pmin > 0) {
+      /* the rate timer clears hold once pmin has passed */
+      obs->hold = 1;
+      rate_timer_start();
+    }
+#endif /* COAP_OBSERVE_RATE_LIMITING */
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Observers with the same options get the same representation */
+static int
+same_options(const coap_observer_t *a, const coap_observer_t *b)
+{
+  return a->has_accept == b->has_accept
+         && (!a->has_accept || a->accept == b->accept);
+}
+/*---------------------------------------------------------------------------*/
+/* Sets up the "fake" GET request with the options of the observer */
+static void
+init_request(coap_packet_t *request, const char *url,
+             const coap_observer_t *obs)
+{
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, url);
+  if(obs->has_accept) {
+    coap_set_header_accept(request, obs->accept);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends the notification for a change to a matching observer. The
+ * representation is generated on first use only and then serialized into
+ * the transaction of every further observer with the same options.
+ */
+static void
+notify_observer(resource_t *resource, coap_packet_t *request,
+                coap_packet_t *notification, uint8_t *generated,
+                coap_observer_t *obs)
+{
+#if COAP_OBSERVE_RATE_LIMITING
+  if(obs->hold) {
+    PRINTF("           Deferring notification (pmin %u)\n", obs->pmin);
+    obs->pending = 1;
+    rate_timer_start();
+    return;
+  }
+#endif /* COAP_OBSERVE_RATE_LIMITING */
+
+  if(!*generated) {
+    resource->get_handler(request, notification, notification_buffer,
+                          REST_MAX_CHUNK_SIZE, NULL);
+    *generated = 1;
+  }
+  send_notification(obs, notification);
+}
+/*---------------------------------------------------------------------------*/
+#if COAP_OBSERVE_RATE_LIMITING
+static int
+rate_due(coap_observer_t *obs)
+{
+  clock_time_t elapsed = clock_time() - obs->last_notify;
+
+  return obs->resource != NULL
+    && ((obs->pending && !obs->hold)
+        || (obs->pmax > 0
+            && elapsed >= (clock_time_t)obs->pmax * CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+static void
+rate_check(void *ptr)
+{
+  coap_packet_t notification[1];
+  coap_packet_t request[1];
+  coap_observer_t *obs = NULL;
+  coap_observer_t *o;
+  uint8_t active = 0;
+
+  for(obs = (coap_observer_t *)list_head(observers_list); obs;
+      obs = obs->next) {
+    if(obs->hold && (clock_time_t)(clock_time() - obs->last_notify)
+       >= (clock_time_t)obs->pmin * CLOCK_SECOND) {
+      obs->hold = 0;
+    }
+  }
+
+  for(obs = (coap_observer_t *)list_head(observers_list); obs;
+      obs = obs->next) {
+    if(!rate_due(obs)) {
+      continue;
+    }
+    /* Generate the representation once, for this observer and all
+       further observers of the same URL and options that are due. Once
+       notified, an observer is no longer due. */
+    PRINTF("Observe: Rate-limited notification for %s\n", obs->url);
+    coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
+    init_request(request, obs->url, obs);
+    obs->resource->get_handler(request, notification, notification_buffer,
+                               REST_MAX_CHUNK_SIZE, NULL);
+    for(o = obs; o; o = o->next) {
+      if(o->resource == obs->resource && strcmp(o->url, obs->url) == 0
+         && same_options(o, obs) && rate_due(o)) {
+        send_notification(o, notification);
+      }
+    }
+  }
+
+  for(obs = (coap_observer_t *)list_head(observers_list); obs;
+      obs = obs->next) {
+    if(obs->hold || obs->pending || obs->pmax > 0) {
+      active = 1;
+    }
+  }
+  /* a notification sent above may already have restarted the timer */
+  if(active && ctimer_expired(&rate_timer)) {
+    ctimer_reset(&rate_timer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+rate_timer_start(void)
+{
+  if(ctimer_expired(&rate_timer)) {
+    /* bind the timer to the engine, the caller might be a transient process */
+    PROCESS_CONTEXT_BEGIN(&coap_engine);
+    ctimer_set(&rate_timer, CLOCK_SECOND, rate_check, NULL);
+    PROCESS_CONTEXT_END(&coap_engine);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_query_seconds(coap_packet_t *request, const char *name)
+{
+  const char *value;
+  int len = coap_get_query_variable(request, name, &value);
+  unsigned long seconds = 0;
+
+  while(len-- > 0 && *value >= '0' && *value <= '9') {
+    seconds = seconds * 10 + (*value++ - '0');
+    if(seconds > PERIOD_MAX) {
+      return PERIOD_MAX;
+    }
+  }
+  return seconds;
+}
+#endif /* COAP_OBSERVE_RATE_LIMITING */
+/*---------------------------------------------------------------------------*/
 void
 coap_notify_observers(resource_t *resource)
 {
   coap_notify_observers_sub(resource, NULL);
 }
+/*---------------------------------------------------------------------------*/
+static coap_observer_t *
+next_candidate(coap_observer_t *obs, int exact)
+{
+  return exact ? obs->url_next : obs->next;
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_notify_observers_sub(resource_t *resource, const char *subpath)
 {
@@ -192,8 +502,12 @@ coap_notify_observers_sub(resource_t *resource, const char *subpath)
   coap_packet_t notification[1]; /* this way the packet can be treated as pointer as usual */
   coap_packet_t request[1]; /* this way the packet can be treated as pointer as usual */
   coap_observer_t *obs = NULL;
+  coap_observer_t *o;
+  coap_observer_t *first;
   int url_len, obs_url_len;
   char url[COAP_OBSERVER_URL_LEN];
+  uint8_t generated;
+  int exact;
 
   url_len = strlen(resource->url);
   strncpy(url, resource->url, COAP_OBSERVER_URL_LEN - 1);
@@ -205,57 +519,37 @@ coap_notify_observers_sub(resource_t *resource, const char *subpath)
   /* url now contains the notify URL that needs to match the observer */
   PRINTF("Observe: Notification from %s\n", url);
 
-  coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
-  /* create a "fake" request for the URI */
-  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
-  coap_set_header_uri_path(request, url);
+  /* Without sub-resources only exact matches count, and the URL hash
+     bucket holds all candidates */
+  exact = !(resource->flags & HAS_SUB_RESOURCES);
+  first = exact ? *url_bucket(url) : list_head(observers_list);
 
-  /* iterate over observers */
   url_len = strlen(url);
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  for(obs = first; obs; obs = next_candidate(obs, exact)) {
     obs_url_len = strlen(obs->url);
 
     /* Do a match based on the parent/sub-resource match so that it is
        possible to do parent-node observe */
-    if((obs_url_len == url_len
-        || (obs_url_len > url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && obs->url[url_len] == '/'))
-       && strncmp(url, obs->url, url_len) == 0) {
-      coap_transaction_t *transaction = NULL;
-
-      /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
-
-      if((transaction = coap_new_transaction(coap_get_mid(), &obs->addr, obs->port))) {
-        if(obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0) {
-          PRINTF("           Force Confirmable for\n");
-          notification->type = COAP_TYPE_CON;
-        }
-
-        PRINTF("           Observer ");
-        PRINT6ADDR(&obs->addr);
-        PRINTF(":%u\n", obs->port);
-
-        /* update last MID for RST matching */
-        obs->last_mid = transaction->mid;
-
-        /* prepare response */
-        notification->mid = transaction->mid;
-
-        resource->get_handler(request, notification,
-                              transaction->packet + COAP_MAX_HEADER_SIZE,
-                              REST_MAX_CHUNK_SIZE, NULL);
-
-        if(notification->code < BAD_REQUEST_4_00) {
-          coap_set_header_observe(notification, (obs->obs_counter)++);
-        }
-        coap_set_token(notification, obs->token, obs->token_len);
-
-        transaction->packet_len =
-          coap_serialize_message(notification, transaction->packet);
+    obs->due = (obs_url_len == url_len
+                || (!exact && obs_url_len > url_len
+                    && obs->url[url_len] == '/'))
+      && strncmp(url, obs->url, url_len) == 0;
+  }
 
-        coap_send_transaction(transaction);
+  /* Generate the representation once for each set of options, and send
+     it to every observer with these options */
+  for(obs = first; obs; obs = next_candidate(obs, exact)) {
+    if(!obs->due) {
+      continue;
+    }
+    coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
+    /* create a "fake" request for the URI */
+    init_request(request, url, obs);
+    generated = 0;
+    for(o = obs; o; o = next_candidate(o, exact)) {
+      if(o->due && same_options(o, obs)) {
+        o->due = 0;
+        notify_observer(resource, request, notification, &generated, o);
       }
     }
   }
@@ -276,6 +570,18 @@ coap_observe_handler(resource_t *resource, void *request, void *response)
                            coap_req->uri_path, coap_req->uri_path_len);
        if(obs) {
           coap_set_header_observe(coap_res, (obs->obs_counter)++);
+          obs->has_accept = IS_OPTION(coap_req, COAP_OPTION_ACCEPT) != 0;
+          obs->accept = coap_req->accept;
+#if COAP_OBSERVE_RATE_LIMITING
+          obs->resource = resource;
+          obs->pmin = get_query_seconds(coap_req, "pmin");
+          obs->pmax = get_query_seconds(coap_req, "pmax");
+          /* the response to the registration counts as a notification */
+          obs->hold = obs->pmin > 0;
+          if(obs->pmin > 0 || obs->pmax > 0) {
+            rate_timer_start();
+          }
+#endif /* COAP_OBSERVE_RATE_LIMITING */
           /*
            * Following payload is for demonstration purposes only.
            * A subscription should return the same representation as a normal GET.
@@ -55,6 +55,10 @@ typedef struct coap_observable {
 
 typedef struct coap_observer {
   struct coap_observer *next;   /* for LIST */
+  struct coap_observer *prev;   /* previous in the list, NULL if first */
+  struct coap_observer *endpoint_next; /* next in the same endpoint hash bucket */
+  struct coap_observer *url_next;   /* next in the same URL hash bucket */
+  struct coap_observer *url_prev;   /* previous in the bucket, NULL if first */
 
   char url[COAP_OBSERVER_URL_LEN];
   uip_ipaddr_t addr;
@@ -62,11 +66,23 @@ typedef struct coap_observer {
   uint8_t token_len;
   uint8_t token[COAP_TOKEN_LEN];
   uint16_t last_mid;
+  uint16_t accept;              /* Accept of the registration, if any */
+  uint8_t has_accept;
+  uint8_t due;                  /* to be notified of the current change */
 
   int32_t obs_counter;
 
   struct etimer retrans_timer;
   uint8_t retrans_counter;
+
+#if COAP_OBSERVE_RATE_LIMITING
+  resource_t *resource;
+  clock_time_t last_notify;
+  uint16_t pmin;                /* seconds, 0 if not requested */
+  uint16_t pmax;                /* seconds, 0 if not requested */
+  uint8_t pending;              /* change deferred due to pmin */
+  uint8_t hold;                 /* pmin has not passed since last_notify */
+#endif /* COAP_OBSERVE_RATE_LIMITING */
 } coap_observer_t;
 
 list_t coap_get_observers(void);
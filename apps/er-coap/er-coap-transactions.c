@@ -55,10 +55,97 @@
 
 /*---------------------------------------------------------------------------*/
 MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
-LIST(transactions_list);
 
 static struct process *transaction_handler_process = NULL;
 
+/* open transactions hashed by MID, chained through hash_next */
+static coap_transaction_t *transactions_hash[COAP_TRANSACTION_HASH_SIZE];
+
+/*
+ * Timer wheel for retransmissions: a transaction expiring in tick n is kept
+ * in slot n % COAP_TIMER_WHEEL_SIZE, chained both ways through wheel_next
+ * and wheel_prev, so that an ACK unlinks it without a scan. A single
+ * etimer wakes up the handler process at the next occupied slot, so the cost
+ * of a timer event no longer depends on the number of open transactions.
+ */
+static coap_transaction_t *wheel[COAP_TIMER_WHEEL_SIZE];
+static struct etimer wheel_timer;
+static clock_time_t wheel_tick;         /* last processed tick */
+static uint16_t wheel_count;
+
+#define MID_HASH(mid)   ((mid) % COAP_TRANSACTION_HASH_SIZE)
+#define TICK_SLOT(tick) ((tick) & (COAP_TIMER_WHEEL_SIZE - 1))
+
+#if (COAP_TIMER_WHEEL_SIZE & (COAP_TIMER_WHEEL_SIZE - 1)) != 0
+#error "COAP_TIMER_WHEEL_SIZE must be a power of two"
+#endif
+
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+expiration_tick(coap_transaction_t *t)
+{
+  clock_time_t expiration = t->retrans_timer.start + t->retrans_timer.interval;
+
+  /* round up so that a transaction is always expired when its slot is processed */
+  return (expiration + COAP_TIMER_WHEEL_TICK - 1) / COAP_TIMER_WHEEL_TICK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_schedule(void)
+{
+  clock_time_t now = clock_time();
+  clock_time_t now_tick = now / COAP_TIMER_WHEEL_TICK;
+  clock_time_t tick;
+
+  if(wheel_count > 0) {
+    for(tick = now_tick + 1; tick != now_tick + 1 + COAP_TIMER_WHEEL_SIZE;
+        tick++) {
+      if(wheel[TICK_SLOT(tick)] != NULL) {
+        PROCESS_CONTEXT_BEGIN(transaction_handler_process);
+        etimer_set(&wheel_timer, tick * COAP_TIMER_WHEEL_TICK - now);
+        PROCESS_CONTEXT_END(transaction_handler_process);
+        return;
+      }
+    }
+  }
+  etimer_stop(&wheel_timer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_insert(coap_transaction_t *t)
+{
+  coap_transaction_t **slot = &wheel[TICK_SLOT(expiration_tick(t))];
+
+  if(wheel_count == 0) {
+    wheel_tick = clock_time() / COAP_TIMER_WHEEL_TICK;
+  }
+  t->wheel_prev = NULL;
+  t->wheel_next = *slot;
+  if(*slot != NULL) {
+    (*slot)->wheel_prev = t;
+  }
+  *slot = t;
+  t->scheduled = 1;
+  wheel_count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(coap_transaction_t *t)
+{
+  if(!t->scheduled) {
+    return;
+  }
+  if(t->wheel_prev != NULL) {
+    t->wheel_prev->wheel_next = t->wheel_next;
+  } else {
+    wheel[TICK_SLOT(expiration_tick(t))] = t->wheel_next;
+  }
+  if(t->wheel_next != NULL) {
+    t->wheel_next->wheel_prev = t->wheel_prev;
+  }
+  t->scheduled = 0;
+  wheel_count--;
+}
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -75,12 +162,15 @@ coap_new_transaction(uint16_t mid, uip_ipaddr_t *addr, uint16_t port)
   if(t) {
     t->mid = mid;
     t->retrans_counter = 0;
+    t->scheduled = 0;
+    t->packet_offset = 0;
 
     /* save client address */
     uip_ipaddr_copy(&t->addr, addr);
     t->port = port;
 
-    list_add(transactions_list, t); /* list itself makes sure same element is not added twice */
+    t->hash_next = transactions_hash[MID_HASH(mid)];
+    transactions_hash[MID_HASH(mid)] = t;
   }
 
   return t;
@@ -91,31 +181,33 @@ coap_send_transaction(coap_transaction_t *t)
 {
   PRINTF("Sending transaction %u\n", t->mid);
 
-  coap_send_message(&t->addr, t->port, t->packet, t->packet_len);
+  coap_send_message(&t->addr, t->port, t->packet + t->packet_offset,
+                    t->packet_len);
 
   if(COAP_TYPE_CON ==
-     ((COAP_HEADER_TYPE_MASK & t->packet[0]) >> COAP_HEADER_TYPE_POSITION)) {
+     ((COAP_HEADER_TYPE_MASK & t->packet[t->packet_offset])
+      >> COAP_HEADER_TYPE_POSITION)) {
     if(t->retrans_counter < COAP_MAX_RETRANSMIT) {
       /* not timed out yet */
       PRINTF("Keeping transaction %u\n", t->mid);
 
+      wheel_remove(t);
       if(t->retrans_counter == 0) {
-        t->retrans_timer.timer.interval =
-          COAP_RESPONSE_TIMEOUT_TICKS + (random_rand()
-                                         %
-                                         (clock_time_t)
-                                         COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+        timer_set(&t->retrans_timer,
+                  COAP_RESPONSE_TIMEOUT_TICKS + (random_rand()
+                                                 %
+                                                 (clock_time_t)
+                                                 COAP_RESPONSE_TIMEOUT_BACKOFF_MASK));
         PRINTF("Initial interval %f\n",
-               (float)t->retrans_timer.timer.interval / CLOCK_SECOND);
+               (float)t->retrans_timer.interval / CLOCK_SECOND);
       } else {
-        t->retrans_timer.timer.interval <<= 1;  /* double */
+        t->retrans_timer.interval <<= 1;  /* double */
+        timer_restart(&t->retrans_timer);
         PRINTF("Doubled (%u) interval %f\n", t->retrans_counter,
-               (float)t->retrans_timer.timer.interval / CLOCK_SECOND);
+               (float)t->retrans_timer.interval / CLOCK_SECOND);
       }
-
-      PROCESS_CONTEXT_BEGIN(transaction_handler_process);
-      etimer_restart(&t->retrans_timer);        /* interval updated above */
-      PROCESS_CONTEXT_END(transaction_handler_process);
+      wheel_insert(t);
+      wheel_schedule();
 
       t = NULL;
     } else {
@@ -141,11 +233,19 @@ coap_send_transaction(coap_transaction_t *t)
 void
 coap_clear_transaction(coap_transaction_t *t)
 {
+  coap_transaction_t **p;
+
   if(t) {
     PRINTF("Freeing transaction %u: %p\n", t->mid, t);
 
-    etimer_stop(&t->retrans_timer);
-    list_remove(transactions_list, t);
+    wheel_remove(t);
+    for(p = &transactions_hash[MID_HASH(t->mid)]; *p != NULL;
+        p = &(*p)->hash_next) {
+      if(*p == t) {
+        *p = t->hash_next;
+        break;
+      }
+    }
     memb_free(&transactions_memb, t);
   }
 }
@@ -154,7 +254,7 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
   coap_transaction_t *t = NULL;
 
-  for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
+  for(t = transactions_hash[MID_HASH(mid)]; t; t = t->hash_next) {
     if(t->mid == mid) {
       PRINTF("Found transaction for MID %u: %p\n", t->mid, t);
       return t;
@@ -163,17 +263,54 @@ coap_get_transaction_by_mid(uint16_t mid)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+coap_transaction_t *
+coap_get_transaction(uint16_t mid, uip_ipaddr_t *addr, uint16_t port)
+{
+  coap_transaction_t *t = NULL;
+
+  for(t = transactions_hash[MID_HASH(mid)]; t; t = t->hash_next) {
+    if(t->mid == mid && t->port == port && uip_ipaddr_cmp(&t->addr, addr)) {
+      PRINTF("Found transaction for MID %u: %p\n", t->mid, t);
+      return t;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_check_transactions()
 {
   coap_transaction_t *t = NULL;
+  coap_transaction_t **p;
+  clock_time_t now_tick = clock_time() / COAP_TIMER_WHEEL_TICK;
+  int slots = 0;
 
-  for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
-    if(etimer_expired(&t->retrans_timer)) {
-      ++(t->retrans_counter);
-      PRINTF("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
-      coap_send_transaction(t);
-    }
+  /* process each slot passed since the last run, at most one revolution */
+  while(wheel_count > 0 && wheel_tick != now_tick
+        && slots++ < COAP_TIMER_WHEEL_SIZE) {
+    wheel_tick++;
+
+    /*
+     * Restart the scan after every retransmission, as callbacks of timed
+     * out transactions may clear other transactions of the same slot.
+     */
+    do {
+      for(p = &wheel[TICK_SLOT(wheel_tick)]; *p != NULL;
+          p = &(*p)->wheel_next) {
+        if(timer_expired(&(*p)->retrans_timer)) {
+          break;
+        }
+      }
+      if((t = *p) != NULL) {
+        wheel_remove(t);
+
+        ++(t->retrans_counter);
+        PRINTF("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
+        coap_send_transaction(t);
+      }
+    } while(t != NULL);
   }
+  wheel_tick = now_tick;
+  wheel_schedule();
 }
 /*---------------------------------------------------------------------------*/
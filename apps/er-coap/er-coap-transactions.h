@@ -50,11 +50,14 @@
 
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
-  struct coap_transaction *next;        /* for LIST */
+  struct coap_transaction *hash_next;   /* next in the same MID hash bucket */
+  struct coap_transaction *wheel_next;  /* next in the same timer wheel slot */
+  struct coap_transaction *wheel_prev;  /* previous in the slot, NULL if first */
 
   uint16_t mid;
-  struct etimer retrans_timer;
+  struct timer retrans_timer;
   uint8_t retrans_counter;
+  uint8_t scheduled;
 
   uip_ipaddr_t addr;
   uint16_t port;
@@ -63,6 +66,7 @@ typedef struct coap_transaction {
   void *callback_data;
 
   uint16_t packet_len;
+  uint16_t packet_offset;       /* start of the message in packet, see coap_serialize_message_in_place() */
   uint8_t packet[COAP_MAX_PACKET_SIZE + 1];     /* +1 for the terminating '\0' which will not be sent
                                                  * Use snprintf(buf, len+1, "", ...) to completely fill payload */
 } coap_transaction_t;
@@ -74,6 +78,8 @@ coap_transaction_t *coap_new_transaction(uint16_t mid, uip_ipaddr_t *addr,
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
+coap_transaction_t *coap_get_transaction(uint16_t mid, uip_ipaddr_t *addr,
+                                         uint16_t port);
 
 void coap_check_transactions();
 
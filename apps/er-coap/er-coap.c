@@ -82,7 +82,19 @@ coap_log_2(uint16_t value)
 }
 /*---------------------------------------------------------------------------*/
 static uint32_t
-coap_parse_int_option(uint8_t *bytes, size_t length)
+coap_block_option(uint32_t num, uint8_t more, uint16_t size)
+{
+  uint32_t block = num << 4;
+
+  if(more) {
+    block |= 0x8;
+  }
+  block |= 0xF & coap_log_2(size / 16);
+  return block;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+coap_parse_int_option(const uint8_t *bytes, size_t length)
 {
   uint32_t var = 0;
   int i = 0;
@@ -106,115 +118,209 @@ coap_option_nibble(unsigned int value)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Length of the option header for a delta and a value length */
+static size_t
+coap_option_header_length(unsigned int delta, size_t length)
+{
+  return 1 + (delta > 268 ? 2 : delta > 12) + (length > 268 ? 2 : length > 12);
+}
+/*---------------------------------------------------------------------------*/
+/* Encodes an option header for a delta and a value length, see RFC 7252,
+   3.1. The header is 1 to 5 bytes; returns its length. */
 static size_t
-coap_set_option_header(unsigned int delta, size_t length, uint8_t *buffer)
+coap_option_header(uint8_t *header, unsigned int delta, size_t length)
 {
-  size_t written = 0;
+  size_t i = 1;
 
-  buffer[0] = coap_option_nibble(delta) << 4 | coap_option_nibble(length);
+  header[0] = coap_option_nibble(delta) << 4 | coap_option_nibble(length);
 
   if(delta > 268) {
-    buffer[++written] = ((delta - 269) >> 8) & 0xff;
-    buffer[++written] = (delta - 269) & 0xff;
+    header[i++] = ((delta - 269) >> 8) & 0xff;
+    header[i++] = (delta - 269) & 0xff;
   } else if(delta > 12) {
-    buffer[++written] = (delta - 13);
+    header[i++] = (delta - 13);
   }
 
   if(length > 268) {
-    buffer[++written] = ((length - 269) >> 8) & 0xff;
-    buffer[++written] = (length - 269) & 0xff;
+    header[i++] = ((length - 269) >> 8) & 0xff;
+    header[i++] = (length - 269) & 0xff;
   } else if(length > 12) {
-    buffer[++written] = (length - 13);
+    header[i++] = (length - 13);
   }
-
-  PRINTF("WRITTEN %zu B opt header\n", 1 + written);
-
-  return ++written;
+  return i;
 }
 /*---------------------------------------------------------------------------*/
+/* Length of an integer option value without leading zero bytes, so 0 has
+   no bytes */
 static size_t
-coap_serialize_int_option(unsigned int number, unsigned int current_number,
-                          uint8_t *buffer, uint32_t value)
+coap_int_option_length(uint32_t value)
 {
-  size_t i = 0;
-
-  if(0xFF000000 & value) {
-    ++i;
+  if(value > 0xFFFFFF) {
+    return 4;
+  } else if(value > 0xFFFF) {
+    return 3;
+  } else if(value > 0xFF) {
+    return 2;
   }
-  if(0xFFFF0000 & value) {
-    ++i;
+  return value > 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_int_option_value(uint8_t *bytes, size_t length, uint32_t value)
+{
+  while(length-- > 0) {
+    bytes[length] = (uint8_t)value;
+    value >>= 8;
   }
-  if(0xFFFFFF00 & value) {
-    ++i;
+}
+/*---------------------------------------------------------------------------*/
+/* Reserves n bytes in the writer, or flags an error if they do not fit */
+static int
+coap_writer_reserve(coap_writer_t *writer, size_t n)
+{
+  if(writer->error || writer->len + n > writer->size) {
+    writer->error = 1;
+    return 0;
   }
-  if(0xFFFFFFFF & value) {
-    ++i;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_writer_put(coap_writer_t *writer, const uint8_t *data, size_t n)
+{
+  if(n > 0) {
+    memcpy(writer->buffer + writer->len, data, n);
+    writer->len += n;
   }
-  PRINTF("OPTION %u (delta %u, len %zu)\n", number, number - current_number,
-         i);
-
-  i = coap_set_option_header(number - current_number, i, buffer);
+}
+/*---------------------------------------------------------------------------*/
+/* Writes an option header, once there is room for the value as well */
+static int
+coap_writer_option_header(coap_writer_t *writer, unsigned int number,
+                          size_t length)
+{
+  unsigned int delta;
 
-  if(0xFF000000 & value) {
-    buffer[i++] = (uint8_t)(value >> 24);
+  if(number < writer->number) {
+    writer->error = 1;
+    return 0;
   }
-  if(0xFFFF0000 & value) {
-    buffer[i++] = (uint8_t)(value >> 16);
+  delta = number - writer->number;
+  if(!coap_writer_reserve(writer, coap_option_header_length(delta, length)
+                          + length)) {
+    return 0;
+  }
+  writer->len += coap_option_header(writer->buffer + writer->len, delta,
+                                    length);
+  writer->number = number;
+
+  PRINTF("OPTION %u (delta %u, len %zu)\n", number, delta, length);
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The header of a message that is serialized in place is written back to
+ * front, ending in front of the payload, so that neither has to be moved.
+ * An option header holds the delta to the option before it, which is only
+ * known once that option is written, so each header waits in the
+ * prepender until then.
+ */
+typedef struct {
+  uint8_t *start;        /* first byte written so far */
+  uint8_t *limit;        /* nothing is written in front of this */
+  unsigned int number;   /* option whose header is missing, 0 if none */
+  size_t length;         /* value length of that option */
+  uint8_t error;         /* set once something did not fit */
+} coap_prepender_t;
+/*---------------------------------------------------------------------------*/
+/* Makes room for n bytes in front of what is written, or returns NULL */
+static uint8_t *
+coap_prepend_space(coap_prepender_t *p, size_t n)
+{
+  if(p->error || (size_t)(p->start - p->limit) < n) {
+    p->error = 1;
+    return NULL;
   }
-  if(0xFFFFFF00 & value) {
-    buffer[i++] = (uint8_t)(value >> 8);
+  p->start -= n;
+  return p->start;
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_prepend(coap_prepender_t *p, const uint8_t *data, size_t n)
+{
+  uint8_t *dst = coap_prepend_space(p, n);
+
+  if(dst != NULL) {
+    memcpy(dst, data, n);
   }
-  if(0xFFFFFFFF & value) {
-    buffer[i++] = (uint8_t)(value);
+}
+/*---------------------------------------------------------------------------*/
+/* Writes the missing option header, with the delta from number */
+static void
+coap_prepend_option_header(coap_prepender_t *p, unsigned int number)
+{
+  unsigned int delta = p->number - number;
+  uint8_t *header;
+
+  if(p->number != 0) {
+    header = coap_prepend_space(p, coap_option_header_length(delta,
+                                                             p->length));
+    if(header != NULL) {
+      coap_option_header(header, delta, p->length);
+    }
+    p->number = 0;
   }
-  return i;
 }
 /*---------------------------------------------------------------------------*/
-static size_t
-coap_serialize_array_option(unsigned int number, unsigned int current_number,
-                            uint8_t *buffer, uint8_t *array, size_t length,
-                            char split_char)
+static void
+coap_prepend_option(coap_prepender_t *p, unsigned int number,
+                    const uint8_t *value, size_t length)
 {
-  size_t i = 0;
+  coap_prepend_option_header(p, number);
+  coap_prepend(p, value, length);
+  p->number = number;
+  p->length = length;
+}
+/*---------------------------------------------------------------------------*/
+static void
+coap_prepend_int_option(coap_prepender_t *p, unsigned int number,
+                        uint32_t value)
+{
+  size_t length = coap_int_option_length(value);
+  uint8_t *bytes;
 
-  PRINTF("ARRAY type %u, len %zu, full [%.*s]\n", number, length,
-	 (int)length, array);
-
-  if(split_char != '\0') {
-    int j;
-    uint8_t *part_start = array;
-    uint8_t *part_end = NULL;
-    size_t temp_length;
-
-    for(j = 0; j <= length + 1; ++j) {
-      PRINTF("STEP %u/%zu (%c)\n", j, length, array[j]);
-      if(array[j] == split_char || j == length) {
-        part_end = array + j;
-        temp_length = part_end - part_start;
-
-        i += coap_set_option_header(number - current_number, temp_length,
-                                    &buffer[i]);
-        memcpy(&buffer[i], part_start, temp_length);
-        i += temp_length;
-
-        PRINTF("OPTION type %u, delta %u, len %zu, part [%.*s]\n", number,
-               number - current_number, i, (int)temp_length, part_start);
-
-        ++j;                    /* skip the splitter */
-        current_number = number;
-        part_start = array + j;
+  coap_prepend_option_header(p, number);
+  if((bytes = coap_prepend_space(p, length)) != NULL) {
+    coap_int_option_value(bytes, length, value);
+  }
+  p->number = number;
+  p->length = length;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes one option per part, last part first */
+static void
+coap_prepend_array_option(coap_prepender_t *p, unsigned int number,
+                          const uint8_t *array, size_t length,
+                          char split_char)
+{
+  const uint8_t *end = array + length;
+  const uint8_t *part;
+
+  for(;;) {
+    part = array;
+    if(split_char != '\0') {
+      part = end;
+      while(part > array && part[-1] != split_char) {
+        part--;
       }
-    }                           /* for */
-  } else {
-    i += coap_set_option_header(number - current_number, length, &buffer[i]);
-    memcpy(&buffer[i], array, length);
-    i += length;
-
-    PRINTF("OPTION type %u, delta %u, len %zu\n", number,
-           number - current_number, length);
+    }
+    coap_prepend_option(p, number, part, end - part);
+    if(part == array) {
+      break;
+    }
+    end = part - 1;
   }
-
-  return i;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -227,8 +333,11 @@ coap_merge_multi_option(char **dst, size_t *dst_len, uint8_t *option,
     (*dst)[*dst_len] = separator;
     *dst_len += 1;
 
-    /* memmove handles 2-byte option headers */
-    memmove((*dst) + (*dst_len), option, option_len);
+    /* With a 1-byte option header, the separator took its place and the
+       option already follows. memmove handles longer option headers. */
+    if(option != (uint8_t *)(*dst) + (*dst_len)) {
+      memmove((*dst) + (*dst_len), option, option_len);
+    }
 
     *dst_len += option_len;
   } else {
@@ -307,52 +416,119 @@ coap_init_message(void *packet, coap_message_type_t type, uint8_t code,
   coap_pkt->mid = mid;
 }
 /*---------------------------------------------------------------------------*/
-size_t
-coap_serialize_message(void *packet, uint8_t *buffer)
+void
+coap_writer_init(coap_writer_t *writer, uint8_t *buffer, size_t size)
 {
-  coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
-  uint8_t *option;
-  unsigned int current_number = 0;
+  writer->buffer = buffer;
+  writer->size = size;
+  writer->len = 0;
+  writer->number = 0;
+  writer->error = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_writer_header(coap_writer_t *writer, coap_message_type_t type,
+                   uint8_t code, uint16_t mid, const uint8_t *token,
+                   size_t token_len)
+{
+  uint8_t header[COAP_HEADER_LEN];
 
-  /* Initialize */
-  coap_pkt->buffer = buffer;
-  coap_pkt->version = 1;
+  if(token_len > COAP_TOKEN_LEN || writer->len != 0) {
+    writer->error = 1;
+    return 0;
+  }
+  if(!coap_writer_reserve(writer, COAP_HEADER_LEN + token_len)) {
+    return 0;
+  }
 
-  PRINTF("-Serializing MID %u to %p, ", coap_pkt->mid, coap_pkt->buffer);
+  header[0] = COAP_HEADER_VERSION_MASK & 1 << COAP_HEADER_VERSION_POSITION;
+  header[0] |= COAP_HEADER_TYPE_MASK & type << COAP_HEADER_TYPE_POSITION;
+  header[0] |= COAP_HEADER_TOKEN_LEN_MASK
+    & token_len << COAP_HEADER_TOKEN_LEN_POSITION;
+  header[1] = code;
+  header[2] = (uint8_t)(mid >> 8);
+  header[3] = (uint8_t)(mid);
 
-  /* set header fields */
-  coap_pkt->buffer[0] = 0x00;
-  coap_pkt->buffer[0] |= COAP_HEADER_VERSION_MASK
-    & (coap_pkt->version) << COAP_HEADER_VERSION_POSITION;
-  coap_pkt->buffer[0] |= COAP_HEADER_TYPE_MASK
-    & (coap_pkt->type) << COAP_HEADER_TYPE_POSITION;
-  coap_pkt->buffer[0] |= COAP_HEADER_TOKEN_LEN_MASK
-    & (coap_pkt->token_len) << COAP_HEADER_TOKEN_LEN_POSITION;
-  coap_pkt->buffer[1] = coap_pkt->code;
-  coap_pkt->buffer[2] = (uint8_t)((coap_pkt->mid) >> 8);
-  coap_pkt->buffer[3] = (uint8_t)(coap_pkt->mid);
+  coap_writer_put(writer, header, COAP_HEADER_LEN);
+  coap_writer_put(writer, token, token_len);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_writer_int_option(coap_writer_t *writer, unsigned int number,
+                       uint32_t value)
+{
+  size_t length = coap_int_option_length(value);
 
-  /* empty packet, dont need to do more stuff */
-  if(!coap_pkt->code) {
-    PRINTF("-Done serializing empty message at %p-\n", coap_pkt->buffer);
-    return 4;
+  if(!coap_writer_option_header(writer, number, length)) {
+    return 0;
   }
+  coap_int_option_value(writer->buffer + writer->len, length, value);
+  writer->len += length;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_writer_array_option(coap_writer_t *writer, unsigned int number,
+                         const uint8_t *array, size_t length,
+                         char split_char)
+{
+  const uint8_t *end = array + length;
+  const uint8_t *part_end;
 
-  /* set Token */
-  PRINTF("Token (len %u)", coap_pkt->token_len);
-  option = coap_pkt->buffer + COAP_HEADER_LEN;
-  for(current_number = 0; current_number < coap_pkt->token_len;
-      ++current_number) {
-    PRINTF(" %02X", coap_pkt->token[current_number]);
-    *option = coap_pkt->token[current_number];
-    ++option;
+  PRINTF("ARRAY type %u, len %zu, full [%.*s]\n", number, length,
+         (int)length, array);
+
+  /* Split into one option per part, e.g. per Uri-Path segment */
+  do {
+    part_end = NULL;
+    if(split_char != '\0') {
+      part_end = memchr(array, split_char, end - array);
+    }
+    if(part_end == NULL) {
+      part_end = end;
+    }
+    if(!coap_writer_option_header(writer, number, part_end - array)) {
+      return 0;
+    }
+    coap_writer_put(writer, array, part_end - array);
+    array = part_end + 1;
+  } while(part_end < end);
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t *
+coap_writer_payload(coap_writer_t *writer)
+{
+  static const uint8_t marker = 0xFF;
+
+  if(!coap_writer_reserve(writer, 1)) {
+    return NULL;
   }
-  PRINTF("-\n");
+  coap_writer_put(writer, &marker, 1);
+  return writer->buffer + writer->len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the CoAP header, token, and options of a packet. Returns 0 if
+ * they exceed COAP_MAX_HEADER_SIZE.
+ */
+static int
+coap_serialize_header(coap_packet_t *coap_pkt, coap_writer_t *writer)
+{
+  PRINTF("-Serializing MID %u to %p, ", coap_pkt->mid, writer->buffer);
 
-  /* Serialize options */
-  current_number = 0;
+  /* empty packet, dont need to do more stuff */
+  if(!coap_pkt->code) {
+    PRINTF("-Done serializing empty message-\n");
+    return coap_writer_header(writer, coap_pkt->type, 0, coap_pkt->mid,
+                              NULL, 0);
+  }
 
-  PRINTF("-Serializing options at %p-\n", option);
+  PRINTF("Token (len %u)\n", coap_pkt->token_len);
+  coap_writer_header(writer, coap_pkt->type, coap_pkt->code, coap_pkt->mid,
+                     coap_pkt->token, coap_pkt->token_len);
 
   /* The options must be serialized in the order of their number */
   COAP_SERIALIZE_BYTE_OPTION(COAP_OPTION_IF_MATCH, if_match, "If-Match");
@@ -388,40 +564,160 @@ coap_serialize_message(void *packet, uint8_t *buffer)
                                "Proxy-Scheme");
   COAP_SERIALIZE_INT_OPTION(COAP_OPTION_SIZE1, size1, "Size1");
 
-  PRINTF("-Done serializing at %p----\n", option);
+  PRINTF("-Done serializing %u B----\n", (unsigned int)writer->len);
 
-  /* Pack payload */
-  if((option - coap_pkt->buffer) <= COAP_MAX_HEADER_SIZE) {
-    /* Payload marker */
-    if(coap_pkt->payload_len) {
-      *option = 0xFF;
-      ++option;
-    }
-    memmove(option, coap_pkt->payload, coap_pkt->payload_len);
-  } else {
+  if(writer->error) {
     /* an error occurred: caller must check for !=0 */
-    coap_pkt->buffer = NULL;
     coap_error_message = "Serialized header exceeds COAP_MAX_HEADER_SIZE";
     return 0;
   }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+coap_serialize_message(void *packet, uint8_t *buffer)
+{
+  coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
+  coap_writer_t writer;
+  uint8_t *option;
+
+  coap_pkt->version = 1;
+  coap_pkt->buffer = buffer;
+
+  coap_writer_init(&writer, buffer, COAP_MAX_HEADER_SIZE);
+  if(!coap_serialize_header(coap_pkt, &writer)) {
+    coap_pkt->buffer = NULL;
+    return 0;
+  }
+  if(!coap_pkt->code) {
+    return COAP_HEADER_LEN;
+  }
+
+  /* Pack payload */
+  option = buffer + writer.len;
+  if(coap_pkt->payload_len) {
+    /* Payload marker */
+    *option = 0xFF;
+    ++option;
+  }
+  memmove(option, coap_pkt->payload, coap_pkt->payload_len);
 
   PRINTF("-Done %u B (header len %u, payload len %u)-\n",
          (unsigned int)(coap_pkt->payload_len + option - buffer),
          (unsigned int)(option - buffer),
          (unsigned int)coap_pkt->payload_len);
 
-  PRINTF("Dump [0x%02X %02X %02X %02X  %02X %02X %02X %02X]\n",
-         coap_pkt->buffer[0],
-         coap_pkt->buffer[1],
-         coap_pkt->buffer[2],
-         coap_pkt->buffer[3],
-         coap_pkt->buffer[4],
-         coap_pkt->buffer[5], coap_pkt->buffer[6], coap_pkt->buffer[7]
-         );
-
   return (option - buffer) + coap_pkt->payload_len; /* packet length */
 }
 /*---------------------------------------------------------------------------*/
+#define COAP_PREPEND_INT_OPTION(number, value) \
+  if(IS_OPTION(coap_pkt, number)) { \
+    coap_prepend_int_option(p, number, value); \
+  }
+#define COAP_PREPEND_ARRAY_OPTION(number, field, splitter) \
+  if(IS_OPTION(coap_pkt, number)) { \
+    coap_prepend_array_option(p, number, (const uint8_t *)coap_pkt->field, \
+                              coap_pkt->field##_len, splitter); \
+  }
+#define COAP_PREPEND_BLOCK_OPTION(number, field) \
+  COAP_PREPEND_INT_OPTION(number, \
+                          coap_block_option(coap_pkt->field##_num, \
+                                            coap_pkt->field##_more, \
+                                            coap_pkt->field##_size))
+
+/* Writes the same bytes as coap_serialize_header(), back to front */
+static void
+coap_prepend_header(coap_packet_t *coap_pkt, coap_prepender_t *p)
+{
+  uint8_t *header;
+
+  /* The options in decreasing order of their number */
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_SIZE1, coap_pkt->size1);
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_PROXY_SCHEME, proxy_scheme, '\0');
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_PROXY_URI, proxy_uri, '\0');
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_SIZE2, coap_pkt->size2);
+  COAP_PREPEND_BLOCK_OPTION(COAP_OPTION_BLOCK1, block1);
+  COAP_PREPEND_BLOCK_OPTION(COAP_OPTION_BLOCK2, block2);
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_LOCATION_QUERY, location_query, '&');
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_ACCEPT, coap_pkt->accept);
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_URI_QUERY, uri_query, '&');
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_MAX_AGE, coap_pkt->max_age);
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_CONTENT_FORMAT,
+                          coap_pkt->content_format);
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_URI_PATH, uri_path, '/');
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_LOCATION_PATH, location_path, '/');
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_URI_PORT, coap_pkt->uri_port);
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_OBSERVE, coap_pkt->observe);
+  COAP_PREPEND_INT_OPTION(COAP_OPTION_IF_NONE_MATCH, 0);
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_ETAG, etag, '\0');
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_URI_HOST, uri_host, '\0');
+  COAP_PREPEND_ARRAY_OPTION(COAP_OPTION_IF_MATCH, if_match, '\0');
+  coap_prepend_option_header(p, 0);
+
+  coap_prepend(p, coap_pkt->token, coap_pkt->token_len);
+
+  if((header = coap_prepend_space(p, COAP_HEADER_LEN)) == NULL) {
+    return;
+  }
+  header[0] = COAP_HEADER_VERSION_MASK & 1 << COAP_HEADER_VERSION_POSITION;
+  header[0] |= COAP_HEADER_TYPE_MASK & coap_pkt->type
+    << COAP_HEADER_TYPE_POSITION;
+  header[0] |= COAP_HEADER_TOKEN_LEN_MASK
+    & coap_pkt->token_len << COAP_HEADER_TOKEN_LEN_POSITION;
+  header[1] = coap_pkt->code;
+  header[2] = (uint8_t)(coap_pkt->mid >> 8);
+  header[3] = (uint8_t)(coap_pkt->mid);
+}
+/*---------------------------------------------------------------------------*/
+size_t
+coap_serialize_message_in_place(void *packet, uint8_t *buffer,
+                                uint16_t *offset)
+{
+  coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
+  static const uint8_t marker = 0xFF;
+  coap_prepender_t p;
+  size_t header_len;
+
+  *offset = 0;
+
+  /*
+   * If the handler wrote the payload into the same buffer behind the header
+   * space, write the header backwards from the payload. Otherwise, or if
+   * the header does not fit in front of the payload, the payload is moved
+   * down to the header.
+   */
+  if(!coap_pkt->code || !coap_pkt->payload_len
+     || coap_pkt->token_len > COAP_TOKEN_LEN
+     || coap_pkt->payload <= buffer
+     || coap_pkt->payload + coap_pkt->payload_len
+     > buffer + COAP_MAX_PACKET_SIZE) {
+    return coap_serialize_message(coap_pkt, buffer);
+  }
+
+  p.start = coap_pkt->payload;
+  p.limit = coap_pkt->payload - buffer > COAP_MAX_HEADER_SIZE + 1 ?
+    coap_pkt->payload - (COAP_MAX_HEADER_SIZE + 1) : buffer;
+  p.number = 0;
+  p.error = 0;
+  coap_prepend(&p, &marker, 1);
+  coap_prepend_header(coap_pkt, &p);
+  if(p.error) {
+    return coap_serialize_message(coap_pkt, buffer);
+  }
+
+  header_len = coap_pkt->payload - p.start;
+  *offset = p.start - buffer;
+  coap_pkt->version = 1;
+  coap_pkt->buffer = p.start;
+
+  PRINTF("-Done %u B in place at +%u (header len %u, payload len %u)-\n",
+         (unsigned int)(header_len + coap_pkt->payload_len),
+         (unsigned int)*offset, (unsigned int)header_len,
+         (unsigned int)coap_pkt->payload_len);
+
+  return header_len + coap_pkt->payload_len; /* packet length */
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
                   uint16_t length)
@@ -440,9 +736,104 @@ coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
 }
 /*---------------------------------------------------------------------------*/
 coap_status_t
+coap_option_iterator_init(coap_option_iterator_t *it, const uint8_t *data,
+                          uint16_t data_len)
+{
+  unsigned int token_len;
+
+  memset(it, 0, sizeof(coap_option_iterator_t));
+  if(data_len < COAP_HEADER_LEN) {
+    coap_error_message = "Message shorter than the CoAP header";
+    return BAD_REQUEST_4_00;
+  }
+  token_len = (COAP_HEADER_TOKEN_LEN_MASK & data[0])
+    >> COAP_HEADER_TOKEN_LEN_POSITION;
+  if(token_len > COAP_TOKEN_LEN || COAP_HEADER_LEN + token_len > data_len) {
+    coap_error_message = "Token Length must not be more than 8";
+    return BAD_REQUEST_4_00;
+  }
+  it->next = data + COAP_HEADER_LEN + token_len;
+  it->end = data + data_len;
+  return NO_ERROR;
+}
+/*---------------------------------------------------------------------------*/
+/* Decodes an extended option delta or length, see RFC 7252, 3.1 */
+static int
+coap_option_iterator_extended(coap_option_iterator_t *it, unsigned int *value)
+{
+  if(*value == 13) {
+    if(it->next + 1 > it->end) {
+      return 0;
+    }
+    *value += it->next[0];
+    it->next += 1;
+  } else if(*value == 14) {
+    if(it->next + 2 > it->end) {
+      return 0;
+    }
+    *value = 269 + (it->next[0] << 8) + it->next[1];
+    it->next += 2;
+  } else if(*value == 15) {
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+coap_option_iterator_step(coap_option_iterator_t *it)
+{
+  unsigned int delta;
+  unsigned int length;
+
+  if(it->next >= it->end) {
+    it->value = NULL;
+    it->length = 0;
+    return 0;
+  }
+
+  /* payload marker 0xFF, currently only checking for 0xF* because rest is reserved */
+  if((it->next[0] & 0xF0) == 0xF0) {
+    it->value = it->next + 1;
+    it->length = it->end - it->value;
+    it->next = it->end;
+    return 0;
+  }
+
+  delta = it->next[0] >> 4;
+  length = it->next[0] & 0x0F;
+  it->next += 1;
+
+  if(!coap_option_iterator_extended(it, &delta)
+     || !coap_option_iterator_extended(it, &length)
+     || length > it->end - it->next) {
+    coap_error_message = "Option exceeds the message";
+    it->next = it->end;
+    return -1;
+  }
+
+  it->number += delta;
+  it->value = it->next;
+  it->length = length;
+  it->next += length;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_option_iterator_next(coap_option_iterator_t *it)
+{
+  return coap_option_iterator_step(it);
+}
+/*---------------------------------------------------------------------------*/
+coap_status_t
 coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
 {
   coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
+  coap_option_iterator_t it;
+  coap_status_t status;
+  uint8_t *current_option;
+  unsigned int option_number;
+  size_t option_length;
+  int ret;
 
   /* initialize packet */
   memset(coap_pkt, 0, sizeof(coap_packet_t));
@@ -450,6 +841,10 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
   /* pointer to packet bytes */
   coap_pkt->buffer = data;
 
+  if((status = coap_option_iterator_init(&it, data, data_len)) != NO_ERROR) {
+    return status;
+  }
+
   /* parse header fields */
   coap_pkt->version = (COAP_HEADER_VERSION_MASK & coap_pkt->buffer[0])
     >> COAP_HEADER_VERSION_POSITION;
@@ -465,77 +860,25 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
     return BAD_REQUEST_4_00;
   }
 
-  if(coap_pkt->token_len > COAP_TOKEN_LEN) {
-    coap_error_message = "Token Length must not be more than 8";
-    return BAD_REQUEST_4_00;
-  }
-
-  uint8_t *current_option = data + COAP_HEADER_LEN;
-
-  memcpy(coap_pkt->token, current_option, coap_pkt->token_len);
+  memcpy(coap_pkt->token, data + COAP_HEADER_LEN, coap_pkt->token_len);
   PRINTF("Token (len %u) [0x%02X%02X%02X%02X%02X%02X%02X%02X]\n",
          coap_pkt->token_len, coap_pkt->token[0], coap_pkt->token[1],
          coap_pkt->token[2], coap_pkt->token[3], coap_pkt->token[4],
          coap_pkt->token[5], coap_pkt->token[6], coap_pkt->token[7]
          );                     /*FIXME always prints 8 bytes */
 
-  /* parse options */
-  memset(coap_pkt->options, 0, sizeof(coap_pkt->options));
-  current_option += coap_pkt->token_len;
-
-  unsigned int option_number = 0;
-  unsigned int option_delta = 0;
-  size_t option_length = 0;
-
-  while(current_option < data + data_len) {
-    /* payload marker 0xFF, currently only checking for 0xF* because rest is reserved */
-    if((current_option[0] & 0xF0) == 0xF0) {
-      coap_pkt->payload = ++current_option;
-      coap_pkt->payload_len = data_len - (coap_pkt->payload - data);
+  /* parse options, they point into the message */
+  while((ret = coap_option_iterator_step(&it)) > 0) {
+    current_option = (uint8_t *)it.value;
+    option_number = it.number;
+    option_length = it.length;
 
-      /* also for receiving, the Erbium upper bound is REST_MAX_CHUNK_SIZE */
-      if(coap_pkt->payload_len > REST_MAX_CHUNK_SIZE) {
-        coap_pkt->payload_len = REST_MAX_CHUNK_SIZE;
-        /* null-terminate payload */
-      }
-      coap_pkt->payload[coap_pkt->payload_len] = '\0';
-
-      break;
-    }
+    PRINTF("OPTION %u (len %zu): ", option_number, option_length);
 
-    option_delta = current_option[0] >> 4;
-    option_length = current_option[0] & 0x0F;
-    ++current_option;
-
-    if(option_delta == 13) {
-      option_delta += current_option[0];
-      ++current_option;
-    } else if(option_delta == 14) {
-      option_delta += 255;
-      option_delta += current_option[0] << 8;
-      ++current_option;
-      option_delta += current_option[0];
-      ++current_option;
+    if(option_number <= COAP_OPTION_SIZE1) {
+      SET_OPTION(coap_pkt, option_number);
     }
 
-    if(option_length == 13) {
-      option_length += current_option[0];
-      ++current_option;
-    } else if(option_length == 14) {
-      option_length += 255;
-      option_length += current_option[0] << 8;
-      ++current_option;
-      option_length += current_option[0];
-      ++current_option;
-    }
-
-    option_number += option_delta;
-
-    PRINTF("OPTION %u (delta %u, len %zu): ", option_number, option_delta,
-           option_length);
-
-    SET_OPTION(coap_pkt, option_number);
-
     switch(option_number) {
     case COAP_OPTION_CONTENT_FORMAT:
       coap_pkt->content_format = coap_parse_int_option(current_option,
@@ -687,9 +1030,22 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
         return BAD_OPTION_4_02;
       }
     }
+  }
+  if(ret < 0) {
+    return BAD_REQUEST_4_00;
+  }
 
-    current_option += option_length;
-  }                             /* for */
+  if(it.value != NULL) {
+    coap_pkt->payload = (uint8_t *)it.value;
+    coap_pkt->payload_len = it.length;
+
+    /* also for receiving, the Erbium upper bound is REST_MAX_CHUNK_SIZE */
+    if(coap_pkt->payload_len > REST_MAX_CHUNK_SIZE) {
+      coap_pkt->payload_len = REST_MAX_CHUNK_SIZE;
+      /* null-terminate payload */
+    }
+    coap_pkt->payload[coap_pkt->payload_len] = '\0';
+  }
   PRINTF("-Done parsing-------\n");
 
   return NO_ERROR;
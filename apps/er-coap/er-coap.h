@@ -132,12 +132,32 @@ typedef struct {
   uint8_t *payload;
 } coap_packet_t;
 
+/* Iterator over the options of a received message. The option values
+   and the payload point into the message; nothing is copied. */
+typedef struct {
+  const uint8_t *next;   /* header of the next option */
+  const uint8_t *end;    /* end of the message */
+  unsigned int number;   /* number of the current option */
+  const uint8_t *value;  /* current option value, or the payload at the end */
+  size_t length;         /* length of the value or payload */
+} coap_option_iterator_t;
+
+/* Streaming serializer. It writes the header and token, the options in
+   increasing order of their number, and the payload marker directly into
+   the message buffer. */
+typedef struct {
+  uint8_t *buffer;       /* start of the message */
+  size_t size;           /* the most bytes that may be written */
+  size_t len;            /* bytes written so far */
+  unsigned int number;   /* number of the last option written */
+  uint8_t error;         /* set once something did not fit or was out of order */
+} coap_writer_t;
+
 /* option format serialization */
 #define COAP_SERIALIZE_INT_OPTION(number, field, text) \
   if(IS_OPTION(coap_pkt, number)) { \
     PRINTF(text " [%u]\n", (unsigned int)coap_pkt->field);		\
-    option += coap_serialize_int_option(number, current_number, option, coap_pkt->field); \
-    current_number = number; \
+    coap_writer_int_option(writer, number, coap_pkt->field); \
   }
 #define COAP_SERIALIZE_BYTE_OPTION(number, field, text) \
   if(IS_OPTION(coap_pkt, number)) { \
@@ -151,25 +171,20 @@ typedef struct {
            coap_pkt->field[6], \
            coap_pkt->field[7] \
            ); /* FIXME always prints 8 bytes */ \
-    option += coap_serialize_array_option(number, current_number, option, coap_pkt->field, coap_pkt->field##_len, '\0'); \
-    current_number = number; \
+    coap_writer_array_option(writer, number, coap_pkt->field, coap_pkt->field##_len, '\0'); \
   }
 #define COAP_SERIALIZE_STRING_OPTION(number, field, splitter, text) \
   if(IS_OPTION(coap_pkt, number)) { \
     PRINTF(text " [%.*s]\n", (int)coap_pkt->field##_len, coap_pkt->field); \
-    option += coap_serialize_array_option(number, current_number, option, (uint8_t *)coap_pkt->field, coap_pkt->field##_len, splitter); \
-    current_number = number; \
+    coap_writer_array_option(writer, number, (const uint8_t *)coap_pkt->field, coap_pkt->field##_len, splitter); \
   }
 #define COAP_SERIALIZE_BLOCK_OPTION(number, field, text) \
   if(IS_OPTION(coap_pkt, number)) \
   { \
     PRINTF(text " [%lu%s (%u B/blk)]\n", (unsigned long)coap_pkt->field##_num, coap_pkt->field##_more ? "+" : "", coap_pkt->field##_size); \
-    uint32_t block = coap_pkt->field##_num << 4; \
-    if(coap_pkt->field##_more) { block |= 0x8; } \
-    block |= 0xF & coap_log_2(coap_pkt->field##_size / 16); \
+    uint32_t block = coap_block_option(coap_pkt->field##_num, coap_pkt->field##_more, coap_pkt->field##_size); \
     PRINTF(text " encoded: 0x%lX\n", (unsigned long)block);		\
-    option += coap_serialize_int_option(number, current_number, option, block); \
-    current_number = number; \
+    coap_writer_int_option(writer, number, block); \
   }
 
 /* to store error code and human-readable payload */
@@ -182,11 +197,29 @@ uint16_t coap_get_mid(void);
 void coap_init_message(void *packet, coap_message_type_t type, uint8_t code,
                        uint16_t mid);
 size_t coap_serialize_message(void *packet, uint8_t *buffer);
+size_t coap_serialize_message_in_place(void *packet, uint8_t *buffer,
+                                       uint16_t *offset);
 void coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
                        uint16_t length);
 coap_status_t coap_parse_message(void *request, uint8_t *data,
                                  uint16_t data_len);
 
+coap_status_t coap_option_iterator_init(coap_option_iterator_t *it,
+                                        const uint8_t *data,
+                                        uint16_t data_len);
+int coap_option_iterator_next(coap_option_iterator_t *it);
+
+void coap_writer_init(coap_writer_t *writer, uint8_t *buffer, size_t size);
+int coap_writer_header(coap_writer_t *writer, coap_message_type_t type,
+                       uint8_t code, uint16_t mid, const uint8_t *token,
+                       size_t token_len);
+int coap_writer_int_option(coap_writer_t *writer, unsigned int number,
+                           uint32_t value);
+int coap_writer_array_option(coap_writer_t *writer, unsigned int number,
+                             const uint8_t *array, size_t length,
+                             char split_char);
+uint8_t *coap_writer_payload(coap_writer_t *writer);
+
 int coap_get_query_variable(void *packet, const char *name,
                             const char **output);
 int coap_get_post_variable(void *packet, const char *name,
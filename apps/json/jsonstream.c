@@ -0,0 +1,567 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Streaming JSON parser that can be fed a document in chunks
+ */
+
+#include "jsonstream.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* What the grammar accepts next, outside of atomic values */
+enum {
+  EXPECT_VALUE,
+  EXPECT_VALUE_OR_END,
+  EXPECT_KEY,
+  EXPECT_KEY_OR_END,
+  EXPECT_COLON,
+  EXPECT_COMMA_OR_END,
+  EXPECT_NOTHING
+};
+
+/* Where the lexer is inside an atomic value */
+enum {
+  LEX_NONE,
+  LEX_STRING,
+  LEX_ESCAPE,
+  LEX_UNICODE,
+  LEX_NUMBER,
+  LEX_LITERAL
+};
+
+/*--------------------------------------------------------------------*/
+static int
+error(struct jsonstream_state *state, char error)
+{
+  state->error = error;
+  return JSONSTREAM_ERROR;
+}
+/*--------------------------------------------------------------------*/
+static void
+value_add(struct jsonstream_state *state, char c)
+{
+  if(state->vlen < JSONSTREAM_VALUE_SIZE - 1) {
+    state->value[state->vlen++] = c;
+    state->value[state->vlen] = 0;
+  }
+}
+/*--------------------------------------------------------------------*/
+static void
+value_begin(struct jsonstream_state *state, char type)
+{
+  state->vtype = type;
+  state->vlen = 0;
+  state->value[0] = 0;
+}
+/*--------------------------------------------------------------------*/
+/* the current container level owns the last segment of the path */
+/*--------------------------------------------------------------------*/
+static void
+path_set(struct jsonstream_state *state, const char *segment, int len)
+{
+  uint8_t level = state->depth;
+
+  if(state->path_overflow != 0 && state->path_overflow < level) {
+    /* an outer level did not fit - the path stays invalid */
+    return;
+  }
+  state->path_overflow = 0;
+  state->pathlen = state->pathpos[level - 1];
+  if(state->pathlen + 1 + len >= JSONSTREAM_PATH_SIZE) {
+    state->path_overflow = level;
+    return;
+  }
+  state->path[state->pathlen++] = '/';
+  memcpy(&state->path[state->pathlen], segment, len);
+  state->pathlen += len;
+  state->path[state->pathlen] = 0;
+}
+/*--------------------------------------------------------------------*/
+static void
+path_set_index(struct jsonstream_state *state)
+{
+  char buf[6];
+  int i;
+  uint16_t index;
+
+  index = state->index[state->depth - 1];
+  i = sizeof(buf);
+  do {
+    buf[--i] = '0' + index % 10;
+    index /= 10;
+  } while(index > 0);
+  path_set(state, &buf[i], sizeof(buf) - i);
+}
+/*--------------------------------------------------------------------*/
+static int
+push(struct jsonstream_state *state, char c)
+{
+  if(state->depth >= JSONPARSE_MAX_DEPTH) {
+    return error(state, JSON_ERROR_SYNTAX);
+  }
+  state->stack[state->depth] = c;
+  state->index[state->depth] = 0;
+  state->pathpos[state->depth] = state->pathlen;
+  state->depth++;
+  state->vtype = 0;
+  return c;
+}
+/*--------------------------------------------------------------------*/
+static void
+pop(struct jsonstream_state *state)
+{
+  state->depth--;
+  if(state->path_overflow == 0 || state->path_overflow > state->depth) {
+    /* back to the path of the container that was closed */
+    state->path_overflow = 0;
+    state->pathlen = state->pathpos[state->depth];
+    state->path[state->pathlen] = 0;
+  }
+  state->vtype = 0;
+}
+/*--------------------------------------------------------------------*/
+static char
+top(struct jsonstream_state *state)
+{
+  if(state->depth == 0) {
+    return 0;
+  }
+  return state->stack[state->depth - 1];
+}
+/*--------------------------------------------------------------------*/
+static int
+value_end(struct jsonstream_state *state, int type)
+{
+  state->expect = state->depth == 0 ? EXPECT_NOTHING : EXPECT_COMMA_OR_END;
+  return type;
+}
+/*--------------------------------------------------------------------*/
+static const char *
+literal(char type)
+{
+  switch(type) {
+  case JSON_TYPE_TRUE:
+    return "true";
+  case JSON_TYPE_FALSE:
+    return "false";
+  default:
+    return "null";
+  }
+}
+/*--------------------------------------------------------------------*/
+static void
+value_add_utf8(struct jsonstream_state *state, uint16_t code)
+{
+  if(code < 0x80) {
+    value_add(state, code);
+  } else if(code < 0x800) {
+    value_add(state, 0xc0 | (code >> 6));
+    value_add(state, 0x80 | (code & 0x3f));
+  } else {
+    value_add(state, 0xe0 | (code >> 12));
+    value_add(state, 0x80 | ((code >> 6) & 0x3f));
+    value_add(state, 0x80 | (code & 0x3f));
+  }
+}
+/*--------------------------------------------------------------------*/
+static int
+hex(char c)
+{
+  if(c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if(c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if(c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+/*--------------------------------------------------------------------*/
+static int
+is_number(char c)
+{
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+    c == 'e' || c == 'E';
+}
+/*--------------------------------------------------------------------*/
+/* start of a value where the grammar expects one */
+/*--------------------------------------------------------------------*/
+static int
+value_start(struct jsonstream_state *state, char c)
+{
+  if(top(state) == '[') {
+    path_set_index(state);
+  }
+  switch(c) {
+  case '{':
+    state->expect = EXPECT_KEY_OR_END;
+    return push(state, c);
+  case '[':
+    state->expect = EXPECT_VALUE_OR_END;
+    return push(state, c);
+  case '"':
+    value_begin(state, JSON_TYPE_STRING);
+    state->lex = LEX_STRING;
+    return 0;
+  case 't':
+  case 'f':
+  case 'n':
+    value_begin(state, c);
+    value_add(state, c);
+    state->ucount = 1;
+    state->lex = LEX_LITERAL;
+    return 0;
+  default:
+    if(c == '-' || (c >= '0' && c <= '9')) {
+      value_begin(state, JSON_TYPE_NUMBER);
+      value_add(state, c);
+      state->lex = LEX_NUMBER;
+      return 0;
+    }
+  }
+  return error(state, JSON_ERROR_SYNTAX);
+}
+/*--------------------------------------------------------------------*/
+static int
+string_end(struct jsonstream_state *state)
+{
+  if(state->vtype == JSON_TYPE_PAIR_NAME) {
+    path_set(state, state->value, state->vlen);
+    state->expect = EXPECT_COLON;
+    return JSON_TYPE_PAIR_NAME;
+  }
+  return value_end(state, JSON_TYPE_STRING);
+}
+/*--------------------------------------------------------------------*/
+/* one character of a string, number or literal */
+/*--------------------------------------------------------------------*/
+static int
+atomic(struct jsonstream_state *state, char c)
+{
+  int v;
+
+  switch(state->lex) {
+  case LEX_STRING:
+    if(c == '"') {
+      state->lex = LEX_NONE;
+      return string_end(state);
+    } else if(c == '\\') {
+      state->lex = LEX_ESCAPE;
+    } else if((unsigned char)c < 0x20) {
+      return error(state, JSON_ERROR_SYNTAX);
+    } else {
+      value_add(state, c);
+    }
+    return 0;
+  case LEX_ESCAPE:
+    state->lex = LEX_STRING;
+    switch(c) {
+    case 'b':
+      c = '\b';
+      break;
+    case 'f':
+      c = '\f';
+      break;
+    case 'n':
+      c = '\n';
+      break;
+    case 'r':
+      c = '\r';
+      break;
+    case 't':
+      c = '\t';
+      break;
+    case 'u':
+      state->lex = LEX_UNICODE;
+      state->ucount = 0;
+      state->ucode = 0;
+      return 0;
+    case '"':
+    case '\\':
+    case '/':
+      break;
+    default:
+      return error(state, JSON_ERROR_SYNTAX);
+    }
+    value_add(state, c);
+    return 0;
+  case LEX_UNICODE:
+    if((v = hex(c)) < 0) {
+      return error(state, JSON_ERROR_SYNTAX);
+    }
+    state->ucode = (state->ucode << 4) | v;
+    if(++state->ucount == 4) {
+      value_add_utf8(state, state->ucode);
+      state->lex = LEX_STRING;
+    }
+    return 0;
+  case LEX_LITERAL:
+    if(c != literal(state->vtype)[state->ucount]) {
+      return error(state, JSON_ERROR_SYNTAX);
+    }
+    value_add(state, c);
+    if(literal(state->vtype)[++state->ucount] == 0) {
+      state->lex = LEX_NONE;
+      return value_end(state, state->vtype);
+    }
+    return 0;
+  }
+  return error(state, JSON_ERROR_SYNTAX);
+}
+/*--------------------------------------------------------------------*/
+void
+jsonstream_setup(struct jsonstream_state *state,
+                 jsonstream_callback_t callback, void *ptr)
+{
+  memset(state, 0, sizeof(struct jsonstream_state));
+  state->callback = callback;
+  state->ptr = ptr;
+  state->expect = EXPECT_VALUE;
+  state->lex = LEX_NONE;
+}
+/*--------------------------------------------------------------------*/
+void
+jsonstream_set_input(struct jsonstream_state *state, const char *data,
+                     int len)
+{
+  state->data = data;
+  state->pos = 0;
+  state->len = len;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_next(struct jsonstream_state *state)
+{
+  char c;
+  int type;
+
+  if(state->error) {
+    return JSONSTREAM_ERROR;
+  }
+
+  while(state->pos < state->len) {
+    c = state->data[state->pos];
+
+    if(state->lex == LEX_NUMBER) {
+      if(is_number(c)) {
+        value_add(state, c);
+        state->pos++;
+        continue;
+      }
+      /* the number ends here - leave the character for the grammar */
+      state->lex = LEX_NONE;
+      return value_end(state, JSON_TYPE_NUMBER);
+    }
+
+    state->pos++;
+    if(state->lex != LEX_NONE) {
+      if((type = atomic(state, c)) != 0) {
+        return type;
+      }
+      continue;
+    }
+
+    if(c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+      continue;
+    }
+
+    switch(state->expect) {
+    case EXPECT_VALUE_OR_END:
+      if(c == ']') {
+        pop(state);
+        return value_end(state, c);
+      }
+      /* fall through */
+    case EXPECT_VALUE:
+      if((type = value_start(state, c)) != 0) {
+        return type;
+      }
+      continue;
+    case EXPECT_KEY_OR_END:
+      if(c == '}') {
+        pop(state);
+        return value_end(state, c);
+      }
+      /* fall through */
+    case EXPECT_KEY:
+      if(c == '"') {
+        value_begin(state, JSON_TYPE_PAIR_NAME);
+        state->lex = LEX_STRING;
+        continue;
+      }
+      return error(state, JSON_ERROR_SYNTAX);
+    case EXPECT_COLON:
+      if(c == ':') {
+        state->expect = EXPECT_VALUE;
+        continue;
+      }
+      return error(state, JSON_ERROR_SYNTAX);
+    case EXPECT_COMMA_OR_END:
+      if(c == ',') {
+        if(top(state) == '{') {
+          state->expect = EXPECT_KEY;
+        } else {
+          state->index[state->depth - 1]++;
+          state->expect = EXPECT_VALUE;
+        }
+        continue;
+      }
+      if(c == '}' && top(state) == '{') {
+        pop(state);
+        return value_end(state, c);
+      }
+      if(c == ']' && top(state) == '[') {
+        pop(state);
+        return value_end(state, c);
+      }
+      return error(state, c == ']' ? JSON_ERROR_UNEXPECTED_END_OF_ARRAY :
+                   JSON_ERROR_SYNTAX);
+    default:
+      /* only whitespace may follow the top-level value */
+      return error(state, JSON_ERROR_SYNTAX);
+    }
+  }
+  return JSONSTREAM_MORE;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_feed(struct jsonstream_state *state, const char *data, int len)
+{
+  int type;
+
+  jsonstream_set_input(state, data, len);
+  while((type = jsonstream_next(state)) > 0) {
+    if(state->callback != NULL) {
+      state->callback(state, type);
+    }
+  }
+  return type;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_is_complete(struct jsonstream_state *state)
+{
+  return state->expect == EXPECT_NOTHING && state->error == 0;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_get_type(struct jsonstream_state *state)
+{
+  return state->vtype;
+}
+/*--------------------------------------------------------------------*/
+const char *
+jsonstream_get_value(struct jsonstream_state *state)
+{
+  return state->value;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_get_len(struct jsonstream_state *state)
+{
+  return state->vlen;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_get_value_as_int(struct jsonstream_state *state)
+{
+  if(state->vtype != JSON_TYPE_NUMBER) {
+    return 0;
+  }
+  return atoi(state->value);
+}
+/*--------------------------------------------------------------------*/
+long
+jsonstream_get_value_as_long(struct jsonstream_state *state)
+{
+  if(state->vtype != JSON_TYPE_NUMBER) {
+    return 0;
+  }
+  return atol(state->value);
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_strcmp_value(struct jsonstream_state *state, const char *str)
+{
+  if(state->vtype == 0) {
+    return -1;
+  }
+  return strcmp(str, state->value);
+}
+/*--------------------------------------------------------------------*/
+const char *
+jsonstream_path(struct jsonstream_state *state)
+{
+  if(state->path_overflow) {
+    return NULL;
+  }
+  return state->path;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonstream_path_match(struct jsonstream_state *state, const char *pattern)
+{
+  const char *p;
+
+  if(state->path_overflow) {
+    return 0;
+  }
+  p = state->path;
+  while(*pattern != 0 && *p != 0) {
+    if(*pattern != '/' || *p != '/') {
+      return 0;
+    }
+    pattern++;
+    p++;
+    if(*pattern == '*' && (pattern[1] == '/' || pattern[1] == 0)) {
+      /* wildcard segment */
+      pattern++;
+      while(*p != '/' && *p != 0) {
+        p++;
+      }
+    } else {
+      while(*pattern != '/' && *pattern != 0) {
+        if(*pattern++ != *p++) {
+          return 0;
+        }
+      }
+      if(*p != '/' && *p != 0) {
+        return 0;
+      }
+    }
+  }
+  return *pattern == *p;
+}
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Streaming JSON parser that can be fed a document in chunks
+ */
+
+#ifndef JSONSTREAM_H_
+#define JSONSTREAM_H_
+
+#include "contiki-conf.h"
+#include "json.h"
+#include "jsonparse.h"
+
+/* Max size of a string, number or pair name kept by the parser.
+   Longer values are truncated but the document is still parsed. */
+#ifdef JSONSTREAM_CONF_VALUE_SIZE
+#define JSONSTREAM_VALUE_SIZE JSONSTREAM_CONF_VALUE_SIZE
+#else
+#define JSONSTREAM_VALUE_SIZE 32
+#endif /* JSONSTREAM_CONF_VALUE_SIZE */
+
+/* Max size of the path to the current value, e.g. "/cfg/servers/1/port" */
+#ifdef JSONSTREAM_CONF_PATH_SIZE
+#define JSONSTREAM_PATH_SIZE JSONSTREAM_CONF_PATH_SIZE
+#else
+#define JSONSTREAM_PATH_SIZE 48
+#endif /* JSONSTREAM_CONF_PATH_SIZE */
+
+/* Returned by jsonstream_next() when the current chunk is consumed */
+#define JSONSTREAM_MORE   0
+/* Returned by jsonstream_next() and jsonstream_feed() on a parse error */
+#define JSONSTREAM_ERROR -1
+
+struct jsonstream_state;
+
+typedef void (* jsonstream_callback_t)(struct jsonstream_state *state,
+                                       int type);
+
+struct jsonstream_state {
+  jsonstream_callback_t callback;
+  void *ptr;
+  /* the chunk being parsed */
+  const char *data;
+  int pos;
+  int len;
+  /* grammar and lexer state, kept between chunks */
+  uint8_t expect;
+  uint8_t lex;
+  uint8_t depth;
+  uint8_t ucount;
+  uint16_t ucode;
+  char error;
+  char stack[JSONPARSE_MAX_DEPTH];
+  uint16_t index[JSONPARSE_MAX_DEPTH];
+  /* path to the current value */
+  uint8_t pathpos[JSONPARSE_MAX_DEPTH];
+  uint8_t pathlen;
+  uint8_t path_overflow;
+  char path[JSONSTREAM_PATH_SIZE];
+  /* the current atomic value */
+  char vtype;
+  uint8_t vlen;
+  char value[JSONSTREAM_VALUE_SIZE];
+};
+
+/**
+ * \brief      Initialize a streaming JSON parser state.
+ * \param state    A pointer to a streaming JSON parser state
+ * \param callback Function called for each element by jsonstream_feed(),
+ *                 or NULL when only jsonstream_next() is used
+ * \param ptr      Opaque pointer available to the callback as state->ptr
+ *
+ *             Unlike jsonparse, the streaming parser never needs the
+ *             whole document. It keeps its own copy of the value being
+ *             parsed so a string or number may be split across chunks,
+ *             and the chunks can be discarded as soon as they have
+ *             been fed.
+ */
+void jsonstream_setup(struct jsonstream_state *state,
+                      jsonstream_callback_t callback, void *ptr);
+
+/**
+ * \brief      Set the next chunk of the document for jsonstream_next().
+ * \param state A pointer to a streaming JSON parser state
+ * \param data  The next chunk of the document
+ * \param len   The length of the chunk
+ */
+void jsonstream_set_input(struct jsonstream_state *state, const char *data,
+                          int len);
+
+/**
+ * \brief      Move to the next JSON element in the current chunk.
+ * \param state A pointer to a streaming JSON parser state
+ * \return     The type of the element, JSONSTREAM_MORE when the chunk
+ *             is consumed or JSONSTREAM_ERROR on a parse error.
+ *
+ *             Element types are the ones used by jsonparse:
+ *             JSON_TYPE_OBJECT and JSON_TYPE_ARRAY when a container
+ *             opens, '}' and ']' when it closes, JSON_TYPE_PAIR_NAME
+ *             for a pair name and JSON_TYPE_STRING, JSON_TYPE_NUMBER,
+ *             JSON_TYPE_TRUE, JSON_TYPE_FALSE or JSON_TYPE_NULL for
+ *             atomic values. A number is only reported when the
+ *             character that ends it has been seen.
+ */
+int jsonstream_next(struct jsonstream_state *state);
+
+/**
+ * \brief      Feed a chunk of the document to the parser.
+ * \param state A pointer to a streaming JSON parser state
+ * \param data  The next chunk of the document
+ * \param len   The length of the chunk
+ * \return     0 when the chunk was parsed, JSONSTREAM_ERROR on a parse
+ *             error.
+ *
+ *             The callback given to jsonstream_setup() is called for
+ *             each element found in the chunk.
+ */
+int jsonstream_feed(struct jsonstream_state *state, const char *data,
+                    int len);
+
+/* return non-zero when a complete top-level value has been parsed */
+int jsonstream_is_complete(struct jsonstream_state *state);
+
+/* get the type of the current atomic value */
+int jsonstream_get_type(struct jsonstream_state *state);
+
+/* get the current atomic value as a null terminated (decoded) string */
+const char *jsonstream_get_value(struct jsonstream_state *state);
+
+/* get the length of the current atomic value */
+int jsonstream_get_len(struct jsonstream_state *state);
+
+/* get the current JSON value parsed as an int */
+int jsonstream_get_value_as_int(struct jsonstream_state *state);
+
+/* get the current JSON value parsed as a long */
+long jsonstream_get_value_as_long(struct jsonstream_state *state);
+
+/* compare the JSON value with the specified string */
+int jsonstream_strcmp_value(struct jsonstream_state *state, const char *str);
+
+/**
+ * \brief      Get the path to the current element.
+ * \param state A pointer to a streaming JSON parser state
+ * \return     The path, or NULL if it did not fit in JSONSTREAM_PATH_SIZE
+ *
+ *             The path is made of the pair names and array indexes
+ *             leading to the element, each prefixed by '/', as in
+ *             "/cfg/servers/1/port". The top-level value has the
+ *             empty path.
+ */
+const char *jsonstream_path(struct jsonstream_state *state);
+
+/**
+ * \brief      Match the path to the current element against a pattern.
+ * \param state   A pointer to a streaming JSON parser state
+ * \param pattern The path to match, where a "*" segment matches any
+ *                single pair name or array index
+ * \return     Non-zero if the path matches
+ */
+int jsonstream_path_match(struct jsonstream_state *state,
+                          const char *pattern);
+
+#endif /* JSONSTREAM_H_ */
@@ -59,6 +59,10 @@
 #include "lib/list.h"
 #include "sys/cc.h"
 
+#if MQTT_PERSISTENCE
+#include "cfs/cfs.h"
+#endif /* MQTT_PERSISTENCE */
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -165,6 +169,7 @@ static process_event_t mqtt_do_subscribe_event;
 static process_event_t mqtt_do_unsubscribe_event;
 static process_event_t mqtt_do_publish_event;
 static process_event_t mqtt_do_pingreq_event;
+static process_event_t mqtt_do_inflight_event;
 static process_event_t mqtt_continue_send_event;
 static process_event_t mqtt_abort_now_event;
 process_event_t mqtt_update_event;
@@ -209,17 +214,32 @@ reset_defaults(struct mqtt_connection *conn)
 
   reset_packet(&conn->in_packet);
   conn->out_buffer_sent = 0;
+  conn->out_buffer_queued = 0;
 }
 /*---------------------------------------------------------------------------*/
 static void
 abort_connection(struct mqtt_connection *conn)
 {
   conn->out_buffer_ptr = conn->out_buffer;
+  conn->out_buffer_queued = 0;
+  conn->out_refs_pending = 0;
   conn->out_queue_full = 0;
 
   /* Reset outgoing packet */
   memset(&conn->out_packet, 0, sizeof(conn->out_packet));
 
+  ctimer_stop(&conn->inflight_timer);
+#if MQTT_PERSISTENCE
+  /* Keep the in-flight messages, they are sent again after reconnecting */
+  if(conn->inflight_fd >= 0) {
+    cfs_close(conn->inflight_fd);
+    conn->inflight_fd = -1;
+  }
+#else /* MQTT_PERSISTENCE */
+  memset(conn->inflight, 0, sizeof(conn->inflight));
+  conn->inflight_count = 0;
+#endif /* MQTT_PERSISTENCE */
+
   tcp_socket_close(&conn->socket);
   tcp_socket_unregister(&conn->socket);
 
@@ -255,11 +275,21 @@ disconnect_tcp(struct mqtt_connection *conn)
   memset(&conn->socket, 0, sizeof(conn->socket));
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Hands the bytes written since the last call to the socket. The socket uses
+ * out_buffer as its output buffer, so this appends to data that may still be
+ * in flight and the packets are sent together in the next segment.
+ */
 static void
 send_out_buffer(struct mqtt_connection *conn)
 {
-  if(conn->out_buffer_ptr - conn->out_buffer == 0) {
-    conn->out_buffer_sent = 1;
+  uint16_t len;
+
+  len = conn->out_buffer_ptr - conn->out_buffer - conn->out_buffer_queued;
+  if(len == 0) {
+    if(tcp_socket_queuelen(&conn->socket) == 0) {
+      conn->out_buffer_sent = 1;
+    }
     return;
   }
   conn->out_buffer_sent = 0;
@@ -267,8 +297,9 @@ send_out_buffer(struct mqtt_connection *conn)
   DBG("MQTT - (send_out_buffer) Space used in buffer: %i\n",
       conn->out_buffer_ptr - conn->out_buffer);
 
-  tcp_socket_send(&conn->socket, conn->out_buffer,
-                  conn->out_buffer_ptr - conn->out_buffer);
+  tcp_socket_send(&conn->socket, &conn->out_buffer[conn->out_buffer_queued],
+                  len);
+  conn->out_buffer_queued += len;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -452,9 +483,12 @@ PT_THREAD(connect_pt(struct pt *pt, struct mqtt_connection *conn))
 
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
-  /* Wait for CONNACK */
+  /*
+   * Wait for CONNACK. The application may publish or subscribe as soon as
+   * it is reported, which sets up out_packet again, so wait for the state.
+   */
   reset_packet(&conn->in_packet);
-  PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
+  PT_WAIT_UNTIL(pt, conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER ||
                 timer_expired(&conn->t));
   if(timer_expired(&conn->t)) {
     DBG("Timeout waiting for CONNACK\n");
@@ -530,7 +564,7 @@ PT_THREAD(subscribe_pt(struct pt *pt, struct mqtt_connection *conn))
                       conn->out_packet.remaining_length_enc,
                       conn->out_packet.remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
+  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
   /* Write Payload */
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
@@ -592,7 +626,7 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.remaining_length_enc,
                       conn->out_packet.remaining_length_enc_bytes);
   /* Write Variable Header */
-  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
+  PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
   /* Write Payload */
   PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.topic_length >> 8));
@@ -665,48 +699,124 @@ PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_MQTT_WRITE_BYTES(conn, (uint8_t *)conn->out_packet.topic,
                       conn->out_packet.topic_length);
   if(conn->out_packet.qos > MQTT_QOS_LEVEL_0) {
-    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid << 8));
+    PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid >> 8));
     PT_MQTT_WRITE_BYTE(conn, (conn->out_packet.mid & 0x00FF));
   }
   /* Write Payload */
-  PT_MQTT_WRITE_BYTES(conn,
-                      conn->out_packet.payload,
-                      conn->out_packet.payload_size);
+  if(conn->out_packet.gather == NULL) {
+    PT_MQTT_WRITE_BYTES(conn,
+                        conn->out_packet.payload,
+                        conn->out_packet.payload_size);
+  } else {
+    /* Hand the headers to the socket first, the parts are sent after them */
+    send_out_buffer(conn);
+    for(conn->out_gather_pos = 0;
+        conn->out_gather_pos < conn->out_packet.gather_count;
+        conn->out_gather_pos++) {
+      if(conn->out_packet.gather[conn->out_gather_pos].len == 0) {
+        continue;
+      }
+      if(tcp_socket_send_ref(&conn->socket,
+                             conn->out_packet.gather[conn->out_gather_pos].data,
+                             conn->out_packet.gather[conn->out_gather_pos].len)
+         > 0) {
+        conn->out_refs_pending = 1;
+        conn->out_buffer_sent = 0;
+      } else {
+        /* No free reference in the socket, copy this part */
+        PT_MQTT_WRITE_BYTES(conn,
+                            (uint8_t *)conn->out_packet.gather[conn->out_gather_pos].data,
+                            conn->out_packet.gather[conn->out_gather_pos].len);
+        send_out_buffer(conn);
+      }
+    }
+  }
 
   send_out_buffer(conn);
-  timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /*
-   * If QoS is zero then wait until the message has been sent, since there is
-   * no ACK to wait for.
-   *
-   * Also notify the app will not be notified via PUBACK or PUBCOMP
+   * Do not wait for PUBACK or PUBREC here. QoS 1 and 2 messages are tracked
+   * in the in-flight table and the acknowledgements are handled as they
+   * arrive, so the next message can be written while this one is in flight.
+   * The payload has been copied, so the app may reuse it already. Payload
+   * parts that the socket references are released on TCP_SOCKET_DATA_SENT.
    */
-  if(conn->out_packet.qos == 0) {
+  if(!conn->out_refs_pending) {
+    conn->out_queue_full = 0;
     process_post(conn->app_process, mqtt_update_event, NULL);
-  } else if(conn->out_packet.qos == 1) {
-    /* Wait for PUBACK */
-    reset_packet(&conn->in_packet);
-    PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
-                  timer_expired(&conn->t));
-    if(timer_expired(&conn->t)) {
-      DBG("Timeout waiting for PUBACK\n");
-    }
-    if(conn->in_packet.mid != conn->out_packet.mid) {
-      DBG("MQTT - Warning, got PUBACK with none matching MID. Currently there "
-          "is no support for several concurrent PUBLISH messages.\n");
-    }
-  } else if(conn->out_packet.qos == 2) {
-    DBG("MQTT - QoS not implemented yet.\n");
-    /* Should wait for PUBREC, send PUBREL and then wait for PUBCOMP */
   }
 
-  reset_packet(&conn->in_packet);
+  DBG("MQTT - Publish Enqueued\n");
 
-  /* This is clear after the entire transaction is complete */
-  conn->out_queue_full = 0;
+  PT_END(pt);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends PUBREL for QoS 2 messages that got PUBREC and, after reconnecting,
+ * sends the stored copies of un-acknowledged messages again.
+ */
+static
+PT_THREAD(inflight_pt(struct pt *pt, struct mqtt_connection *conn))
+{
+#if MQTT_PERSISTENCE
+  char name[16];
+  int len;
+#endif /* MQTT_PERSISTENCE */
 
-  DBG("MQTT - Publish Enqueued\n");
+  PT_BEGIN(pt);
+
+  for(conn->inflight_pos = 0; conn->inflight_pos < MQTT_INFLIGHT_WINDOW;
+      conn->inflight_pos++) {
+    if(conn->inflight[conn->inflight_pos].mid == 0) {
+      continue;
+    }
+    if(conn->inflight[conn->inflight_pos].qos_state == MQTT_QOS_STATE_GOT_REC) {
+      DBG("MQTT - Sending PUBREL %u\n", conn->inflight[conn->inflight_pos].mid);
+      PT_MQTT_WRITE_BYTE(conn, MQTT_FHDR_MSG_TYPE_PUBREL |
+                         MQTT_FHDR_QOS_LEVEL_1);
+      PT_MQTT_WRITE_BYTE(conn, MQTT_MID_SIZE);
+      PT_MQTT_WRITE_BYTE(conn, conn->inflight[conn->inflight_pos].mid >> 8);
+      PT_MQTT_WRITE_BYTE(conn, conn->inflight[conn->inflight_pos].mid & 0x00FF);
+      conn->inflight[conn->inflight_pos].qos_state = MQTT_QOS_STATE_SENT_REL;
+      conn->inflight[conn->inflight_pos].sent = clock_time();
+    }
+#if MQTT_PERSISTENCE
+    else if(conn->inflight[conn->inflight_pos].resend) {
+      DBG("MQTT - Sending PUBLISH %u again\n",
+          conn->inflight[conn->inflight_pos].mid);
+      conn->inflight[conn->inflight_pos].sent = clock_time();
+      snprintf(name, sizeof(name), MQTT_PERSISTENCE_NAME, conn->inflight_pos);
+      conn->inflight_fd = cfs_open(name, CFS_READ);
+      if(conn->inflight_fd < 0) {
+        conn->inflight[conn->inflight_pos].resend = 0;
+        continue;
+      }
+      /* Read the stored packet straight into the output buffer */
+      while(1) {
+        if(conn->out_buffer_ptr ==
+           &conn->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE]) {
+          send_out_buffer(conn);
+          PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+        }
+        len = cfs_read(conn->inflight_fd, conn->out_buffer_ptr,
+                       &conn->out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE] -
+                       conn->out_buffer_ptr);
+        if(len <= 0) {
+          break;
+        }
+        if(conn->inflight[conn->inflight_pos].resend) {
+          *conn->out_buffer_ptr |= MQTT_FHDR_DUP_FLAG;
+          conn->inflight[conn->inflight_pos].resend = 0;
+        }
+        conn->out_buffer_ptr += len;
+      }
+      cfs_close(conn->inflight_fd);
+      conn->inflight_fd = -1;
+    }
+#endif /* MQTT_PERSISTENCE */
+  }
+
+  send_out_buffer(conn);
 
   PT_END(pt);
 }
@@ -740,9 +850,265 @@ PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+static struct mqtt_inflight *
+inflight_lookup(struct mqtt_connection *conn, uint16_t mid)
+{
+  int i;
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    if(conn->inflight[i].mid == mid && mid != 0) {
+      return &conn->inflight[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+inflight_free(struct mqtt_connection *conn, struct mqtt_inflight *slot)
+{
+#if MQTT_PERSISTENCE
+  char name[16];
+  snprintf(name, sizeof(name), MQTT_PERSISTENCE_NAME,
+           (unsigned)(slot - conn->inflight));
+  cfs_remove(name);
+#endif /* MQTT_PERSISTENCE */
+  slot->mid = 0;
+  conn->inflight_count--;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * One pass of inflight_pt() handles all slots, so the acknowledgements of a
+ * full window do not each need an event in the queue.
+ */
+static void
+inflight_post(struct mqtt_connection *conn)
+{
+  if(!conn->inflight_posted &&
+     process_post(&mqtt_process, mqtt_do_inflight_event, conn) ==
+     PROCESS_ERR_OK) {
+    conn->inflight_posted = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends PUBREL, or a stored PUBLISH, again when its acknowledgement is late,
+ * and gives the message up after MQTT_INFLIGHT_RETRIES attempts.
+ */
+static void
+inflight_check(void *ptr)
+{
+  struct mqtt_connection *conn = ptr;
+  struct mqtt_inflight *slot;
+  uint16_t mid;
+  uint8_t resend = 0;
+  int i;
+
+  if(conn->state != MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+    /* Started again by handle_connack() */
+    return;
+  }
+
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    slot = &conn->inflight[i];
+    if(slot->mid == 0 ||
+       (clock_time_t)(clock_time() - slot->sent) <
+       (clock_time_t)MQTT_INFLIGHT_TIMEOUT * CLOCK_SECOND) {
+      continue;
+    }
+    if(slot->retries >= MQTT_INFLIGHT_RETRIES ||
+       (!MQTT_PERSISTENCE && slot->qos_state == MQTT_QOS_STATE_NO_ACK)) {
+      /* Without persistence, the payload of a PUBLISH is not kept */
+      mid = slot->mid;
+      PRINTF("MQTT - No acknowledgement for message %u\n", mid);
+      inflight_free(conn, slot);
+      call_event(conn, MQTT_EVENT_PUBACK_TIMEOUT, &mid);
+      continue;
+    }
+    slot->retries++;
+    slot->sent = clock_time();
+    if(slot->qos_state == MQTT_QOS_STATE_NO_ACK) {
+      slot->resend = 1;
+    } else {
+      slot->qos_state = MQTT_QOS_STATE_GOT_REC;
+    }
+    resend = 1;
+  }
+
+  if(resend) {
+    /* Not inflight_post(), this also recovers from a lost event */
+    process_post(&mqtt_process, mqtt_do_inflight_event, conn);
+  }
+  if(conn->inflight_count > 0) {
+    ctimer_reset(&conn->inflight_timer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+inflight_timer_start(struct mqtt_connection *conn)
+{
+  if(ctimer_expired(&conn->inflight_timer)) {
+    ctimer_set(&conn->inflight_timer, MQTT_INFLIGHT_TIMEOUT * CLOCK_SECOND,
+               inflight_check, conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if MQTT_PERSISTENCE
+/*
+ * Stores the PUBLISH packet in out_packet as it is sent on the wire, so that
+ * it can be copied back into the output buffer when sending it again.
+ */
+static void
+persistence_store(struct mqtt_connection *conn, int index)
+{
+  char name[16];
+  uint8_t hdr[MQTT_FHDR_SIZE + MQTT_MAX_REMAINING_LENGTH_BYTES];
+  uint8_t remaining_length_bytes;
+  uint8_t len[MQTT_STRING_LEN_SIZE];
+  int fd, ok, i;
+
+  snprintf(name, sizeof(name), MQTT_PERSISTENCE_NAME, index);
+  cfs_remove(name);
+  fd = cfs_open(name, CFS_WRITE);
+  if(fd < 0) {
+    PRINTF("MQTT - Could not store message %u\n", conn->out_packet.mid);
+    return;
+  }
+
+  hdr[0] = MQTT_FHDR_MSG_TYPE_PUBLISH | conn->out_packet.qos << 1;
+  if(conn->out_packet.retain == MQTT_RETAIN_ON) {
+    hdr[0] |= MQTT_FHDR_RETAIN_FLAG;
+  }
+  encode_remaining_length(&hdr[MQTT_FHDR_SIZE], &remaining_length_bytes,
+                          MQTT_STRING_LEN_SIZE + conn->out_packet.topic_length +
+                          MQTT_MID_SIZE + conn->out_packet.payload_size);
+  len[0] = conn->out_packet.topic_length >> 8;
+  len[1] = conn->out_packet.topic_length & 0x00FF;
+
+  ok = cfs_write(fd, hdr, MQTT_FHDR_SIZE + remaining_length_bytes) ==
+    MQTT_FHDR_SIZE + remaining_length_bytes;
+  ok = ok && cfs_write(fd, len, sizeof(len)) == sizeof(len);
+  ok = ok && cfs_write(fd, conn->out_packet.topic,
+                       conn->out_packet.topic_length) ==
+    conn->out_packet.topic_length;
+  len[0] = conn->out_packet.mid >> 8;
+  len[1] = conn->out_packet.mid & 0x00FF;
+  ok = ok && cfs_write(fd, len, sizeof(len)) == sizeof(len);
+  if(conn->out_packet.gather == NULL) {
+    ok = ok && cfs_write(fd, conn->out_packet.payload,
+                         conn->out_packet.payload_size) ==
+      conn->out_packet.payload_size;
+  } else {
+    for(i = 0; i < conn->out_packet.gather_count; i++) {
+      ok = ok && cfs_write(fd, (void *)conn->out_packet.gather[i].data,
+                           conn->out_packet.gather[i].len) ==
+        conn->out_packet.gather[i].len;
+    }
+  }
+  cfs_close(fd);
+
+  if(!ok) {
+    PRINTF("MQTT - Could not store message %u\n", conn->out_packet.mid);
+    cfs_remove(name);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Replaces the stored PUBLISH of a QoS 2 message that got PUBREC with the
+ * PUBREL that is still to be acknowledged.
+ */
+static void
+persistence_store_rel(struct mqtt_connection *conn, int index)
+{
+  char name[16];
+  uint8_t buf[MQTT_FHDR_SIZE + 1 + MQTT_MID_SIZE];
+  int fd, ok;
+
+  snprintf(name, sizeof(name), MQTT_PERSISTENCE_NAME, index);
+  cfs_remove(name);
+  fd = cfs_open(name, CFS_WRITE);
+  if(fd < 0) {
+    PRINTF("MQTT - Could not store PUBREL %u\n", conn->inflight[index].mid);
+    return;
+  }
+  buf[0] = MQTT_FHDR_MSG_TYPE_PUBREL | MQTT_FHDR_QOS_LEVEL_1;
+  buf[1] = MQTT_MID_SIZE;
+  buf[2] = conn->inflight[index].mid >> 8;
+  buf[3] = conn->inflight[index].mid & 0x00FF;
+  ok = cfs_write(fd, buf, sizeof(buf)) == sizeof(buf);
+  cfs_close(fd);
+
+  if(!ok) {
+    PRINTF("MQTT - Could not store PUBREL %u\n", conn->inflight[index].mid);
+    cfs_remove(name);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Restores the in-flight table from messages stored before a reboot */
+static void
+persistence_load(struct mqtt_connection *conn)
+{
+  char name[16];
+  uint8_t fhdr;
+  uint8_t buf[2];
+  uint16_t topic_length;
+  int fd, i, ok;
+
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    snprintf(name, sizeof(name), MQTT_PERSISTENCE_NAME, i);
+    fd = cfs_open(name, CFS_READ);
+    if(fd < 0) {
+      continue;
+    }
+    /* Fixed header, remaining length, the topic of a PUBLISH, message ID */
+    ok = cfs_read(fd, &fhdr, 1) == 1;
+    do {
+      ok = ok && cfs_read(fd, buf, 1) == 1;
+    } while(ok && (buf[0] & 0x80));
+    if(ok && (fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH) {
+      ok = cfs_read(fd, buf, 2) == 2;
+      topic_length = (buf[0] << 8) | buf[1];
+      ok = ok &&
+        cfs_seek(fd, topic_length, CFS_SEEK_CUR) != (cfs_offset_t)-1;
+    }
+    ok = ok && cfs_read(fd, buf, 2) == 2;
+    cfs_close(fd);
+
+    if(ok && (fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH &&
+       ((fhdr >> 1) & 0x03) != MQTT_QOS_LEVEL_0) {
+      conn->inflight[i].qos = (fhdr >> 1) & 0x03;
+      conn->inflight[i].qos_state = MQTT_QOS_STATE_NO_ACK;
+      conn->inflight[i].resend = 1;
+    } else if(ok && (fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBREL) {
+      conn->inflight[i].qos = MQTT_QOS_LEVEL_2;
+      conn->inflight[i].qos_state = MQTT_QOS_STATE_SENT_REL;
+      conn->inflight[i].resend = 0;
+    } else {
+      cfs_remove(name);
+      continue;
+    }
+    conn->inflight[i].mid = (buf[0] << 8) | buf[1];
+    conn->inflight_count++;
+    if(conn->inflight[i].mid > conn->mid_counter) {
+      conn->mid_counter = conn->inflight[i].mid | 1;
+    }
+    DBG("MQTT - Restored message %u\n", conn->inflight[i].mid);
+  }
+}
+#endif /* MQTT_PERSISTENCE */
+/*---------------------------------------------------------------------------*/
+static uint16_t
+next_mid(struct mqtt_connection *conn)
+{
+  do {
+    INCREMENT_MID(conn);
+  } while(inflight_lookup(conn, conn->mid_counter) != NULL);
+  return conn->mid_counter;
+}
+/*---------------------------------------------------------------------------*/
 static void
 handle_connack(struct mqtt_connection *conn)
 {
+  int i;
+
   DBG("MQTT - Got CONNACK\n");
 
   if(conn->in_packet.payload[1] != 0) {
@@ -760,6 +1126,26 @@ handle_connack(struct mqtt_connection *conn)
 
   /* Always reset packet before callback since it might be used directly */
   conn->state = MQTT_CONN_STATE_CONNECTED_TO_BROKER;
+
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    conn->inflight[i].sent = clock_time();
+    conn->inflight[i].retries = 0;
+#if MQTT_PERSISTENCE
+    /* Continue the exchanges that did not complete before the reconnect */
+    if(conn->inflight[i].qos_state == MQTT_QOS_STATE_NO_ACK) {
+      conn->inflight[i].resend = 1;
+    } else if(conn->inflight[i].qos_state == MQTT_QOS_STATE_SENT_REL) {
+      conn->inflight[i].qos_state = MQTT_QOS_STATE_GOT_REC;
+    }
+#endif /* MQTT_PERSISTENCE */
+  }
+  if(conn->inflight_count > 0) {
+#if MQTT_PERSISTENCE
+    inflight_post(conn);
+#endif /* MQTT_PERSISTENCE */
+    inflight_timer_start(conn);
+  }
+
   call_event(conn, MQTT_EVENT_CONNECTED, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -818,12 +1204,73 @@ handle_unsuback(struct mqtt_connection *conn)
 static void
 handle_puback(struct mqtt_connection *conn)
 {
+  struct mqtt_inflight *slot;
+
   DBG("MQTT - Got PUBACK\n");
 
-  conn->out_packet.qos_state = MQTT_QOS_STATE_GOT_ACK;
   conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
     (conn->in_packet.payload[1]);
 
+  slot = inflight_lookup(conn, conn->in_packet.mid);
+  if(slot == NULL || slot->qos != MQTT_QOS_LEVEL_1) {
+    DBG("MQTT - Warning, got PUBACK for unknown MID %u\n",
+        conn->in_packet.mid);
+    return;
+  }
+  inflight_free(conn, slot);
+
+  call_event(conn, MQTT_EVENT_PUBACK, &conn->in_packet.mid);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pubrec(struct mqtt_connection *conn)
+{
+  struct mqtt_inflight *slot;
+
+  DBG("MQTT - Got PUBREC\n");
+
+  conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
+    (conn->in_packet.payload[1]);
+
+  slot = inflight_lookup(conn, conn->in_packet.mid);
+  if(slot == NULL || slot->qos != MQTT_QOS_LEVEL_2) {
+    DBG("MQTT - Warning, got PUBREC for unknown MID %u\n",
+        conn->in_packet.mid);
+    return;
+  }
+  if(slot->qos_state == MQTT_QOS_STATE_NO_ACK) {
+#if MQTT_PERSISTENCE
+    /* The broker owns the message now, only the PUBREL is left to send */
+    persistence_store_rel(conn, slot - conn->inflight);
+    slot->resend = 0;
+#endif /* MQTT_PERSISTENCE */
+    slot->qos_state = MQTT_QOS_STATE_GOT_REC;
+    slot->retries = 0;
+  } else if(slot->qos_state == MQTT_QOS_STATE_SENT_REL) {
+    /* PUBREC sent again, answer with PUBREL again */
+    slot->qos_state = MQTT_QOS_STATE_GOT_REC;
+  }
+  inflight_post(conn);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pubcomp(struct mqtt_connection *conn)
+{
+  struct mqtt_inflight *slot;
+
+  DBG("MQTT - Got PUBCOMP\n");
+
+  conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
+    (conn->in_packet.payload[1]);
+
+  slot = inflight_lookup(conn, conn->in_packet.mid);
+  if(slot == NULL || slot->qos_state != MQTT_QOS_STATE_SENT_REL) {
+    DBG("MQTT - Warning, got PUBCOMP for unknown MID %u\n",
+        conn->in_packet.mid);
+    return;
+  }
+  inflight_free(conn, slot);
+
   call_event(conn, MQTT_EVENT_PUBACK, &conn->in_packet.mid);
 }
 /*---------------------------------------------------------------------------*/
@@ -907,21 +1354,20 @@ parse_publish_vhdr(struct mqtt_connection *conn,
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Reads one packet, or as much of it as there is. Returns the number of
+ * bytes used, the rest belongs to the packets that follow.
+ */
 static int
-tcp_input(struct tcp_socket *s,
-          void *ptr,
-          const uint8_t *input_data_ptr,
-          int input_data_len)
+input_packet(struct mqtt_connection *conn,
+             const uint8_t *input_data_ptr,
+             int input_data_len)
 {
-  struct mqtt_connection *conn = ptr;
   uint32_t pos = 0;
   uint32_t copy_bytes = 0;
+  uint32_t end;
   uint8_t byte;
 
-  if(input_data_len == 0) {
-    return 0;
-  }
-
   if(conn->in_packet.packet_received) {
     reset_packet(&conn->in_packet);
   }
@@ -936,7 +1382,7 @@ tcp_input(struct tcp_socket *s,
     DBG("MQTT - Read VHDR '%02X'\n", conn->in_packet.fhdr);
 
     if(pos >= input_data_len) {
-      return 0;
+      return pos;
     }
   }
 
@@ -944,7 +1390,7 @@ tcp_input(struct tcp_socket *s,
   if(!conn->in_packet.has_remaining_length) {
     do {
       if(pos >= input_data_len) {
-        return 0;
+        return pos;
       }
 
       byte = input_data_ptr[pos++];
@@ -955,7 +1401,7 @@ tcp_input(struct tcp_socket *s,
       if(conn->in_packet.byte_counter > 5) {
         call_event(conn, MQTT_EVENT_ERROR, NULL);
         DBG("Received more then 4 byte 'remaining lenght'.");
-        return 0;
+        return input_data_len;
       }
 
       conn->in_packet.remaining_length +=
@@ -967,6 +1413,10 @@ tcp_input(struct tcp_socket *s,
     conn->in_packet.has_remaining_length = 1;
   }
 
+  /* Bytes of the whole packet, counted like byte_counter */
+  end = MQTT_FHDR_SIZE + conn->in_packet.remaining_length_bytes +
+    conn->in_packet.remaining_length;
+
   /*
    * Check for unsupported payload length. Will read all incoming data from the
    * server in any case and then reset the packet.
@@ -978,12 +1428,14 @@ tcp_input(struct tcp_socket *s,
 
     PRINTF("MQTT - Error, unsupported payload size for non-PUBLISH message\n");
 
-    conn->in_packet.byte_counter += input_data_len;
-    if(conn->in_packet.byte_counter >=
-       (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
+    copy_bytes = MIN(input_data_len - pos,
+                     end - conn->in_packet.byte_counter);
+    conn->in_packet.byte_counter += copy_bytes;
+    pos += copy_bytes;
+    if(conn->in_packet.byte_counter >= end) {
       conn->in_packet.packet_received = 1;
     }
-    return 0;
+    return pos;
   }
 
   /*
@@ -992,16 +1444,16 @@ tcp_input(struct tcp_socket *s,
    * Note: There will always be at least one byte left to read when we enter
    *       this loop.
    */
-  while(conn->in_packet.byte_counter <
-        (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
+  while(conn->in_packet.byte_counter < end) {
 
     if((conn->in_packet.fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH &&
        conn->in_packet.topic_received == 0) {
       parse_publish_vhdr(conn, &pos, input_data_ptr, input_data_len);
     }
 
-    /* Read in as much as we can into the packet payload */
-    copy_bytes = MIN(input_data_len - pos,
+    /* Read in as much of this packet as we can into the packet payload */
+    copy_bytes = MIN(MIN(input_data_len - pos,
+                         end - conn->in_packet.byte_counter),
                      MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos);
     DBG("- Copied %lu payload bytes\n", copy_bytes);
     memcpy(&conn->in_packet.payload[conn->in_packet.payload_pos],
@@ -1018,8 +1470,12 @@ tcp_input(struct tcp_socket *s,
     }
     DBG("\n");
 
-    /* Full buffer, shall only happen to PUBLISH messages. */
-    if(MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos == 0) {
+    /*
+     * Full buffer, shall only happen to PUBLISH messages. The last chunk is
+     * handled below, with the other packets.
+     */
+    if(MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos == 0 &&
+       conn->in_packet.byte_counter < end) {
       conn->in_publish_msg.payload_chunk = conn->in_packet.payload;
       conn->in_publish_msg.payload_chunk_length = MQTT_INPUT_BUFF_SIZE;
       conn->in_publish_msg.payload_left -= MQTT_INPUT_BUFF_SIZE;
@@ -1030,9 +1486,8 @@ tcp_input(struct tcp_socket *s,
       conn->in_packet.payload_pos = 0;
     }
 
-    if(pos >= input_data_len &&
-       (conn->in_packet.byte_counter < (MQTT_FHDR_SIZE + conn->in_packet.remaining_length))) {
-      return 0;
+    if(pos >= input_data_len && conn->in_packet.byte_counter < end) {
+      return pos;
     }
   }
 
@@ -1059,6 +1514,12 @@ tcp_input(struct tcp_socket *s,
   case MQTT_FHDR_MSG_TYPE_PUBACK:
     handle_puback(conn);
     break;
+  case MQTT_FHDR_MSG_TYPE_PUBREC:
+    handle_pubrec(conn);
+    break;
+  case MQTT_FHDR_MSG_TYPE_PUBCOMP:
+    handle_pubcomp(conn);
+    break;
   case MQTT_FHDR_MSG_TYPE_SUBACK:
     handle_suback(conn);
     break;
@@ -1069,10 +1530,8 @@ tcp_input(struct tcp_socket *s,
     handle_pingresp(conn);
     break;
 
-  /* QoS 2 not implemented yet */
-  case MQTT_FHDR_MSG_TYPE_PUBREC:
+  /* QoS 2 is not implemented for incoming PUBLISH messages */
   case MQTT_FHDR_MSG_TYPE_PUBREL:
-  case MQTT_FHDR_MSG_TYPE_PUBCOMP:
     call_event(conn, MQTT_EVENT_NOT_IMPLEMENTED_ERROR, NULL);
     PRINTF("MQTT - Got unhandled MQTT Message Type '%i'",
            (conn->in_packet.fhdr & 0xF0));
@@ -1086,6 +1545,24 @@ tcp_input(struct tcp_socket *s,
 
   conn->in_packet.packet_received = 1;
 
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+tcp_input(struct tcp_socket *s,
+          void *ptr,
+          const uint8_t *input_data_ptr,
+          int input_data_len)
+{
+  struct mqtt_connection *conn = ptr;
+  int pos = 0;
+
+  /* A segment can hold several packets, e.g. acknowledgements of the
+     messages in flight */
+  while(pos < input_data_len) {
+    pos += input_packet(conn, input_data_ptr + pos, input_data_len - pos);
+  }
+
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -1096,6 +1573,7 @@ static void
 tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
 {
   struct mqtt_connection *conn = ptr;
+  uint16_t shift;
 
   /* Take care of event */
   switch(event) {
@@ -1128,9 +1606,24 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
   case TCP_SOCKET_DATA_SENT: {
     DBG("MQTT - Got TCP_DATA_SENT\n");
 
-    if(conn->socket.output_data_len == 0) {
+    /*
+     * The socket has moved the data that is left down over the acknowledged
+     * bytes. Nothing is written after the last send_out_buffer() at this
+     * point, the protothreads hand what they wrote to the socket before they
+     * wait.
+     */
+    shift = conn->out_buffer_queued - conn->socket.output_data_len;
+    conn->out_buffer_queued -= shift;
+    conn->out_buffer_ptr -= shift;
+    if(tcp_socket_queuelen(&conn->socket) == 0) {
       conn->out_buffer_sent = 1;
-      conn->out_buffer_ptr = conn->out_buffer;
+    }
+
+    /* The socket no longer references the payload of a gather publish */
+    if(conn->out_refs_pending && conn->socket.output_refs_count == 0) {
+      conn->out_refs_pending = 0;
+      conn->out_queue_full = 0;
+      process_post(conn->app_process, mqtt_update_event, NULL);
     }
 
     ctimer_restart(&conn->keep_alive_timer);
@@ -1214,8 +1707,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_subscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* Packets are appended to the output buffer even if data is in flight */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(subscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED &&
               conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
@@ -1227,8 +1720,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_unsubscribe_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* Packets are appended to the output buffer even if data is in flight */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(unsubscribe_pt(&conn->out_proto_thread, conn) < PT_EXITED &&
               conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
@@ -1240,8 +1733,8 @@ PROCESS_THREAD(mqtt_process, ev, data)
       conn = data;
       DBG("MQTT - Got mqtt_do_publish_mqtt_event!\n");
 
-      if(conn->out_buffer_sent == 1 &&
-         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+      /* Packets are appended to the output buffer even if data is in flight */
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
         PT_INIT(&conn->out_proto_thread);
         while(publish_pt(&conn->out_proto_thread, conn) < PT_EXITED &&
               conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
@@ -1249,6 +1742,19 @@ PROCESS_THREAD(mqtt_process, ev, data)
         }
       }
     }
+    if(ev == mqtt_do_inflight_event) {
+      conn = data;
+      conn->inflight_posted = 0;
+      DBG("MQTT - Got mqtt_do_inflight_event!\n");
+
+      if(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+        PT_INIT(&conn->out_proto_thread);
+        while(inflight_pt(&conn->out_proto_thread, conn) < PT_EXITED &&
+              conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+          PT_MQTT_WAIT_SEND();
+        }
+      }
+    }
   }
   PROCESS_END();
 }
@@ -1267,6 +1773,7 @@ mqtt_init(void)
     mqtt_do_unsubscribe_event = process_alloc_event();
     mqtt_do_publish_event = process_alloc_event();
     mqtt_do_pingreq_event = process_alloc_event();
+    mqtt_do_inflight_event = process_alloc_event();
     mqtt_update_event = process_alloc_event();
     mqtt_abort_now_event = process_alloc_event();
     mqtt_event_max = mqtt_abort_now_event;
@@ -1296,6 +1803,10 @@ mqtt_register(struct mqtt_connection *conn, struct process *app_process,
   conn->auto_reconnect = 1;
   conn->max_segment_size = max_segment_size;
   reset_defaults(conn);
+#if MQTT_PERSISTENCE
+  conn->inflight_fd = -1;
+  persistence_load(conn);
+#endif /* MQTT_PERSISTENCE */
 
   mqtt_init();
   list_add(mqtt_conn_list, conn);
@@ -1328,7 +1839,12 @@ mqtt_connect(struct mqtt_connection *conn, char *host, uint16_t port,
   conn->server_port = port;
   conn->out_buffer_ptr = conn->out_buffer;
   conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
+#if MQTT_PERSISTENCE
+  /* Ask the broker to keep the session the stored messages belong to */
+  conn->connect_vhdr_flags &= ~MQTT_VHDR_CLEAN_SESSION_FLAG;
+#else /* MQTT_PERSISTENCE */
   conn->connect_vhdr_flags |= MQTT_VHDR_CLEAN_SESSION_FLAG;
+#endif /* MQTT_PERSISTENCE */
 
   /* convert the string IPv6 address to a numeric IPv6 address */
   uiplib_ip6addrconv(host, &ip6addr);
@@ -1410,38 +1926,97 @@ mqtt_unsubscribe(struct mqtt_connection *conn, uint16_t *mid, char *topic)
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
-mqtt_status_t
-mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
-             uint8_t *payload, uint32_t payload_size,
-             mqtt_qos_level_t qos_level, mqtt_retain_t retain)
+static mqtt_status_t
+publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+        uint8_t *payload, uint32_t payload_size,
+        const struct mqtt_gather *gather, uint8_t gather_count,
+        mqtt_qos_level_t qos_level, mqtt_retain_t retain)
 {
+  int i;
+
   if(conn->state != MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
     return MQTT_STATUS_NOT_CONNECTED_ERROR;
   }
 
   DBG("MQTT - Call to mqtt_publish...\n");
 
-  /* Currently don't have a queue, so only one item at a time */
+  /* One packet is written at a time, QoS 1 and 2 also need an in-flight slot */
   if(conn->out_queue_full) {
     DBG("MQTT - Not accepted!\n");
     return MQTT_STATUS_OUT_QUEUE_FULL;
   }
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW && conn->inflight[i].mid != 0; i++);
+  if(qos_level > MQTT_QOS_LEVEL_0 && i == MQTT_INFLIGHT_WINDOW) {
+    DBG("MQTT - Not accepted, in-flight window full!\n");
+    return MQTT_STATUS_OUT_QUEUE_FULL;
+  }
+  /* Nothing is reserved if the event queue is full */
+  if(process_post(&mqtt_process, mqtt_do_publish_event, conn) !=
+     PROCESS_ERR_OK) {
+    DBG("MQTT - Not accepted, event queue full!\n");
+    return MQTT_STATUS_OUT_QUEUE_FULL;
+  }
   conn->out_queue_full = 1;
   DBG("MQTT - Accepted!\n");
 
-  conn->out_packet.mid = INCREMENT_MID(conn);
+  conn->out_packet.mid = next_mid(conn);
   conn->out_packet.retain = retain;
   conn->out_packet.topic = topic;
   conn->out_packet.topic_length = strlen(topic);
   conn->out_packet.payload = payload;
   conn->out_packet.payload_size = payload_size;
+  conn->out_packet.gather = gather;
+  conn->out_packet.gather_count = gather_count;
   conn->out_packet.qos = qos_level;
   conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
 
-  process_post(&mqtt_process, mqtt_do_publish_event, conn);
+  if(qos_level > MQTT_QOS_LEVEL_0) {
+    conn->inflight[i].mid = conn->out_packet.mid;
+    conn->inflight[i].qos = qos_level;
+    conn->inflight[i].qos_state = MQTT_QOS_STATE_NO_ACK;
+    conn->inflight[i].resend = 0;
+    conn->inflight[i].retries = 0;
+    conn->inflight[i].sent = clock_time();
+    conn->inflight_count++;
+#if MQTT_PERSISTENCE
+    persistence_store(conn, i);
+#endif /* MQTT_PERSISTENCE */
+    inflight_timer_start(conn);
+  }
+  if(mid != NULL) {
+    *mid = conn->out_packet.mid;
+  }
+
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+             uint8_t *payload, uint32_t payload_size,
+             mqtt_qos_level_t qos_level, mqtt_retain_t retain)
+{
+  return publish(conn, mid, topic, payload, payload_size, NULL, 0,
+                 qos_level, retain);
+}
+/*----------------------------------------------------------------------------*/
+mqtt_status_t
+mqtt_publish_gather(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+                    const struct mqtt_gather *gather, uint8_t gather_count,
+                    mqtt_qos_level_t qos_level, mqtt_retain_t retain)
+{
+  uint32_t payload_size = 0;
+  int i;
+
+  if(gather == NULL) {
+    return MQTT_STATUS_INVALID_ARGS_ERROR;
+  }
+  for(i = 0; i < gather_count; i++) {
+    payload_size += gather[i].len;
+  }
+  return publish(conn, mid, topic, NULL, payload_size, gather, gather_count,
+                 qos_level, retain);
+}
+/*----------------------------------------------------------------------------*/
 void
 mqtt_set_username_password(struct mqtt_connection *conn, char *username,
                            char *password)
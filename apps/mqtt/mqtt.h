@@ -61,7 +61,7 @@
  *  -- "Exactly once" (2), where message are assured to arrive exactly once.
  *  This level could be used, for example, with billing systems where duplicate
  *  or lost messages could lead to incorrect charges being applied. This QoS
- *  level is currently not supported in this implementation.
+ *  level is only supported for messages published by this implementation.
  *
  * - A small transport overhead and protocol exchanges minimized to reduce
  *   network traffic.
@@ -117,6 +117,50 @@
 #define MQTT_PROTOCOL_VERSION 3
 #define MQTT_PROTOCOL_NAME "MQIsdp"
 #define MQTT_TOPIC_MAX_LENGTH 128
+
+/*
+ * Number of QoS 1 and 2 PUBLISH messages that may await acknowledgement from
+ * the broker at the same time.
+ */
+#ifdef MQTT_CONF_INFLIGHT_WINDOW
+#define MQTT_INFLIGHT_WINDOW MQTT_CONF_INFLIGHT_WINDOW
+#else
+#define MQTT_INFLIGHT_WINDOW 4
+#endif
+
+/*
+ * When enabled, un-acknowledged QoS 1 and 2 messages are stored in CFS (one
+ * file per in-flight slot, MQTT_PERSISTENCE_NAME) and sent again with the DUP
+ * flag after reconnecting, also after a reboot. The broker is then asked to
+ * keep the session. Only one connection may use persistence.
+ */
+#ifdef MQTT_CONF_PERSISTENCE
+#define MQTT_PERSISTENCE MQTT_CONF_PERSISTENCE
+#else
+#define MQTT_PERSISTENCE 0
+#endif
+
+#define MQTT_PERSISTENCE_NAME "mqtt.%u"
+
+/*
+ * Seconds to wait for the acknowledgement of an in-flight message. The
+ * in-flight slots are checked at this interval, so a message waits between
+ * one and two timeouts. A PUBREL, or with persistence a PUBLISH, is then
+ * sent again with the DUP flag, up to MQTT_INFLIGHT_RETRIES times. After
+ * that, or at the first timeout of a PUBLISH that was not stored, the slot
+ * is freed and MQTT_EVENT_PUBACK_TIMEOUT is reported.
+ */
+#ifdef MQTT_CONF_INFLIGHT_TIMEOUT
+#define MQTT_INFLIGHT_TIMEOUT MQTT_CONF_INFLIGHT_TIMEOUT
+#else
+#define MQTT_INFLIGHT_TIMEOUT 20
+#endif
+
+#ifdef MQTT_CONF_INFLIGHT_RETRIES
+#define MQTT_INFLIGHT_RETRIES MQTT_CONF_INFLIGHT_RETRIES
+#else
+#define MQTT_INFLIGHT_RETRIES 3
+#endif
 /*---------------------------------------------------------------------------*/
 /*
  * Debug configuration, this is similar but not exactly like the Debugging
@@ -150,7 +194,8 @@ typedef enum {
   MQTT_EVENT_SUBACK,
   MQTT_EVENT_UNSUBACK,
   MQTT_EVENT_PUBLISH,
-  MQTT_EVENT_PUBACK,
+  MQTT_EVENT_PUBACK, /* Also reported on PUBCOMP for QoS 2 messages */
+  MQTT_EVENT_PUBACK_TIMEOUT, /* An in-flight message was given up */
 
   /* Errors */
   MQTT_EVENT_ERROR = 0x80,
@@ -183,7 +228,9 @@ typedef enum {
   MQTT_QOS_STATE_NO_ACK,
   MQTT_QOS_STATE_GOT_ACK,
 
-  /* Expand for QoS 2 */
+  /* QoS 2 */
+  MQTT_QOS_STATE_GOT_REC,
+  MQTT_QOS_STATE_SENT_REL,
 } mqtt_qos_state_t;
 /*---------------------------------------------------------------------------*/
 /*
@@ -269,6 +316,12 @@ struct mqtt_in_packet {
   uint8_t topic_received;
 };
 
+/* A part of the payload of a message published with mqtt_publish_gather() */
+struct mqtt_gather {
+  const uint8_t *data;
+  uint16_t len;
+};
+
 /* This struct represents a packet sent to the MQTT server. */
 struct mqtt_out_packet {
   uint8_t fhdr;
@@ -280,10 +333,25 @@ struct mqtt_out_packet {
   uint16_t topic_length;
   uint8_t *payload;
   uint32_t payload_size;
+  const struct mqtt_gather *gather;
+  uint8_t gather_count;
   mqtt_qos_level_t qos;
   mqtt_qos_state_t qos_state;
   mqtt_retain_t retain;
 };
+
+/*
+ * A QoS 1 or 2 PUBLISH message that has been sent but not completely
+ * acknowledged. A slot is free when mid is zero.
+ */
+struct mqtt_inflight {
+  uint16_t mid;
+  mqtt_qos_level_t qos;
+  mqtt_qos_state_t qos_state;
+  uint8_t resend;
+  uint8_t retries;
+  clock_time_t sent;
+};
 /*---------------------------------------------------------------------------*/
 /**
  * \brief           MQTT event callback function
@@ -348,6 +416,21 @@ struct mqtt_connection {
   struct pt out_proto_thread;
   uint32_t out_write_pos;
   uint16_t max_segment_size;
+  /* Bytes at the start of out_buffer that have been handed to the socket */
+  uint16_t out_buffer_queued;
+  /* Payload parts that the socket sends from the application's memory */
+  uint8_t out_gather_pos;
+  uint8_t out_refs_pending;
+
+  /* PUBLISH messages waiting for PUBACK / PUBREC / PUBCOMP */
+  struct mqtt_inflight inflight[MQTT_INFLIGHT_WINDOW];
+  uint8_t inflight_count;
+  uint8_t inflight_pos;
+  uint8_t inflight_posted;
+  struct ctimer inflight_timer;
+#if MQTT_PERSISTENCE
+  int inflight_fd;
+#endif /* MQTT_PERSISTENCE */
 
   /* Incoming data related */
   uint8_t in_buffer[MQTT_TCP_INPUT_BUFF_SIZE];
@@ -443,14 +526,18 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \param topic A pointer to the topic to subscribe to.
  * \param payload A pointer to the topic payload.
  * \param payload_size Payload size.
- * \param qos_level Quality Of Service level to use. Currently supports 0, 1.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
  * \param retain If the RETAIN flag is set to 1, in a PUBLISH Packet sent by a
  *        Client to a Server, the Server MUST store the Application Message
  *        and its QoS, so that it can be delivered to future subscribers whose
  *        subscriptions match its topic name
  * \return MQTT_STATUS_OK or some error status
  *
- * This function publishes to a topic on a MQTT broker.
+ * This function publishes to a topic on a MQTT broker. The message ID is
+ * returned in mid, when not NULL, and is reported again with
+ * MQTT_EVENT_PUBACK. Up to MQTT_INFLIGHT_WINDOW QoS 1 and 2 messages may
+ * await acknowledgement, and the payload may be reused as soon as
+ * mqtt_ready() is true again.
  */
 mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            uint16_t *mid,
@@ -460,6 +547,33 @@ mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            mqtt_qos_level_t qos_level,
                            mqtt_retain_t retain);
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Publish to a MQTT topic without copying the payload.
+ * \param conn A pointer to the MQTT connection.
+ * \param mid A pointer to message ID.
+ * \param topic A pointer to the topic to subscribe to.
+ * \param gather An array of payload parts, sent one after the other.
+ * \param gather_count The number of payload parts.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
+ * \param retain The RETAIN flag, see mqtt_publish().
+ * \return MQTT_STATUS_OK or some error status
+ *
+ * Like mqtt_publish(), but the payload parts are not copied into the output
+ * buffer. The TCP socket builds its segments directly from them, so the
+ * parts, and the gather array, must not be changed until mqtt_ready() is
+ * true again, which is when the broker has acknowledged them on TCP level.
+ * Parts are copied as usual when the socket has no free reference (see
+ * TCP_SOCKET_CONF_MAX_REFS). This suits large payloads, small messages are
+ * sent more efficiently with mqtt_publish().
+ */
+mqtt_status_t mqtt_publish_gather(struct mqtt_connection *conn,
+                                  uint16_t *mid,
+                                  char *topic,
+                                  const struct mqtt_gather *gather,
+                                  uint8_t gather_count,
+                                  mqtt_qos_level_t qos_level,
+                                  mqtt_retain_t retain);
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Set the user name and password for a MQTT client.
  * \param conn A pointer to the MQTT connection.
@@ -499,7 +613,8 @@ void mqtt_set_last_will(struct mqtt_connection *conn,
   ((conn)->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER ? 1 : 0)
 
 #define mqtt_ready(conn) \
-  (!(conn)->out_queue_full && mqtt_connected((conn)))
+  (!(conn)->out_queue_full && \
+   (conn)->inflight_count < MQTT_INFLIGHT_WINDOW && mqtt_connected((conn)))
 /*---------------------------------------------------------------------------*/
 #endif /* MQTT_H_ */
 /*---------------------------------------------------------------------------*/
@@ -46,6 +46,7 @@
 #include "lwm2m-object.h"
 #include "lwm2m-device.h"
 #include "lwm2m-plain-text.h"
+#include "lwm2m-senml-cbor.h"
 #include "rest-engine.h"
 #include "er-coap-constants.h"
 #include "er-coap-engine.h"
@@ -80,7 +81,9 @@
 #define REMOTE_PORT        UIP_HTONS(COAP_DEFAULT_PORT)
 #define BS_REMOTE_PORT     UIP_HTONS(5685)
 
+/* registered objects, kept ordered by id for binary search */
 static const lwm2m_object_t *objects[MAX_OBJECTS];
+static uint8_t object_count;
 static char endpoint[32];
 static char rd_data[128]; /* allocate some data for the RD */
 
@@ -497,27 +500,61 @@ lwm2m_engine_parse_context(const lwm2m_object_t *object,
 const lwm2m_object_t *
 lwm2m_engine_get_object(uint16_t id)
 {
-  int i;
-  for(i = 0; i < MAX_OBJECTS; i++) {
-    if(objects[i] != NULL && objects[i]->id == id) {
-      return objects[i];
+  int low = 0;
+  int high = object_count - 1;
+  int mid;
+
+  while(low <= high) {
+    mid = (low + high) / 2;
+    if(objects[mid]->id == id) {
+      return objects[mid];
+    } else if(objects[mid]->id < id) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+void
+lwm2m_engine_update_instance(lwm2m_instance_t *instance)
+{
+  int i;
+
+  /* get_resource() binary searches the resources when they are ordered */
+  for(i = 1; i < instance->count; i++) {
+    if(instance->resources[i - 1].id >= instance->resources[i].id) {
+      break;
+    }
+  }
+  if(i >= instance->count) {
+    instance->flag |= LWM2M_INSTANCE_FLAG_SORTED;
+  } else {
+    instance->flag &= ~LWM2M_INSTANCE_FLAG_SORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
 int
 lwm2m_engine_register_object(const lwm2m_object_t *object)
 {
   int i;
   int found = 0;
-  for(i = 0; i < MAX_OBJECTS; i++) {
-    if(objects[i] == NULL) {
-      objects[i] = object;
-      found = 1;
-      break;
+
+  if(object_count < MAX_OBJECTS) {
+    /* insert ordered by id */
+    for(i = object_count; i > 0 && objects[i - 1]->id > object->id; i--) {
+      objects[i] = objects[i - 1];
     }
+    objects[i] = object;
+    object_count++;
+    found = 1;
   }
+
+  for(i = 0; i < object->count; i++) {
+    lwm2m_engine_update_instance(&object->instances[i]);
+  }
+
   rest_activate_resource(lwm2m_object_get_coap_resource(object),
                          (char *)object->path);
   return found;
@@ -555,6 +592,16 @@ get_instance(const lwm2m_object_t *object, lwm2m_context_t *context, int depth)
   int i;
   if(depth > 1) {
     PRINTF("lwm2m: searching for instance %u\n", context->object_instance_id);
+
+    /* instances are usually numbered by their position in the array */
+    i = context->object_instance_id;
+    if(i < object->count && object->instances[i].id == i) {
+      if(object->instances[i].flag & LWM2M_INSTANCE_FLAG_USED) {
+        context->object_instance_index = i;
+        return &object->instances[i];
+      }
+    }
+
     for(i = 0; i < object->count; i++) {
       PRINTF("  Instance %d -> %u (used: %d)\n", i, object->instances[i].id,
              (object->instances[i].flag & LWM2M_INSTANCE_FLAG_USED) != 0);
@@ -574,6 +621,22 @@ get_resource(const lwm2m_instance_t *instance, lwm2m_context_t *context)
   int i;
   if(instance != NULL) {
     PRINTF("lwm2m: searching for resource %u\n", context->resource_id);
+    if(instance->flag & LWM2M_INSTANCE_FLAG_SORTED) {
+      int low = 0;
+      int high = instance->count - 1;
+      while(low <= high) {
+        i = (low + high) / 2;
+        if(instance->resources[i].id == context->resource_id) {
+          context->resource_index = i;
+          return &instance->resources[i];
+        } else if(instance->resources[i].id < context->resource_id) {
+          low = i + 1;
+        } else {
+          high = i - 1;
+        }
+      }
+      return NULL;
+    }
     for(i = 0; i < instance->count; i++) {
       PRINTF("  Resource %d -> %u\n", i, instance->resources[i].id);
       if(instance->resources[i].id == context->resource_id) {
@@ -707,6 +770,229 @@ write_rd_json_data(const lwm2m_context_t *context,
   return rdlen;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * A read callback returns 0 both when it has no value and when the writer
+ * ran out of room, so the callback is given a writer that notes the
+ * latter. Each writer returns 0 only when the value does not fit.
+ */
+static const lwm2m_writer_t *callback_writer;
+static uint8_t callback_overflow;
+
+static size_t
+checked_write_int(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                  int32_t value)
+{
+  size_t len = callback_writer->write_int(ctx, outbuf, outlen, value);
+  callback_overflow |= len == 0;
+  return len;
+}
+
+static size_t
+checked_write_string(const lwm2m_context_t *ctx, uint8_t *outbuf,
+                     size_t outlen, const char *value, size_t strlen)
+{
+  size_t len = callback_writer->write_string(ctx, outbuf, outlen,
+                                             value, strlen);
+  callback_overflow |= len == 0;
+  return len;
+}
+
+static size_t
+checked_write_float32fix(const lwm2m_context_t *ctx, uint8_t *outbuf,
+                         size_t outlen, int32_t value, int bits)
+{
+  size_t len = callback_writer->write_float32fix(ctx, outbuf, outlen,
+                                                 value, bits);
+  callback_overflow |= len == 0;
+  return len;
+}
+
+static size_t
+checked_write_boolean(const lwm2m_context_t *ctx, uint8_t *outbuf,
+                      size_t outlen, int value)
+{
+  size_t len = callback_writer->write_boolean(ctx, outbuf, outlen, value);
+  callback_overflow |= len == 0;
+  return len;
+}
+
+static const lwm2m_writer_t checked_writer = {
+  checked_write_int,
+  checked_write_string,
+  checked_write_float32fix,
+  checked_write_boolean
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the value of a readable resource with the writer of the context.
+ * Returns the number of bytes written or -1 if the buffer is too small.
+ */
+static int
+write_resource(lwm2m_context_t *context, const lwm2m_resource_t *resource,
+               uint8_t *buffer, size_t size)
+{
+  const lwm2m_writer_t *writer = context->writer;
+  int len = 0;
+
+  if(lwm2m_object_is_resource_string(resource)) {
+    const uint8_t *value = lwm2m_object_get_resource_string(resource, context);
+    if(value != NULL) {
+      len = writer->write_string(context, buffer, size, (const char *)value,
+                                 lwm2m_object_get_resource_strlen(resource,
+                                                                  context));
+      if(len == 0) {
+        return -1;
+      }
+    }
+  } else if(lwm2m_object_is_resource_int(resource)) {
+    int32_t value;
+    if(lwm2m_object_get_resource_int(resource, context, &value)) {
+      len = writer->write_int(context, buffer, size, value);
+      if(len == 0) {
+        return -1;
+      }
+    }
+  } else if(lwm2m_object_is_resource_floatfix(resource)) {
+    int32_t value;
+    if(lwm2m_object_get_resource_floatfix(resource, context, &value)) {
+      len = writer->write_float32fix(context, buffer, size,
+                                     value, LWM2M_FLOAT32_BITS);
+      if(len == 0) {
+        return -1;
+      }
+    }
+  } else if(lwm2m_object_is_resource_boolean(resource)) {
+    int value;
+    if(lwm2m_object_get_resource_boolean(resource, context, &value)) {
+      len = writer->write_boolean(context, buffer, size, value);
+      if(len == 0) {
+        return -1;
+      }
+    }
+  } else if(lwm2m_object_is_resource_callback(resource)
+            && resource->value.callback.read != NULL) {
+    callback_writer = writer;
+    callback_overflow = 0;
+    context->writer = &checked_writer;
+    len = resource->value.callback.read(context, buffer, size);
+    context->writer = writer;
+    if(len < 0 || callback_overflow) {
+      return -1;
+    }
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes all readable resources of an instance with the given writer in one
+ * pass over the resource array. Returns the number of bytes written or -1
+ * if the buffer is too small.
+ */
+static int
+write_instance(lwm2m_context_t *context, const lwm2m_instance_t *instance,
+               const lwm2m_writer_t *writer, uint8_t *buffer, size_t size)
+{
+  size_t pos = 0;
+  int len, i;
+
+  context->writer = writer;
+  for(i = 0; i < instance->count; i++) {
+    context->resource_id = instance->resources[i].id;
+    context->resource_index = i;
+    len = write_resource(context, &instance->resources[i],
+                         &buffer[pos], size - pos);
+    if(len < 0) {
+      return -1;
+    }
+    pos += len;
+  }
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+/* maximum TLV header: type, 16-bit id and 16-bit length */
+#define OBJECT_INSTANCE_TLV_HEADER_MAX 5
+/*
+ * Writes all used instances of an object as object instance TLVs. The
+ * resources are written behind room for the header, which is then filled
+ * in by oma_tlv_write() moving the resources down in place.
+ */
+static int
+write_object_tlv(lwm2m_context_t *context, const lwm2m_object_t *object,
+                 uint8_t *buffer, size_t size)
+{
+  oma_tlv_t tlv;
+  size_t pos = 0;
+  int len, i;
+
+  for(i = 0; i < object->count; i++) {
+    if((object->instances[i].flag & LWM2M_INSTANCE_FLAG_USED) == 0) {
+      continue;
+    }
+    if(size - pos <= OBJECT_INSTANCE_TLV_HEADER_MAX) {
+      return -1;
+    }
+    context->object_instance_id = object->instances[i].id;
+    context->object_instance_index = i;
+    len = write_instance(context, &object->instances[i], &oma_tlv_writer,
+                         &buffer[pos + OBJECT_INSTANCE_TLV_HEADER_MAX],
+                         size - pos - OBJECT_INSTANCE_TLV_HEADER_MAX);
+    if(len < 0) {
+      return -1;
+    }
+    tlv.type = OMA_TLV_TYPE_OBJECT_INSTANCE;
+    tlv.id = object->instances[i].id;
+    tlv.length = len;
+    tlv.value = &buffer[pos + OBJECT_INSTANCE_TLV_HEADER_MAX];
+    len = oma_tlv_write(&tlv, &buffer[pos], size - pos);
+    if(len == 0) {
+      return -1;
+    }
+    pos += len;
+  }
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes one instance, or all used instances of the object when instance
+ * is NULL, as a single SenML CBOR pack.
+ */
+static int
+write_senml_cbor(lwm2m_context_t *context, const lwm2m_object_t *object,
+                 const lwm2m_instance_t *instance,
+                 uint8_t *buffer, size_t size)
+{
+  lwm2m_senml_cbor_pack_t pack;
+  size_t pos;
+  int len, i;
+
+  pos = lwm2m_senml_cbor_pack_begin(context, &pack, buffer, size);
+  for(i = 0; pos > 0 && i < object->count; i++) {
+    if(instance != NULL && instance != &object->instances[i]) {
+      continue;
+    }
+    if((object->instances[i].flag & LWM2M_INSTANCE_FLAG_USED) == 0) {
+      continue;
+    }
+    context->object_instance_id = object->instances[i].id;
+    context->object_instance_index = i;
+    len = write_instance(context, &object->instances[i],
+                         &lwm2m_senml_cbor_writer,
+                         &buffer[pos], size - pos);
+    if(len < 0) {
+      pos = 0;
+    } else {
+      pos += len;
+    }
+  }
+  /* always end the pack, so that the context no longer refers to it */
+  len = lwm2m_senml_cbor_pack_end(context, &buffer[pos],
+                                  pos > 0 ? size - pos : 0);
+  if(pos == 0 || len == 0) {
+    return -1;
+  }
+  return pos + len;
+}
+/*---------------------------------------------------------------------------*/
 void
 lwm2m_engine_handler(const lwm2m_object_t *object,
                      void *request, void *response,
@@ -784,6 +1070,7 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
           /* allocate this instance */
           object->instances[i].flag |= LWM2M_INSTANCE_FLAG_USED;
           object->instances[i].id = context.object_instance_id;
+          lwm2m_engine_update_instance(&object->instances[i]);
           context.object_instance_index = i;
           PRINTF("Created instance: %d\n", context.object_instance_id);
           REST.set_response_status(response, CREATED_2_01);
@@ -872,13 +1159,15 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
       if(lwm2m_object_is_resource_callback(resource)) {
         if(resource->value.callback.write != NULL) {
           /* pick a reader ??? */
-          if(format == LWM2M_TEXT_PLAIN) {
-            /* a string */
+          if(format == LWM2M_TEXT_PLAIN || format == LWM2M_SENML_CBOR) {
             const uint8_t *data;
             int plen = REST.get_request_payload(request, &data);
-            context.reader = &lwm2m_plain_text_reader;
-            PRINTF("PUT Callback with data: '%.*s'\n", plen, data);
-            /* no specific reader for plain text */
+            if(format == LWM2M_SENML_CBOR) {
+              context.reader = &lwm2m_senml_cbor_reader;
+            } else {
+              context.reader = &lwm2m_plain_text_reader;
+            }
+            PRINTF("PUT Callback with %d bytes of data\n", plen);
             tlvlen = resource->value.callback.write(&context, data, plen,
                                                     buffer, preferred_size);
             PRINTF("tlvlen:%u\n", (unsigned int)tlvlen);
@@ -897,6 +1186,20 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
       }
       /* HANDLE GET */
     } else if(method == METHOD_GET) {
+      if(format == LWM2M_SENML_CBOR) {
+        int cborlen;
+        context.writer = &lwm2m_senml_cbor_writer;
+        cborlen = write_resource(&context, resource, buffer, preferred_size);
+        if(cborlen > 0) {
+          REST.set_response_payload(response, buffer, cborlen);
+          REST.set_header_content_type(response, LWM2M_SENML_CBOR);
+        } else if(cborlen < 0) {
+          REST.set_response_status(response, INTERNAL_SERVER_ERROR_5_00);
+        } else {
+          REST.set_response_status(response, METHOD_NOT_ALLOWED_4_05);
+        }
+        return;
+      }
       if(lwm2m_object_is_resource_string(resource)) {
         const uint8_t *value;
         uint16_t len;
@@ -971,6 +1274,26 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
       REST.set_response_status(response, METHOD_NOT_ALLOWED_4_05);
     } else if(instance == NULL) {
       REST.set_response_status(response, NOT_FOUND_4_04);
+    } else if(format == LWM2M_TLV) {
+      int tlvlen = write_instance(&context, instance, &oma_tlv_writer,
+                                  buffer, preferred_size);
+      if(tlvlen < 0) {
+        PRINTF("Failed to generate instance TLV\n");
+        REST.set_response_status(response, REQUEST_ENTITY_TOO_LARGE_4_13);
+        return;
+      }
+      REST.set_response_payload(response, buffer, tlvlen);
+      REST.set_header_content_type(response, LWM2M_TLV);
+    } else if(format == LWM2M_SENML_CBOR) {
+      int cborlen = write_senml_cbor(&context, object, instance,
+                                     buffer, preferred_size);
+      if(cborlen < 0) {
+        PRINTF("Failed to generate instance SenML CBOR\n");
+        REST.set_response_status(response, REQUEST_ENTITY_TOO_LARGE_4_13);
+        return;
+      }
+      REST.set_response_payload(response, buffer, cborlen);
+      REST.set_header_content_type(response, LWM2M_SENML_CBOR);
     } else {
       int rdlen;
       if(format == APPLICATION_LINK_FORMAT) {
@@ -982,7 +1305,7 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
       }
       if(rdlen < 0) {
         PRINTF("Failed to generate instance response\n");
-        REST.set_response_status(response, SERVICE_UNAVAILABLE_5_03);
+        REST.set_response_status(response, REQUEST_ENTITY_TOO_LARGE_4_13);
         return;
       }
       REST.set_response_payload(response, buffer, rdlen);
@@ -992,6 +1315,26 @@ lwm2m_engine_handler(const lwm2m_object_t *object,
         REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
       }
     }
+  } else if(depth == 1 && method == METHOD_GET && format == LWM2M_TLV) {
+    /* produce an object response with all instances */
+    int tlvlen = write_object_tlv(&context, object, buffer, preferred_size);
+    if(tlvlen < 0) {
+      PRINTF("Failed to generate object TLV\n");
+      REST.set_response_status(response, REQUEST_ENTITY_TOO_LARGE_4_13);
+      return;
+    }
+    REST.set_response_payload(response, buffer, tlvlen);
+    REST.set_header_content_type(response, LWM2M_TLV);
+  } else if(depth == 1 && method == METHOD_GET && format == LWM2M_SENML_CBOR) {
+    int cborlen = write_senml_cbor(&context, object, NULL,
+                                   buffer, preferred_size);
+    if(cborlen < 0) {
+      PRINTF("Failed to generate object SenML CBOR\n");
+      REST.set_response_status(response, REQUEST_ENTITY_TOO_LARGE_4_13);
+      return;
+    }
+    REST.set_response_payload(response, buffer, cborlen);
+    REST.set_header_content_type(response, LWM2M_SENML_CBOR);
   }
 }
 /*---------------------------------------------------------------------------*/
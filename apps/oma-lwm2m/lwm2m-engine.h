@@ -54,7 +54,8 @@ typedef enum {
   LWM2M_TEXT_PLAIN = 1541,
   LWM2M_TLV        = 1542,
   LWM2M_JSON       = 1543,
-  LWM2M_OPAQUE     = 1544
+  LWM2M_OPAQUE     = 1544,
+  LWM2M_SENML_CBOR = 112
 } lwm2m_content_format_t;
 
 void lwm2m_engine_init(void);
@@ -68,6 +69,10 @@ const lwm2m_object_t *lwm2m_engine_get_object(uint16_t id);
 
 int lwm2m_engine_register_object(const lwm2m_object_t *object);
 
+/* To be called for an instance whose resources change after its object
+   has been registered */
+void lwm2m_engine_update_instance(lwm2m_instance_t *instance);
+
 void lwm2m_engine_handler(const lwm2m_object_t *object,
                           void *request, void *response,
                           uint8_t *buffer, uint16_t preferred_size,
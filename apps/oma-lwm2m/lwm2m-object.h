@@ -99,6 +99,9 @@ typedef struct lwm2m_context {
 
   const struct lwm2m_reader *reader;
   const struct lwm2m_writer *writer;
+  /* State the writer keeps between the values of one document, such as
+     a SenML pack, or NULL */
+  void *writer_state;
 } lwm2m_context_t;
 
 /* LWM2M format writer for the various formats supported */
@@ -199,6 +202,9 @@ typedef struct lwm2m_resource {
 } lwm2m_resource_t;
 
 #define LWM2M_INSTANCE_FLAG_USED 1
+/* kept by the engine when the resources are ordered by id, see
+   lwm2m_engine_update_instance() */
+#define LWM2M_INSTANCE_FLAG_SORTED 2
 
 typedef struct lwm2m_instance {
   uint16_t id;
@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup oma-lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML CBOR reader / writer
+ *
+ *         The writer emits each value as one SenML record directly into the
+ *         output buffer. The base name "/object/instance/" is only written
+ *         in the first record of a pack and when the instance changes.
+ *         Fixpoint values are written as CBOR integers when they have no
+ *         fraction, as half floats when they fit exactly, and as single
+ *         floats otherwise.
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-senml-cbor.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DEBUG 0
+#if DEBUG
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* CBOR major types */
+#define CBOR_UINT         0
+#define CBOR_NEGINT       1
+#define CBOR_TEXT         3
+#define CBOR_ARRAY        4
+#define CBOR_MAP          5
+#define CBOR_SIMPLE       7
+
+#define CBOR_FALSE        0xf4
+#define CBOR_TRUE         0xf5
+#define CBOR_FLOAT16      0xf9
+#define CBOR_FLOAT32      0xfa
+#define CBOR_FLOAT64      0xfb
+#define CBOR_INDEFINITE   31
+#define CBOR_BREAK        0xff
+
+/* SenML labels (RFC 8428) */
+#define SENML_BASE_NAME   -2
+#define SENML_NAME        0
+#define SENML_VALUE       2
+#define SENML_STRING      3
+#define SENML_BOOLEAN     4
+
+/* "/65535/65535/65535" */
+#define SENML_NAME_MAX    19
+
+/*---------------------------------------------------------------------------*/
+static size_t
+write_head(uint8_t *outbuf, size_t outlen, uint8_t major, uint32_t arg)
+{
+  major <<= 5;
+  if(arg < 24) {
+    if(outlen < 1) {
+      return 0;
+    }
+    outbuf[0] = major | arg;
+    return 1;
+  }
+  if(arg <= 0xff) {
+    if(outlen < 2) {
+      return 0;
+    }
+    outbuf[0] = major | 24;
+    outbuf[1] = arg;
+    return 2;
+  }
+  if(arg <= 0xffff) {
+    if(outlen < 3) {
+      return 0;
+    }
+    outbuf[0] = major | 25;
+    outbuf[1] = arg >> 8;
+    outbuf[2] = arg;
+    return 3;
+  }
+  if(outlen < 5) {
+    return 0;
+  }
+  outbuf[0] = major | 26;
+  outbuf[1] = arg >> 24;
+  outbuf[2] = arg >> 16;
+  outbuf[3] = arg >> 8;
+  outbuf[4] = arg;
+  return 5;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_cbor_int(uint8_t *outbuf, size_t outlen, int32_t value)
+{
+  if(value < 0) {
+    return write_head(outbuf, outlen, CBOR_NEGINT, (uint32_t)(-(value + 1)));
+  }
+  return write_head(outbuf, outlen, CBOR_UINT, value);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_cbor_text(uint8_t *outbuf, size_t outlen, const char *text, size_t len)
+{
+  size_t n = write_head(outbuf, outlen, CBOR_TEXT, len);
+  if(n == 0 || outlen - n < len) {
+    return 0;
+  }
+  memcpy(&outbuf[n], text, len);
+  return n + len;
+}
+/*---------------------------------------------------------------------------*/
+/* Writes the decimal digits of value, without terminating zero */
+static int
+write_decimal(char *name, uint16_t value)
+{
+  char digits[5];
+  int n = 0, len = 0;
+
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while(value > 0);
+  while(n > 0) {
+    name[len++] = digits[--n];
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes everything of a record up to its value: the array header when the
+ * record is a pack of its own, the map header, the base name when needed,
+ * the name and the label of the value. A record of its own has no base
+ * name, its name is the full path of the resource.
+ */
+static size_t
+write_record_head(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                  int label)
+{
+  lwm2m_senml_cbor_pack_t *pack = ctx->writer_state;
+  char name[SENML_NAME_MAX];
+  size_t pos = 0;
+  size_t n;
+  int base, len;
+
+  base = pack != NULL && (!pack->has_base ||
+                          pack->base_object_id != ctx->object_id ||
+                          pack->base_instance_id != ctx->object_instance_id);
+
+  if(pack == NULL) {
+    pos = write_head(outbuf, outlen, CBOR_ARRAY, 1);
+    if(pos == 0) {
+      return 0;
+    }
+  }
+  n = write_head(&outbuf[pos], outlen - pos, CBOR_MAP, base ? 3 : 2);
+  if(n == 0) {
+    return 0;
+  }
+  pos += n;
+
+  if(base) {
+    name[0] = '/';
+    len = 1 + write_decimal(&name[1], ctx->object_id);
+    name[len++] = '/';
+    len += write_decimal(&name[len], ctx->object_instance_id);
+    name[len++] = '/';
+    n = write_cbor_int(&outbuf[pos], outlen - pos, SENML_BASE_NAME);
+    if(n == 0) {
+      return 0;
+    }
+    pos += n;
+    n = write_cbor_text(&outbuf[pos], outlen - pos, name, len);
+    if(n == 0) {
+      return 0;
+    }
+    pos += n;
+  }
+
+  len = 0;
+  if(pack == NULL) {
+    name[len++] = '/';
+    len += write_decimal(&name[len], ctx->object_id);
+    name[len++] = '/';
+    len += write_decimal(&name[len], ctx->object_instance_id);
+    name[len++] = '/';
+  }
+  len += write_decimal(&name[len], ctx->resource_id);
+  n = write_cbor_int(&outbuf[pos], outlen - pos, SENML_NAME);
+  if(n == 0) {
+    return 0;
+  }
+  pos += n;
+  n = write_cbor_text(&outbuf[pos], outlen - pos, name, len);
+  if(n == 0) {
+    return 0;
+  }
+  pos += n;
+
+  n = write_cbor_int(&outbuf[pos], outlen - pos, label);
+  if(n == 0) {
+    return 0;
+  }
+  pos += n;
+
+  if(base) {
+    pack->has_base = 1;
+    pack->base_object_id = ctx->object_id;
+    pack->base_instance_id = ctx->object_instance_id;
+  }
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_senml_cbor_pack_begin(lwm2m_context_t *ctx,
+                            lwm2m_senml_cbor_pack_t *pack,
+                            uint8_t *outbuf, size_t outlen)
+{
+  pack->has_base = 0;
+  ctx->writer_state = pack;
+  if(outlen < 1) {
+    return 0;
+  }
+  /* indefinite length array - the number of records is not known yet */
+  outbuf[0] = (CBOR_ARRAY << 5) | CBOR_INDEFINITE;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+lwm2m_senml_cbor_pack_end(lwm2m_context_t *ctx,
+                          uint8_t *outbuf, size_t outlen)
+{
+  ctx->writer_state = NULL;
+  if(outlen < 1) {
+    return 0;
+  }
+  outbuf[0] = CBOR_BREAK;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  size_t pos, n;
+  pos = write_record_head(ctx, outbuf, outlen, SENML_VALUE);
+  if(pos == 0) {
+    return 0;
+  }
+  n = write_cbor_int(&outbuf[pos], outlen - pos, value);
+  if(n == 0) {
+    return 0;
+  }
+  return pos + n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  size_t pos, n;
+  pos = write_record_head(ctx, outbuf, outlen, SENML_STRING);
+  if(pos == 0) {
+    return 0;
+  }
+  n = write_cbor_text(&outbuf[pos], outlen - pos, value, stringlen);
+  if(n == 0) {
+    return 0;
+  }
+  return pos + n;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  uint32_t a, f;
+  size_t pos;
+  int p, e;
+
+  if((value & ((1L << bits) - 1)) == 0) {
+    /* no fraction - an integer is shorter than a float */
+    return write_int(ctx, outbuf, outlen, value >> bits);
+  }
+
+  pos = write_record_head(ctx, outbuf, outlen, SENML_VALUE);
+  if(pos == 0) {
+    return 0;
+  }
+
+  a = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  for(p = 31; (a & (1UL << p)) == 0; p--);
+  e = p - bits;
+
+  if(e >= -14 && e <= 15 && (p < 10 || (a & ((1UL << (p - 10)) - 1)) == 0)) {
+    /* the 11 significant bits of a half float hold the value exactly */
+    if(outlen - pos < 3) {
+      return 0;
+    }
+    f = p > 10 ? a >> (p - 10) : a << (10 - p);
+    f = (f & 0x3ff) | ((uint32_t)(e + 15) << 10);
+    if(value < 0) {
+      f |= 0x8000;
+    }
+    outbuf[pos] = CBOR_FLOAT16;
+    outbuf[pos + 1] = f >> 8;
+    outbuf[pos + 2] = f;
+    return pos + 3;
+  }
+
+  if(outlen - pos < 5) {
+    return 0;
+  }
+  if(p > 23) {
+    f = a >> (p - 23);
+  } else {
+    f = a << (23 - p);
+  }
+  f = (f & 0x7fffffUL) | ((uint32_t)(e + 127) << 23);
+  if(value < 0) {
+    f |= 0x80000000UL;
+  }
+
+  outbuf[pos] = CBOR_FLOAT32;
+  outbuf[pos + 1] = f >> 24;
+  outbuf[pos + 2] = f >> 16;
+  outbuf[pos + 3] = f >> 8;
+  outbuf[pos + 4] = f;
+  return pos + 5;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(const lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  size_t pos;
+  pos = write_record_head(ctx, outbuf, outlen, SENML_BOOLEAN);
+  if(pos == 0 || pos >= outlen) {
+    return 0;
+  }
+  outbuf[pos] = value ? CBOR_TRUE : CBOR_FALSE;
+  return pos + 1;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_senml_cbor_writer = {
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads the head of a CBOR data item. Returns the number of bytes used or 0
+ * on error. For floats, arg holds the bits of the value (the high 32 bits
+ * of a double).
+ */
+static size_t
+read_head(const uint8_t *inbuf, size_t len, uint8_t *major, uint8_t *info,
+          uint32_t *arg)
+{
+  size_t n, i;
+  if(len < 1) {
+    return 0;
+  }
+  *major = inbuf[0] >> 5;
+  *info = inbuf[0] & 0x1f;
+  if(*info < 24) {
+    *arg = *info;
+    return 1;
+  }
+  if(*info == CBOR_INDEFINITE) {
+    *arg = 0;
+    return 1;
+  }
+  if(*info > 27) {
+    return 0;
+  }
+  n = 1 << (*info - 24);
+  if(len < 1 + n) {
+    return 0;
+  }
+  *arg = 0;
+  for(i = 0; i < n && i < 4; i++) {
+    *arg = (*arg << 8) | inbuf[1 + i];
+  }
+  if(n == 8 && *major != CBOR_SIMPLE) {
+    /* 64-bit integers and lengths are not supported */
+    return 0;
+  }
+  return 1 + n;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the size of the scalar data item at inbuf or 0 on error */
+static size_t
+skip_item(const uint8_t *inbuf, size_t len)
+{
+  uint8_t major, info;
+  uint32_t arg;
+  size_t n = read_head(inbuf, len, &major, &info, &arg);
+  if(n == 0 || info == CBOR_INDEFINITE) {
+    return 0;
+  }
+  if(major == CBOR_UINT || major == CBOR_NEGINT || major == CBOR_SIMPLE) {
+    return n;
+  }
+  if(major == CBOR_TEXT || major == 2) {
+    if(len - n < arg) {
+      return 0;
+    }
+    return n + arg;
+  }
+  /* no nested items in SenML records */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_label(const uint8_t *inbuf, size_t len, size_t *n)
+{
+  uint8_t major, info;
+  uint32_t arg;
+  *n = read_head(inbuf, len, &major, &info, &arg);
+  if(*n == 0 || arg > 0xff) {
+    *n = 0;
+    return 0;
+  }
+  if(major == CBOR_UINT) {
+    return arg;
+  }
+  if(major == CBOR_NEGINT) {
+    return -1 - (int)arg;
+  }
+  *n = 0;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Finds the value with the given label in the record for the resource of
+ * the context. A record matches when its full name (base name + name) is
+ * the path of the resource or when it has no name at all. Returns a pointer
+ * to the value item or NULL.
+ */
+static const uint8_t *
+find_value(const lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+           int label, size_t *valuelen)
+{
+  char path[SENML_NAME_MAX];
+  const uint8_t *bn = NULL, *name, *value;
+  size_t pos, n, bnlen = 0, namelen, pathlen;
+  uint32_t records, pairs;
+  uint8_t major, info;
+  int indefinite, key;
+
+  pathlen = snprintf(path, sizeof(path), "/%u/%u/%u", ctx->object_id,
+                     ctx->object_instance_id, ctx->resource_id);
+
+  pos = read_head(inbuf, len, &major, &info, &records);
+  if(pos == 0 || major != CBOR_ARRAY) {
+    return NULL;
+  }
+  indefinite = info == CBOR_INDEFINITE;
+
+  while(pos < len && (indefinite ? inbuf[pos] != CBOR_BREAK : records-- > 0)) {
+    n = read_head(&inbuf[pos], len - pos, &major, &info, &pairs);
+    if(n == 0 || major != CBOR_MAP || info == CBOR_INDEFINITE) {
+      return NULL;
+    }
+    pos += n;
+    name = NULL;
+    namelen = 0;
+    value = NULL;
+    *valuelen = 0;
+    while(pairs-- > 0) {
+      key = read_label(&inbuf[pos], len - pos, &n);
+      if(n == 0) {
+        return NULL;
+      }
+      pos += n;
+      n = skip_item(&inbuf[pos], len - pos);
+      if(n == 0) {
+        return NULL;
+      }
+      if(key == SENML_BASE_NAME || key == SENML_NAME) {
+        uint32_t textlen;
+        size_t h = read_head(&inbuf[pos], len - pos, &major, &info, &textlen);
+        if(major != CBOR_TEXT) {
+          return NULL;
+        }
+        if(key == SENML_BASE_NAME) {
+          bn = &inbuf[pos + h];
+          bnlen = textlen;
+        } else {
+          name = &inbuf[pos + h];
+          namelen = textlen;
+        }
+      } else if(key == label) {
+        value = &inbuf[pos];
+        *valuelen = n;
+      }
+      pos += n;
+    }
+    if(value != NULL) {
+      if(bnlen + namelen == 0) {
+        return value;
+      }
+      if(bnlen + namelen == pathlen &&
+         (bnlen == 0 || memcmp(path, bn, bnlen) == 0) &&
+         (namelen == 0 || memcmp(&path[bnlen], name, namelen) == 0)) {
+        return value;
+      }
+    }
+  }
+  PRINTF("No SenML record for %.*s\n", (int)pathlen, path);
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Converts a float with the given mantissa (hidden bit included at
+ * position mbits) and unbiased exponent to fixpoint.
+ */
+static int
+float_to_fix(int neg, int e, uint32_t m, int mbits, int bits, int32_t *value)
+{
+  int shift = e - mbits + bits;
+  if(shift >= 0) {
+    if(mbits + shift > 30) {
+      return 0;
+    }
+    m <<= shift;
+  } else if(shift > -32) {
+    m >>= -shift;
+  } else {
+    m = 0;
+  }
+  *value = neg ? -(int32_t)m : (int32_t)m;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+decode_number(const uint8_t *item, size_t len, int32_t *value, int bits)
+{
+  uint8_t major, info;
+  uint32_t arg, m;
+  int e;
+
+  if(read_head(item, len, &major, &info, &arg) == 0) {
+    return 0;
+  }
+  if(major == CBOR_UINT || major == CBOR_NEGINT) {
+    if(arg > (0x7fffffffUL >> bits)) {
+      return 0;
+    }
+    *value = major == CBOR_UINT ? (int32_t)(arg << bits)
+      : -(int32_t)((arg + 1) << bits);
+    return 1;
+  }
+  if(major != CBOR_SIMPLE) {
+    return 0;
+  }
+  if(item[0] == CBOR_FLOAT16) {
+    e = (arg >> 10) & 0x1f;
+    m = arg & 0x3ff;
+    if(e == 0) {
+      *value = 0;
+      return 1;
+    }
+    return float_to_fix(arg & 0x8000, e - 15, m | (1UL << 10), 10,
+                        bits, value);
+  }
+  if(item[0] == CBOR_FLOAT32) {
+    e = (arg >> 23) & 0xff;
+    m = arg & 0x7fffffUL;
+    if(e == 0) {
+      *value = 0;
+      return 1;
+    }
+    return float_to_fix(arg & 0x80000000UL, e - 127, m | (1UL << 23), 23,
+                        bits, value);
+  }
+  if(item[0] == CBOR_FLOAT64) {
+    /* keep the 30 most significant bits of the mantissa */
+    e = (arg >> 20) & 0x7ff;
+    m = ((arg & 0xfffffUL) << 10) | (item[5] << 2) | (item[6] >> 6);
+    if(e == 0) {
+      *value = 0;
+      return 1;
+    }
+    return float_to_fix(arg & 0x80000000UL, e - 1023, m | (1UL << 30), 30,
+                        bits, value);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_int(const lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+         int32_t *value)
+{
+  size_t vlen;
+  const uint8_t *item = find_value(ctx, inbuf, len, SENML_VALUE, &vlen);
+  if(item == NULL || !decode_number(item, vlen, value, 0)) {
+    return 0;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_string(const lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+            uint8_t *value, size_t stringlen)
+{
+  uint8_t major, info;
+  uint32_t arg;
+  size_t vlen, n;
+  const uint8_t *item = find_value(ctx, inbuf, len, SENML_STRING, &vlen);
+  if(item == NULL) {
+    return 0;
+  }
+  n = read_head(item, vlen, &major, &info, &arg);
+  if(major != CBOR_TEXT || stringlen <= arg) {
+    /* The outbuffer can not contain the full string including ending zero */
+    return 0;
+  }
+  memcpy(value, &item[n], arg);
+  value[arg] = '\0';
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_float32fix(const lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+                int32_t *value, int bits)
+{
+  size_t vlen;
+  const uint8_t *item = find_value(ctx, inbuf, len, SENML_VALUE, &vlen);
+  if(item == NULL || !decode_number(item, vlen, value, bits)) {
+    return 0;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_boolean(const lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+             int *value)
+{
+  size_t vlen;
+  const uint8_t *item = find_value(ctx, inbuf, len, SENML_BOOLEAN, &vlen);
+  if(item == NULL || (item[0] != CBOR_TRUE && item[0] != CBOR_FALSE)) {
+    return 0;
+  }
+  *value = item[0] == CBOR_TRUE;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_reader_t lwm2m_senml_cbor_reader = {
+  read_int,
+  read_string,
+  read_float32fix,
+  read_boolean
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup oma-lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the Contiki OMA LWM2M SenML CBOR reader / writer
+ */
+
+#ifndef LWM2M_SENML_CBOR_H_
+#define LWM2M_SENML_CBOR_H_
+
+#include "lwm2m-object.h"
+
+extern const lwm2m_reader_t lwm2m_senml_cbor_reader;
+extern const lwm2m_writer_t lwm2m_senml_cbor_writer;
+
+/* The state of a SenML pack while it is written */
+typedef struct lwm2m_senml_cbor_pack {
+  uint16_t base_object_id;
+  uint16_t base_instance_id;
+  uint8_t has_base;
+} lwm2m_senml_cbor_pack_t;
+
+/*
+ * Values written with lwm2m_senml_cbor_writer between pack_begin() and
+ * pack_end() become records of one SenML pack. pack_begin() keeps the
+ * pack in the writer_state of the context, and pack_end() clears it.
+ * Values written outside a pack are each written as a complete pack
+ * with a single record.
+ */
+size_t lwm2m_senml_cbor_pack_begin(lwm2m_context_t *ctx,
+                                   lwm2m_senml_cbor_pack_t *pack,
+                                   uint8_t *outbuf, size_t outlen);
+
+size_t lwm2m_senml_cbor_pack_end(lwm2m_context_t *ctx,
+                                 uint8_t *outbuf, size_t outlen);
+
+#endif /* LWM2M_SENML_CBOR_H_ */
+/** @} */
@@ -155,8 +155,8 @@ oma_tlv_write(const oma_tlv_t *tlv, uint8_t *buffer, size_t len)
     buffer[pos++] = tlv->length & 0xff;
   }
 
-  /* finally add the value */
-  memcpy(&buffer[pos], tlv->value, tlv->length);
+  /* finally add the value (may overlap when wrapping TLVs in place) */
+  memmove(&buffer[pos], tlv->value, tlv->length);
 
   if(DEBUG) {
     int i;
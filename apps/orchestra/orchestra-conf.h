@@ -72,6 +72,59 @@
 #define ORCHESTRA_UNICAST_PERIOD                  17
 #endif /* ORCHESTRA_CONF_UNICAST_PERIOD */
 
+/* Length of the slotframe of the unicast_traffic_adaptive rule */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_UNICAST_PERIOD
+#define ORCHESTRA_ADAPTIVE_UNICAST_PERIOD         ORCHESTRA_CONF_ADAPTIVE_UNICAST_PERIOD
+#else /* ORCHESTRA_CONF_ADAPTIVE_UNICAST_PERIOD */
+#define ORCHESTRA_ADAPTIVE_UNICAST_PERIOD         23
+#endif /* ORCHESTRA_CONF_ADAPTIVE_UNICAST_PERIOD */
+
+/* unicast_traffic_adaptive: maximum number of cells per node */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS
+#define ORCHESTRA_ADAPTIVE_MAX_CELLS              ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS
+#else /* ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS */
+#define ORCHESTRA_ADAPTIVE_MAX_CELLS              4
+#endif /* ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS */
+
+/* unicast_traffic_adaptive: number of descendants per additional cell */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_NODES_PER_CELL
+#define ORCHESTRA_ADAPTIVE_NODES_PER_CELL         ORCHESTRA_CONF_ADAPTIVE_NODES_PER_CELL
+#else /* ORCHESTRA_CONF_ADAPTIVE_NODES_PER_CELL */
+#define ORCHESTRA_ADAPTIVE_NODES_PER_CELL         4
+#endif /* ORCHESTRA_CONF_ADAPTIVE_NODES_PER_CELL */
+
+/* unicast_traffic_adaptive: timeslot offset between two cells of a node */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_CELL_STRIDE
+#define ORCHESTRA_ADAPTIVE_CELL_STRIDE            ORCHESTRA_CONF_ADAPTIVE_CELL_STRIDE
+#else /* ORCHESTRA_CONF_ADAPTIVE_CELL_STRIDE */
+#define ORCHESTRA_ADAPTIVE_CELL_STRIDE            (ORCHESTRA_ADAPTIVE_UNICAST_PERIOD / ORCHESTRA_ADAPTIVE_MAX_CELLS)
+#endif /* ORCHESTRA_CONF_ADAPTIVE_CELL_STRIDE */
+
+/* unicast_traffic_adaptive: queue length to the parent above which packets
+ * may use any Tx cell */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_QUEUE_THRESHOLD
+#define ORCHESTRA_ADAPTIVE_QUEUE_THRESHOLD        ORCHESTRA_CONF_ADAPTIVE_QUEUE_THRESHOLD
+#else /* ORCHESTRA_CONF_ADAPTIVE_QUEUE_THRESHOLD */
+#define ORCHESTRA_ADAPTIVE_QUEUE_THRESHOLD        4
+#endif /* ORCHESTRA_CONF_ADAPTIVE_QUEUE_THRESHOLD */
+
+/* unicast_traffic_adaptive: length, in slotframes, of the windows in which
+ * the frames sent to the parent are counted. Cells are updated at the start
+ * of every window. */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_LOAD_WINDOW
+#define ORCHESTRA_ADAPTIVE_LOAD_WINDOW            ORCHESTRA_CONF_ADAPTIVE_LOAD_WINDOW
+#else /* ORCHESTRA_CONF_ADAPTIVE_LOAD_WINDOW */
+#define ORCHESTRA_ADAPTIVE_LOAD_WINDOW            8
+#endif /* ORCHESTRA_CONF_ADAPTIVE_LOAD_WINDOW */
+
+/* unicast_traffic_adaptive: number of frames per window and per cell above
+ * which a node gets an additional cell */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_CELL_LOAD
+#define ORCHESTRA_ADAPTIVE_CELL_LOAD              ORCHESTRA_CONF_ADAPTIVE_CELL_LOAD
+#else /* ORCHESTRA_CONF_ADAPTIVE_CELL_LOAD */
+#define ORCHESTRA_ADAPTIVE_CELL_LOAD              (ORCHESTRA_ADAPTIVE_LOAD_WINDOW / 2)
+#endif /* ORCHESTRA_CONF_ADAPTIVE_CELL_LOAD */
+
 /* Is the per-neighbor unicast slotframe sender-based (if not, it is receiver-based).
  * Note: sender-based works only with RPL storing mode as it relies on DAO and
  * routing entries to keep track of children and parents. */
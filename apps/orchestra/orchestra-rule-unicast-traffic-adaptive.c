@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+/**
+ * \file
+ *         Orchestra: a sender-based slotframe dedicated to upwards unicast
+ *         traffic, where nodes get a number of cells that grows with the
+ *         size of their RPL sub-tree and with their traffic to their parent:
+ *           cells(node) = max(1 + descendants(node) / ORCHESTRA_ADAPTIVE_NODES_PER_CELL,
+ *                             1 + load(node) / ORCHESTRA_ADAPTIVE_CELL_LOAD),
+ *           up to ORCHESTRA_ADAPTIVE_MAX_CELLS
+ *         Cell i of a node is at timeslot
+ *           (hash(node.MAC) + i * ORCHESTRA_ADAPTIVE_CELL_STRIDE) % ORCHESTRA_ADAPTIVE_UNICAST_PERIOD
+ *         Nodes transmit in their own cells, and listen in the cells of each of
+ *         their children. Both ends compute the cells of a link from local
+ *         state that describes the same thing:
+ *         - descendants(node): the routes the node has other than through its
+ *           parent, and at the parent, the routes through the node other
+ *           than the route to the node itself. The parent learns a route
+ *           from a DAO that the node forwards after adding the route itself,
+ *           so the parent's count lags. The node uses the smaller of its
+ *           counts at the start of this and the previous window, and the
+ *           parent the larger of its current count and its count at the
+ *           start of this window. A change is then used by the parent first,
+ *           as long as the DAO takes less than a window to get there.
+ *         - load(node): the frames the node got ACKed by its parent in the
+ *           previous window of ORCHESTRA_ADAPTIVE_LOAD_WINDOW slotframes, and
+ *           at the parent, the frames it received from the node in that
+ *           window. Both count every frame, fragments included. Windows
+ *           start at the same ASN on all nodes, and the cells are updated at
+ *           the start of each window. A node with a backlog uses all its
+ *           cells, so a growing queue adds cells.
+ *         When the queue to the parent holds ORCHESTRA_ADAPTIVE_QUEUE_THRESHOLD
+ *         packets or more, packets may also be sent in any Tx cell of any
+ *         slotframe.
+ *         Requires RPL storing mode. Use before unicast_per_neighbor, which
+ *         handles all other unicast traffic.
+ */
+
+#include "contiki.h"
+#include "orchestra.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/mac/frame802154.h"
+#include "net/mac/tsch/tsch-private.h"
+#include "net/packetbuf.h"
+#include "sys/ctimer.h"
+
+/* Length of a load window, in timeslots */
+#define LOAD_WINDOW_SLOTS ((uint32_t)ORCHESTRA_ADAPTIVE_LOAD_WINDOW * ORCHESTRA_ADAPTIVE_UNICAST_PERIOD)
+
+/* Descendants of a node, counted when a window starts */
+struct adaptive_descendants {
+  uint16_t window;  /* window of start */
+  uint8_t start;    /* count at the start of that window */
+  uint8_t prev;     /* count at the start of the window before */
+};
+
+/* Our parent or one of our children */
+struct adaptive_nbr {
+  /* Frames sent to the parent, or received from a child */
+  uint16_t window;  /* window of count */
+  uint8_t count;    /* frames in that window */
+  uint8_t last;     /* frames in the window before */
+  /* Descendants of a child */
+  struct adaptive_descendants descendants;
+};
+NBR_TABLE(struct adaptive_nbr, adaptive_nbrs);
+
+static uint16_t slotframe_handle = 0;
+static uint16_t channel_offset = 0;
+static struct tsch_slotframe *sf_adaptive;
+static struct ctimer update_timer;
+/* Number of our own Tx cells in the slotframe */
+static uint8_t tx_cells;
+/* Our own descendants */
+static struct adaptive_descendants own_descendants;
+/* The link options of each timeslot, built by update_links() */
+static uint8_t timeslot_options[ORCHESTRA_ADAPTIVE_UNICAST_PERIOD];
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_node_timeslot(const linkaddr_t *addr, uint8_t cell)
+{
+  if(addr != NULL && ORCHESTRA_ADAPTIVE_UNICAST_PERIOD > 0) {
+    return (ORCHESTRA_LINKADDR_HASH(addr) + cell * ORCHESTRA_ADAPTIVE_CELL_STRIDE)
+      % ORCHESTRA_ADAPTIVE_UNICAST_PERIOD;
+  } else {
+    return 0xffff;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+current_window(void)
+{
+  return current_asn.ls4b / LOAD_WINDOW_SLOTS;
+}
+/*---------------------------------------------------------------------------*/
+/* Start a new window if needed. Windows without traffic leave no entry
+ * behind, so the previous count is only kept for consecutive windows. */
+static void
+load_rotate(struct adaptive_nbr *l, uint16_t window)
+{
+  if(l->window != window) {
+    l->last = (uint16_t)(l->window + 1) == window ? l->count : 0;
+    l->window = window;
+    l->count = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The number of frames to or from a neighbor in the previous window */
+static uint8_t
+get_load(const linkaddr_t *addr)
+{
+  struct adaptive_nbr *l = nbr_table_get_from_lladdr(adaptive_nbrs, addr);
+  if(l == NULL) {
+    return 0;
+  }
+  load_rotate(l, current_window());
+  return l->last;
+}
+/*---------------------------------------------------------------------------*/
+/* Our entry for a neighbor, added if needed */
+static struct adaptive_nbr *
+get_nbr(const linkaddr_t *addr)
+{
+  struct adaptive_nbr *l = nbr_table_get_from_lladdr(adaptive_nbrs, addr);
+  if(l == NULL) {
+    /* the neighbor is already known to RPL, this only adds our entry */
+    l = nbr_table_add_lladdr(adaptive_nbrs, addr);
+    if(l == NULL) {
+      return NULL;
+    }
+    memset(l, 0, sizeof(*l));
+    l->window = current_window();
+    l->descendants.window = l->window - 2;
+  }
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+static void
+count_load(const linkaddr_t *addr)
+{
+  struct adaptive_nbr *l = get_nbr(addr);
+  if(l == NULL) {
+    return;
+  }
+  load_rotate(l, current_window());
+  if(l->count < 0xff) {
+    l->count++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Record the descendant count at the start of a new window. The first
+ * count seen in a window stands for its start. */
+static void
+descendants_rotate(struct adaptive_descendants *d, int count)
+{
+  uint16_t window = current_window();
+
+  if(count > 0xff) {
+    count = 0xff;
+  }
+  if(d->window != window) {
+    d->prev = (uint16_t)(d->window + 1) == window ? d->start : count;
+    d->start = count;
+    d->window = window;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+get_num_cells(int descendants, uint8_t load)
+{
+  int cells = 1 + descendants / ORCHESTRA_ADAPTIVE_NODES_PER_CELL;
+  int load_cells = 1 + load / ORCHESTRA_ADAPTIVE_CELL_LOAD;
+  if(load_cells > cells) {
+    cells = load_cells;
+  }
+  return cells < ORCHESTRA_ADAPTIVE_MAX_CELLS ? cells : ORCHESTRA_ADAPTIVE_MAX_CELLS;
+}
+/*---------------------------------------------------------------------------*/
+/* Number of routes through a neighbor. If skip_own is set, the route to the
+ * neighbor itself is not counted. */
+static int
+count_routes_via(const linkaddr_t *addr, int skip_own)
+{
+  struct uip_ds6_route_neighbor_routes *routes;
+  struct uip_ds6_route_neighbor_route *r;
+  uip_ipaddr_t iid;
+  int count = 0;
+
+  routes = nbr_table_get_from_lladdr(nbr_routes, addr);
+  if(routes == NULL) {
+    return 0;
+  }
+  uip_ds6_set_addr_iid(&iid, (uip_lladdr_t *)addr);
+  for(r = list_head(routes->route_list); r != NULL; r = list_item_next(r)) {
+    if(!skip_own || memcmp(&r->route->ipaddr.u8[8], &iid.u8[8], 8) != 0) {
+      count++;
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static int
+has_parent(void)
+{
+  return orchestra_parent_knows_us
+    && !linkaddr_cmp(&orchestra_parent_linkaddr, &linkaddr_null);
+}
+/*---------------------------------------------------------------------------*/
+/* Mark the cells of a node in timeslot_options */
+static void
+mark_cells(const linkaddr_t *addr, uint8_t num_cells, uint8_t options)
+{
+  uint8_t i;
+
+  for(i = 0; i < num_cells; i++) {
+    timeslot_options[get_node_timeslot(addr, i)] |= options;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Bring the slotframe in line with the current parent, children, sub-tree
+ * sizes and loads */
+static void
+update_links(void)
+{
+  uint16_t timeslot;
+  nbr_table_item_t *item;
+  struct adaptive_nbr *n;
+  int descendants;
+
+  memset(timeslot_options, 0, sizeof(timeslot_options));
+
+  /* Our own cells, to transmit to our parent */
+  if(has_parent()) {
+    descendants = uip_ds6_route_num_routes()
+      - count_routes_via(&orchestra_parent_linkaddr, 0);
+    descendants_rotate(&own_descendants, descendants);
+    descendants = MIN(own_descendants.start, own_descendants.prev);
+    mark_cells(&linkaddr_node_addr,
+               get_num_cells(descendants,
+                             get_load(&orchestra_parent_linkaddr)),
+               LINK_OPTION_TX | LINK_OPTION_SHARED);
+  }
+
+  /* The cells of our children (all route next hops), computed once per
+   * child */
+  for(item = nbr_table_head(nbr_routes); item != NULL;
+      item = nbr_table_next(nbr_routes, item)) {
+    linkaddr_t *addr = nbr_table_get_lladdr(nbr_routes, item);
+    if(linkaddr_cmp(addr, &orchestra_parent_linkaddr)) {
+      continue;
+    }
+    descendants = count_routes_via(addr, 1);
+    n = get_nbr(addr);
+    if(n != NULL) {
+      descendants_rotate(&n->descendants, descendants);
+      descendants = MAX(descendants, n->descendants.start);
+    }
+    mark_cells(addr, get_num_cells(descendants, get_load(addr)),
+               LINK_OPTION_RX);
+  }
+
+  tx_cells = 0;
+  for(timeslot = 0; timeslot < ORCHESTRA_ADAPTIVE_UNICAST_PERIOD; timeslot++) {
+    uint8_t options = timeslot_options[timeslot];
+    struct tsch_link *l = tsch_schedule_get_link_by_timeslot(sf_adaptive, timeslot);
+    if(options == 0) {
+      if(l != NULL) {
+        tsch_schedule_remove_link(sf_adaptive, l);
+      }
+    } else if(l == NULL || l->link_options != options) {
+      tsch_schedule_add_link(sf_adaptive, options,
+                             LINK_TYPE_NORMAL, &tsch_broadcast_address,
+                             timeslot, channel_offset);
+    }
+    if(options & LINK_OPTION_TX) {
+      tx_cells++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Update the links again just after the start of the next load window */
+static void
+update_timer_callback(void *ptr)
+{
+  uint32_t slots = LOAD_WINDOW_SLOTS;
+
+  update_links();
+  if(tsch_is_associated) {
+    slots -= current_asn.ls4b % LOAD_WINDOW_SLOTS;
+  }
+  ctimer_set(&update_timer,
+             1 + slots * TSCH_DEFAULT_TS_TIMESLOT_LENGTH / (1000000UL / CLOCK_SECOND),
+             update_timer_callback, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_added(const linkaddr_t *linkaddr)
+{
+  update_links();
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_removed(const linkaddr_t *linkaddr)
+{
+  update_links();
+}
+/*---------------------------------------------------------------------------*/
+/* Count the frames received from our children. This runs once per
+ * frame, fragments included. */
+static void
+packet_received(void)
+{
+  const linkaddr_t *src = packetbuf_addr(PACKETBUF_ADDR_SENDER);
+  if(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &linkaddr_node_addr)
+     && !linkaddr_cmp(src, &orchestra_parent_linkaddr)
+     && nbr_table_get_from_lladdr(nbr_routes, src) != NULL) {
+    count_load(src);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Count the frames ACKed by our parent, fragments included, as our
+ * parent counts every frame it receives from us */
+static void
+packet_sent(int mac_status)
+{
+  if(mac_status != MAC_TX_OK || !has_parent()) {
+    return;
+  }
+  if(tx_cells == 0) {
+    /* our parent just ACKed our DAO */
+    update_links();
+  }
+  if(linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &orchestra_parent_linkaddr)) {
+    count_load(&orchestra_parent_linkaddr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+select_packet(uint16_t *slotframe, uint16_t *timeslot)
+{
+  /* Select data packets to our parent, once we have cells for it */
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  if(packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME
+     && has_parent() && tx_cells > 0
+     && linkaddr_cmp(dest, &orchestra_parent_linkaddr)) {
+    /* Under backlog, allow the packet to go in any Tx cell to the parent */
+    int backlog = tsch_queue_packet_count(dest) >= ORCHESTRA_ADAPTIVE_QUEUE_THRESHOLD;
+    if(slotframe != NULL) {
+      *slotframe = backlog ? 0xffff : slotframe_handle;
+    }
+    if(timeslot != NULL) {
+      *timeslot = 0xffff;
+    }
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+new_time_source(const struct tsch_neighbor *old, const struct tsch_neighbor *new)
+{
+  if(new != old) {
+    const linkaddr_t *new_addr = new != NULL ? &new->addr : NULL;
+    if(new_addr != NULL) {
+      linkaddr_copy(&orchestra_parent_linkaddr, new_addr);
+    } else {
+      linkaddr_copy(&orchestra_parent_linkaddr, &linkaddr_null);
+    }
+    update_links();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(uint16_t sf_handle)
+{
+  slotframe_handle = sf_handle;
+  channel_offset = sf_handle;
+  nbr_table_register(adaptive_nbrs, NULL);
+  own_descendants.window = current_window() - 2;
+  /* Slotframe for upwards unicast transmissions */
+  sf_adaptive = tsch_schedule_add_slotframe(slotframe_handle, ORCHESTRA_ADAPTIVE_UNICAST_PERIOD);
+  /* Sub-tree sizes and loads change without any Orchestra callback.
+   * Refresh the links at the start of every load window. */
+  update_timer_callback(NULL);
+}
+/*---------------------------------------------------------------------------*/
+struct orchestra_rule unicast_traffic_adaptive = {
+  init,
+  new_time_source,
+  select_packet,
+  child_added,
+  child_removed,
+  packet_received,
+  packet_sent,
+};
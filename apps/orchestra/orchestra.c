@@ -64,11 +64,18 @@ const struct orchestra_rule *all_rules[] = ORCHESTRA_RULES;
 static void
 orchestra_packet_received(void)
 {
+  int i;
+  for(i = 0; i < NUM_RULES; i++) {
+    if(all_rules[i]->packet_received != NULL) {
+      all_rules[i]->packet_received();
+    }
+  }
 }
 /*---------------------------------------------------------------------------*/
 static void
 orchestra_packet_sent(int mac_status)
 {
+  int i;
   /* Check if our parent just ACKed a DAO */
   if(orchestra_parent_knows_us == 0
      && mac_status == MAC_TX_OK
@@ -79,6 +86,11 @@ orchestra_packet_sent(int mac_status)
       orchestra_parent_knows_us = 1;
     }
   }
+  for(i = 0; i < NUM_RULES; i++) {
+    if(all_rules[i]->packet_sent != NULL) {
+      all_rules[i]->packet_sent(mac_status);
+    }
+  }
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -50,10 +50,13 @@ struct orchestra_rule {
   int  (* select_packet)(uint16_t *slotframe, uint16_t *timeslot);
   void (* child_added)(const linkaddr_t *addr);
   void (* child_removed)(const linkaddr_t *addr);
+  void (* packet_received)(void);
+  void (* packet_sent)(int mac_status);
 };
 
 struct orchestra_rule eb_per_time_source;
 struct orchestra_rule unicast_per_neighbor;
+struct orchestra_rule unicast_traffic_adaptive;
 struct orchestra_rule default_common;
 
 extern linkaddr_t orchestra_parent_linkaddr;
@@ -59,6 +59,95 @@ PROCESS(rest_engine_process, "REST Engine");
 LIST(restful_services);
 LIST(restful_periodic_services);
 /*---------------------------------------------------------------------------*/
+/* URI-path hash table over the activated resources, chained through hash_next */
+static resource_t *url_table[REST_ENGINE_HASH_SIZE];
+static uint16_t resource_count;
+/*---------------------------------------------------------------------------*/
+#define URL_HASH_INIT 5381
+#define URL_HASH_STEP(h, c) ((uint16_t)(((h) << 5) + (h) + (uint8_t)(c)))
+/*---------------------------------------------------------------------------*/
+static uint16_t
+url_hash(const char *url, int len)
+{
+  uint16_t h = URL_HASH_INIT;
+
+  while(len-- > 0) {
+    h = URL_HASH_STEP(h, *url++);
+  }
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the first activated resource with exactly the given URI path, or
+ * NULL. If sub_only is set, only resources with HAS_SUB_RESOURCES qualify.
+ */
+static resource_t *
+url_lookup(uint16_t hash, const char *url, int len, uint8_t sub_only)
+{
+  resource_t *r;
+
+  for(r = url_table[hash % REST_ENGINE_HASH_SIZE]; r != NULL;
+      r = r->hash_next) {
+    if(r->url_len == len && memcmp(r->url, url, len) == 0
+       && (!sub_only || (r->flags & HAS_SUB_RESOURCES))) {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the link pointing at an activated resource in its bucket, or NULL
+ * if the resource is not activated.
+ */
+static resource_t **
+url_link(const resource_t *resource)
+{
+  resource_t **r;
+
+  if(resource->url == NULL) {
+    return NULL;
+  }
+  for(r = &url_table[url_hash(resource->url, resource->url_len)
+                     % REST_ENGINE_HASH_SIZE];
+      *r != NULL; r = &(*r)->hash_next) {
+    if(*r == resource) {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Finds the resource handling a request URI path. A resource matches if its
+ * path equals the request path, or if it has sub-resources and its path is a
+ * prefix of the request path ending at a '/'. As with the former linear scan,
+ * the earliest activated of all matching resources is returned.
+ */
+static resource_t *
+url_dispatch(const char *url, int url_len)
+{
+  resource_t *best = NULL;
+  resource_t *r;
+  uint16_t h = URL_HASH_INIT;
+  int i;
+
+  for(i = 0; i < url_len; i++) {
+    if(url[i] == '/') {
+      r = url_lookup(h, url, i, 1);
+      if(r != NULL && (best == NULL || r->index < best->index)) {
+        best = r;
+      }
+    }
+    h = URL_HASH_STEP(h, url[i]);
+  }
+  r = url_lookup(h, url, url_len, 0);
+  if(r != NULL && (best == NULL || r->index < best->index)) {
+    best = r;
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
 /*- REST Engine API ---------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 /**
@@ -80,6 +169,8 @@ rest_init_engine(void)
   initialized = 1;
 
   list_init(restful_services);
+  memset(url_table, 0, sizeof(url_table));
+  resource_count = 0;
 
   REST.set_service_callback(rest_invoke_restful_service);
 
@@ -98,13 +189,38 @@ rest_init_engine(void)
  * The resource implementation must be imported first using the
  * extern keyword. The build system takes care of compiling every
  * *.c file in the ./resources/ sub-directory (see example Makefile).
+ *
+ * Activating a resource again under the same path has no effect. Under
+ * another path, the resource is moved to the new path as if it was
+ * activated for the first time.
  */
 void
 rest_activate_resource(resource_t *resource, char *path)
 {
+  resource_t **bucket;
+
+  bucket = url_link(resource);
+  if(bucket != NULL) {
+    if(strcmp(resource->url, path) == 0) {
+      PRINTF("Already active: %s\n", path);
+      return;
+    }
+    /* unlink from the bucket of the former path */
+    *bucket = resource->hash_next;
+  }
   resource->url = path;
+  resource->url_len = strlen(path);
+  resource->index = resource_count++;
+  resource->hash_next = NULL;
   list_add(restful_services, resource);
 
+  /* append to keep activation order within the bucket */
+  bucket = &url_table[url_hash(path, resource->url_len) % REST_ENGINE_HASH_SIZE];
+  while(*bucket != NULL) {
+    bucket = &(*bucket)->hash_next;
+  }
+  *bucket = resource;
+
   PRINTF("Activating: %s\n", resource->url);
 
   /* Only add periodic resources with a periodic_handler and a period > 0. */
@@ -133,44 +249,34 @@ rest_invoke_restful_service(void *request, void *response, uint8_t *buffer,
 
   resource_t *resource = NULL;
   const char *url = NULL;
-  int url_len, res_url_len;
+  int url_len;
 
   url_len = REST.get_url(request, &url);
-  for(resource = (resource_t *)list_head(restful_services);
-      resource; resource = resource->next) {
-
-    /* if the web service handles that kind of requests and urls matches */
-    res_url_len = strlen(resource->url);
-    if((url_len == res_url_len
-        || (url_len > res_url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && url[res_url_len] == '/'))
-       && strncmp(resource->url, url, res_url_len) == 0) {
-      found = 1;
-      rest_resource_flags_t method = REST.get_method_type(request);
-
-      PRINTF("/%s, method %u, resource->flags %u\n", resource->url,
-             (uint16_t)method, resource->flags);
-
-      if((method & METHOD_GET) && resource->get_handler != NULL) {
-        /* call handler function */
-        resource->get_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_POST) && resource->post_handler != NULL) {
-        /* call handler function */
-        resource->post_handler(request, response, buffer, buffer_size,
+  resource = url_dispatch(url, url_len);
+  if(resource != NULL) {
+    found = 1;
+    rest_resource_flags_t method = REST.get_method_type(request);
+
+    PRINTF("/%s, method %u, resource->flags %u\n", resource->url,
+           (uint16_t)method, resource->flags);
+
+    if((method & METHOD_GET) && resource->get_handler != NULL) {
+      /* call handler function */
+      resource->get_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_POST) && resource->post_handler != NULL) {
+      /* call handler function */
+      resource->post_handler(request, response, buffer, buffer_size,
+                             offset);
+    } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
+      /* call handler function */
+      resource->put_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
+      /* call handler function */
+      resource->delete_handler(request, response, buffer, buffer_size,
                                offset);
-      } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
-        /* call handler function */
-        resource->put_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
-        /* call handler function */
-        resource->delete_handler(request, response, buffer, buffer_size,
-                                 offset);
-      } else {
-        allowed = 0;
-        REST.set_response_status(response, REST.status.METHOD_NOT_ALLOWED);
-      }
-      break;
+    } else {
+      allowed = 0;
+      REST.set_response_status(response, REST.status.METHOD_NOT_ALLOWED);
     }
   }
   if(!found) {
@@ -62,6 +62,17 @@
 #define REST_MAX_CHUNK_SIZE     64
 #endif
 
+/*
+ * Number of buckets in the URI-path hash table used to dispatch requests.
+ * Lookup cost no longer grows with the number of activated resources as long
+ * as the table is not much smaller than the resource count.
+ */
+#ifdef REST_ENGINE_CONF_HASH_SIZE
+#define REST_ENGINE_HASH_SIZE REST_ENGINE_CONF_HASH_SIZE
+#else
+#define REST_ENGINE_HASH_SIZE   16
+#endif
+
 struct resource_s;
 struct periodic_resource_s;
 
@@ -95,6 +106,9 @@ struct resource_s {
     restful_trigger_handler trigger;
     restful_trigger_handler resume;
   };
+  struct resource_s *hash_next;   /* next resource in the same URI hash bucket */
+  uint16_t url_len;               /* cached strlen(url), set on activation */
+  uint16_t index;                 /* activation order, first match wins */
 };
 typedef struct resource_s resource_t;
 
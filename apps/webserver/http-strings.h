@@ -14,8 +14,19 @@ extern const char http_index_htm[11];
 extern const char http_index_html[12];
 extern const char http_404_html[10];
 extern const char http_referer[9];
+extern const char http_accept_encoding[17];
+extern const char http_gzip[5];
+extern const char http_connection[12];
+extern const char http_close[6];
 extern const char http_header_200[85];
 extern const char http_header_404[92];
+extern const char http_header_200_11[66];
+extern const char http_header_404_11[73];
+extern const char http_content_length[17];
+extern const char http_transfer_encoding_chunked[29];
+extern const char http_chunked_end[6];
+extern const char http_content_encoding_gzip[48];
+extern const char http_vary_accept_encoding[24];
 extern const char http_content_type_plain[29];
 extern const char http_content_type_html[28];
 extern const char http_content_type_css [27];
@@ -43,6 +43,7 @@
 static uint16_t count[HTTPD_FS_NUMFILES];
 #endif /* HTTPD_FS_STATISTICS */
 
+#ifndef HTTPD_FS_HASH_SIZE
 /*-----------------------------------------------------------------------------------*/
 static uint8_t
 httpd_fs_strcmp(const char *str1, const char *str2)
@@ -66,7 +67,8 @@ loop:
 }
 /*-----------------------------------------------------------------------------------*/
 int
-httpd_fs_open(const char *name, struct httpd_fs_file *file)
+httpd_fs_open_accept(const char *name, struct httpd_fs_file *file,
+                     uint8_t accept)
 {
 #if HTTPD_FS_STATISTICS
   uint16_t i = 0;
@@ -80,6 +82,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
     if(httpd_fs_strcmp(name, f->name) == 0) {
       file->data = f->data;
       file->len = f->len;
+      file->encoding = 0;
 #if HTTPD_FS_STATISTICS
       ++count[i];
 #endif /* HTTPD_FS_STATISTICS */
@@ -92,6 +95,90 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
   }
   return 0;
 }
+#else /* HTTPD_FS_HASH_SIZE */
+/*-----------------------------------------------------------------------------------*/
+/* A requested name ends at the end of the string, the end of the
+   line or the start of a query. */
+#define NAME_END(c) ((c) == 0 || (c) == '\r' || (c) == '\n' || (c) == '?')
+
+/* Must match the hash computed by tools/makefsdata. */
+static uint16_t
+httpd_fs_namehash(const char *name)
+{
+  uint16_t h;
+
+  h = 0;
+  while(!NAME_END(*name)) {
+    h = h * 31 + (uint8_t)*name++;
+  }
+  return h;
+}
+/*-----------------------------------------------------------------------------------*/
+static uint8_t
+httpd_fs_namecmp(const char *name, const char *fname)
+{
+  while(*fname != 0) {
+    if(*name++ != *fname++) {
+      return 1;
+    }
+  }
+  return !NAME_END(*name);
+}
+/*-----------------------------------------------------------------------------------*/
+static const struct httpd_fsdata_hash *
+httpd_fs_lookup(const char *name)
+{
+  const struct httpd_fsdata_hash *e;
+  uint16_t h;
+  uint8_t i;
+
+  h = httpd_fs_namehash(name);
+  for(i = 0; i < HTTPD_FS_HASH_SIZE; i++) {
+    e = &httpd_fs_hash[(h + i) & (HTTPD_FS_HASH_SIZE - 1)];
+    if(e->file == NULL) {
+      break;
+    }
+    if(httpd_fs_namecmp(name, e->file->name) == 0) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*-----------------------------------------------------------------------------------*/
+int
+httpd_fs_open_accept(const char *name, struct httpd_fs_file *file,
+                     uint8_t accept)
+{
+  const struct httpd_fsdata_hash *e;
+  const struct httpd_fsdata_file *f;
+
+  e = httpd_fs_lookup(name);
+  if(e == NULL) {
+    return 0;
+  }
+  f = e->file;
+  file->encoding = 0;
+  if(e->gzip != NULL) {
+    file->encoding = HTTPD_FS_VARY;
+    if(accept & HTTPD_FS_GZIP) {
+      f = e->gzip;
+      file->encoding |= HTTPD_FS_GZIP;
+    }
+  }
+  file->data = (char *)f->data;
+  file->len = f->len;
+#if HTTPD_FS_STATISTICS
+  ++count[e->index];
+#endif /* HTTPD_FS_STATISTICS */
+  return 1;
+}
+#endif /* HTTPD_FS_HASH_SIZE */
+/*-----------------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  return httpd_fs_open_accept(name, file, 0);
+}
 /*-----------------------------------------------------------------------------------*/
 void
 httpd_fs_init(void)
@@ -108,6 +195,12 @@ httpd_fs_init(void)
 uint16_t
 httpd_fs_count(char *name)
 {
+#ifdef HTTPD_FS_HASH_SIZE
+  const struct httpd_fsdata_hash *e;
+
+  e = httpd_fs_lookup(name);
+  return e == NULL ? 0 : count[e->index];
+#else /* HTTPD_FS_HASH_SIZE */
   struct httpd_fsdata_file_noconst *f;
   uint16_t i;
 
@@ -122,6 +215,7 @@ httpd_fs_count(char *name)
     ++i;
   }
   return 0;
+#endif /* HTTPD_FS_HASH_SIZE */
 }
 #endif /* HTTPD_FS_STATISTICS */
 /*-----------------------------------------------------------------------------------*/
@@ -38,15 +38,29 @@
 
 #define HTTPD_FS_STATISTICS 1
 
+/* Content encodings of a file. */
+#define HTTPD_FS_GZIP 0x01
+/* Set in file->encoding when the file has more than one encoding, so
+   that the response depends on what the client accepts. */
+#define HTTPD_FS_VARY 0x80
+
 struct httpd_fs_file {
   char *data;
   int len;
+  uint8_t encoding;
 };
 
 /* file must be allocated by caller and will be filled in
    by the function. */
 int httpd_fs_open(const char *name, struct httpd_fs_file *file);
 
+/* Like httpd_fs_open(), but opens a compressed copy of the file if
+   there is one in an encoding that is set in the accept mask. The
+   encoding of the opened data is returned in file->encoding, together
+   with HTTPD_FS_VARY if the file has a compressed copy. */
+int httpd_fs_open_accept(const char *name, struct httpd_fs_file *file,
+                         uint8_t accept);
+
 #ifdef HTTPD_FS_STATISTICS
 #if HTTPD_FS_STATISTICS == 1  
 uint16_t httpd_fs_count(char *name);
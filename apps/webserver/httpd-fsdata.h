@@ -60,4 +60,13 @@ struct httpd_fsdata_file_noconst {
 #endif /* HTTPD_FS_STATISTICS */
 };
 
+/* Slot in the file name hash table generated by makefsdata. gzip is
+   the compressed copy of file, if any, and index is the position of
+   file in the linked list. */
+struct httpd_fsdata_hash {
+  const struct httpd_fsdata_file *file;
+  const struct httpd_fsdata_file *gzip;
+  uint8_t index;
+};
+
 #endif /* HTTPD_FSDATA_H_ */
@@ -52,12 +52,21 @@
 #endif /* WEBSERVER_CONF_CGI_CONNS */
 
 #define STATE_WAITING 0
-#define STATE_OUTPUT  1
+#define STATE_CLOSING 1
+
+/* Chunk size line of up to four hex digits and the CRLF after the
+   chunk data. */
+#define CHUNK_OVERHEAD 8
+
+/* The outgoing segment, for framing chunks. */
+extern uint16_t uip_slen;
+extern void *uip_sappdata;
 
 #define SEND_STRING(s, str) PSOCK_SEND(s, (uint8_t *)str, (unsigned int)strlen(str))
 MEMB(conns, struct httpd_state, CONNS);
 
 #define ISO_nl      0x0a
+#define ISO_cr      0x0d
 #define ISO_space   0x20
 #define ISO_bang    0x21
 #define ISO_percent 0x25
@@ -66,21 +75,83 @@ MEMB(conns, struct httpd_state, CONNS);
 #define ISO_colon   0x3a
 
 /*---------------------------------------------------------------------------*/
+/*
+ * Fill the outgoing segment with the headers that have not been
+ * acknowledged yet, followed by file data if body is set. Both are
+ * copied straight from the constant strings and the file system into
+ * uip_appdata, so the first segment of a response carries the headers
+ * and the start of the file. The state is not changed apart from
+ * s->len, as psock calls the generator again on retransmissions.
+ */
 static unsigned short
-generate(void *state)
+gather(struct httpd_state *s, int body)
 {
-  struct httpd_state *s = (struct httpd_state *)state;
+  char *dst;
+  const char *src;
+  unsigned short room, n;
+  uint8_t i;
 
-  if(s->file.len > uip_mss()) {
-    s->len = uip_mss();
-  } else {
-    s->len = s->file.len;
+  dst = (char *)uip_appdata;
+  room = uip_mss();
+  for(i = 0; i < HTTPD_HDRS && s->hdr[i] != NULL && room > 0; i++) {
+    src = s->hdr[i];
+    if(i == 0) {
+      src += s->hdrpos;
+    }
+    n = (unsigned short)strlen(src);
+    if(n > room) {
+      n = room;
+    }
+    memcpy(dst, src, n);
+    dst += n;
+    room -= n;
   }
-  memcpy(uip_appdata, s->file.data, s->len);
-  
+  if(body) {
+    n = s->file.len > room ? room : (unsigned short)s->file.len;
+    memcpy(dst, s->file.data, n);
+    dst += n;
+  }
+  s->len = (int)(dst - (char *)uip_appdata);
+
   return s->len;
 }
 /*---------------------------------------------------------------------------*/
+static unsigned short
+generate(void *state)
+{
+  return gather((struct httpd_state *)state, 1);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate_headers(void *state)
+{
+  return gather((struct httpd_state *)state, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Move past len acknowledged bytes of headers and file data. */
+static void
+advance(struct httpd_state *s, int len)
+{
+  int n;
+  uint8_t i;
+
+  while(len > 0 && s->hdr[0] != NULL) {
+    n = (int)strlen(s->hdr[0]) - s->hdrpos;
+    if(len < n) {
+      s->hdrpos += len;
+      return;
+    }
+    len -= n;
+    s->hdrpos = 0;
+    for(i = 1; i < HTTPD_HDRS; i++) {
+      s->hdr[i - 1] = s->hdr[i];
+    }
+    s->hdr[HTTPD_HDRS - 1] = NULL;
+  }
+  s->file.data += len;
+  s->file.len -= len;
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_file(struct httpd_state *s))
 {
@@ -88,9 +159,8 @@ PT_THREAD(send_file(struct httpd_state *s))
   
   do {
     PSOCK_GENERATOR_SEND(&s->sout, generate, s);
-    s->file.len -= s->len;
-    s->file.data += s->len;
-  } while(s->file.len > 0);
+    advance(s, s->len);
+  } while(s->file.len > 0 || s->hdr[0] != NULL);
       
   PSOCK_END(&s->sout);
 }
@@ -181,17 +251,42 @@ PT_THREAD(handle_script(struct httpd_state *s))
   PT_END(&s->scriptpt);
 }
 /*---------------------------------------------------------------------------*/
-static
-PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
+static int
+is_script(struct httpd_state *s)
 {
-/* gcc warning if not initialized. 
- * If initialized, minimal-net platform segmentation fault if not static...
- */
-  static const char *ptr = NULL;
+  char *ptr;
 
-  PSOCK_BEGIN(&s->sout);
+  ptr = strrchr(s->filename, ISO_period);
+  return ptr != NULL && strncmp(ptr, http_shtml, 6) == 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Answer the requests that have been read, then close the
+ * connection. Returns non-zero if there is nothing left to answer.
+ */
+static int
+stop_reading(struct httpd_state *s)
+{
+  s->state = STATE_CLOSING;
+  if(s->nreq == 0) {
+    return 1;
+  }
+  s->req[s->nreq - 1].close = 1;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_headers(struct httpd_state *s, const char *statushdr)
+{
+  const char *ptr;
+  uint8_t i;
 
-  SEND_STRING(&s->sout, statushdr);
+  if(s->req[0].simple) {
+    /* The response to an HTTP/0.9 request is the body alone. */
+    memset(s->hdr, 0, sizeof(s->hdr));
+    s->hdrpos = 0;
+    return;
+  }
 
   ptr = strrchr(s->filename, ISO_period);
   if(ptr == NULL) {
@@ -210,90 +305,272 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
   } else {
     ptr = http_content_type_plain;
   }
-  SEND_STRING(&s->sout, ptr);
+
+  i = 0;
+  s->hdr[i++] = statushdr;
+  if(s->file.encoding & HTTPD_FS_GZIP) {
+    s->hdr[i++] = http_content_encoding_gzip;
+  } else if(s->file.encoding & HTTPD_FS_VARY) {
+    /* Caches must not give this to clients that accept gzip. */
+    s->hdr[i++] = http_vary_accept_encoding;
+  }
+  if(!s->req[0].close) {
+    /* The end of a response on a kept connection is given by its
+       length, or by the last chunk for scripts. */
+    if(is_script(s)) {
+      s->hdr[i++] = http_transfer_encoding_chunked;
+    } else {
+      sprintf(s->lenhdr, "%u\r\n", (unsigned int)s->file.len);
+      s->hdr[i++] = http_content_length;
+      s->hdr[i++] = s->lenhdr;
+    }
+  }
+  s->hdr[i++] = ptr;
+  while(i < HTTPD_HDRS) {
+    s->hdr[i++] = NULL;
+  }
+  s->hdrpos = 0;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(send_headers(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sout);
+
+  while(s->hdr[0] != NULL) {
+    PSOCK_GENERATOR_SEND(&s->sout, generate_headers, s);
+    advance(s, s->len);
+  }
+
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(handle_output(struct httpd_state *s))
 {
-  char *ptr;
-  
   PT_BEGIN(&s->outputpt);
- 
-  if(!httpd_fs_open(s->filename, &s->file)) {
-    strcpy(s->filename, http_404_html);
-    httpd_fs_open(s->filename, &s->file);
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_headers(s,
-		   http_header_404));
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_file(s));
-  } else {
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_headers(s,
-		   http_header_200));
-    ptr = strrchr(s->filename, ISO_period);
-    if(ptr != NULL && strncmp(ptr, http_shtml, 6) == 0) {
+
+  while(1) {
+    /* A request stays first in the queue until it has been answered. */
+    PT_WAIT_UNTIL(&s->outputpt, s->nreq > 0);
+    memcpy(s->filename, s->req[0].filename, sizeof(s->filename));
+    s->accept = s->req[0].accept;
+
+    /* Scripts are parsed while they are sent and are never compressed. */
+    if(is_script(s)) {
+      s->accept = 0;
+    }
+
+    /* The headers go out together with the start of the file, except
+       for scripts. */
+    if(!httpd_fs_open_accept(s->filename, &s->file, s->accept)) {
+      strcpy(s->filename, http_404_html);
+      httpd_fs_open_accept(s->filename, &s->file, s->accept);
+      set_headers(s, s->req[0].close ? http_header_404 : http_header_404_11);
+      PT_WAIT_THREAD(&s->outputpt,
+		     send_file(s));
+    } else if(is_script(s)) {
+      set_headers(s, s->req[0].close ? http_header_200 : http_header_200_11);
+      PT_WAIT_THREAD(&s->outputpt,
+		     send_headers(s));
+      if(!s->req[0].close) {
+	/* The script output is framed into chunks by
+	   handle_connection(). */
+	s->chunked = 1;
+	if(uip_mss() > 2 * CHUNK_OVERHEAD) {
+	  uip_conn->mss -= CHUNK_OVERHEAD;
+	}
+      }
       PT_INIT(&s->scriptpt);
       PT_WAIT_THREAD(&s->outputpt, handle_script(s));
+      if(s->chunked) {
+	s->chunked = 0;
+	s->hdr[0] = http_chunked_end;
+	s->hdrpos = 0;
+	PT_WAIT_THREAD(&s->outputpt,
+		       send_headers(s));
+      }
     } else {
+      if(s->file.len > 0xffff) {
+	/* Too long for lenhdr, so the end is marked by closing. */
+	s->req[0].close = 1;
+	s->nreq = 1;
+	s->state = STATE_CLOSING;
+      }
+      set_headers(s, s->req[0].close ? http_header_200 : http_header_200_11);
       PT_WAIT_THREAD(&s->outputpt,
 		     send_file(s));
     }
+
+    if(s->req[0].close) {
+      break;
+    }
+    memmove(&s->req[0], &s->req[1], sizeof(s->req) - sizeof(s->req[0]));
+    s->nreq--;
   }
   PSOCK_CLOSE(&s->sout);
   PT_END(&s->outputpt);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Read requests into the queue. A client may send the next request
+ * before the previous one has been answered, so input is read while
+ * output is going on. uIP does not keep data that the application has
+ * not read, so when a request arrives and the queue is full, the
+ * connection is closed after the last queued request and the client
+ * has to send the rest again.
+ */
 static
 PT_THREAD(handle_input(struct httpd_state *s))
 {
+  char *ptr;
+
   PSOCK_BEGIN(&s->sin);
 
-  PSOCK_READTO(&s->sin, ISO_space);
-  
-  if(strncmp(s->inputbuf, http_get, 4) != 0) {
-    PSOCK_CLOSE_EXIT(&s->sin);
-  }
-  PSOCK_READTO(&s->sin, ISO_space);
+  while(1) {
+    PSOCK_READTO(&s->sin, ISO_space);
 
-  if(s->inputbuf[0] != ISO_slash) {
-    PSOCK_CLOSE_EXIT(&s->sin);
-  }
+    if(strncmp(s->inputbuf, http_get, 4) != 0) {
+      if(stop_reading(s)) {
+	PSOCK_CLOSE_EXIT(&s->sin);
+      }
+      PSOCK_EXIT(&s->sin);
+    }
+    /* The rest of the request line is the path, followed by the
+       version unless this is an HTTP/0.9 simple request. */
+    PSOCK_READTO(&s->sin, ISO_nl);
 
-  if(s->inputbuf[1] == ISO_space) {
-    strncpy(s->filename, http_index_html, sizeof(s->filename));
-  } else {
-    s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
-    strncpy(s->filename, s->inputbuf, sizeof(s->filename));
-  }
+    if(s->inputbuf[0] != ISO_slash) {
+      if(stop_reading(s)) {
+	PSOCK_CLOSE_EXIT(&s->sin);
+      }
+      PSOCK_EXIT(&s->sin);
+    }
 
-  petsciiconv_topetscii(s->filename, sizeof(s->filename));
-  webserver_log_file(&uip_conn->ripaddr, s->filename);
-  petsciiconv_toascii(s->filename, sizeof(s->filename));
-  s->state = STATE_OUTPUT;
+    s->partial = s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] != ISO_nl;
+    s->inputbuf[PSOCK_DATALEN(&s->sin)] = 0;
+    ptr = s->inputbuf;
+    while(*ptr != 0 && *ptr != ISO_space &&
+	  *ptr != ISO_cr && *ptr != ISO_nl) {
+      ++ptr;
+    }
 
-  while(1) {
-    PSOCK_READTO(&s->sin, ISO_nl);
+    /* Only HTTP/1.1 connections are kept open. */
+    s->req[s->nreq].simple = *ptr != ISO_space;
+    s->req[s->nreq].close = !HTTPD_KEEPALIVE || *ptr != ISO_space ||
+      strncmp(ptr + 1, http_11, 8) != 0;
+
+    if(ptr == s->inputbuf + 1) {
+      strncpy(s->req[s->nreq].filename, http_index_html,
+	      sizeof(s->req[0].filename));
+    } else {
+      *ptr = 0;
+      strncpy(s->req[s->nreq].filename, s->inputbuf,
+	      sizeof(s->req[0].filename));
+    }
+    s->req[s->nreq].filename[sizeof(s->req[0].filename) - 1] = 0;
+
+    petsciiconv_topetscii(s->req[s->nreq].filename,
+			  sizeof(s->req[0].filename));
+    webserver_log_file(&uip_conn->ripaddr, s->req[s->nreq].filename);
+    petsciiconv_toascii(s->req[s->nreq].filename,
+			sizeof(s->req[0].filename));
+
+    /* If the request line is too long for inputbuf, the version is in
+       one of the pieces that are left. */
+    while(s->partial) {
+      PSOCK_READTO(&s->sin, ISO_nl);
+      s->inputbuf[PSOCK_DATALEN(&s->sin)] = 0;
+      if(strchr(s->inputbuf, ISO_space) != NULL) {
+	s->req[s->nreq].simple = 0;
+      }
+      s->partial = s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] != ISO_nl;
+    }
+
+    /* Read the header lines up to the empty line that ends the request
+       before the output starts, so that the content encoding is known.
+       Lines longer than inputbuf are read in pieces, and only the first
+       piece of a line is looked at. A simple request has no headers. */
+    s->req[s->nreq].accept = 0;
+    while(!s->req[s->nreq].simple) {
+      PSOCK_READTO(&s->sin, ISO_nl);
+
+      if(s->partial) {
+	/* Rest of a long line. */
+      } else if(strncmp(s->inputbuf, http_referer, 8) == 0) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
+	petsciiconv_topetscii(s->inputbuf, PSOCK_DATALEN(&s->sin) - 2);
+	webserver_log(s->inputbuf);
+      } else if(strncmp(s->inputbuf, http_accept_encoding, 16) == 0) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin)] = 0;
+	if(strstr(s->inputbuf + 16, http_gzip) != NULL) {
+	  s->req[s->nreq].accept |= HTTPD_FS_GZIP;
+	}
+      } else if(strncmp(s->inputbuf, http_connection, 11) == 0) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin)] = 0;
+	if(strstr(s->inputbuf + 11, http_close) != NULL) {
+	  s->req[s->nreq].close = 1;
+	}
+      } else if(s->inputbuf[0] == ISO_cr || s->inputbuf[0] == ISO_nl) {
+	break;
+      }
+      s->partial = s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] != ISO_nl;
+    }
 
-    if(strncmp(s->inputbuf, http_referer, 8) == 0) {
-      s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
-      petsciiconv_topetscii(s->inputbuf, PSOCK_DATALEN(&s->sin) - 2);
-      webserver_log(s->inputbuf);
+    if(s->req[s->nreq++].close) {
+      s->state = STATE_CLOSING;
+      PSOCK_EXIT(&s->sin);
+    }
+    if(s->nreq == HTTPD_REQS && s->sin.readlen > 0) {
+      /* The rest of the segment holds requests there is no room for. */
+      s->sin.readlen = 0;
+      stop_reading(s);
+      PSOCK_EXIT(&s->sin);
     }
   }
-  
+
   PSOCK_END(&s->sin);
 }
 /*---------------------------------------------------------------------------*/
+/* Put the chunk size line and the trailing CRLF around the data in the
+   outgoing segment. */
+static void
+frame_chunk(void)
+{
+  char size[7];
+  int n;
+
+  n = sprintf(size, "%x\r\n", (unsigned int)uip_slen);
+  memmove((char *)uip_sappdata + n, uip_sappdata, uip_slen);
+  memcpy(uip_sappdata, size, n);
+  memcpy((char *)uip_sappdata + n + uip_slen, http_crnl, 2);
+  uip_slen += n + 2;
+}
+/*---------------------------------------------------------------------------*/
 static void
 handle_connection(struct httpd_state *s)
 {
-  handle_input(s);
-  if(s->state == STATE_OUTPUT) {
-    handle_output(s);
+  uint16_t mss;
+
+  /* Keep room in the segment for the framing of a chunk. */
+  mss = uip_mss();
+  if(s->chunked && mss > 2 * CHUNK_OVERHEAD) {
+    uip_conn->mss = mss - CHUNK_OVERHEAD;
+  }
+
+  if(s->state == STATE_WAITING) {
+    if(s->nreq < HTTPD_REQS) {
+      handle_input(s);
+    } else if(uip_newdata()) {
+      stop_reading(s);
+    }
   }
+  handle_output(s);
+
+  if(s->chunked && uip_slen > 0) {
+    frame_chunk();
+  }
+  uip_conn->mss = mss;
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -316,6 +593,8 @@ httpd_appcall(void *state)
     PSOCK_INIT(&s->sout, (uint8_t *)s->inputbuf, sizeof(s->inputbuf) - 1);
     PT_INIT(&s->outputpt);
     s->state = STATE_WAITING;
+    s->nreq = 0;
+    s->chunked = 0;
     /*    timer_set(&s->timer, CLOCK_SECOND * 100);*/
     s->timer = 0;
     handle_connection(s);
@@ -323,8 +602,14 @@ httpd_appcall(void *state)
     if(uip_poll()) {
       ++s->timer;
       if(s->timer >= 20) {
-	uip_abort();
-	memb_free(&conns, s);
+	if(s->nreq == 0) {
+	  /* A kept connection that has not been used. */
+	  uip_close();
+	} else {
+	  uip_abort();
+	  memb_free(&conns, s);
+	}
+	return;
       }
     } else {
       s->timer = 0;
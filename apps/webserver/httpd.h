@@ -38,6 +38,31 @@
 #include "contiki-net.h"
 #include "httpd-fs.h"
 
+/* Maximum number of header strings sent before a file. */
+#define HTTPD_HDRS 5
+
+/* Keep HTTP/1.1 connections open between requests. */
+#ifdef WEBSERVER_CONF_KEEPALIVE
+#define HTTPD_KEEPALIVE WEBSERVER_CONF_KEEPALIVE
+#else /* WEBSERVER_CONF_KEEPALIVE */
+#define HTTPD_KEEPALIVE 1
+#endif /* WEBSERVER_CONF_KEEPALIVE */
+
+/* Number of pipelined requests per connection that are held until
+   they are answered, including the one being answered. */
+#ifdef WEBSERVER_CONF_REQS
+#define HTTPD_REQS WEBSERVER_CONF_REQS
+#else /* WEBSERVER_CONF_REQS */
+#define HTTPD_REQS 2
+#endif /* WEBSERVER_CONF_REQS */
+
+struct httpd_request {
+  char filename[20];
+  char accept;      /* Content encodings the client accepts. */
+  char close;       /* Close the connection after the response. */
+  char simple;      /* HTTP/0.9 request, answered without headers. */
+};
+
 struct httpd_state {
   unsigned char timer;
   struct psock sin, sout;
@@ -45,6 +70,14 @@ struct httpd_state {
   char inputbuf[50];
   char filename[20];
   char state;
+  char accept;      /* Content encodings the client accepts. */
+  char partial;     /* The last line read was not complete. */
+  char chunked;     /* Output is sent with chunked transfer encoding. */
+  unsigned char nreq;
+  struct httpd_request req[HTTPD_REQS];
+  unsigned char hdrpos;
+  const char *hdr[HTTPD_HDRS];
+  char lenhdr[8];   /* Content-Length value. */
   struct httpd_fs_file file;  
   int len;
   char *scriptptr;
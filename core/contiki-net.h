@@ -57,6 +57,7 @@
 
 #include "net/ip/udp-socket.h"
 #include "net/ip/tcp-socket.h"
+#include "net/ip/event-socket.h"
 
 #include "net/rime/rime.h"
 
@@ -58,16 +58,19 @@ memb_init(struct memb *m)
 void *
 memb_alloc(struct memb *m)
 {
+  char *count;
   int i;
 
-  for(i = 0; i < m->num; ++i) {
-    if(m->count[i] == 0) {
-      /* If this block was unused, we increase the reference count to
-	 indicate that it now is used and return a pointer to the
-	 memory block. */
-      ++(m->count[i]);
-      return (void *)((char *)m->mem + (i * m->size));
-    }
+  /* Find the first unused block. memchr() can check several reference
+     counts at a time, which matters for pools of thousands of blocks. */
+  count = memchr(m->count, 0, m->num);
+  if(count != NULL) {
+    i = count - m->count;
+    /* If this block was unused, we increase the reference count to
+       indicate that it now is used and return a pointer to the
+       memory block. */
+    ++(m->count[i]);
+    return (void *)((char *)m->mem + (i * m->size));
   }
 
   /* No free block was found, so we return NULL to indicate failure to
@@ -79,25 +82,23 @@ char
 memb_free(struct memb *m, void *ptr)
 {
   int i;
-  char *ptr2;
+  char *ptr2 = (char *)ptr;
 
-  /* Walk through the list of blocks and try to find the block to
-     which the pointer "ptr" points to. */
-  ptr2 = (char *)m->mem;
-  for(i = 0; i < m->num; ++i) {
-    
-    if(ptr2 == (char *)ptr) {
-      /* We've found to block to which "ptr" points so we decrease the
-	 reference count and return the new value of it. */
-      if(m->count[i] > 0) {
-	/* Make sure that we don't deallocate free memory. */
-	--(m->count[i]);
-      }
-      return m->count[i];
-    }
-    ptr2 += m->size;
+  /* Find the block to which "ptr" points from its offset, instead of
+     walking through the list of blocks. */
+  if(ptr2 < (char *)m->mem ||
+     ptr2 >= (char *)m->mem + m->num * m->size ||
+     (ptr2 - (char *)m->mem) % m->size != 0) {
+    return -1;
+  }
+  i = (ptr2 - (char *)m->mem) / m->size;
+
+  /* Decrease the reference count and return the new value of it. */
+  if(m->count[i] > 0) {
+    /* Make sure that we don't deallocate free memory. */
+    --(m->count[i]);
   }
-  return -1;
+  return m->count[i];
 }
 /*---------------------------------------------------------------------------*/
 int
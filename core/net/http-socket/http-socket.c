@@ -37,6 +37,16 @@
 
 #define MAX_PATHLEN 80
 #define MAX_HOSTLEN 40
+
+/* Where the parser is in a chunked body */
+enum {
+  CHUNK_SIZE,
+  CHUNK_EXT,
+  CHUNK_DATA,
+  CHUNK_DATA_END,
+  CHUNK_TRAILER,
+};
+
 PROCESS(http_socket_process, "HTTP socket process");
 LIST(socketlist);
 
@@ -58,15 +68,33 @@ parse_header_init(struct http_socket *s)
   PT_INIT(&s->headerpt);
 }
 /*---------------------------------------------------------------------------*/
+static void
+append_value(struct http_socket *s, char c)
+{
+  int len = strlen(s->header_field);
+
+  if(len < sizeof(s->header_field) - 1) {
+    s->header_field[len] = tolower((int)c);
+    s->header_field[len + 1] = '\0';
+  }
+}
+/*---------------------------------------------------------------------------*/
 static int
 parse_header_byte(struct http_socket *s, char c)
 {
   PT_BEGIN(&s->headerpt);
 
   memset(&s->header, -1, sizeof(s->header));
+  s->chunked = 0;
+  s->server_close = 0;
 
-  /* Skip the HTTP response */
+  /* Skip the HTTP response. A HTTP/1.0 server closes the connection
+     after the response. */
+  s->header_chars = 0;
   while(c != ' ') {
+    if(++s->header_chars == 8 && c == '0') {
+      s->server_close = 1;
+    }
     PT_YIELD(&s->headerpt);
   }
 
@@ -79,7 +107,8 @@ parse_header_byte(struct http_socket *s, char c)
     PT_YIELD(&s->headerpt);
   }
 
-  if(s->header.status_code == 0x200 || s->header.status_code == 0x206) {
+  if(s->header.status_code == 0x200 || s->header.status_code == 0x206 ||
+     s->header.status_code == 0x204 || s->header.status_code == 0x304) {
     /* Read headers until data */
 
     while(1) {
@@ -93,12 +122,14 @@ parse_header_byte(struct http_socket *s, char c)
         PT_YIELD(&s->headerpt);
       } while(c != '\n');
       s->header_chars--;
-      PT_YIELD(&s->headerpt);
 
       if(s->header_chars == 0) {
-        /* This was an empty line, i.e. the end of headers */
+        /* This was an empty line, i.e. the end of headers. It is ended
+           here, so that a response without a body is complete without
+           waiting for more data. */
         break;
       }
+      PT_YIELD(&s->headerpt);
 
       /* Start of line */
       s->header_chars = 0;
@@ -195,6 +226,22 @@ parse_header_byte(struct http_socket *s, char c)
               }
             }
           }
+        } else if(!strcmp(s->header_field, "Transfer-Encoding")) {
+          s->header_field[0] = '\0';
+          while(c != '\r') {
+            append_value(s, c);
+            s->header_chars++;
+            PT_YIELD(&s->headerpt);
+          }
+          s->chunked = strstr(s->header_field, "chunked") != NULL;
+        } else if(!strcmp(s->header_field, "Connection")) {
+          s->header_field[0] = '\0';
+          while(c != '\r') {
+            append_value(s, c);
+            s->header_chars++;
+            PT_YIELD(&s->headerpt);
+          }
+          s->server_close = strstr(s->header_field, "close") != NULL;
         }
       }
     }
@@ -222,6 +269,84 @@ parse_header_byte(struct http_socket *s, char c)
   PT_END(&s->headerpt);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Pass body data on to the callback, without the framing of a chunked
+ * body. Returns non-zero when the whole body has been received, which
+ * is known from the Content-Length header or from the last chunk.
+ * Without either, the body ends when the server closes. 204 and 304
+ * responses have no body, whatever their headers say.
+ */
+static int
+body(struct http_socket *s, const uint8_t *data, int len)
+{
+  int n;
+
+  if(s->header.status_code == 0x204 || s->header.status_code == 0x304) {
+    return 1;
+  }
+
+  if(!s->chunked) {
+    if(s->header.content_length >= 0 &&
+       len > s->header.content_length - s->bodylen) {
+      len = s->header.content_length - s->bodylen;
+    }
+    call_callback(s, HTTP_SOCKET_DATA, data, len);
+    s->bodylen += len;
+    return s->header.content_length >= 0 &&
+      s->bodylen >= s->header.content_length;
+  }
+
+  while(len > 0) {
+    switch(s->chunk_state) {
+    case CHUNK_SIZE:
+    case CHUNK_EXT:
+      if(*data == '\n') {
+        s->chunk_state = s->chunk_len > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+      } else if(s->chunk_state == CHUNK_SIZE && isxdigit((int)*data)) {
+        s->chunk_len = (s->chunk_len << 4) |
+          (isdigit((int)*data) ? *data - '0' : tolower((int)*data) - 'a' + 10);
+      } else {
+        /* Chunk extensions are ignored */
+        s->chunk_state = CHUNK_EXT;
+      }
+      n = 1;
+      break;
+    case CHUNK_DATA:
+      n = MIN(len, s->chunk_len);
+      call_callback(s, HTTP_SOCKET_DATA, data, n);
+      s->bodylen += n;
+      s->chunk_len -= n;
+      if(s->chunk_len == 0) {
+        s->chunk_state = CHUNK_DATA_END;
+      }
+      break;
+    case CHUNK_DATA_END:
+      /* The CRLF after the chunk data */
+      if(*data == '\n') {
+        s->chunk_state = CHUNK_SIZE;
+      }
+      n = 1;
+      break;
+    default:
+      /* Trailer fields up to an empty line, with chunk_len counting the
+         characters of the line */
+      if(*data == '\n') {
+        if(s->chunk_len == 0) {
+          return 1;
+        }
+        s->chunk_len = 0;
+      } else if(*data != '\r') {
+        s->chunk_len++;
+      }
+      n = 1;
+      break;
+    }
+    data += n;
+    len -= n;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 static int
 input_pt(struct http_socket *s,
          const uint8_t *inputptr, int inputdatalen)
@@ -234,7 +359,9 @@ input_pt(struct http_socket *s,
   do {
     for(i = 0; i < inputdatalen; i++) {
       if(!PT_SCHEDULE(parse_header_byte(s, inputptr[i]))) {
+        /* The last byte of the header has been used */
         s->header_received = 1;
+        i++;
         break;
       }
     }
@@ -249,16 +376,21 @@ input_pt(struct http_socket *s,
   } while(s->header_received == 0);
 
   s->bodylen = 0;
+  s->chunk_state = CHUNK_SIZE;
+  s->chunk_len = 0;
   do {
     /* Receive the data */
-    call_callback(s, HTTP_SOCKET_DATA, inputptr, inputdatalen);
-
-    /* Close the connection if the expected content length has been received */
-    if(s->header.content_length >= 0 && s->bodylen < s->header.content_length) {
-      s->bodylen += inputdatalen;
-      if(s->bodylen >= s->header.content_length) {
+    if(body(s, inputptr, inputdatalen)) {
+      /* Keep the connection for the next request, or close it. This
+         is done before the callback, which may start the next
+         request. */
+      if(s->keepalive && !s->server_close) {
+        s->idle = 1;
+      } else {
         tcp_socket_close(&s->s);
       }
+      call_callback(s, HTTP_SOCKET_DONE, NULL, 0);
+      PT_EXIT(&s->pt);
     }
 
     PT_YIELD(&s->pt);
@@ -324,6 +456,7 @@ parse_url(const char *url, char *host, uint16_t *portptr, char *path)
         if(host != NULL) {
           host[i] = 0;
         }
+        ++urlptr;
         break;
       }
       if(host != NULL) {
@@ -388,73 +521,87 @@ removesocket(struct http_socket *s)
 }
 /*---------------------------------------------------------------------------*/
 static void
-event(struct tcp_socket *tcps, void *ptr,
-      tcp_socket_event_t e)
+send_request(struct http_socket *s)
 {
-  struct http_socket *s = ptr;
+  struct tcp_socket *tcps = &s->s;
   char host[MAX_HOSTLEN];
   char path[MAX_PATHLEN];
   uint16_t port;
   char str[42];
   int len;
 
-  if(e == TCP_SOCKET_CONNECTED) {
-    printf("Connected\n");
-    if(parse_url(s->url, host, &port, path)) {
-      tcp_socket_send_str(tcps, s->postdata != NULL ? "POST " : "GET ");
-      if(s->proxy_port != 0) {
-        /* If we are configured to route through a proxy, we should
-           provide the full URL as the path. */
-        tcp_socket_send_str(tcps, s->url);
-      } else {
-        tcp_socket_send_str(tcps, path);
-      }
-      tcp_socket_send_str(tcps, " HTTP/1.1\r\n");
+  if(parse_url(s->url, host, &port, path)) {
+    tcp_socket_send_str(tcps, s->postdata != NULL ? "POST " : "GET ");
+    if(s->proxy_port != 0) {
+      /* If we are configured to route through a proxy, we should
+         provide the full URL as the path. */
+      tcp_socket_send_str(tcps, s->url);
+    } else {
+      tcp_socket_send_str(tcps, path);
+    }
+    tcp_socket_send_str(tcps, " HTTP/1.1\r\n");
+    if(!s->keepalive) {
       tcp_socket_send_str(tcps, "Connection: close\r\n");
-      tcp_socket_send_str(tcps, "Host: ");
-      tcp_socket_send_str(tcps, host);
-      tcp_socket_send_str(tcps, "\r\n");
-      if(s->postdata != NULL) {
-        if(s->content_type) {
-          tcp_socket_send_str(tcps, "Content-Type: ");
-          tcp_socket_send_str(tcps, s->content_type);
-          tcp_socket_send_str(tcps, "\r\n");
-        }
-        tcp_socket_send_str(tcps, "Content-Length: ");
-        sprintf(str, "%u", s->postdatalen);
-        tcp_socket_send_str(tcps, str);
+    }
+    tcp_socket_send_str(tcps, "Host: ");
+    tcp_socket_send_str(tcps, host);
+    tcp_socket_send_str(tcps, "\r\n");
+    if(s->postdata != NULL) {
+      if(s->content_type) {
+        tcp_socket_send_str(tcps, "Content-Type: ");
+        tcp_socket_send_str(tcps, s->content_type);
         tcp_socket_send_str(tcps, "\r\n");
-      } else if(s->length || s->pos > 0) {
-        tcp_socket_send_str(tcps, "Range: bytes=");
-        if(s->length) {
-          if(s->pos >= 0) {
-            sprintf(str, "%llu-%llu", s->pos, s->pos + s->length - 1);
-          } else {
-            sprintf(str, "-%llu", s->length);
-          }
+      }
+      tcp_socket_send_str(tcps, "Content-Length: ");
+      sprintf(str, "%u", s->postdatalen);
+      tcp_socket_send_str(tcps, str);
+      tcp_socket_send_str(tcps, "\r\n");
+    } else if(s->length || s->pos > 0) {
+      tcp_socket_send_str(tcps, "Range: bytes=");
+      if(s->length) {
+        if(s->pos >= 0) {
+          sprintf(str, "%llu-%llu", s->pos, s->pos + s->length - 1);
         } else {
-          sprintf(str, "%llu-", s->pos);
+          sprintf(str, "-%llu", s->length);
         }
-        tcp_socket_send_str(tcps, str);
-        tcp_socket_send_str(tcps, "\r\n");
+      } else {
+        sprintf(str, "%llu-", s->pos);
       }
+      tcp_socket_send_str(tcps, str);
       tcp_socket_send_str(tcps, "\r\n");
-      if(s->postdata != NULL && s->postdatalen) {
-        len = tcp_socket_send(tcps, s->postdata, s->postdatalen);
-        s->postdata += len;
-        s->postdatalen -= len;
-      }
     }
-    parse_header_init(s);
+    tcp_socket_send_str(tcps, "\r\n");
+    if(s->postdata != NULL && s->postdatalen) {
+      len = tcp_socket_send(tcps, s->postdata, s->postdatalen);
+      s->postdata += len;
+      s->postdatalen -= len;
+    }
+  }
+  parse_header_init(s);
+}
+/*---------------------------------------------------------------------------*/
+static void
+event(struct tcp_socket *tcps, void *ptr,
+      tcp_socket_event_t e)
+{
+  struct http_socket *s = ptr;
+  int len;
+
+  if(e == TCP_SOCKET_CONNECTED) {
+    printf("Connected\n");
+    send_request(s);
   } else if(e == TCP_SOCKET_CLOSED) {
+    s->idle = 0;
     call_callback(s, HTTP_SOCKET_CLOSED, NULL, 0);
     removesocket(s);
     printf("Closed\n");
   } else if(e == TCP_SOCKET_TIMEDOUT) {
+    s->idle = 0;
     call_callback(s, HTTP_SOCKET_TIMEDOUT, NULL, 0);
     removesocket(s);
     printf("Timedout\n");
   } else if(e == TCP_SOCKET_ABORTED) {
+    s->idle = 0;
     call_callback(s, HTTP_SOCKET_ABORTED, NULL, 0);
     removesocket(s);
     printf("Aborted\n");
@@ -469,6 +616,25 @@ event(struct tcp_socket *tcps, void *ptr,
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+connect_to(struct http_socket *s, const uip_ipaddr_t *addr, uint16_t port)
+{
+  struct uip_conn *c = s->s.c;
+
+  if(s->idle && c != NULL &&
+     (c->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+     uip_ipaddr_cmp(&c->ripaddr, addr) && c->rport == UIP_HTONS(port)) {
+    /* Send the request on the connection that the last response left
+       open. */
+    s->idle = 0;
+    send_request(s);
+    tcpip_poll_tcp(c);
+    return;
+  }
+  s->idle = 0;
+  tcp_socket_connect(&s->s, addr, port);
+}
+/*---------------------------------------------------------------------------*/
 static int
 start_request(struct http_socket *s)
 {
@@ -506,14 +672,14 @@ start_request(struct http_socket *s)
         }
         if(addr != NULL) {
           s->did_tcp_connect = 1;
-          tcp_socket_connect(&s->s, addr, port);
+          connect_to(s, addr, port);
           return HTTP_SOCKET_OK;
         } else {
           return HTTP_SOCKET_ERR;
         }
       }
     }
-    tcp_socket_connect(&s->s, &ip6addr, port);
+    connect_to(s, &ip6addr, port);
     return HTTP_SOCKET_OK;
   } else {
     return HTTP_SOCKET_ERR;
@@ -592,6 +758,8 @@ http_socket_init(struct http_socket *s)
   init();
   uip_create_unspecified(&s->proxy_addr);
   s->proxy_port = 0;
+  s->keepalive = 0;
+  s->idle = 0;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -664,6 +832,7 @@ http_socket_close(struct http_socket *socket)
       s != NULL;
       s = list_item_next(s)) {
     if(s == socket) {
+      s->idle = 0;
       tcp_socket_close(&s->s);
       removesocket(s);
       return 1;
@@ -680,3 +849,9 @@ http_socket_set_proxy(struct http_socket *s,
   s->proxy_port = port;
 }
 /*---------------------------------------------------------------------------*/
+void
+http_socket_set_keepalive(struct http_socket *s, int keepalive)
+{
+  s->keepalive = keepalive;
+}
+/*---------------------------------------------------------------------------*/
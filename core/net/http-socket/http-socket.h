@@ -44,6 +44,7 @@ typedef enum {
   HTTP_SOCKET_TIMEDOUT,
   HTTP_SOCKET_ABORTED,
   HTTP_SOCKET_HOSTNAME_NOT_FOUND,
+  HTTP_SOCKET_DONE,
 } http_socket_event_t;
 
 struct http_socket_header {
@@ -91,11 +92,18 @@ struct http_socket {
   uint8_t timeout_timer_started;
   struct pt pt, headerpt;
   int header_chars;
-  char header_field[15];
+  char header_field[18];
   struct http_socket_header header;
   uint8_t header_received;
   uint64_t bodylen;
   const char *content_type;
+
+  uint8_t keepalive;
+  uint8_t idle;           /* The connection is open and not in use. */
+  uint8_t server_close;   /* The server closes after the response. */
+  uint8_t chunked;
+  uint8_t chunk_state;
+  uint32_t chunk_len;
 };
 
 void http_socket_init(struct http_socket *s);
@@ -117,5 +125,16 @@ int http_socket_close(struct http_socket *socket);
 void http_socket_set_proxy(struct http_socket *s,
                            const uip_ipaddr_t *addr, uint16_t port);
 
+/*
+ * With keepalive set, the connection is left open when a response is
+ * complete, and the next request on the socket is sent on it if it
+ * goes to the same address and port. The end of every response is
+ * signalled with HTTP_SOCKET_DONE. A HTTP_SOCKET_CLOSED after that
+ * only means that the open connection has gone away; a request that
+ * gets HTTP_SOCKET_CLOSED before HTTP_SOCKET_DONE may not have been
+ * seen by the server and can be sent again.
+ */
+void http_socket_set_keepalive(struct http_socket *s, int keepalive);
+
 
 #endif /* HTTP_SOCKET_H */
@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Event-driven sockets with readiness notification
+ */
+
+#include "contiki-net.h"
+#include "sys/cc.h"
+#include "net/ip/event-socket.h"
+
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+/* Socket states */
+#define STATE_QUEUED   0x01 /* On the ready list of the set */
+#define STATE_OPEN     0x02 /* TCP connection established */
+#define STATE_STOPPED  0x04 /* TCP connection stopped by a full buffer */
+
+/* The room a TCP socket must have in its input buffer to take
+   whatever the peer may send before it learns about a closed window. */
+#define TCP_ROOM MAX(UIP_RECEIVE_WINDOW, UIP_TCP_MSS)
+
+/* Kept in front of each datagram in the input buffer of a UDP socket */
+struct udp_hdr {
+  uip_ipaddr_t addr;
+  uint16_t port;
+  uint16_t len;
+};
+/*---------------------------------------------------------------------------*/
+static int
+buf_init(struct event_socket_buf *b, uint8_t *data, uint16_t size)
+{
+  if(data == NULL || size < 2 || (size & (size - 1)) != 0) {
+    return 0;
+  }
+  b->data = data;
+  b->mask = size - 1;
+  b->put_ptr = 0;
+  b->get_ptr = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+buf_elements(const struct event_socket_buf *b)
+{
+  return (b->put_ptr - b->get_ptr) & b->mask;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+buf_space(const struct event_socket_buf *b)
+{
+  /* As in lib/ringbuf, one byte is left unused to tell a full buffer
+     from an empty one. */
+  return b->mask - buf_elements(b);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+buf_put(struct event_socket_buf *b, const void *data, uint16_t len)
+{
+  uint16_t first;
+
+  len = MIN(len, buf_space(b));
+  first = MIN(len, b->mask + 1 - b->put_ptr);
+  memcpy(&b->data[b->put_ptr], data, first);
+  memcpy(b->data, (const uint8_t *)data + first, len - first);
+  b->put_ptr = (b->put_ptr + len) & b->mask;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Takes len bytes out of the buffer, and copies them to data unless it
+   is NULL */
+static uint16_t
+buf_get(struct event_socket_buf *b, void *data, uint16_t len)
+{
+  uint16_t first;
+
+  len = MIN(len, buf_elements(b));
+  if(data != NULL) {
+    first = MIN(len, b->mask + 1 - b->get_ptr);
+    memcpy(data, &b->data[b->get_ptr], first);
+    memcpy((uint8_t *)data + first, b->data, len - first);
+  }
+  b->get_ptr = (b->get_ptr + len) & b->mask;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+ready_events(struct event_socket *s)
+{
+  uint8_t events = s->events;
+
+  if(buf_elements(&s->in) > 0) {
+    events |= EVENT_SOCKET_READABLE;
+  }
+  if(s->type == EVENT_SOCKET_TYPE_UDP ||
+     ((s->state & STATE_OPEN) && tcp_socket_max_sendlen(&s->s.tcp) > 0)) {
+    events |= EVENT_SOCKET_WRITABLE;
+  }
+  return events & s->watch;
+}
+/*---------------------------------------------------------------------------*/
+/* Puts the socket on the ready list if it is ready and not already
+   there. The process of the set is polled, so that it handles all the
+   sockets that have become ready at once. */
+static void
+update(struct event_socket *s)
+{
+  struct event_socket_set *set = s->set;
+
+  if((s->state & STATE_QUEUED) || ready_events(s) == 0) {
+    return;
+  }
+  s->state |= STATE_QUEUED;
+  s->ready_next = NULL;
+  if(set->ready == NULL) {
+    set->ready = s;
+  } else {
+    set->ready_tail->ready_next = s;
+  }
+  set->ready_tail = s;
+  process_poll(set->p);
+}
+/*---------------------------------------------------------------------------*/
+static void
+unqueue(struct event_socket *s)
+{
+  struct event_socket_set *set = s->set;
+  struct event_socket *prev, *q;
+
+  if(!(s->state & STATE_QUEUED)) {
+    return;
+  }
+  prev = NULL;
+  for(q = set->ready; q != NULL; prev = q, q = q->ready_next) {
+    if(q == s) {
+      if(prev == NULL) {
+        set->ready = s->ready_next;
+      } else {
+        prev->ready_next = s->ready_next;
+      }
+      if(set->ready_tail == s) {
+        set->ready_tail = prev;
+      }
+      break;
+    }
+  }
+  s->state &= ~STATE_QUEUED;
+}
+/*---------------------------------------------------------------------------*/
+static int
+tcp_input(struct tcp_socket *ts, void *ptr,
+          const uint8_t *data, int len)
+{
+  struct event_socket *s = ptr;
+
+  if(buf_put(&s->in, data, len) < len) {
+    /* Only happens if the peer ignores the window. */
+    PRINTF("event-socket: %d bytes dropped\n", len - buf_space(&s->in));
+  }
+
+  /* Stop the connection before the buffer can overflow. uIP always
+     advertises the same window, so the peer has to be stopped while
+     there is still room for all that it may send. */
+  if(buf_space(&s->in) < TCP_ROOM && !(s->state & STATE_STOPPED)) {
+    s->state |= STATE_STOPPED;
+    tcp_socket_stop(ts);
+  }
+
+  update(s);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_event(struct tcp_socket *ts, void *ptr,
+          tcp_socket_event_t event)
+{
+  struct event_socket *s = ptr;
+
+  switch(event) {
+  case TCP_SOCKET_CONNECTED:
+    /* A listening socket may have been left with data from its last
+       connection, which has been reported as closed. */
+    buf_get(&s->in, NULL, buf_elements(&s->in));
+    s->state = (s->state & STATE_QUEUED) | STATE_OPEN;
+    s->events = (s->events & ~EVENT_SOCKET_CLOSED) | EVENT_SOCKET_CONNECTED;
+    break;
+  case TCP_SOCKET_CLOSED:
+  case TCP_SOCKET_TIMEDOUT:
+  case TCP_SOCKET_ABORTED:
+    s->state &= ~(STATE_OPEN | STATE_STOPPED);
+    s->events |= EVENT_SOCKET_CLOSED;
+    break;
+  case TCP_SOCKET_DATA_SENT:
+    break;
+  }
+  update(s);
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_input(struct udp_socket *c, void *ptr,
+          const uip_ipaddr_t *source_addr, uint16_t source_port,
+          const uip_ipaddr_t *dest_addr, uint16_t dest_port,
+          const uint8_t *data, uint16_t datalen)
+{
+  struct event_socket *s = ptr;
+  struct udp_hdr hdr;
+
+  if(buf_space(&s->in) < sizeof(hdr) + datalen) {
+    s->dropped++;
+    return;
+  }
+  uip_ipaddr_copy(&hdr.addr, source_addr);
+  hdr.port = source_port;
+  hdr.len = datalen;
+  buf_put(&s->in, &hdr, sizeof(hdr));
+  buf_put(&s->in, data, datalen);
+  update(s);
+}
+/*---------------------------------------------------------------------------*/
+void
+event_socket_set_init(struct event_socket_set *set)
+{
+  set->ready = NULL;
+  set->ready_tail = NULL;
+  set->p = PROCESS_CURRENT();
+}
+/*---------------------------------------------------------------------------*/
+struct event_socket *
+event_socket_set_next(struct event_socket_set *set, uint8_t *events)
+{
+  struct event_socket *s;
+  uint8_t ev;
+
+  while((s = set->ready) != NULL) {
+    set->ready = s->ready_next;
+    if(set->ready == NULL) {
+      set->ready_tail = NULL;
+    }
+    s->state &= ~STATE_QUEUED;
+
+    /* The socket may no longer be ready, e.g., if the application has
+       changed what it watches. */
+    ev = ready_events(s);
+    if(ev != 0) {
+      s->events &= ~ev;
+      *events = ev;
+      return s;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_socket(struct event_socket *s, struct event_socket_set *set,
+            void *ptr, uint8_t type)
+{
+  s->set = set;
+  s->ready_next = NULL;
+  s->ptr = ptr;
+  s->dropped = 0;
+  s->type = type;
+  s->watch = EVENT_SOCKET_DEFAULT_WATCH;
+  s->events = 0;
+  s->state = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_tcp_register(struct event_socket *s,
+                          struct event_socket_set *set, void *ptr,
+                          uint8_t *input_buf, uint16_t input_buf_size,
+                          uint8_t *output_buf, uint16_t output_buf_size)
+{
+  if(s == NULL || set == NULL ||
+     !buf_init(&s->in, input_buf, input_buf_size) ||
+     buf_space(&s->in) < TCP_ROOM) {
+    return -1;
+  }
+  init_socket(s, set, ptr, EVENT_SOCKET_TYPE_TCP);
+
+  /* Data is read straight from the uIP buffer into the ring buffer. */
+  return tcp_socket_register(&s->s.tcp, s, NULL, 0,
+                             output_buf, output_buf_size,
+                             tcp_input, tcp_event);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_udp_register(struct event_socket *s,
+                          struct event_socket_set *set, void *ptr,
+                          uint8_t *input_buf, uint16_t input_buf_size)
+{
+  if(s == NULL || set == NULL ||
+     !buf_init(&s->in, input_buf, input_buf_size)) {
+    return -1;
+  }
+  init_socket(s, set, ptr, EVENT_SOCKET_TYPE_UDP);
+
+  /* Incoming datagrams are handled in the context of the process of
+     the set. */
+  PROCESS_CONTEXT_BEGIN(set->p);
+  udp_socket_register(&s->s.udp, s, udp_input);
+  PROCESS_CONTEXT_END();
+  if(s->s.udp.udp_conn == NULL) {
+    return -1;
+  }
+  update(s);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_unregister(struct event_socket *s)
+{
+  if(s == NULL) {
+    return -1;
+  }
+  unqueue(s);
+  if(s->type == EVENT_SOCKET_TYPE_TCP) {
+    return tcp_socket_unregister(&s->s.tcp);
+  }
+  return udp_socket_close(&s->s.udp);
+}
+/*---------------------------------------------------------------------------*/
+void
+event_socket_watch(struct event_socket *s, uint8_t events)
+{
+  s->watch = events;
+  update(s);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_listen(struct event_socket *s, uint16_t port)
+{
+  if(s == NULL || s->type != EVENT_SOCKET_TYPE_TCP) {
+    return -1;
+  }
+  return tcp_socket_listen(&s->s.tcp, port);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_connect(struct event_socket *s,
+                     const uip_ipaddr_t *ipaddr, uint16_t port)
+{
+  uip_ipaddr_t addr;
+
+  if(s == NULL) {
+    return -1;
+  }
+  if(s->type == EVENT_SOCKET_TYPE_TCP) {
+    return tcp_socket_connect(&s->s.tcp, ipaddr, port);
+  }
+  uip_ipaddr_copy(&addr, ipaddr);
+  return udp_socket_connect(&s->s.udp, &addr, port);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_bind(struct event_socket *s, uint16_t port)
+{
+  if(s == NULL || s->type != EVENT_SOCKET_TYPE_UDP) {
+    return -1;
+  }
+  return udp_socket_bind(&s->s.udp, port);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_read(struct event_socket *s, uint8_t *buf, uint16_t len)
+{
+  if(s == NULL) {
+    return -1;
+  }
+  if(s->type == EVENT_SOCKET_TYPE_UDP) {
+    return event_socket_recvfrom(s, buf, len, NULL, NULL);
+  }
+
+  len = buf_get(&s->in, buf, len);
+
+  if((s->state & STATE_STOPPED) && buf_space(&s->in) >= TCP_ROOM) {
+    s->state &= ~STATE_STOPPED;
+    tcp_socket_restart(&s->s.tcp);
+  }
+  update(s);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_recvfrom(struct event_socket *s, uint8_t *buf, uint16_t len,
+                      uip_ipaddr_t *addr, uint16_t *port)
+{
+  struct udp_hdr hdr;
+
+  if(s == NULL || s->type != EVENT_SOCKET_TYPE_UDP ||
+     buf_get(&s->in, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+    return -1;
+  }
+  if(addr != NULL) {
+    uip_ipaddr_copy(addr, &hdr.addr);
+  }
+  if(port != NULL) {
+    *port = hdr.port;
+  }
+  len = buf_get(&s->in, buf, MIN(len, hdr.len));
+  buf_get(&s->in, NULL, hdr.len - len);
+  update(s);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+event_socket_readable(struct event_socket *s)
+{
+  return buf_elements(&s->in);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_write(struct event_socket *s, const uint8_t *data,
+                   uint16_t len)
+{
+  if(s == NULL) {
+    return -1;
+  }
+  if(s->type == EVENT_SOCKET_TYPE_UDP) {
+    return udp_socket_send(&s->s.udp, data, len);
+  }
+  if(!(s->state & STATE_OPEN)) {
+    return -1;
+  }
+  len = tcp_socket_send(&s->s.tcp, data, len);
+  /* Send now rather than at the next periodic poll. */
+  if(len > 0 && s->s.tcp.c != NULL) {
+    tcpip_poll_tcp(s->s.tcp.c);
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_sendto(struct event_socket *s, const uint8_t *data,
+                    uint16_t len, const uip_ipaddr_t *addr,
+                    uint16_t port)
+{
+  if(s == NULL || s->type != EVENT_SOCKET_TYPE_UDP) {
+    return -1;
+  }
+  return udp_socket_sendto(&s->s.udp, data, len, addr, port);
+}
+/*---------------------------------------------------------------------------*/
+int
+event_socket_close(struct event_socket *s)
+{
+  if(s == NULL) {
+    return -1;
+  }
+  if(s->type == EVENT_SOCKET_TYPE_UDP) {
+    unqueue(s);
+    return udp_socket_close(&s->s.udp);
+  }
+  if(!(s->state & STATE_OPEN)) {
+    return 1;
+  }
+  /* Data that has not been read is thrown away. */
+  buf_get(&s->in, NULL, buf_elements(&s->in));
+  s->state &= ~(STATE_OPEN | STATE_STOPPED);
+  tcp_socket_close(&s->s.tcp);
+  /* Close now rather than at the next periodic poll. */
+  tcpip_poll_tcp(s->s.tcp.c);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
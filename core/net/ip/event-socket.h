@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Event-driven sockets with readiness notification
+ *
+ *         An event socket is a TCP or UDP socket, built on tcp-socket
+ *         and udp-socket, whose incoming data is kept in a ring
+ *         buffer until the application reads it. Sockets belong to a
+ *         set, and a single process can serve all the sockets in a
+ *         set, much like with poll() or epoll: when a socket becomes
+ *         ready, it is put on the ready list of its set and the
+ *         process of the set is polled. The process then takes the
+ *         ready sockets off the list with event_socket_set_next().
+ *
+ *         The work done for each event is proportional to the number
+ *         of ready sockets, not to the number of sockets in the set,
+ *         and the per-connection state is only the socket and its
+ *         buffers, so one process can serve as many connections as
+ *         uIP has room for.
+ */
+
+#ifndef EVENT_SOCKET_H_
+#define EVENT_SOCKET_H_
+
+#include "contiki.h"
+#include "net/ip/tcp-socket.h"
+#include "net/ip/udp-socket.h"
+
+/** There is data, or a datagram, to read. */
+#define EVENT_SOCKET_READABLE   0x01
+/** There is room for more data in the output buffer. */
+#define EVENT_SOCKET_WRITABLE   0x02
+/** A TCP socket has been connected, or has accepted a connection. */
+#define EVENT_SOCKET_CONNECTED  0x04
+/** A TCP connection has been closed, aborted or has timed out. */
+#define EVENT_SOCKET_CLOSED     0x08
+
+/* The events that are watched after a socket has been registered */
+#define EVENT_SOCKET_DEFAULT_WATCH (EVENT_SOCKET_READABLE |  \
+                                    EVENT_SOCKET_CONNECTED | \
+                                    EVENT_SOCKET_CLOSED)
+
+struct event_socket;
+
+struct event_socket_set {
+  struct event_socket *ready;
+  struct event_socket *ready_tail;
+  struct process *p;
+};
+
+/*
+ * Incoming data. Like lib/ringbuf, but with 16-bit indices and block
+ * operations.
+ */
+struct event_socket_buf {
+  uint8_t *data;
+  uint16_t mask;
+  uint16_t put_ptr, get_ptr;
+};
+
+struct event_socket {
+  union {
+    struct tcp_socket tcp;
+    struct udp_socket udp;
+  } s;
+  struct event_socket_set *set;
+  struct event_socket *ready_next;
+  void *ptr;
+  struct event_socket_buf in;
+  uint16_t dropped;
+  uint8_t type;
+  uint8_t watch;
+  uint8_t events;
+  uint8_t state;
+};
+
+enum {
+  EVENT_SOCKET_TYPE_TCP,
+  EVENT_SOCKET_TYPE_UDP,
+};
+
+/**
+ * \brief      Initialize a socket set
+ * \param set  A pointer to the socket set
+ *
+ *             This function initializes a socket set for the
+ *             calling process. Whenever a socket in the set becomes
+ *             ready, the process is polled, i.e., it gets a
+ *             PROCESS_EVENT_POLL event, and should then call
+ *             event_socket_set_next() until it returns NULL.
+ */
+void event_socket_set_init(struct event_socket_set *set);
+
+/**
+ * \brief      Get the next ready socket from a socket set
+ * \param set  A pointer to the socket set
+ * \param events A pointer to where the ready events are stored
+ * \return     The socket, or NULL if no socket in the set is ready
+ *
+ *             This function takes the first socket off the ready
+ *             list of the set and returns it, with the events that it
+ *             is ready for, of the events it watches. The readable
+ *             and writable events are level triggered: a socket that
+ *             is left ready is put back on the list when data
+ *             arrives or is acknowledged, and right away when the
+ *             application has read from it, so a socket with more
+ *             data is returned again after the sockets that are
+ *             already on the list.
+ */
+struct event_socket *event_socket_set_next(struct event_socket_set *set,
+                                           uint8_t *events);
+
+/**
+ * \brief      Register a TCP event socket
+ * \param s    A pointer to the event socket
+ * \param set  The socket set the socket belongs to
+ * \param ptr  A user-defined pointer, kept in s->ptr
+ * \param input_buf A pointer to the memory for incoming data
+ * \param input_buf_size The size of input_buf, which must be a power of two
+ * \param output_buf A pointer to the memory for outgoing data
+ * \param output_buf_size The size of output_buf
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             Incoming data is held in the input buffer until it is
+ *             read with event_socket_read(). When the buffer is too
+ *             full to hold a full receive window, the connection is
+ *             stopped, and it is restarted when enough data has been
+ *             read. The input buffer must therefore be larger than
+ *             the receive window, UIP_RECEIVE_WINDOW, and the TCP
+ *             MSS.
+ */
+int event_socket_tcp_register(struct event_socket *s,
+                              struct event_socket_set *set, void *ptr,
+                              uint8_t *input_buf, uint16_t input_buf_size,
+                              uint8_t *output_buf, uint16_t output_buf_size);
+
+/**
+ * \brief      Register a UDP event socket
+ * \param s    A pointer to the event socket
+ * \param set  The socket set the socket belongs to
+ * \param ptr  A user-defined pointer, kept in s->ptr
+ * \param input_buf A pointer to the memory for incoming datagrams
+ * \param input_buf_size The size of input_buf, which must be a power of two
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             Incoming datagrams are queued in the input buffer,
+ *             together with their source address and port. A
+ *             datagram that does not fit is dropped and counted in
+ *             s->dropped. A UDP socket is always writable.
+ */
+int event_socket_udp_register(struct event_socket *s,
+                              struct event_socket_set *set, void *ptr,
+                              uint8_t *input_buf, uint16_t input_buf_size);
+
+/**
+ * \brief      Unregister an event socket
+ * \param s    A pointer to the event socket
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             This function takes the socket out of its set and
+ *             unregisters the underlying TCP or UDP socket.
+ */
+int event_socket_unregister(struct event_socket *s);
+
+/**
+ * \brief      Choose the events to be notified about
+ * \param s    A pointer to the event socket
+ * \param events The events, EVENT_SOCKET_READABLE etc.
+ *
+ *             Only the watched events make a socket ready. An
+ *             application should normally only watch
+ *             EVENT_SOCKET_WRITABLE when it has data waiting to be
+ *             written, as a TCP socket is writable most of the time.
+ */
+void event_socket_watch(struct event_socket *s, uint8_t events);
+
+/**
+ * \brief      Listen for connections on a TCP event socket
+ * \param s    A pointer to the event socket
+ * \param port The TCP port number, in host byte order
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             The socket is ready with EVENT_SOCKET_CONNECTED when it
+ *             has accepted a connection, and goes back to listening
+ *             when the connection has been closed. To accept several
+ *             connections at the same time, several sockets listen on
+ *             the same port.
+ */
+int event_socket_listen(struct event_socket *s, uint16_t port);
+
+/**
+ * \brief      Connect an event socket to a remote host
+ * \param s    A pointer to the event socket
+ * \param ipaddr The IP address of the remote host
+ * \param port The port number, in host byte order, of the remote host
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             A TCP socket is ready with EVENT_SOCKET_CONNECTED when
+ *             the connection has been set up. A UDP socket sends to,
+ *             and only receives from, the remote host.
+ */
+int event_socket_connect(struct event_socket *s,
+                         const uip_ipaddr_t *ipaddr, uint16_t port);
+
+/**
+ * \brief      Bind a UDP event socket to a local port
+ * \param s    A pointer to the event socket
+ * \param port The UDP port number, in host byte order
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ */
+int event_socket_bind(struct event_socket *s, uint16_t port);
+
+/**
+ * \brief      Read from an event socket
+ * \param s    A pointer to the event socket
+ * \param buf  A pointer to where the data is stored
+ * \param len  The size of buf
+ * \retval -1  If an error occurs
+ * \return     The number of bytes read
+ *
+ *             On a TCP socket, this function reads up to len bytes
+ *             of the incoming data. On a UDP socket, it reads the next
+ *             datagram; the part that does not fit in buf is
+ *             discarded.
+ */
+int event_socket_read(struct event_socket *s, uint8_t *buf, uint16_t len);
+
+/**
+ * \brief      Read the next datagram from a UDP event socket
+ * \param s    A pointer to the event socket
+ * \param buf  A pointer to where the data is stored
+ * \param len  The size of buf
+ * \param addr A pointer to where the source address is stored, or NULL
+ * \param port A pointer to where the source port is stored, or NULL
+ * \retval -1  If an error occurs or there is no datagram
+ * \return     The number of bytes read
+ */
+int event_socket_recvfrom(struct event_socket *s, uint8_t *buf, uint16_t len,
+                          uip_ipaddr_t *addr, uint16_t *port);
+
+/**
+ * \brief      The amount of data waiting to be read
+ * \param s    A pointer to the event socket
+ * \return     The number of bytes in the input buffer
+ *
+ *             For a UDP socket, this includes the address and length
+ *             that are kept with each datagram.
+ */
+uint16_t event_socket_readable(struct event_socket *s);
+
+/**
+ * \brief      Write to an event socket
+ * \param s    A pointer to the event socket
+ * \param data A pointer to the data
+ * \param len  The length of the data
+ * \retval -1  If an error occurs
+ * \return     The number of bytes written
+ *
+ *             On a TCP socket, the data is put in the output buffer,
+ *             and the function returns how much of it there was room
+ *             for. On a connected UDP socket, the data is sent as one
+ *             datagram.
+ */
+int event_socket_write(struct event_socket *s, const uint8_t *data,
+                       uint16_t len);
+
+/**
+ * \brief      Send a datagram on a UDP event socket
+ * \param s    A pointer to the event socket
+ * \param data A pointer to the data
+ * \param len  The length of the data
+ * \param addr The IP address of the remote host
+ * \param port The UDP port number, in host byte order, of the remote host
+ * \retval -1  If an error occurs
+ * \return     The number of bytes sent
+ */
+int event_socket_sendto(struct event_socket *s, const uint8_t *data,
+                        uint16_t len, const uip_ipaddr_t *addr,
+                        uint16_t port);
+
+/**
+ * \brief      Close an event socket
+ * \param s    A pointer to the event socket
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             A TCP connection is closed when the data in the output
+ *             buffer has been sent. A UDP socket is removed from uIP
+ *             and must be registered again to be used.
+ */
+int event_socket_close(struct event_socket *s);
+
+#endif /* EVENT_SOCKET_H_ */
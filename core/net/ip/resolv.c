@@ -158,6 +158,46 @@ strcasecmp(const char *s1, const char *s2)
 #define RESOLV_SUPPORTS_RECORD_EXPIRATION 1
 #endif
 
+/* If RESOLV_CONF_PARALLEL_QUERIES is set, each query is sent to all
+ * configured nameservers at once and the first answer is used.
+ * Otherwise the nameservers are asked one after the other.
+ */
+#ifdef RESOLV_CONF_PARALLEL_QUERIES
+#define RESOLV_PARALLEL_QUERIES RESOLV_CONF_PARALLEL_QUERIES
+#else
+#define RESOLV_PARALLEL_QUERIES 1
+#endif
+
+/* How long, in seconds, a name is known not to resolve when the server
+ * gave no SOA record to take the time from, or when no server answered.
+ */
+#ifdef RESOLV_CONF_NEGATIVE_TTL
+#define RESOLV_NEGATIVE_TTL RESOLV_CONF_NEGATIVE_TTL
+#else
+#define RESOLV_NEGATIVE_TTL 30
+#endif
+
+/* Upper bound for the time a negative answer is cached (RFC 2308). */
+#ifdef RESOLV_CONF_MAX_NEGATIVE_TTL
+#define RESOLV_MAX_NEGATIVE_TTL RESOLV_CONF_MAX_NEGATIVE_TTL
+#else
+#define RESOLV_MAX_NEGATIVE_TTL 300
+#endif
+
+/* A cached name that is looked up less than this many seconds (and less
+ * than a quarter of its TTL) before it expires is queried again in the
+ * background, so that users of the name do not have to wait for it to
+ * be resolved after it expires. Zero disables prefetching.
+ */
+#ifdef RESOLV_CONF_PREFETCH_TIME
+#define RESOLV_PREFETCH_TIME RESOLV_CONF_PREFETCH_TIME
+#else
+#define RESOLV_PREFETCH_TIME 30
+#endif
+
+#define RESOLV_PREFETCH \
+  (RESOLV_SUPPORTS_RECORD_EXPIRATION && RESOLV_PREFETCH_TIME > 0)
+
 #if RESOLV_CONF_SUPPORTS_MDNS && !RESOLV_VERIFY_ANSWER_NAMES
 #error RESOLV_CONF_SUPPORTS_MDNS cannot be set without RESOLV_CONF_VERIFY_ANSWER_NAMES
 #endif
@@ -178,6 +218,7 @@ strcasecmp(const char *s1, const char *s2)
 
 #define DNS_TYPE_A      1
 #define DNS_TYPE_CNAME  5
+#define DNS_TYPE_SOA    6
 #define DNS_TYPE_PTR   12
 #define DNS_TYPE_MX    15
 #define DNS_TYPE_TXT   16
@@ -249,17 +290,25 @@ struct namemap {
 #define STATE_NEW    2
 #define STATE_ASKING 3
 #define STATE_DONE   4
+#define STATE_REFRESHING 5 /* DONE, and being queried again */
   uint8_t state;
   uint8_t tmr;
   uint16_t id;
   uint8_t retries;
   uint8_t seqno;
+  uint8_t hash;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
   unsigned long expiration;
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+#if RESOLV_PREFETCH
+  unsigned long prefetch;
+#endif /* RESOLV_PREFETCH */
   uip_ipaddr_t ipaddr;
   uint8_t err;
   uint8_t server;
+#if RESOLV_PARALLEL_QUERIES
+  uint8_t failed; /* Bit n is set when server n has failed to answer */
+#endif /* RESOLV_PARALLEL_QUERIES */
 #if RESOLV_CONF_SUPPORTS_MDNS
   int is_mdns:1, is_probe:1;
 #endif
@@ -280,6 +329,10 @@ static struct uip_udp_conn *resolv_conn = NULL;
 
 static struct etimer retry;
 
+/* Set when the retry timer has expired. The retransmission timers of the
+   entries only count these ticks, not every run of check_entries(). */
+static uint8_t tick;
+
 process_event_t resolv_event_found;
 
 PROCESS(resolv_process, "DNS resolver");
@@ -422,8 +475,8 @@ skip_name(unsigned char *query)
 
   DEBUG_PRINTF("resolver: skip name: ");
 
-  do {
-    n = *query;
+  /* The root name, as found in SOA records, is a single zero. */
+  while((n = *query) != 0) {
     if(n & 0xc0) {
       DEBUG_PRINTF("<skip-to-%d>", query[0] + ((n & ~0xC0) << 8));
       ++query;
@@ -438,11 +491,48 @@ skip_name(unsigned char *query)
       --n;
     };
     DEBUG_PRINTF(".");
-  } while(*query != 0);
+  }
   DEBUG_PRINTF("\n");
   return query + 1;
 }
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * Hash of a host name, used to skip most of the string comparisons
+ * when the cache is searched. Names are compared without case.
+ */
+static uint8_t
+name_hash(const char *name)
+{
+  uint8_t hash = 0;
+
+  for(; *name != 0; ++name) {
+    hash = hash * 31 + tolower((unsigned int)*name);
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Reads a 32-bit value in network byte order from the packet.
+ */
+static uint32_t
+get32(const unsigned char *ptr)
+{
+  return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) |
+    ((uint32_t)ptr[2] << 8) | ptr[3];
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Reads the TTL of a resource record. Values with the highest bit set
+ * are taken to be zero (RFC 2181).
+ */
+static uint32_t
+record_ttl(const unsigned char *ttl)
+{
+  uint32_t t = get32(ttl);
+
+  return (t & 0x80000000UL) ? 0 : t;
+}
+/*---------------------------------------------------------------------------*/
 /** \internal
  */
 static unsigned char *
@@ -631,6 +721,10 @@ mdns_prep_host_announce_packet(void)
 static char
 try_next_server(struct namemap *namemapptr)
 {
+#if RESOLV_PARALLEL_QUERIES
+  /* All servers are asked at once, so there is no next one to try. */
+  return 0;
+#else /* RESOLV_PARALLEL_QUERIES */
 #if VERBOSE_DEBUG
   printf("server %d\n", namemapptr->server);
 #endif
@@ -641,29 +735,139 @@ try_next_server(struct namemap *namemapptr)
   }
   namemapptr->server = 0;
   return 0;
+#endif /* RESOLV_PARALLEL_QUERIES */
 }
 /*---------------------------------------------------------------------------*/
 /** \internal
- * Runs through the list of names to see if there are any that have
- * not yet been queried and, if so, sends out a query.
+ * Ends the query for an entry that did not get an address. The name is
+ * remembered as not found for ttl seconds. An entry that was only being
+ * refreshed keeps its address until it expires.
  */
 static void
-check_entries(void)
+stop_query(struct namemap *namemapptr, uint32_t ttl)
 {
-  volatile uint8_t i;
+  if(namemapptr->state == STATE_REFRESHING) {
+    namemapptr->state = STATE_DONE;
+    return;
+  }
+
+  /* STATE_ERROR basically means "not found". */
+  namemapptr->state = STATE_ERROR;
+
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  namemapptr->expiration = clock_seconds() + ttl;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
+  resolv_found(namemapptr->name, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Writes the query for an entry into uip_appdata.
+ *
+ * \return The length of the query.
+ */
+static uint16_t
+prepare_query(struct namemap *namemapptr)
+{
   uint8_t *query;
 
   register struct dns_hdr *hdr;
 
+  hdr = (struct dns_hdr *)uip_appdata;
+  memset(hdr, 0, sizeof(struct dns_hdr));
+  hdr->id = namemapptr->id;
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(!namemapptr->is_mdns || namemapptr->is_probe) {
+    hdr->flags1 = DNS_FLAG1_RD;
+  }
+  if(namemapptr->is_mdns) {
+    hdr->id = 0;
+  }
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+  hdr->flags1 = DNS_FLAG1_RD;
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  hdr->numquestions = UIP_HTONS(1);
+  query = (unsigned char *)uip_appdata + sizeof(*hdr);
+  query = encode_name(query, namemapptr->name);
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(namemapptr->is_probe) {
+    *query++ = (uint8_t) ((DNS_TYPE_ANY) >> 8);
+    *query++ = (uint8_t) ((DNS_TYPE_ANY));
+  } else
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  {
+    *query++ = (uint8_t) ((NATIVE_DNS_TYPE) >> 8);
+    *query++ = (uint8_t) ((NATIVE_DNS_TYPE));
+  }
+  *query++ = (uint8_t) ((DNS_CLASS_IN) >> 8);
+  *query++ = (uint8_t) ((DNS_CLASS_IN));
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(namemapptr->is_probe) {
+    /* This is our conflict detection request.
+     * In order to be in compliance with the MDNS
+     * spec, we need to add the records we are proposing
+     * to the rrauth section.
+     */
+    uint8_t count = 0;
+
+    query = mdns_write_announce_records(query, &count);
+    hdr->numauthrr = UIP_HTONS(count);
+  }
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  return query - (uint8_t *)uip_appdata;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Sends the query for an entry to its nameserver, or to all nameservers
+ * that have not failed to answer it.
+ */
+static void
+send_query(struct namemap *namemapptr)
+{
+#if RESOLV_PARALLEL_QUERIES
+  uint8_t server;
+
+  uip_ipaddr_t *addr;
+
+  /* The query is written again for every server, as sending it may
+     have used the buffer. */
+  for(server = 0; (addr = uip_nameserver_get(server)) != NULL; ++server) {
+    if(server < 8 && (namemapptr->failed & (1 << server))) {
+      continue;
+    }
+    uip_udp_packet_sendto(resolv_conn, uip_appdata,
+                          prepare_query(namemapptr),
+                          addr, UIP_HTONS(DNS_PORT));
+  }
+#else /* RESOLV_PARALLEL_QUERIES */
+  uip_udp_packet_sendto(resolv_conn, uip_appdata,
+                        prepare_query(namemapptr),
+                        uip_nameserver_get(namemapptr->server),
+                        UIP_HTONS(DNS_PORT));
+#endif /* RESOLV_PARALLEL_QUERIES */
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Runs through the list of names to see if there are any that have
+ * not yet been queried and, if so, sends out a query. Queries whose
+ * timer has run out are sent again.
+ */
+static void
+check_entries(void)
+{
+  volatile uint8_t i;
+
   register struct namemap *namemapptr;
 
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     namemapptr = &names[i];
-    if(namemapptr->state == STATE_NEW || namemapptr->state == STATE_ASKING) {
-      etimer_set(&retry, CLOCK_SECOND / 4);
-      if(namemapptr->state == STATE_ASKING) {
-        if(--namemapptr->tmr == 0) {
+    if(namemapptr->state == STATE_NEW || namemapptr->state == STATE_ASKING ||
+       namemapptr->state == STATE_REFRESHING) {
+      if(etimer_expired(&retry)) {
+        etimer_set(&retry, CLOCK_SECOND / 4);
+      }
+      if(namemapptr->state != STATE_NEW && namemapptr->tmr > 0) {
+        if(tick && --namemapptr->tmr == 0) {
 #if RESOLV_CONF_SUPPORTS_MDNS
           if(++namemapptr->retries ==
              (namemapptr->is_mdns ? RESOLV_CONF_MAX_MDNS_RETRIES :
@@ -675,15 +879,7 @@ check_entries(void)
             /* Try the next server (if possible) before failing. Otherwise
                simply mark the entry as failed. */
             if(try_next_server(namemapptr) == 0) {
-              /* STATE_ERROR basically means "not found". */
-              namemapptr->state = STATE_ERROR;
-
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-              /* Keep the "not found" error valid for 30 seconds */
-              namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-              resolv_found(namemapptr->name, NULL);
+              stop_query(namemapptr, RESOLV_NEGATIVE_TTL);
               continue;
             }
           }
@@ -702,80 +898,139 @@ check_entries(void)
           continue;
         }
       } else {
-        namemapptr->state = STATE_ASKING;
+        /* The first copy of the query. An entry that is being refreshed
+           stays in STATE_REFRESHING, so that lookups still get its
+           address. */
+        if(namemapptr->state == STATE_NEW) {
+          namemapptr->state = STATE_ASKING;
+        }
         namemapptr->tmr = 1;
         namemapptr->retries = 0;
+        /* Copies sent again keep this id, so that a late answer to an
+           earlier copy is still taken. */
+        namemapptr->id = random_rand();
       }
-      hdr = (struct dns_hdr *)uip_appdata;
-      memset(hdr, 0, sizeof(struct dns_hdr));
-      hdr->id = random_rand();
-      namemapptr->id = hdr->id;
-#if RESOLV_CONF_SUPPORTS_MDNS
-      if(!namemapptr->is_mdns || namemapptr->is_probe) {
-        hdr->flags1 = DNS_FLAG1_RD;
-      }
-      if(namemapptr->is_mdns) {
-        hdr->id = 0;
-      }
-#else /* RESOLV_CONF_SUPPORTS_MDNS */
-      hdr->flags1 = DNS_FLAG1_RD;
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      hdr->numquestions = UIP_HTONS(1);
-      query = (unsigned char *)uip_appdata + sizeof(*hdr);
-      query = encode_name(query, namemapptr->name);
-#if RESOLV_CONF_SUPPORTS_MDNS
-      if(namemapptr->is_probe) {
-        *query++ = (uint8_t) ((DNS_TYPE_ANY) >> 8);
-        *query++ = (uint8_t) ((DNS_TYPE_ANY));
-      } else
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      {
-        *query++ = (uint8_t) ((NATIVE_DNS_TYPE) >> 8);
-        *query++ = (uint8_t) ((NATIVE_DNS_TYPE));
-      }
-      *query++ = (uint8_t) ((DNS_CLASS_IN) >> 8);
-      *query++ = (uint8_t) ((DNS_CLASS_IN));
 #if RESOLV_CONF_SUPPORTS_MDNS
       if(namemapptr->is_mdns) {
-        if(namemapptr->is_probe) {
-          /* This is our conflict detection request.
-           * In order to be in compliance with the MDNS
-           * spec, we need to add the records we are proposing
-           * to the rrauth section.
-           */
-          uint8_t count = 0;
-
-          query = mdns_write_announce_records(query, &count);
-          hdr->numauthrr = UIP_HTONS(count);
-        }
         uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                              (query - (uint8_t *) uip_appdata),
+                              prepare_query(namemapptr),
                               &resolv_mdns_addr, UIP_HTONS(MDNS_PORT));
 
         PRINTF("resolver: (i=%d) Sent MDNS %s for \"%s\".\n", i,
                namemapptr->is_probe?"probe":"request",namemapptr->name);
-      } else {
-        uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                              (query - (uint8_t *) uip_appdata),
-                              (const uip_ipaddr_t *)
-                                uip_nameserver_get(namemapptr->server), 
-                              UIP_HTONS(DNS_PORT));
-
-        PRINTF("resolver: (i=%d) Sent DNS request for \"%s\".\n", i,
-               namemapptr->name);
+        continue;
       }
-#else /* RESOLV_CONF_SUPPORTS_MDNS */
-      uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                            (query - (uint8_t *) uip_appdata),
-                            uip_nameserver_get(namemapptr->server), 
-                            UIP_HTONS(DNS_PORT));
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+      send_query(namemapptr);
       PRINTF("resolver: (i=%d) Sent DNS request for \"%s\".\n", i,
              namemapptr->name);
+    }
+  }
+  tick = 0;
+}
+#if RESOLV_PREFETCH
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Queries a cached name again before it expires. The entry keeps
+ * answering lookups with the old address in the meantime.
+ */
+static void
+start_prefetch(struct namemap *namemapptr)
+{
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(namemapptr->is_mdns) {
+    return;
+  }
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
+
+  PRINTF("resolver: Refreshing \"%s\".\n", namemapptr->name);
+
+  namemapptr->state = STATE_REFRESHING;
+  /* Not sent yet; check_entries() sends it like a new query. */
+  namemapptr->tmr = 0;
+  namemapptr->server = 0;
+#if RESOLV_PARALLEL_QUERIES
+  namemapptr->failed = 0;
+#endif /* RESOLV_PARALLEL_QUERIES */
+
+  /* The query goes out at the next tick of the retry timer. */
+  process_post(&resolv_process, PROCESS_EVENT_TIMER, 0);
+}
+#endif /* RESOLV_PREFETCH */
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Finds how long a negative answer may be cached: the smaller of the
+ * TTL and the MINIMUM field of the SOA record in the authority section
+ * (RFC 2308).
+ *
+ * \param queryptr Start of the answer section.
+ * \param nanswers Number of answer records to skip.
+ * \param nauthrr  Number of authority records.
+ */
+static uint32_t
+negative_ttl(unsigned char *queryptr, uint8_t nanswers, uint8_t nauthrr)
+{
+  const unsigned char *end = (unsigned char *)uip_appdata + uip_datalen();
+
+  unsigned char *rr;
+
+  uint32_t ttl, minimum;
+
+  for(; nanswers > 0; --nanswers) {
+    rr = skip_name(queryptr);
+    if(rr + 10 > end) {
+      return RESOLV_NEGATIVE_TTL;
+    }
+    queryptr = rr + 10 + ((rr[8] << 8) | rr[9]);
+  }
+
+  for(; nauthrr > 0; --nauthrr) {
+    rr = skip_name(queryptr);
+    if(rr + 10 > end) {
       break;
     }
+    queryptr = rr + 10 + ((rr[8] << 8) | rr[9]);
+    if(rr[0] == 0 && rr[1] == DNS_TYPE_SOA && queryptr <= end) {
+      ttl = record_ttl(rr + 4);
+      /* The MINIMUM field ends the record. */
+      minimum = get32(queryptr - 4);
+      if(minimum < ttl) {
+        ttl = minimum;
+      }
+      return ttl < RESOLV_MAX_NEGATIVE_TTL ? ttl : RESOLV_MAX_NEGATIVE_TTL;
+    }
+  }
+  return RESOLV_NEGATIVE_TTL;
+}
+#if RESOLV_PARALLEL_QUERIES
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Notes that the server that sent the current packet could not answer
+ * the query for an entry.
+ *
+ * \return Non-zero if none of the servers has answered.
+ */
+static uint8_t
+server_failed(struct namemap *namemapptr)
+{
+  uint8_t server;
+
+  uip_ipaddr_t *addr;
+
+  uint8_t all = 1;
+
+  for(server = 0; server < 8 &&
+        (addr = uip_nameserver_get(server)) != NULL; ++server) {
+    if(uip_ipaddr_cmp(addr, &UIP_UDP_BUF->srcipaddr)) {
+      namemapptr->failed |= 1 << server;
+    }
+    if((namemapptr->failed & (1 << server)) == 0) {
+      all = 0;
+    }
   }
+  return all;
 }
+#endif /* RESOLV_PARALLEL_QUERIES */
 /*---------------------------------------------------------------------------*/
 /** \internal
  * Called when new UDP data arrives.
@@ -787,6 +1042,10 @@ newdata(void)
 
   static int8_t i;
 
+  static uint32_t ttl;
+
+  static uint8_t is_refresh;
+
   register struct namemap *namemapptr = NULL;
 
   struct dns_answer *ans;
@@ -895,11 +1154,6 @@ newdata(void)
 
 /** ANSWER HANDLING SECTION **************************************************/
 
-  if(nanswers == 0) {
-    /* Skip responses with no answers. */
-    return;
-  }
-
 #if RESOLV_CONF_SUPPORTS_MDNS
   if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
      hdr->id == 0) {
@@ -907,45 +1161,67 @@ newdata(void)
      * because we can't use the `id` field. We will look up the
      * appropriate request in a later step. */
 
+    if(nanswers == 0) {
+      /* Skip responses with no answers. */
+      return;
+    }
+
     i = -1;
     namemapptr = NULL;
   } else
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
   {
+    if((hdr->flags1 & DNS_FLAG1_RESPONSE) == 0) {
+      return;
+    }
+
+    /* With parallel queries, the first answer to arrive is used and the
+       others find no entry waiting for them. */
     for(i = 0; i < RESOLV_ENTRIES; ++i) {
       namemapptr = &names[i];
-      if(namemapptr->state == STATE_ASKING &&
+      if((namemapptr->state == STATE_ASKING ||
+          namemapptr->state == STATE_REFRESHING) &&
          namemapptr->id == hdr->id) {
         break;
       }
     }
 
-    if(i >= RESOLV_ENTRIES || i < 0 || namemapptr->state != STATE_ASKING) {
+    if(i >= RESOLV_ENTRIES || i < 0) {
       PRINTF("resolver: DNS response has bad ID (%04X) \n", uip_ntohs(hdr->id));
       return;
     }
 
     PRINTF("resolver: Incoming response for \"%s\".\n", namemapptr->name);
 
-    /* We'll change this to DONE when we find the record. */
-    namemapptr->state = STATE_ERROR;
-
     namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    /* If we remain in the error state, keep it cached for 30 seconds. */
-    namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+    if(namemapptr->err == DNS_FLAG2_ERR_NAME) {
+      /* The name does not exist. */
+      stop_query(namemapptr,
+                 negative_ttl(queryptr, nanswers,
+                              (uint8_t)uip_ntohs(hdr->numauthrr)));
+      return;
+    }
 
-    /* Check for error. If so, call callback to inform. */
     if(namemapptr->err != 0) {
-      namemapptr->state = STATE_ERROR;
-      resolv_found(namemapptr->name, NULL);
+      /* This server could not answer, but another one may. */
+#if RESOLV_PARALLEL_QUERIES
+      if(server_failed(namemapptr)) {
+        stop_query(namemapptr, RESOLV_NEGATIVE_TTL);
+      }
+#else /* RESOLV_PARALLEL_QUERIES */
+      if(try_next_server(namemapptr)) {
+        namemapptr->tmr = 1;
+      } else {
+        stop_query(namemapptr, RESOLV_NEGATIVE_TTL);
+      }
+#endif /* RESOLV_PARALLEL_QUERIES */
       return;
     }
   }
 
   i = 0;
+  ttl = 0xffffffffUL;
 
   /* Answer parsing loop */
   while(nanswers > 0) {
@@ -969,6 +1245,14 @@ newdata(void)
                  uip_ntohs(ans->ttl[1]), uip_ntohs(ans->len));
 #endif /* VERBOSE_DEBUG */
 
+    /* The address may be reached through CNAME records, and it may be
+     * cached only as long as all of them are valid.
+     */
+    if(ans->type == UIP_HTONS(DNS_TYPE_CNAME) &&
+       record_ttl((unsigned char *)ans->ttl) < ttl) {
+      ttl = record_ttl((unsigned char *)ans->ttl);
+    }
+
     /* Check the class and length of the answer to make sure
      * it matches what we are expecting
      */
@@ -1013,6 +1297,7 @@ newdata(void)
           namemapptr = NULL;
           goto skip_to_next_answer;
         }
+        namemapptr->hash = name_hash(namemapptr->name);
       }
       if(i == RESOLV_ENTRIES) {
         DEBUG_PRINTF
@@ -1045,15 +1330,27 @@ newdata(void)
 
     DEBUG_PRINTF("resolver: Answer for \"%s\" is usable.\n", namemapptr->name);
 
+    /* A refreshed entry is not announced again: its users already
+       have an address. */
+    is_refresh = namemapptr->state == STATE_REFRESHING;
+
     namemapptr->state = STATE_DONE;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    namemapptr->expiration = ans->ttl[1] + (ans->ttl[0] << 8);
-    namemapptr->expiration += clock_seconds();
+    if(record_ttl((unsigned char *)ans->ttl) < ttl) {
+      ttl = record_ttl((unsigned char *)ans->ttl);
+    }
+    namemapptr->expiration = clock_seconds() + ttl;
+#if RESOLV_PREFETCH
+    namemapptr->prefetch = namemapptr->expiration -
+      (ttl / 4 < RESOLV_PREFETCH_TIME ? ttl / 4 : RESOLV_PREFETCH_TIME);
+#endif /* RESOLV_PREFETCH */
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
     uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
 
-    resolv_found(namemapptr->name, &namemapptr->ipaddr);
+    if(!is_refresh) {
+      resolv_found(namemapptr->name, &namemapptr->ipaddr);
+    }
     break;
 
   skip_to_next_answer:
@@ -1061,19 +1358,17 @@ newdata(void)
     --nanswers;
   }
 
-  /* Got to this point there's no answer, try next nameserver if available
-     since this one doesn't know the answer */
+  /* Got to this point there's no answer: the name exists, but has no
+     address of our type. The authority section tells for how long. */
 #if RESOLV_CONF_SUPPORTS_MDNS
-  if(nanswers == 0 && UIP_UDP_BUF->srcport != UIP_HTONS(MDNS_PORT) 
-      && hdr->id != 0)
+  if(nanswers == 0 && !(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
+                        hdr->id == 0))
 #else
-  if(nanswers == 0) 
+  if(nanswers == 0)
 #endif
   {
-    if(try_next_server(namemapptr)) {
-      namemapptr->state = STATE_ASKING;
-      process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
-    }
+    stop_query(namemapptr,
+               negative_ttl(queryptr, 0, (uint8_t)uip_ntohs(hdr->numauthrr)));
   }
 
 }
@@ -1183,6 +1478,9 @@ PROCESS_THREAD(resolv_process, ev, data)
     PROCESS_WAIT_EVENT();
 
     if(ev == PROCESS_EVENT_TIMER) {
+      if(data == &retry) {
+        tick = 1;
+      }
       tcpip_poll_udp(resolv_conn);
     } else if(ev == tcpip_event) {
       if(uip_udp_conn == resolv_conn) {
@@ -1270,6 +1568,8 @@ resolv_query(const char *name)
 
   static uint8_t lseq, lseqi;
 
+  static uint8_t hash;
+
   register struct namemap *nameptr = 0;
 
   init();
@@ -1278,20 +1578,25 @@ resolv_query(const char *name)
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
+  hash = name_hash(name);
 
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
-    if(0 == strcasecmp(nameptr->name, name)) {
+    if(nameptr->hash == hash && 0 == strcasecmp(nameptr->name, name)) {
       break;
     }
     if((nameptr->state == STATE_UNUSED)
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-      || (nameptr->state == STATE_DONE && clock_seconds() > nameptr->expiration)
+      || ((nameptr->state == STATE_DONE || nameptr->state == STATE_ERROR) &&
+          clock_seconds() > nameptr->expiration)
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
     ) {
       lseqi = i;
       lseq = 255;
-    } else if(seqno - nameptr->seqno > lseq) {
+    } else if(nameptr->state != STATE_NEW && nameptr->state != STATE_ASKING &&
+              seqno - nameptr->seqno > lseq) {
+      /* Names that are still being asked for are not replaced unless
+         all of them are. */
       lseq = seqno - nameptr->seqno;
       lseqi = i;
     }
@@ -1307,6 +1612,7 @@ resolv_query(const char *name)
   memset(nameptr, 0, sizeof(*nameptr));
 
   strncpy(nameptr->name, name, sizeof(nameptr->name));
+  nameptr->hash = hash;
   nameptr->state = STATE_NEW;
   nameptr->seqno = seqno;
   ++seqno;
@@ -1341,6 +1647,10 @@ resolv_query(const char *name)
  * was found. The function resolv_query() can be used to send a query
  * for a hostname.
  *
+ * \note A name that is found shortly before it expires is queried
+ * again in the background, and keeps being found with its old address
+ * until the new answer arrives.
+ *
  */
 resolv_status_t
 resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
@@ -1349,10 +1659,13 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
 
   static uint8_t i;
 
+  static uint8_t hash;
+
   struct namemap *nameptr;
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
+  hash = name_hash(name);
 
 #if UIP_CONF_LOOPBACK_INTERFACE
   if(strcmp(name, "localhost")) {
@@ -1374,14 +1687,23 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
 
-    if(strcasecmp(name, nameptr->name) == 0) {
+    if(nameptr->hash == hash && strcasecmp(name, nameptr->name) == 0) {
       switch (nameptr->state) {
       case STATE_DONE:
+      case STATE_REFRESHING:
         ret = RESOLV_STATUS_CACHED;
+        /* Used names are the last ones to be replaced. */
+        nameptr->seqno = seqno++;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
         if(clock_seconds() > nameptr->expiration) {
           ret = RESOLV_STATUS_EXPIRED;
         }
+#if RESOLV_PREFETCH
+        else if(nameptr->state == STATE_DONE &&
+                clock_seconds() >= nameptr->prefetch) {
+          start_prefetch(nameptr);
+        }
+#endif /* RESOLV_PREFETCH */
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
         break;
       case STATE_NEW:
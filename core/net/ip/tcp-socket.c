@@ -42,6 +42,7 @@
 
 
 static void relisten(struct tcp_socket *s);
+static void acked(struct tcp_socket *s);
 
 LIST(socketlist);
 /*---------------------------------------------------------------------------*/
@@ -55,6 +56,43 @@ call_event(struct tcp_socket *s, tcp_socket_event_t event)
   }
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+queuelen(struct tcp_socket *s)
+{
+  uint16_t len = s->output_data_len;
+  int i;
+  for(i = 0; i < s->output_refs_count; i++) {
+    len += s->output_refs[i].len;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Copies the first len bytes of the output, buffered and referenced, to dst */
+static void
+gather(struct tcp_socket *s, uint8_t *dst, uint16_t len)
+{
+  uint16_t bufpos = 0;
+  uint16_t n;
+  int i;
+
+  for(i = 0; i <= s->output_refs_count && len > 0; i++) {
+    /* Buffered data up to the next reference, or to the end */
+    n = (i < s->output_refs_count ? s->output_refs[i].offset :
+         s->output_data_len) - bufpos;
+    n = MIN(n, len);
+    memcpy(dst, &s->output_data_ptr[bufpos], n);
+    dst += n;
+    bufpos += n;
+    len -= n;
+    if(i < s->output_refs_count && len > 0) {
+      n = MIN(s->output_refs[i].len, len);
+      memcpy(dst, s->output_refs[i].data, n);
+      dst += n;
+      len -= n;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 senddata(struct tcp_socket *s)
 {
@@ -63,25 +101,33 @@ senddata(struct tcp_socket *s)
   if(s->output_senddata_len > 0) {
     len = MIN(s->output_senddata_len, len);
     s->output_data_send_nxt = len;
-    uip_send(s->output_data_ptr, len);
+    if(s->output_refs_count == 0) {
+      uip_send(s->output_data_ptr, len);
+    } else {
+      /* Build the segment in uip_buf, so that it is only copied once */
+      gather(s, uip_appdata, len);
+      uip_send(uip_appdata, len);
+    }
+#if UIP_TCP_BUFFERED
+    /* uIP keeps its own copy of the data of a buffered connection, so
+       it can be released right away */
+    if(len > 0) {
+      acked(s);
+    }
+#endif /* UIP_TCP_BUFFERED */
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 acked(struct tcp_socket *s)
 {
-  if(s->output_senddata_len > 0) {
-    /* Copy the data in the outputbuf down and update outputbufptr and
-       outputbuf_lastsent */
+  uint16_t left, consumed, n;
+  int i;
 
-    if(s->output_data_send_nxt > 0) {
-      memcpy(&s->output_data_ptr[0],
-             &s->output_data_ptr[s->output_data_send_nxt],
-             s->output_data_maxlen - s->output_data_send_nxt);
-    }
-    if(s->output_data_len < s->output_data_send_nxt) {
-      printf("tcp: acked assertion failed s->output_data_len (%d) < s->output_data_send_nxt (%d)\n",
-             s->output_data_len,
+  if(s->output_senddata_len > 0) {
+    if(queuelen(s) < s->output_data_send_nxt) {
+      printf("tcp: acked assertion failed queuelen (%d) < s->output_data_send_nxt (%d)\n",
+             queuelen(s),
              s->output_data_send_nxt);
       tcp_markconn(uip_conn, NULL);
       uip_abort();
@@ -89,8 +135,43 @@ acked(struct tcp_socket *s)
       relisten(s);
       return;
     }
-    s->output_data_len -= s->output_data_send_nxt;
-    s->output_senddata_len = s->output_data_len;
+
+    /* Find how much of the acknowledged data came from the output buffer
+       and release the references that have been completely sent */
+    left = s->output_data_send_nxt;
+    consumed = 0;
+    while(left > 0) {
+      if(s->output_refs_count > 0 && s->output_refs[0].offset == consumed) {
+        n = MIN(s->output_refs[0].len, left);
+        s->output_refs[0].data += n;
+        s->output_refs[0].len -= n;
+        left -= n;
+        if(s->output_refs[0].len == 0) {
+          s->output_refs_count--;
+          memmove(&s->output_refs[0], &s->output_refs[1],
+                  s->output_refs_count * sizeof(struct tcp_socket_ref));
+        }
+      } else {
+        n = (s->output_refs_count > 0 ? s->output_refs[0].offset :
+             s->output_data_len) - consumed;
+        n = MIN(n, left);
+        consumed += n;
+        left -= n;
+      }
+    }
+
+    /* Copy the data that is left in the outputbuf down. Only the queued
+       bytes, not the whole buffer. */
+    if(consumed > 0) {
+      memmove(&s->output_data_ptr[0],
+              &s->output_data_ptr[consumed],
+              s->output_data_len - consumed);
+    }
+    s->output_data_len -= consumed;
+    for(i = 0; i < s->output_refs_count; i++) {
+      s->output_refs[i].offset -= consumed;
+    }
+    s->output_senddata_len = queuelen(s);
     s->output_data_send_nxt = 0;
 
     call_event(s, TCP_SOCKET_DATA_SENT);
@@ -105,6 +186,15 @@ newdata(struct tcp_socket *s)
   len = uip_datalen();
   dataptr = uip_appdata;
 
+  if(s->input_data_ptr == NULL) {
+    /* Without an input buffer, the callback reads the data in place
+       in the uIP buffer and must consume all of it. */
+    if(s->input_callback) {
+      s->input_callback(s, s->ptr, dataptr, len);
+    }
+    return;
+  }
+
   /* We have a segment with data coming in. We copy as much data as
      possible into the input buffer and call the input callback
      function. The input callback returns the number of bytes that
@@ -160,8 +250,12 @@ appcall(void *state)
 	if((s->flags & TCP_SOCKET_FLAGS_LISTENING) != 0 &&
 	   s->listen_port != 0 &&
 	   s->listen_port == uip_htons(uip_conn->lport)) {
-	  s->flags &= ~TCP_SOCKET_FLAGS_LISTENING;
+	  s->flags &= ~(TCP_SOCKET_FLAGS_LISTENING | TCP_SOCKET_FLAGS_RESTART);
+	  s->c = uip_conn;
           s->output_data_max_seg = uip_mss();
+#if UIP_TCP_BUFFERED
+          uip_tcp_set_buffered(uip_conn);
+#endif /* UIP_TCP_BUFFERED */
 	  tcp_markconn(uip_conn, s);
 	  call_event(s, TCP_SOCKET_CONNECTED);
 	  break;
@@ -169,6 +263,9 @@ appcall(void *state)
       }
     } else {
       s->output_data_max_seg = uip_mss();
+#if UIP_TCP_BUFFERED
+      uip_tcp_set_buffered(uip_conn);
+#endif /* UIP_TCP_BUFFERED */
       call_event(s, TCP_SOCKET_CONNECTED);
     }
 
@@ -200,9 +297,11 @@ appcall(void *state)
     return;
   }
 
+#if !UIP_TCP_BUFFERED
   if(uip_acked()) {
     acked(s);
   }
+#endif /* !UIP_TCP_BUFFERED */
   if(uip_newdata()) {
     newdata(s);
   }
@@ -215,7 +314,15 @@ appcall(void *state)
     senddata(s);
   }
 
-  if(s->output_data_len == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING) {
+  if(s->flags & TCP_SOCKET_FLAGS_RESTART) {
+    /* Open the window again. With the new data flag set and nothing
+       else to send, uIP sends an ACK that tells the peer about it. */
+    s->flags &= ~TCP_SOCKET_FLAGS_RESTART;
+    uip_restart();
+  }
+
+  if(queuelen(s) == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING &&
+     !uip_outstanding(uip_conn)) {
     s->flags &= ~TCP_SOCKET_FLAGS_CLOSING;
     uip_close();
     s->c = NULL;
@@ -274,6 +381,7 @@ tcp_socket_register(struct tcp_socket *s, void *ptr,
   s->input_data_ptr = input_databuf;
   s->input_data_maxlen = input_databuf_len;
   s->output_data_len = 0;
+  s->output_refs_count = 0;
   s->output_data_ptr = output_databuf;
   s->output_data_maxlen = output_databuf_len;
   s->input_callback = input_callback;
@@ -349,17 +457,57 @@ tcp_socket_send(struct tcp_socket *s,
 
   len = MIN(datalen, s->output_data_maxlen - s->output_data_len);
 
-  memcpy(&s->output_data_ptr[s->output_data_len], data, len);
+  /* The caller may have written the data in place in the output buffer */
+  if(data != &s->output_data_ptr[s->output_data_len]) {
+    memcpy(&s->output_data_ptr[s->output_data_len], data, len);
+  }
   s->output_data_len += len;
 
-  if(s->output_senddata_len == 0) {
-    s->output_senddata_len = s->output_data_len;
+  /* The data to send can grow as long as none of it is in flight */
+  if(s->output_data_send_nxt == 0) {
+    s->output_senddata_len = queuelen(s);
+  }
+
+  /* Send now instead of at the next periodic poll of the connection */
+  if(s->c != NULL) {
+    tcpip_poll_tcp(s->c);
   }
 
   return len;
 }
 /*---------------------------------------------------------------------------*/
 int
+tcp_socket_send_ref(struct tcp_socket *s,
+                    const uint8_t *data, int datalen)
+{
+  struct tcp_socket_ref *ref;
+
+  if(s == NULL) {
+    return -1;
+  }
+
+  if(s->output_refs_count == TCP_SOCKET_MAX_REFS) {
+    return 0;
+  }
+
+  ref = &s->output_refs[s->output_refs_count++];
+  ref->data = data;
+  ref->len = datalen;
+  ref->offset = s->output_data_len;
+
+  /* The data to send can grow as long as none of it is in flight */
+  if(s->output_data_send_nxt == 0) {
+    s->output_senddata_len = queuelen(s);
+  }
+
+  if(s->c != NULL) {
+    tcpip_poll_tcp(s->c);
+  }
+
+  return datalen;
+}
+/*---------------------------------------------------------------------------*/
+int
 tcp_socket_send_str(struct tcp_socket *s,
              const char *str)
 {
@@ -378,6 +526,34 @@ tcp_socket_close(struct tcp_socket *s)
 }
 /*---------------------------------------------------------------------------*/
 int
+tcp_socket_stop(struct tcp_socket *s)
+{
+  if(s == NULL || s->c == NULL) {
+    return -1;
+  }
+
+  s->c->tcpstateflags |= UIP_STOPPED;
+  s->flags &= ~TCP_SOCKET_FLAGS_RESTART;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+tcp_socket_restart(struct tcp_socket *s)
+{
+  if(s == NULL || s->c == NULL) {
+    return -1;
+  }
+
+  if(uip_stopped(s->c)) {
+    /* The window is opened from the next callback for the connection,
+       as the peer has to be told about it. */
+    s->flags |= TCP_SOCKET_FLAGS_RESTART;
+    tcpip_poll_tcp(s->c);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
 tcp_socket_unregister(struct tcp_socket *s)
 {
   if(s == NULL) {
@@ -398,3 +574,9 @@ tcp_socket_max_sendlen(struct tcp_socket *s)
   return s->output_data_maxlen - s->output_data_len;
 }
 /*---------------------------------------------------------------------------*/
+int
+tcp_socket_queuelen(struct tcp_socket *s)
+{
+  return queuelen(s);
+}
+/*---------------------------------------------------------------------------*/
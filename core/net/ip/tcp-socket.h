@@ -36,6 +36,13 @@
 
 struct tcp_socket;
 
+/* The number of references to caller memory a socket can queue for output */
+#ifdef TCP_SOCKET_CONF_MAX_REFS
+#define TCP_SOCKET_MAX_REFS TCP_SOCKET_CONF_MAX_REFS
+#else
+#define TCP_SOCKET_MAX_REFS 2
+#endif
+
 typedef enum {
   TCP_SOCKET_CONNECTED,
   TCP_SOCKET_CLOSED,
@@ -80,6 +87,16 @@ typedef void (* tcp_socket_event_callback_t)(struct tcp_socket *s,
                                              void *ptr,
                                              tcp_socket_event_t event);
 
+/*
+ * Outgoing data that is sent from caller memory instead of the output
+ * buffer. The data goes after the first offset bytes of the output buffer.
+ */
+struct tcp_socket_ref {
+  const uint8_t *data;
+  uint16_t len;
+  uint16_t offset;
+};
+
 struct tcp_socket {
   struct tcp_socket *next;
 
@@ -100,6 +117,9 @@ struct tcp_socket {
   uint16_t output_senddata_len;
   uint16_t output_data_max_seg;
 
+  struct tcp_socket_ref output_refs[TCP_SOCKET_MAX_REFS];
+  uint8_t output_refs_count;
+
   uint8_t flags;
   uint16_t listen_port;
   struct uip_conn *c;
@@ -109,6 +129,7 @@ enum {
   TCP_SOCKET_FLAGS_NONE      = 0x00,
   TCP_SOCKET_FLAGS_LISTENING = 0x01,
   TCP_SOCKET_FLAGS_CLOSING   = 0x02,
+  TCP_SOCKET_FLAGS_RESTART   = 0x04,
 };
 
 /**
@@ -146,6 +167,11 @@ enum {
  *             application has read out the data from the input
  *             buffer.
  *
+ *             If input_databuf is NULL, the data callback is called
+ *             with the data in place in the uIP buffer, and it must
+ *             consume all of it. This saves the copy and the memory
+ *             for applications that keep their own buffers.
+ *
  */
 int tcp_socket_register(struct tcp_socket *s, void *ptr,
                          uint8_t *input_databuf, int input_databuf_len,
@@ -224,11 +250,37 @@ int tcp_socket_unlisten(struct tcp_socket *s);
  *             data has been acknowledged by the remote host, the
  *             event callback is sent with the TCP_SOCKET_DATA_SENT
  *             event.
+ *
+ *             The data may also be written in place, right after the
+ *             data in the output buffer. It must then be sent before
+ *             the socket gets to run, which moves only the data it
+ *             has been given.
  */
 int tcp_socket_send(struct tcp_socket *s,
                     const uint8_t *dataptr,
                     int datalen);
 
+/**
+ * \brief      Send data from caller memory on a connected TCP socket
+ * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
+ * \param dataptr A pointer to the data to be sent
+ * \param datalen The length of the data to be sent
+ * \retval -1  If an error occurs
+ * \return     The number of bytes that were queued, 0 if the socket has
+ *             no free reference
+ *
+ *             This function queues data for sending without copying it
+ *             into the output buffer. The data is copied directly into
+ *             the outgoing segments, in order with data sent with
+ *             tcp_socket_send(), so it must not be changed until the
+ *             remote host has acknowledged it. The data is released when
+ *             output_refs_count no longer counts it, which can be checked
+ *             on the TCP_SOCKET_DATA_SENT event.
+ */
+int tcp_socket_send_ref(struct tcp_socket *s,
+                        const uint8_t *dataptr,
+                        int datalen);
+
 /**
  * \brief      Send a string on a connected TCP socket
  * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
@@ -256,6 +308,36 @@ int tcp_socket_send_str(struct tcp_socket *s,
  */
 int tcp_socket_close(struct tcp_socket *s);
 
+/**
+ * \brief      Stop the flow of incoming data on a connected TCP socket
+ * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             This function closes the receive window of the
+ *             connection, so that the remote host stops sending
+ *             until tcp_socket_restart() is called. Data that is
+ *             already on its way is dropped and later retransmitted
+ *             by the remote host. It can be called from the data
+ *             callback, when the application has no room for more
+ *             data.
+ */
+int tcp_socket_stop(struct tcp_socket *s);
+
+/**
+ * \brief      Restart the flow of incoming data on a stopped TCP socket
+ * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
+ * \retval -1  If an error occurs
+ * \retval 1   If the operation succeeds.
+ *
+ *             This function opens the receive window of a connection
+ *             that was stopped with tcp_socket_stop(). The remote
+ *             host is told about the open window from the next
+ *             callback for the connection, which the function asks
+ *             for by polling it.
+ */
+int tcp_socket_restart(struct tcp_socket *s);
+
 /**
  * \brief      Unregister a registered socket
  * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
@@ -284,4 +366,12 @@ int tcp_socket_unregister(struct tcp_socket *s);
  */
 int tcp_socket_max_sendlen(struct tcp_socket *s);
 
+/**
+ * \brief      The amount of data that has not been acknowledged yet
+ * \param s    A pointer to a TCP socket
+ * \return     The number of bytes, in the output buffer and referenced,
+ *             that are waiting to be sent or acknowledged
+ */
+int tcp_socket_queuelen(struct tcp_socket *s);
+
 #endif /* TCP_SOCKET_H */
@@ -521,11 +521,15 @@ tcpip_input(void)
 }
 /*---------------------------------------------------------------------------*/
 #if NETSTACK_CONF_WITH_IPV6
-void
-tcpip_ipv6_output(void)
+static void
+ipv6_output(void)
 {
   uip_ds6_nbr_t *nbr = NULL;
   uip_ipaddr_t *nexthop;
+  uip_ds6_route_t *route = NULL;
+#if UIP_DS6_FLOW_NB > 0
+  uip_ds6_flow_t *flow;
+#endif /* UIP_DS6_FLOW_NB > 0 */
 
   if(uip_len == 0) {
     return;
@@ -547,15 +551,27 @@ tcpip_ipv6_output(void)
     /* Next hop determination */
     nbr = NULL;
 
+#if UIP_DS6_FLOW_NB > 0
+    /* If the flow has been sent before, the flow cache holds the
+       neighbor it was sent to. RPL may already have looked it up. */
+    flow = uip_ds6_flow_lookup();
+    if(flow != NULL) {
+      nbr = flow->nbr;
+      nexthop = &nbr->ipaddr;
+    } else
+#endif /* UIP_DS6_FLOW_NB > 0 */
     /* We first check if the destination address is on our immediate
        link. If so, we simply use the destination address as our
        nexthop address. */
     if(uip_ds6_is_addr_onlink(&UIP_IP_BUF->destipaddr)){
       nexthop = &UIP_IP_BUF->destipaddr;
     } else {
-      uip_ds6_route_t *route;
       /* Check if we have a route to the destination address. */
+#if UIP_DS6_FLOW_NB > 0
+      route = uip_ds6_flow_route_lookup();
+#else /* UIP_DS6_FLOW_NB > 0 */
       route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
+#endif /* UIP_DS6_FLOW_NB > 0 */
 
       /* No route was found - we send to the default route instead. */
       if(route == NULL) {
@@ -579,6 +595,9 @@ tcpip_ipv6_output(void)
 	    PRINTF("FALLBACK: output error. Reporting DST UNREACH\n");
 	    uip_icmp6_error_output(ICMP6_DST_UNREACH, ICMP6_DST_UNREACH_ADDR, 0);
 	    uip_flags = 0;
+#if UIP_DS6_FLOW_NB > 0
+	    uip_ds6_flow_done();
+#endif /* UIP_DS6_FLOW_NB > 0 */
 	    tcpip_ipv6_output();
 	    return;
 	  }
@@ -641,31 +660,33 @@ tcpip_ipv6_output(void)
       return;
     }
 #endif /* UIP_CONF_IPV6_RPL */
-    nbr = uip_ds6_nbr_lookup(nexthop);
+    if(nbr == NULL) {
+      nbr = uip_ds6_nbr_lookup(nexthop);
+    }
     if(nbr == NULL) {
 #if UIP_ND6_SEND_NA
       if((nbr = uip_ds6_nbr_add(nexthop, NULL, 0, NBR_INCOMPLETE)) == NULL) {
         uip_clear_buf();
         return;
       } else {
-#if UIP_CONF_IPV6_QUEUE_PKT
-        /* Copy outgoing pkt in the queuing buffer for later transmit. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
-#endif
+        uip_ipaddr_t nssrcaddr, *nssrc;
+
       /* RFC4861, 7.2.2:
        * "If the source address of the packet prompting the solicitation is the
        * same as one of the addresses assigned to the outgoing interface, that
        * address SHOULD be placed in the IP Source Address of the outgoing
        * solicitation.  Otherwise, any one of the addresses assigned to the
        * interface should be used."*/
-       if(uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)){
-          uip_nd6_ns_output(&UIP_IP_BUF->srcipaddr, NULL, &nbr->ipaddr);
-        } else {
-          uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
+        nssrc = NULL;
+        if(uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)) {
+          uip_ipaddr_copy(&nssrcaddr, &UIP_IP_BUF->srcipaddr);
+          nssrc = &nssrcaddr;
         }
+#if UIP_CONF_IPV6_QUEUE_PKT
+        /* Queue the outgoing pkt for later transmit. */
+        uip_packetqueue_store(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
+#endif
+        uip_nd6_ns_output(nssrc, NULL, &nbr->ipaddr);
 
         stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
         nbr->nscount = 1;
@@ -680,12 +701,8 @@ tcpip_ipv6_output(void)
       if(nbr->state == NBR_INCOMPLETE) {
         PRINTF("tcpip_ipv6_output: nbr cache entry incomplete\n");
 #if UIP_CONF_IPV6_QUEUE_PKT
-        /* Copy outgoing pkt in the queuing buffer for later transmit and set
-           the destination nbr to nbr. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        /* Queue the outgoing pkt for later transmit to nbr. */
+        uip_packetqueue_store(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
         uip_clear_buf();
         return;
@@ -700,6 +717,12 @@ tcpip_ipv6_output(void)
       }
 #endif /* UIP_ND6_SEND_NA */
 
+#if UIP_DS6_FLOW_NB > 0
+      if(flow == NULL) {
+        uip_ds6_flow_add(nbr);
+      }
+#endif /* UIP_DS6_FLOW_NB > 0 */
+
       tcpip_output(uip_ds6_nbr_get_ll(nbr));
 
 #if UIP_CONF_IPV6_QUEUE_PKT
@@ -707,12 +730,11 @@ tcpip_ipv6_output(void)
        * Send the queued packets from here, may not be 100% perfect though.
        * This happens in a few cases, for example when instead of receiving a
        * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
-       * to STALE, and you must both send a NA and the queued packet.
+       * to STALE, and you must both send a NA and the queued packets. It
+       * also sends the rest of the queue in a burst after uip-nd6 has
+       * handed us the first queued packet on reception of the NA.
        */
-      if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-        uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-        memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-        uip_packetqueue_free(&nbr->packethandle);
+      while(uip_packetqueue_load(&nbr->packethandle)) {
         tcpip_output(uip_ds6_nbr_get_ll(nbr));
       }
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
@@ -725,6 +747,16 @@ tcpip_ipv6_output(void)
   tcpip_output(NULL);
   uip_clear_buf();
 }
+/*---------------------------------------------------------------------------*/
+void
+tcpip_ipv6_output(void)
+{
+  ipv6_output();
+#if UIP_DS6_FLOW_NB > 0
+  /* The packet has been sent or dropped */
+  uip_ds6_flow_done();
+#endif /* UIP_DS6_FLOW_NB > 0 */
+}
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 /*---------------------------------------------------------------------------*/
 #if UIP_UDP
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A pool of uIP packet buffers
+ */
+
+#include "net/ip/uip-bufpool.h"
+
+#if UIP_BUF_POOL
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+#define NUM_BUFS (UIP_BUF_POOL + 1)
+
+static uip_buf_t bufs[NUM_BUFS];
+
+/* The first buffer is uip_buf from the start, so that uip_buf can be
+   used before uip_init() has been called. */
+static uint8_t used[NUM_BUFS] = { 1 };
+
+uip_buf_t *uip_bufptr = &bufs[0];
+/*---------------------------------------------------------------------------*/
+uip_buf_t *
+uip_bufpool_take(void)
+{
+  uip_buf_t *buf;
+  int i;
+
+  for(i = 0; i < NUM_BUFS; i++) {
+    if(!used[i]) {
+      used[i] = 1;
+      buf = uip_bufptr;
+      uip_bufptr = &bufs[i];
+      PRINTF("uip-bufpool: took %d, uip_buf is %d\n",
+             (int)(buf - bufs), i);
+      return buf;
+    }
+  }
+  PRINTF("uip-bufpool: no free buffer\n");
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_bufpool_give(uip_buf_t *buf)
+{
+  uip_bufpool_free(uip_bufptr);
+  uip_bufptr = buf;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_bufpool_free(uip_buf_t *buf)
+{
+  if(buf >= &bufs[0] && buf < &bufs[NUM_BUFS]) {
+    used[buf - bufs] = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_bufpool_numfree(void)
+{
+  int i, n;
+
+  n = 0;
+  for(i = 0; i < NUM_BUFS; i++) {
+    if(!used[i]) {
+      n++;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_BUF_POOL */
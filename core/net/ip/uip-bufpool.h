@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A pool of uIP packet buffers
+ *
+ *         With UIP_CONF_BUF_POOL set, uip_buf refers to one of
+ *         UIP_BUF_POOL + 1 buffers instead of a single static
+ *         buffer. A packet that has to wait, e.g., for neighbor
+ *         discovery, can then keep the buffer it is in while uIP goes
+ *         on with another one, instead of being copied out of uip_buf
+ *         and back in.
+ *
+ *         Ports that access uip_aligned_buf directly cannot use the
+ *         pool.
+ */
+
+#ifndef UIP_BUFPOOL_H_
+#define UIP_BUFPOOL_H_
+
+#include "net/ip/uip.h"
+
+#if UIP_BUF_POOL
+
+/**
+ * \brief      Take the buffer that uip_buf refers to
+ * \return     The buffer, or NULL if there is no free buffer
+ *
+ *             The packet in uip_buf stays in the returned buffer,
+ *             and uip_buf refers to a free buffer afterwards. uip_len
+ *             is not changed.
+ */
+uip_buf_t *uip_bufpool_take(void);
+
+/**
+ * \brief      Put a taken buffer back as uip_buf
+ * \param buf  A buffer returned by uip_bufpool_take()
+ *
+ *             The buffer that uip_buf referred to is freed.
+ */
+void uip_bufpool_give(uip_buf_t *buf);
+
+/**
+ * \brief      Free a taken buffer
+ * \param buf  A buffer returned by uip_bufpool_take()
+ */
+void uip_bufpool_free(uip_buf_t *buf);
+
+/**
+ * \brief      Get the number of free buffers
+ */
+int uip_bufpool_numfree(void);
+
+#endif /* UIP_BUF_POOL */
+
+#endif /* UIP_BUFPOOL_H_ */
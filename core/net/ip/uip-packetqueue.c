@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "net/ip/uip.h"
 
@@ -6,8 +7,7 @@
 
 #include "net/ip/uip-packetqueue.h"
 
-#define MAX_NUM_QUEUED_PACKETS 2
-MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
+MEMB(packets_memb, struct uip_packetqueue_packet, UIP_PACKETQUEUE_NUM);
 
 #define DEBUG 0
 #if DEBUG
@@ -17,15 +17,39 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 #define PRINTF(...)
 #endif
 
+#if NETSTACK_CONF_WITH_IPV6
+#define QUEUE_STAT(s) UIP_STAT(s)
+#else /* NETSTACK_CONF_WITH_IPV6 */
+#define QUEUE_STAT(s)
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+/*---------------------------------------------------------------------------*/
+static void
+packet_free(struct uip_packetqueue_packet *p)
+{
+  struct uip_packetqueue_packet **pp;
+
+  for(pp = &p->handle->packet; *pp != NULL; pp = &(*pp)->next) {
+    if(*pp == p) {
+      *pp = p->next;
+      break;
+    }
+  }
+  ctimer_stop(&p->lifetimer);
+#if UIP_BUF_POOL
+  uip_bufpool_free(p->buf);
+#endif /* UIP_BUF_POOL */
+  memb_free(&packets_memb, p);
+}
 /*---------------------------------------------------------------------------*/
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue_free timed out %p\n", p->handle);
+  QUEUE_STAT(++uip_stat.nd6.qdrop);
+  packet_free(p);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -38,36 +62,55 @@ uip_packetqueue_new(struct uip_packetqueue_handle *handle)
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
 {
+  struct uip_packetqueue_packet *p, **pp;
+  int n;
+
   PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
+  n = 0;
+  for(pp = &handle->packet; *pp != NULL; pp = &(*pp)->next) {
+    n++;
+  }
+  if(n >= UIP_PACKETQUEUE_PER_HANDLE) {
+    PRINTF("queue full\n");
     return NULL;
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
+  p = memb_alloc(&packets_memb);
+  if(p != NULL) {
+    p->next = NULL;
+    p->handle = handle;
+#if UIP_BUF_POOL
+    p->buf = NULL;
+#endif /* UIP_BUF_POOL */
+    p->queue_buf_len = 0;
+    ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+    *pp = p;
   } else {
     PRINTF("uip_packetqueue_alloc failed\n");
   }
-  return handle->packet;
+  return p;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
   PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  while(handle->packet != NULL) {
+    QUEUE_STAT(++uip_stat.nd6.qdrop);
+    packet_free(handle->packet);
   }
 }
 /*---------------------------------------------------------------------------*/
 uint8_t *
 uip_packetqueue_buf(struct uip_packetqueue_handle *h)
 {
+#if UIP_BUF_POOL
+  if(h->packet != NULL && h->packet->buf != NULL) {
+    return &h->packet->buf->u8[UIP_LLH_LEN];
+  }
+  return NULL;
+#else /* UIP_BUF_POOL */
   return h->packet != NULL? h->packet->queue_buf: NULL;
+#endif /* UIP_BUF_POOL */
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
@@ -84,3 +127,62 @@ uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
   }
 }
 /*---------------------------------------------------------------------------*/
+int
+uip_packetqueue_len(struct uip_packetqueue_handle *h)
+{
+  struct uip_packetqueue_packet *p;
+  int n;
+
+  n = 0;
+  for(p = h->packet; p != NULL; p = p->next) {
+    n++;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_packetqueue_store(struct uip_packetqueue_handle *h, clock_time_t lifetime)
+{
+  struct uip_packetqueue_packet *p;
+
+  p = uip_packetqueue_alloc(h, lifetime);
+  if(p == NULL) {
+    QUEUE_STAT(++uip_stat.nd6.qdrop);
+    return 0;
+  }
+#if UIP_BUF_POOL
+  p->buf = uip_bufpool_take();
+  if(p->buf == NULL) {
+    QUEUE_STAT(++uip_stat.nd6.qdrop);
+    packet_free(p);
+    return 0;
+  }
+#else /* UIP_BUF_POOL */
+  memcpy(p->queue_buf, &uip_buf[UIP_LLH_LEN], uip_len);
+#endif /* UIP_BUF_POOL */
+  p->queue_buf_len = uip_len;
+  QUEUE_STAT(++uip_stat.nd6.queued);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_packetqueue_load(struct uip_packetqueue_handle *h)
+{
+  struct uip_packetqueue_packet *p;
+
+  p = h->packet;
+  if(p == NULL || p->queue_buf_len == 0) {
+    return 0;
+  }
+  uip_len = p->queue_buf_len;
+#if UIP_BUF_POOL
+  uip_bufpool_give(p->buf);
+  p->buf = NULL;
+#else /* UIP_BUF_POOL */
+  memcpy(&uip_buf[UIP_LLH_LEN], p->queue_buf, uip_len);
+#endif /* UIP_BUF_POOL */
+  packet_free(p);
+  QUEUE_STAT(++uip_stat.nd6.flushed);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -2,17 +2,40 @@
 #define UIP_PACKETQUEUE_H
 
 #include "sys/ctimer.h"
+#include "net/ip/uip-bufpool.h"
+
+/* The number of packets that can be queued, shared by all handles */
+#ifdef UIP_PACKETQUEUE_CONF_NUM
+#define UIP_PACKETQUEUE_NUM UIP_PACKETQUEUE_CONF_NUM
+#else
+#define UIP_PACKETQUEUE_NUM 2
+#endif
+
+/* The number of packets that can be queued on one handle. The default
+   of half the pool leaves room for another neighbor. */
+#ifdef UIP_PACKETQUEUE_CONF_PER_HANDLE
+#define UIP_PACKETQUEUE_PER_HANDLE UIP_PACKETQUEUE_CONF_PER_HANDLE
+#elif UIP_PACKETQUEUE_NUM > 1
+#define UIP_PACKETQUEUE_PER_HANDLE (UIP_PACKETQUEUE_NUM / 2)
+#else
+#define UIP_PACKETQUEUE_PER_HANDLE 1
+#endif
 
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
+  struct uip_packetqueue_packet *next;
+#if UIP_BUF_POOL
+  uip_buf_t *buf;
+#else /* UIP_BUF_POOL */
   uint8_t queue_buf[UIP_BUFSIZE - UIP_LLH_LEN];
+#endif /* UIP_BUF_POOL */
   uint16_t queue_buf_len;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
+/* The packets of a handle, oldest first */
 struct uip_packetqueue_handle {
   struct uip_packetqueue_packet *packet;
 };
@@ -20,16 +43,32 @@ struct uip_packetqueue_handle {
 void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
 
+/* Add a packet at the end of the queue. Returns NULL if the queue is
+   full or there is no free packet. */
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
 
 
+/* Drop all packets in the queue */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/* The first queued packet */
 uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
 void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
 
+/* The number of queued packets */
+int uip_packetqueue_len(struct uip_packetqueue_handle *h);
+
+/* Queue the packet in uip_buf, of uip_len bytes. With a buffer pool,
+   the packet keeps its buffer and uip_buf refers to another one
+   afterwards. Returns 0 if the packet could not be queued. */
+int uip_packetqueue_store(struct uip_packetqueue_handle *h, clock_time_t lifetime);
+
+/* Move the first queued packet into uip_buf and set uip_len. Returns
+   0 if there was no packet queued. */
+int uip_packetqueue_load(struct uip_packetqueue_handle *h);
+
 
 #endif /* UIP_PACKETQUEUE_H */
@@ -517,10 +517,18 @@ typedef union {
   uint8_t u8[UIP_BUFSIZE];
 } uip_buf_t;
 
+#if UIP_BUF_POOL
+/* The buffer of the pool that is uip_buf, see uip-bufpool.h */
+CCIF extern uip_buf_t *uip_bufptr;
+
+/** Macro to access the current packet buffer as an array of bytes */
+#define uip_buf (uip_bufptr->u8)
+#else /* UIP_BUF_POOL */
 CCIF extern uip_buf_t uip_aligned_buf;
 
 /** Macro to access uip_aligned_buf as an array of bytes */
 #define uip_buf (uip_aligned_buf.u8)
+#endif /* UIP_BUF_POOL */
 
 
 /** @} */
@@ -836,7 +844,11 @@ CCIF void uip_send(const void *data, int len);
  *
  * \hideinitializer
  */
+#if UIP_TCP_BUFFERED
+#define uip_mss()             (uip_tcp_sendable(uip_conn))
+#else /* UIP_TCP_BUFFERED */
 #define uip_mss()             (uip_conn->mss)
+#endif /* UIP_TCP_BUFFERED */
 
 /**
  * Set up a new UDP connection.
@@ -1370,6 +1382,17 @@ struct uip_conn {
   uint8_t timer;         /**< The retransmission timer. */
   uint8_t nrtx;          /**< The number of retransmissions for the last
                               segment sent. */
+#if UIP_TCP_OOO
+  uint8_t sack;          /**< Non-zero if the remote host accepts SACK. */
+#endif /* UIP_TCP_OOO */
+#if UIP_TCP_BUFFERED
+  uint16_t cwnd;         /**< Congestion window, in bytes. */
+  uint16_t ssthresh;     /**< Slow start threshold, in bytes. */
+  uint16_t snd_wnd;      /**< Window advertised by the remote host. */
+  uint16_t recover;      /**< Outstanding data when fast recovery began. */
+  uint8_t dupacks;       /**< Number of duplicate ACKs received. */
+  uint8_t bufflags;      /**< Buffered mode flags. */
+#endif /* UIP_TCP_BUFFERED */
 
   uip_tcp_appstate_t appstate; /** The application state. */
 };
@@ -1388,6 +1411,42 @@ CCIF extern struct uip_conn *uip_conn;
 CCIF extern struct uip_conn uip_conns[UIP_CONNS];
 #endif
 
+#if UIP_TCP_BUFFERED
+#define UIP_TCP_BUF_ON 0x01
+
+/**
+ * Switch a TCP connection to buffered mode.
+ *
+ * In buffered mode uIP keeps a copy of every segment sent on the
+ * connection and retransmits it by itself, so the application is
+ * never invoked with uip_rexmit(). Data passed to uip_send() is owned
+ * by uIP once the application returns, and up to UIP_TCP_SEND_WINDOW
+ * segments may be in flight. uip_acked() is set whenever the remote
+ * host acknowledges new data, which may be only part of what is in
+ * flight.
+ *
+ * uip_mss() returns how much data uIP accepts right now, which is
+ * zero when the window is full. The application should only call
+ * uip_close() when uip_outstanding() is zero; an earlier close is
+ * held back until all data has been acknowledged.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ */
+void uip_tcp_set_buffered(struct uip_conn *conn);
+
+/**
+ * Get the amount of data that can be sent on a connection now.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ * \return For a buffered connection, what congestion control, the
+ * window of the remote host and the retransmission pool allow. For
+ * other connections, the current MSS.
+ */
+uint16_t uip_tcp_sendable(struct uip_conn *conn);
+
+#define uip_tcp_buffered(conn) ((conn)->bufflags & UIP_TCP_BUF_ON)
+#endif /* UIP_TCP_BUFFERED */
+
 /**
  * \addtogroup uiparch
  * @{
@@ -1508,6 +1567,12 @@ struct uip_stats {
     uip_stats_t drop;     /**< Number of dropped ND6 packets. */
     uip_stats_t recv;     /**< Number of recived ND6 packets */
     uip_stats_t sent;     /**< Number of sent ND6 packets */
+    uip_stats_t queued;   /**< Number of packets queued during address
+                               resolution */
+    uip_stats_t flushed;  /**< Number of queued packets sent after
+                               address resolution */
+    uip_stats_t qdrop;    /**< Number of packets that could not be queued
+                               or timed out in the queue */
   } nd6;
 #endif /*NETSTACK_CONF_WITH_IPV6*/
 };
@@ -175,6 +175,21 @@
 #define UIP_BUFSIZE (UIP_CONF_BUFFER_SIZE)
 #endif /* UIP_CONF_BUFFER_SIZE */
 
+/**
+ * The number of uIP packet buffers in addition to uip_buf.
+ *
+ * If non-zero, uip_buf refers to one buffer of a pool, and packets
+ * that are queued while waiting for neighbor discovery keep their
+ * buffer instead of being copied. See uip-bufpool.h.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_BUF_POOL
+#define UIP_BUF_POOL (UIP_CONF_BUF_POOL)
+#else /* UIP_CONF_BUF_POOL */
+#define UIP_BUF_POOL 0
+#endif /* UIP_CONF_BUF_POOL */
+
 
 /**
  * Determines if statistics support should be compiled in.
@@ -485,17 +500,47 @@ void uip_log(char *msg);
 #define UIP_TCP_MSS     (UIP_BUFSIZE - UIP_LLH_LEN - UIP_TCPIP_HLEN)
 #endif /* UIP_CONF_TCP_MSS */
 
+/**
+ * The number of MSS sized buffers shared by all TCP connections for
+ * segments that arrive out of order.
+ *
+ * A segment that arrives ahead of the expected sequence number is
+ * kept and handed to the application once the missing data has
+ * arrived, instead of being dropped. SACK is then negotiated with the
+ * remote host and the buffered segments are reported in SACK blocks,
+ * so that only the missing data is retransmitted.
+ *
+ * A value of 0 disables out-of-order buffering. It is only
+ * implemented by the IPv6 stack.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_OOO_SEGMENTS
+#define UIP_TCP_OOO_SEGMENTS (UIP_CONF_TCP_OOO_SEGMENTS)
+#else /* UIP_CONF_TCP_OOO_SEGMENTS */
+#define UIP_TCP_OOO_SEGMENTS 0
+#endif /* UIP_CONF_TCP_OOO_SEGMENTS */
+
+#define UIP_TCP_OOO (UIP_TCP && NETSTACK_CONF_WITH_IPV6 && \
+                     UIP_TCP_OOO_SEGMENTS > 0)
+
 /**
  * The size of the advertised receiver's window.
  *
  * Should be set low (i.e., to the size of the uip_buf buffer) if the
  * application is slow to process incoming data, or high (32768 bytes)
- * if the application processes data quickly.
+ * if the application processes data quickly. With out-of-order
+ * buffering, the window covers the out-of-order buffers by default.
  *
  * \hideinitializer
  */
 #ifndef UIP_CONF_RECEIVE_WINDOW
+#if UIP_TCP_OOO
+#define UIP_RECEIVE_WINDOW ((UIP_TCP_OOO_SEGMENTS + 1) * UIP_TCP_MSS > 0xffff ? \
+                            0xffff : (UIP_TCP_OOO_SEGMENTS + 1) * UIP_TCP_MSS)
+#else /* UIP_TCP_OOO */
 #define UIP_RECEIVE_WINDOW (UIP_TCP_MSS)
+#endif /* UIP_TCP_OOO */
 #else
 #define UIP_RECEIVE_WINDOW (UIP_CONF_RECEIVE_WINDOW)
 #endif
@@ -511,6 +556,42 @@ void uip_log(char *msg);
 #define UIP_TIME_WAIT_TIMEOUT UIP_CONF_WAIT_TIMEOUT
 #endif
 
+/**
+ * The number of segments a buffered TCP connection may have in flight.
+ *
+ * Connections that have been switched to buffered mode with
+ * uip_tcp_set_buffered() keep a copy of each segment they send, so
+ * that the application never has to regenerate data, and may send
+ * new data before earlier segments have been acknowledged. The
+ * amount of data in flight is limited by NewReno congestion control
+ * and by the window of the remote host.
+ *
+ * A value of 1 disables buffered mode. Buffered mode is only
+ * implemented by the IPv6 stack.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SEND_WINDOW
+#define UIP_TCP_SEND_WINDOW (UIP_CONF_TCP_SEND_WINDOW)
+#else /* UIP_CONF_TCP_SEND_WINDOW */
+#define UIP_TCP_SEND_WINDOW 1
+#endif /* UIP_CONF_TCP_SEND_WINDOW */
+
+/**
+ * The number of MSS sized segment buffers shared by all buffered TCP
+ * connections for retransmissions.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_REXMIT_SEGMENTS
+#define UIP_TCP_REXMIT_SEGMENTS (UIP_CONF_TCP_REXMIT_SEGMENTS)
+#else /* UIP_CONF_TCP_REXMIT_SEGMENTS */
+#define UIP_TCP_REXMIT_SEGMENTS (2 * UIP_TCP_SEND_WINDOW)
+#endif /* UIP_CONF_TCP_REXMIT_SEGMENTS */
+
+#define UIP_TCP_BUFFERED (UIP_TCP && NETSTACK_CONF_WITH_IPV6 && \
+                          UIP_TCP_SEND_WINDOW > 1)
+
 /** @} */
 /*------------------------------------------------------------------------------*/
 /**
@@ -119,7 +119,9 @@ uip_lladdr_t uip_lladdr = {{0,0,0,0,0,0}};
 #endif
 
 /* The packet buffer that contains incoming packets. */
+#if !UIP_BUF_POOL
 uip_buf_t uip_aligned_buf;
+#endif /* !UIP_BUF_POOL */
 
 void *uip_appdata;               /* The uip_appdata pointer points to
 				    application data. */
@@ -106,6 +106,15 @@ void uip_log(char *msg);
 #endif /* SICSLOWPAN_CONF_COMPRESSION */
 #endif /* SICSLOWPAN_COMPRESSION */
 
+#if SICSLOWPAN_DYNAMIC_CONTEXTS && \
+  SICSLOWPAN_COMPRESSION != SICSLOWPAN_COMPRESSION_HC06
+#error "Dynamic contexts need SICSLOWPAN_COMPRESSION_HC06"
+#endif
+
+#if SICSLOWPAN_STATISTICS
+struct sicslowpan_stats sicslowpan_stats;
+#endif /* SICSLOWPAN_STATISTICS */
+
 #define GET16(ptr,index) (((uint16_t)((ptr)[index] << 8)) | ((ptr)[(index) + 1]))
 #define SET16(ptr,index,value) do {     \
   (ptr)[index] = ((value) >> 8) & 0xff; \
@@ -492,6 +501,8 @@ set_packet_attrs()
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
 static struct sicslowpan_addr_context
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+#elif SICSLOWPAN_DYNAMIC_CONTEXTS
+#error "Dynamic contexts need SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0"
 #endif
 
 /** pointer to an address context. */
@@ -533,16 +544,52 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /** \name IPHC related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
-/** \brief find the context corresponding to prefix ipaddr */
+#if SICSLOWPAN_DYNAMIC_CONTEXTS
+/** \brief age a context, return 1 if it is still in use */
+static int
+context_alive(struct sicslowpan_addr_context *c)
+{
+  if(c->used != 1) {
+    return 0;
+  }
+  if(c->isinfinite || !stimer_expired(&c->lifetime)) {
+    return 1;
+  }
+  if(c->compress) {
+    /* Keep the context for decompression for a while */
+    PRINTF("sicslowpan: context %u expired\n", c->number);
+    c->compress = 0;
+    stimer_set(&c->lifetime, SICSLOWPAN_CONTEXT_GRACE_TIME);
+    return 1;
+  }
+  PRINTF("sicslowpan: context %u removed\n", c->number);
+  c->used = 0;
+  return 0;
+}
+/* The receiver of a packet compressed with a context must have it too */
+#define CONTEXT_FOR_COMPRESSION(c, dest) (context_alive(c) && (c)->compress \
+    && (linkaddr_cmp(&(c)->peer, &linkaddr_null)                        \
+        || linkaddr_cmp(&(c)->peer, dest)))
+#define CONTEXT_FOR_DECOMPRESSION(c) context_alive(c)
+#else /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+#define CONTEXT_FOR_COMPRESSION(c, dest) ((c)->used == 1)
+#define CONTEXT_FOR_DECOMPRESSION(c) ((c)->used == 1)
+#endif /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+/*--------------------------------------------------------------------*/
+/** \brief find the context corresponding to prefix ipaddr, for a packet
+    sent to link_destaddr */
 static struct sicslowpan_addr_context*
-addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
+addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr,
+                              const linkaddr_t *link_destaddr)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
   int i;
+  /* Prefix bits beyond the length of a context are zero, so shorter
+     contexts only match addresses whose first 64 bits they cover. */
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
+    if(uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64) &&
+       CONTEXT_FOR_COMPRESSION(&addr_contexts[i], link_destaddr)) {
       return &addr_contexts[i];
     }
   }
@@ -558,8 +605,8 @@ addr_context_lookup_by_number(uint8_t number)
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
   int i;
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
+    if(addr_contexts[i].number == number &&
+       CONTEXT_FOR_DECOMPRESSION(&addr_contexts[i])) {
       return &addr_contexts[i];
     }
   }
@@ -567,6 +614,78 @@ addr_context_lookup_by_number(uint8_t number)
   return NULL;
 }
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_DYNAMIC_CONTEXTS
+int
+sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                       uint8_t length, uint8_t compress,
+                       unsigned long lifetime, const linkaddr_t *peer)
+{
+  struct sicslowpan_addr_context *c, *free;
+  int i;
+
+  if(number > 15 || length > 64) {
+    return -1;
+  }
+
+  c = NULL;
+  free = NULL;
+  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    if(context_alive(&addr_contexts[i])) {
+      if(addr_contexts[i].number == number) {
+        c = &addr_contexts[i];
+        break;
+      }
+    } else if(free == NULL) {
+      free = &addr_contexts[i];
+    }
+  }
+  if(c == NULL) {
+    if(lifetime == 0) {
+      /* Nothing to withdraw */
+      return 0;
+    }
+    if(free == NULL) {
+      PRINTF("sicslowpan: no room for context %u\n", number);
+      return -1;
+    }
+    c = free;
+  }
+
+  c->used = 1;
+  c->number = number;
+  c->length = length;
+  memset(c->prefix, 0, sizeof(c->prefix));
+  memcpy(c->prefix, prefix, (length + 7) / 8);
+  if(length % 8) {
+    c->prefix[length / 8] &= 0xff << (8 - length % 8);
+  }
+  c->isinfinite = 0;
+  linkaddr_copy(&c->peer, peer != NULL ? peer : &linkaddr_null);
+  if(lifetime == 0) {
+    c->compress = 0;
+    stimer_set(&c->lifetime, SICSLOWPAN_CONTEXT_GRACE_TIME);
+  } else {
+    c->compress = compress != 0;
+    stimer_set(&c->lifetime, lifetime);
+  }
+  PRINTF("sicslowpan: context %u length %u compress %u lifetime %lu\n",
+         number, length, c->compress, lifetime);
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+struct sicslowpan_addr_context *
+sicslowpan_context_next(struct sicslowpan_addr_context *c)
+{
+  for(c = c == NULL ? addr_contexts : c + 1;
+      c < addr_contexts + SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; c++) {
+    if(context_alive(c)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+#endif /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+/*--------------------------------------------------------------------*/
 static uint8_t
 compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
 {
@@ -666,6 +785,7 @@ static void
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  struct sicslowpan_addr_context *src_context, *dest_context;
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -696,11 +816,21 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    */
 
 
-  /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  src_context = NULL;
+  if(!uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    src_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr,
+                                                link_destaddr);
+  }
+  dest_context = NULL;
+  if(!uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    dest_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr,
+                                                 link_destaddr);
+  }
+
+  /* The third byte holds the context numbers. Without it, context 0
+     is implied, so it is only needed for the other contexts. */
+  if((src_context != NULL && src_context->number != 0) ||
+     (dest_context != NULL && dest_context->number != 0)) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -793,17 +923,19 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if(src_context != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
-    PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
-           context->number);
-    iphc1 |= SICSLOWPAN_IPHC_CID | SICSLOWPAN_IPHC_SAC;
-    PACKETBUF_IPHC_BUF[2] |= context->number << 4;
+    PRINTF("IPHC: compressing src with context - setting SAC ctx: %d\n",
+           src_context->number);
+    iphc1 |= SICSLOWPAN_IPHC_SAC;
+    if(iphc1 & SICSLOWPAN_IPHC_CID) {
+      PACKETBUF_IPHC_BUF[2] |= src_context->number << 4;
+    }
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
                               &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+    SICSLOWPAN_STAT(sicslowpan_stats.ctx_addr++);
     /* No context found for this address */
   } else if(uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr) &&
             UIP_IP_BUF->destipaddr.u16[1] == 0 &&
@@ -816,6 +948,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     iphc1 |= SICSLOWPAN_IPHC_SAM_00; /* 128-bits */
     memcpy(hc06_ptr, &UIP_IP_BUF->srcipaddr.u16[0], 16);
     hc06_ptr += 16;
+    SICSLOWPAN_STAT(sicslowpan_stats.inline_addr++);
   }
 
   /* dest address*/
@@ -847,15 +980,18 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if(dest_context != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
-      PACKETBUF_IPHC_BUF[2] |= context->number;
+      if(iphc1 & SICSLOWPAN_IPHC_CID) {
+        PACKETBUF_IPHC_BUF[2] |= dest_context->number;
+      }
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
                                 &UIP_IP_BUF->destipaddr,
                                 (uip_lladdr_t *)link_destaddr);
+      SICSLOWPAN_STAT(sicslowpan_stats.ctx_addr++);
       /* No context found for this address */
     } else if(uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr) &&
               UIP_IP_BUF->destipaddr.u16[1] == 0 &&
@@ -868,6 +1004,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
       iphc1 |= SICSLOWPAN_IPHC_DAM_00; /* 128-bits */
       memcpy(hc06_ptr, &UIP_IP_BUF->destipaddr.u16[0], 16);
       hc06_ptr += 16;
+      SICSLOWPAN_STAT(sicslowpan_stats.inline_addr++);
     }
   }
 
@@ -929,6 +1066,9 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   PACKETBUF_IPHC_BUF[1] = iphc1;
 
   packetbuf_hdr_len = hc06_ptr - packetbuf_ptr;
+  SICSLOWPAN_STAT(sicslowpan_stats.iphc_sent++);
+  SICSLOWPAN_STAT(sicslowpan_stats.iphc_saved +=
+                  uncomp_hdr_len - packetbuf_hdr_len);
   return;
 }
 
@@ -1034,6 +1174,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
       context = addr_context_lookup_by_number(sci);
       if(context == NULL) {
         PRINTF("sicslowpan uncompress_hdr: error context not found\n");
+        SICSLOWPAN_STAT(sicslowpan_stats.ctx_unknown++);
         return;
       }
     }
@@ -1081,6 +1222,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
       /* all valid cases below need the context! */
       if(context == NULL) {
         PRINTF("sicslowpan uncompress_hdr: error context not found\n");
+        SICSLOWPAN_STAT(sicslowpan_stats.ctx_unknown++);
         return;
       }
       uncompress_addr(&SICSLOWPAN_IP_BUF(buf)->destipaddr, context->prefix,
@@ -1787,6 +1929,18 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_DYNAMIC_CONTEXTS
+  {
+    int i;
+    /* Preconfigured contexts never expire */
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      addr_contexts[i].length = 64;
+      addr_contexts[i].compress = 1;
+      addr_contexts[i].isinfinite = 1;
+    }
+  }
+#endif /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 }
 /*--------------------------------------------------------------------*/
@@ -50,7 +50,9 @@
 #define SICSLOWPAN_H_
 
 #include "net/ip/uip.h"
+#include "net/linkaddr.h"
 #include "net/mac/mac.h"
+#include "sys/stimer.h"
 
 /**
  * \name General sicslowpan defines
@@ -215,6 +217,30 @@
 /*   uint16_t udpchksum; */
 /* }; */
 
+/**
+ * \name Address contexts
+ * @{
+ */
+/* Let contexts be added, changed and removed at runtime, for example
+   from the 6LoWPAN Context Option of Router Advertisements. Runtime
+   contexts take the slots of the SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS
+   table that are not preconfigured. */
+#ifdef SICSLOWPAN_CONF_DYNAMIC_CONTEXTS
+#define SICSLOWPAN_DYNAMIC_CONTEXTS SICSLOWPAN_CONF_DYNAMIC_CONTEXTS
+#else
+#define SICSLOWPAN_DYNAMIC_CONTEXTS 0
+#endif
+
+/* Seconds that a context is kept for decompression only after its
+   lifetime has run out, so that packets from nodes that still use it
+   can be read */
+#ifdef SICSLOWPAN_CONF_CONTEXT_GRACE_TIME
+#define SICSLOWPAN_CONTEXT_GRACE_TIME SICSLOWPAN_CONF_CONTEXT_GRACE_TIME
+#else
+#define SICSLOWPAN_CONTEXT_GRACE_TIME (60 * 60)
+#endif
+/** @} */
+
 /**
  * \brief An address context for IPHC address compression
  * each context can have upto 8 bytes
@@ -223,8 +249,43 @@ struct sicslowpan_addr_context {
   uint8_t used; /* possibly use as prefix-length */
   uint8_t number;
   uint8_t prefix[8];
+#if SICSLOWPAN_DYNAMIC_CONTEXTS
+  uint8_t length;         /* prefix length in bits */
+  uint8_t compress;       /* may be used for compression, not only
+                             for decompression */
+  uint8_t isinfinite;
+  struct stimer lifetime;
+  linkaddr_t peer;        /* the only neighbor that is known to have
+                             the context, linkaddr_null for all */
+#endif /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+};
+
+/**
+ * \name Compression statistics
+ * @{
+ */
+#ifdef SICSLOWPAN_CONF_STATISTICS
+#define SICSLOWPAN_STATISTICS SICSLOWPAN_CONF_STATISTICS
+#else
+#define SICSLOWPAN_STATISTICS 0
+#endif
+
+#if SICSLOWPAN_STATISTICS
+struct sicslowpan_stats {
+  unsigned long iphc_sent;   /**< Packets sent with IPHC headers */
+  long iphc_saved;           /**< Header bytes removed by IPHC */
+  unsigned long ctx_addr;    /**< Addresses compressed with a context */
+  unsigned long inline_addr; /**< Unicast addresses sent in full */
+  unsigned long ctx_unknown; /**< Received packets with an unknown context */
 };
 
+extern struct sicslowpan_stats sicslowpan_stats;
+#define SICSLOWPAN_STAT(s) s
+#else
+#define SICSLOWPAN_STAT(s)
+#endif /* SICSLOWPAN_STATISTICS */
+/** @} */
+
 /**
  * \name Address compressibility test functions
  * @{
@@ -321,6 +382,44 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+#if SICSLOWPAN_DYNAMIC_CONTEXTS
+/**
+ * \brief      Add, change or withdraw an address context
+ * \param number The context identifier, 0-15
+ * \param prefix The prefix bytes of the context
+ * \param length The prefix length in bits, at most 64
+ * \param compress Non-zero if the context may be used for compression
+ * \param lifetime The lifetime of the context in seconds
+ * \param peer The neighbor the context was learned from, or NULL
+ * \retval 0   The context table was updated
+ * \retval -1  The table is full, or the context is longer than 64 bits
+ *
+ *             A context with compress set to zero is only used to
+ *             decompress received packets. A lifetime of zero
+ *             withdraws the context: it is no longer used for
+ *             compression and is removed after
+ *             SICSLOWPAN_CONTEXT_GRACE_TIME seconds.
+ *
+ *             Routers do not learn contexts from each other, so a
+ *             context learned from a neighbor is only used to compress
+ *             packets sent to that neighbor. A context set with a NULL
+ *             peer is used towards all neighbors. It must then be set
+ *             on every node that may receive such packets, for example
+ *             at boot on all routers of the network.
+ */
+int sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                           uint8_t length, uint8_t compress,
+                           unsigned long lifetime, const linkaddr_t *peer);
+
+/**
+ * \brief      Iterate over the address contexts in use
+ * \param c    The previous context, or NULL to get the first one
+ * \return     The next context, or NULL if there are no more
+ */
+struct sicslowpan_addr_context *
+sicslowpan_context_next(struct sicslowpan_addr_context *c);
+#endif /* SICSLOWPAN_DYNAMIC_CONTEXTS */
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup uip6
+ * @{
+ */
+
+/**
+ * \file
+ *    Flow cache for the IPv6 next-hop decision
+ */
+
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/uip.h"
+
+#include "lib/list.h"
+#include "lib/memb.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#if UIP_DS6_FLOW_NB > 0
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* The flow list is ordered by how recently the flows were used: the
+   least recently used flow is at the end of the list and is the one
+   that is replaced when the cache is full. */
+LIST(flowlist);
+MEMB(flowmemb, uip_ds6_flow_t, UIP_DS6_FLOW_NB);
+
+static struct uip_ds6_notification notification;
+
+/* The lookups made for the packet in uip_buf, until uip_ds6_flow_done().
+   A forwarded packet is first looked up by RPL, to set the down flag
+   of its hop-by-hop option, then by tcpip_ipv6_output(). */
+static uip_ds6_flow_t *pkt_flow;
+static uip_ds6_route_t *pkt_route;
+static uint8_t pkt_flags;
+#define PKT_FLOW  1 /* pkt_flow is the outcome of the flow lookup */
+#define PKT_ROUTE 2 /* pkt_route is the outcome of the route lookup */
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+packet_label(void)
+{
+  return ((uint32_t)(UIP_IP_BUF->tcflow & 0x0f) << 16) |
+    UIP_HTONS(UIP_IP_BUF->flow);
+}
+/*---------------------------------------------------------------------------*/
+/* Addresses in the same network mostly differ in the interface
+   identifier, so only the last bytes of the addresses are hashed. */
+static uint8_t
+packet_hash(uint32_t label)
+{
+  const uint8_t *s = &UIP_IP_BUF->srcipaddr.u8[12];
+  const uint8_t *d = &UIP_IP_BUF->destipaddr.u8[12];
+
+  return s[0] ^ s[1] ^ s[2] ^ s[3] ^ d[0] ^ d[1] ^ d[2] ^ d[3] ^
+    (uint8_t)label ^ (uint8_t)(label >> 8) ^ (uint8_t)(label >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static void
+notification_callback(int event, uip_ipaddr_t *route, uip_ipaddr_t *nexthop,
+                      int num_routes)
+{
+  /* Any change to the routes, default routers, neighbors or prefixes
+     may change the next hop of a flow or free an entry that a flow
+     points to. */
+  uip_ds6_flow_flush();
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_flow_init(void)
+{
+  memb_init(&flowmemb);
+  list_init(flowlist);
+  uip_ds6_notification_add(&notification, notification_callback);
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_flow_t *
+uip_ds6_flow_lookup(void)
+{
+  uip_ds6_flow_t *f;
+  uint32_t label;
+  uint8_t hash;
+
+  if(pkt_flags & PKT_FLOW) {
+    return pkt_flow;
+  }
+
+  label = packet_label();
+  hash = packet_hash(label);
+  for(f = list_head(flowlist); f != NULL; f = list_item_next(f)) {
+    if(f->hash == hash && f->label == label &&
+       uip_ipaddr_cmp(&f->destipaddr, &UIP_IP_BUF->destipaddr) &&
+       uip_ipaddr_cmp(&f->srcipaddr, &UIP_IP_BUF->srcipaddr)) {
+      if(f != list_head(flowlist)) {
+        list_remove(flowlist, f);
+        list_push(flowlist, f);
+      }
+      /* Keep the route from being replaced as least recently used
+         while it carries traffic. */
+      if((f->flags & UIP_DS6_FLOW_ROUTE) && f->route != NULL) {
+        uip_ds6_route_touch(f->route);
+      }
+      break;
+    }
+  }
+  pkt_flow = f;
+  pkt_flags |= PKT_FLOW;
+  return f;
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_route_t *
+uip_ds6_flow_route_lookup(void)
+{
+  uip_ds6_flow_t *f;
+
+  f = uip_ds6_flow_lookup();
+  if(f != NULL) {
+    /* The route of an on-link flow is looked up the first time it is
+       needed, and then kept until the cache is flushed. */
+    if(!(f->flags & UIP_DS6_FLOW_ROUTE)) {
+      f->route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
+      f->flags |= UIP_DS6_FLOW_ROUTE;
+    }
+    return f->route;
+  }
+
+  if(!(pkt_flags & PKT_ROUTE)) {
+    pkt_route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
+    pkt_flags |= PKT_ROUTE;
+  }
+  return pkt_route;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_flow_add(uip_ds6_nbr_t *nbr)
+{
+  uip_ds6_flow_t *f;
+
+  f = memb_alloc(&flowmemb);
+  if(f == NULL) {
+    f = list_chop(flowlist);
+  }
+
+  uip_ipaddr_copy(&f->srcipaddr, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&f->destipaddr, &UIP_IP_BUF->destipaddr);
+  f->label = packet_label();
+  f->hash = packet_hash(f->label);
+  f->route = pkt_route;
+  f->flags = (pkt_flags & PKT_ROUTE) ? UIP_DS6_FLOW_ROUTE : 0;
+  f->nbr = nbr;
+  list_push(flowlist, f);
+
+  pkt_flow = f;
+  pkt_flags |= PKT_FLOW;
+
+  PRINTF("uip_ds6_flow_add: ");
+  PRINT6ADDR(&f->srcipaddr);
+  PRINTF(" -> ");
+  PRINT6ADDR(&f->destipaddr);
+  PRINTF(" label %lx via ", (unsigned long)f->label);
+  PRINT6ADDR(&nbr->ipaddr);
+  PRINTF("\n");
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_flow_done(void)
+{
+  pkt_flags = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_flow_flush(void)
+{
+  uip_ds6_flow_t *f;
+
+  while((f = list_pop(flowlist)) != NULL) {
+    memb_free(&flowmemb, f);
+  }
+  /* The route kept for the packet may be the one that was removed */
+  pkt_flags = 0;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_DS6_FLOW_NB > 0 */
+/** @} */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup uip6
+ * @{
+ */
+
+/**
+ * \file
+ *    Flow cache for the IPv6 next-hop decision
+ *
+ *    The cache remembers, for recently seen (source, destination,
+ *    flow label) tuples, the neighbor a packet was sent to and the
+ *    route that was used. A hit skips the on-link check, the route
+ *    lookup, the default router selection and the neighbor lookup in
+ *    tcpip_ipv6_output(), and the route lookup that RPL does to set
+ *    the down flag of the hop-by-hop option. The cache is flushed
+ *    through the uip-ds6 notification interface whenever a route,
+ *    default router, neighbor or prefix is added or removed.
+ *
+ *    The outcome of the lookups is also kept for the packet in
+ *    uip_buf, so that a forwarded packet is looked up once, by RPL,
+ *    and tcpip_ipv6_output() reuses the result, even on a miss.
+ */
+
+#ifndef UIP_DS6_FLOW_H_
+#define UIP_DS6_FLOW_H_
+
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6-route.h"
+
+/* Number of flow cache entries, 0 to disable the cache */
+#ifdef UIP_CONF_DS6_FLOW_NB
+#define UIP_DS6_FLOW_NB UIP_CONF_DS6_FLOW_NB
+#else /* UIP_CONF_DS6_FLOW_NB */
+#define UIP_DS6_FLOW_NB 0
+#endif /* UIP_CONF_DS6_FLOW_NB */
+
+#if UIP_DS6_FLOW_NB > 0 && !UIP_DS6_NOTIFICATIONS
+#error "The flow cache needs UIP_DS6_NOTIFICATIONS"
+#endif
+
+/** \brief The route of the entry is the outcome of a route lookup
+    for the destination */
+#define UIP_DS6_FLOW_ROUTE 1
+
+/** \brief An entry in the flow cache */
+typedef struct uip_ds6_flow {
+  struct uip_ds6_flow *next;
+  uip_ipaddr_t srcipaddr;
+  uip_ipaddr_t destipaddr;
+  uint32_t label;
+  /** The route to the destination, NULL if there is none. Only
+      valid with UIP_DS6_FLOW_ROUTE: no route is looked up for an
+      on-link destination until RPL needs it. */
+  struct uip_ds6_route *route;
+  /* Neighbor cache entries are included after this file, so the
+     entry is referred to by its struct tag */
+  struct uip_ds6_nbr *nbr;
+  uint8_t hash;
+  uint8_t flags;
+} uip_ds6_flow_t;
+
+/** \name Flow cache basic routines */
+/** @{ */
+void uip_ds6_flow_init(void);
+
+/**
+ * \brief      Look up the flow of the packet in uip_buf
+ * \return     The cache entry, or NULL if the flow is not cached
+ *
+ *             The outcome is kept until uip_ds6_flow_done(), so the
+ *             cache is only searched once per packet.
+ */
+uip_ds6_flow_t *uip_ds6_flow_lookup(void);
+
+/**
+ * \brief      Look up the route to the destination of the packet in uip_buf
+ * \return     The route, or NULL if there is none
+ *
+ *             The outcome is kept in the flow cache entry, or until
+ *             uip_ds6_flow_done() if the flow is not cached.
+ */
+uip_ds6_route_t *uip_ds6_flow_route_lookup(void);
+
+/**
+ * \brief      Cache the next-hop decision for the packet in uip_buf
+ * \param nbr  The neighbor the packet is sent to
+ *
+ *             The route is taken from uip_ds6_flow_route_lookup(), if
+ *             it was called for the packet. The least recently used
+ *             entry is replaced when the cache is full.
+ */
+void uip_ds6_flow_add(struct uip_ds6_nbr *nbr);
+
+/**
+ * \brief      Forget the lookups made for the packet in uip_buf
+ *
+ *             Must be called once the packet has been sent or dropped,
+ *             before uip_buf holds another packet.
+ */
+void uip_ds6_flow_done(void);
+
+void uip_ds6_flow_flush(void);
+/** @} */
+
+#endif /* UIP_DS6_FLOW_H_ */
+/** @} */
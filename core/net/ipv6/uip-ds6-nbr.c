@@ -99,6 +99,10 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     PRINTLLADDR(lladdr);
     PRINTF(" state %u\n", state);
     NEIGHBOR_STATE_CHANGED(nbr);
+#if UIP_DS6_NOTIFICATIONS
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_NBR_ADD,
+                              &nbr->ipaddr, &nbr->ipaddr);
+#endif
     return nbr;
   } else {
     PRINTF("uip_ds6_nbr_add drop ip addr ");
@@ -119,6 +123,10 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
     NEIGHBOR_STATE_CHANGED(nbr);
+#if UIP_DS6_NOTIFICATIONS
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_NBR_RM,
+                              &nbr->ipaddr, &nbr->ipaddr);
+#endif
     nbr_table_remove(ds6_neighbors, nbr);
   }
   return;
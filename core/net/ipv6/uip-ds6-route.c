@@ -117,9 +117,9 @@ assert_nbr_routes_list_sane(void)
 #endif /* DEBUG != DEBUG_NONE */
 /*---------------------------------------------------------------------------*/
 #if UIP_DS6_NOTIFICATIONS
-static void
-call_route_callback(int event, uip_ipaddr_t *route,
-		    uip_ipaddr_t *nexthop)
+void
+uip_ds6_notification_call(int event, uip_ipaddr_t *route,
+			  uip_ipaddr_t *nexthop)
 {
   int num;
   struct uip_ds6_notification *n;
@@ -250,19 +250,27 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     PRINTF("uip-ds6-route: No route found\n");
   }
 
-  if(found_route != NULL && found_route != list_head(routelist)) {
-    /* If we found a route, we put it at the start of the routeslist
-       list. The list is ordered by how recently we looked them up:
-       the least recently used route will be at the end of the
-       list - for fast lookups (assuming multiple packets to the same node). */
-
-    list_remove(routelist, found_route);
-    list_push(routelist, found_route);
+  if(found_route != NULL) {
+    uip_ds6_route_touch(found_route);
   }
 
   return found_route;
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_ds6_route_touch(uip_ds6_route_t *route)
+{
+  if(route != list_head(routelist)) {
+    /* We put the route at the start of the routeslist list. The list
+       is ordered by how recently we looked them up: the least
+       recently used route will be at the end of the list - for fast
+       lookups (assuming multiple packets to the same node). */
+
+    list_remove(routelist, route);
+    list_push(routelist, route);
+  }
+}
+/*---------------------------------------------------------------------------*/
 uip_ds6_route_t *
 uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 		  uip_ipaddr_t *nexthop)
@@ -400,7 +408,7 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
   ANNOTATE("#L %u 1;blue\n", nexthop->u8[sizeof(uip_ipaddr_t) - 1]);
 
 #if UIP_DS6_NOTIFICATIONS
-  call_route_callback(UIP_DS6_NOTIFICATION_ROUTE_ADD, ipaddr, nexthop);
+  uip_ds6_notification_call(UIP_DS6_NOTIFICATION_ROUTE_ADD, ipaddr, nexthop);
 #endif
 
 #if DEBUG != DEBUG_NONE
@@ -461,7 +469,7 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
     PRINTF("uip_ds6_route_rm num %d\n", num_routes);
 
 #if UIP_DS6_NOTIFICATIONS
-    call_route_callback(UIP_DS6_NOTIFICATION_ROUTE_RM,
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_ROUTE_RM,
         &route->ipaddr, uip_ds6_route_nexthop(route));
 #endif
   }
@@ -550,7 +558,7 @@ uip_ds6_defrt_add(uip_ipaddr_t *ipaddr, unsigned long interval)
   ANNOTATE("#L %u 1\n", ipaddr->u8[sizeof(uip_ipaddr_t) - 1]);
 
 #if UIP_DS6_NOTIFICATIONS
-  call_route_callback(UIP_DS6_NOTIFICATION_DEFRT_ADD, ipaddr, ipaddr);
+  uip_ds6_notification_call(UIP_DS6_NOTIFICATION_DEFRT_ADD, ipaddr, ipaddr);
 #endif
 
 #if DEBUG != DEBUG_NONE
@@ -579,8 +587,8 @@ uip_ds6_defrt_rm(uip_ds6_defrt_t *defrt)
       memb_free(&defaultroutermemb, defrt);
       ANNOTATE("#L %u 0\n", defrt->ipaddr.u8[sizeof(uip_ipaddr_t) - 1]);
 #if UIP_DS6_NOTIFICATIONS
-      call_route_callback(UIP_DS6_NOTIFICATION_DEFRT_RM,
-			  &defrt->ipaddr, &defrt->ipaddr);
+      uip_ds6_notification_call(UIP_DS6_NOTIFICATION_DEFRT_RM,
+				&defrt->ipaddr, &defrt->ipaddr);
 #endif
       return;
     }
@@ -59,11 +59,16 @@ void uip_ds6_route_init(void);
 /* Event constants for the uip-ds6 route notification interface. The
    notification interface allows for a user program to be notified via
    a callback when a route has been added or removed and when the
-   system has added or removed a default route. */
-#define UIP_DS6_NOTIFICATION_DEFRT_ADD 0
-#define UIP_DS6_NOTIFICATION_DEFRT_RM  1
-#define UIP_DS6_NOTIFICATION_ROUTE_ADD 2
-#define UIP_DS6_NOTIFICATION_ROUTE_RM  3
+   system has added or removed a default route, a neighbor or an
+   on-link prefix. */
+#define UIP_DS6_NOTIFICATION_DEFRT_ADD  0
+#define UIP_DS6_NOTIFICATION_DEFRT_RM   1
+#define UIP_DS6_NOTIFICATION_ROUTE_ADD  2
+#define UIP_DS6_NOTIFICATION_ROUTE_RM   3
+#define UIP_DS6_NOTIFICATION_NBR_ADD    4
+#define UIP_DS6_NOTIFICATION_NBR_RM     5
+#define UIP_DS6_NOTIFICATION_PREFIX_ADD 6
+#define UIP_DS6_NOTIFICATION_PREFIX_RM  7
 
 typedef void (* uip_ds6_notification_callback)(int event,
 					       uip_ipaddr_t *route,
@@ -78,6 +83,11 @@ void uip_ds6_notification_add(struct uip_ds6_notification *n,
 			      uip_ds6_notification_callback c);
 
 void uip_ds6_notification_rm(struct uip_ds6_notification *n);
+
+/* Call the registered callbacks. Used by the neighbor cache and the
+   prefix list, which have no notification list of their own. */
+void uip_ds6_notification_call(int event, uip_ipaddr_t *route,
+			       uip_ipaddr_t *nexthop);
 /*--------------------------------------------------*/
 #endif
 
@@ -161,6 +171,8 @@ uip_ds6_route_t *uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
                                    uip_ipaddr_t *next_hop);
 void uip_ds6_route_rm(uip_ds6_route_t *route);
 void uip_ds6_route_rm_by_nexthop(uip_ipaddr_t *nexthop);
+/* Mark the route as recently used, as a lookup does */
+void uip_ds6_route_touch(uip_ds6_route_t *route);
 
 uip_ipaddr_t *uip_ds6_route_nexthop(uip_ds6_route_t *);
 int uip_ds6_route_num_routes(void);
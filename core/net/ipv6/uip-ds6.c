@@ -95,6 +95,9 @@ uip_ds6_init(void)
 
   uip_ds6_neighbors_init();
   uip_ds6_route_init();
+#if UIP_DS6_FLOW_NB > 0
+  uip_ds6_flow_init();
+#endif /* UIP_DS6_FLOW_NB > 0 */
 
   PRINTF("Init of IPv6 data structures\n");
   PRINTF("%u neighbors\n%u default routers\n%u prefixes\n%u routes\n%u unicast addresses\n%u multicast addresses\n%u anycast addresses\n",
@@ -248,6 +251,10 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     PRINT6ADDR(&locprefix->ipaddr);
     PRINTF("length %u, flags %x, Valid lifetime %lx, Preffered lifetime %lx\n",
        ipaddrlen, flags, vtime, ptime);
+#if UIP_DS6_NOTIFICATIONS
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_PREFIX_ADD,
+                              &locprefix->ipaddr, NULL);
+#endif
     return locprefix;
   } else {
     PRINTF("No more space in Prefix list\n");
@@ -277,6 +284,10 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     PRINTF("Adding prefix ");
     PRINT6ADDR(&locprefix->ipaddr);
     PRINTF("length %u, vlifetime %lu\n", ipaddrlen, interval);
+#if UIP_DS6_NOTIFICATIONS
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_PREFIX_ADD,
+                              &locprefix->ipaddr, NULL);
+#endif
     return locprefix;
   }
   return NULL;
@@ -289,6 +300,10 @@ uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix)
 {
   if(prefix != NULL) {
     prefix->isused = 0;
+#if UIP_DS6_NOTIFICATIONS
+    uip_ds6_notification_call(UIP_DS6_NOTIFICATION_PREFIX_RM,
+                              &prefix->ipaddr, NULL);
+#endif
   }
   return;
 }
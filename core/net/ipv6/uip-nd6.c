@@ -75,6 +75,14 @@
 #include "net/ip/uip-nameserver.h"
 #include "lib/random.h"
 
+#if UIP_ND6_RA_6CO
+#include "net/ipv6/sicslowpan.h"
+#include "net/packetbuf.h"
+#if !SICSLOWPAN_DYNAMIC_CONTEXTS
+#error "UIP_CONF_ND6_RA_6CO needs SICSLOWPAN_CONF_DYNAMIC_CONTEXTS"
+#endif
+#endif /* UIP_ND6_RA_6CO */
+
 /*------------------------------------------------------------------*/
 #define DEBUG 0
 #include "net/ip/uip-debug.h"
@@ -114,6 +122,7 @@ void uip_log(char *msg);
 #define UIP_ND6_OPT_PREFIX_BUF ((uip_nd6_opt_prefix_info *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_MTU_BUF ((uip_nd6_opt_mtu *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_RDNSS_BUF ((uip_nd6_opt_dns *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
+#define UIP_ND6_OPT_6CO_BUF ((uip_nd6_opt_6co *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 /** @} */
 
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -551,17 +560,16 @@ na_input(void)
     }
   }
 #if UIP_CONF_IPV6_QUEUE_PKT
-  /* The nbr is now reachable, check if we had buffered a pkt for it */
+  /* The nbr is now reachable, check if we had buffered pkts for it. The
+     first one is sent as our output, and tcpip_ipv6_output() sends the
+     rest of the queue right after it. */
   /*if(nbr->queue_buf_len != 0) {
     uip_len = nbr->queue_buf_len;
     memcpy(UIP_IP_BUF, nbr->queue_buf, uip_len);
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+  if(uip_packetqueue_load(&nbr->packethandle)) {
     return;
   }
 
@@ -665,6 +673,9 @@ discard:
 void
 uip_nd6_ra_output(uip_ipaddr_t * dest)
 {
+#if UIP_ND6_RA_6CO
+  struct sicslowpan_addr_context *context;
+#endif /* UIP_ND6_RA_6CO */
 
   UIP_IP_BUF->vtc = 0x60;
   UIP_IP_BUF->tcflow = 0;
@@ -731,6 +742,40 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
   uip_len += UIP_ND6_OPT_MTU_LEN;
   nd6_opt_offset += UIP_ND6_OPT_MTU_LEN;
 
+#if UIP_ND6_RA_6CO
+  /* 6LoWPAN contexts, with the lifetime in units of 60 seconds */
+  for(context = sicslowpan_context_next(NULL);
+      context != NULL;
+      context = sicslowpan_context_next(context)) {
+    unsigned long lifetime;
+
+    if(!linkaddr_cmp(&context->peer, &linkaddr_null)) {
+      /* only known to the neighbor it was learned from */
+      continue;
+    }
+
+    UIP_ND6_OPT_6CO_BUF->type = UIP_ND6_OPT_6CO;
+    UIP_ND6_OPT_6CO_BUF->len = UIP_ND6_OPT_6CO_LEN >> 3;
+    UIP_ND6_OPT_6CO_BUF->preflen = context->length;
+    UIP_ND6_OPT_6CO_BUF->flags_cid = context->number |
+      (context->compress ? UIP_ND6_6CO_FLAG_C : 0);
+    UIP_ND6_OPT_6CO_BUF->reserved = 0;
+    lifetime = 0xffff;
+    if(!context->isinfinite) {
+      lifetime = (stimer_remaining(&context->lifetime) + 59) / 60;
+      if(lifetime > 0xffff) {
+        lifetime = 0xffff;
+      }
+    }
+    UIP_ND6_OPT_6CO_BUF->lifetime = uip_htons(lifetime);
+    memcpy(UIP_ND6_OPT_6CO_BUF->prefix, context->prefix,
+           sizeof(context->prefix));
+
+    uip_len += UIP_ND6_OPT_6CO_LEN;
+    nd6_opt_offset += UIP_ND6_OPT_6CO_LEN;
+  }
+#endif /* UIP_ND6_RA_6CO */
+
 #if UIP_ND6_RA_RDNSS
   if(uip_nameserver_count() > 0) {
     uint8_t i = 0;
@@ -993,6 +1038,25 @@ ra_input(void)
       }
       break;
 #endif /* UIP_ND6_RA_RDNSS */
+#if UIP_ND6_RA_6CO
+    case UIP_ND6_OPT_6CO:
+      PRINTF("Processing 6CO option in RA\n");
+      /* Contexts longer than 64 bits would cover interface
+         identifier bits, which the compressor does not handle. Only
+         the router that sent the RA is known to have the context. */
+      if(UIP_ND6_OPT_6CO_BUF->len >= UIP_ND6_OPT_6CO_LEN >> 3 &&
+         UIP_ND6_OPT_6CO_BUF->preflen <= 64) {
+        sicslowpan_context_set(UIP_ND6_OPT_6CO_BUF->flags_cid &
+                               UIP_ND6_6CO_CID_MASK,
+                               UIP_ND6_OPT_6CO_BUF->prefix,
+                               UIP_ND6_OPT_6CO_BUF->preflen,
+                               UIP_ND6_OPT_6CO_BUF->flags_cid &
+                               UIP_ND6_6CO_FLAG_C,
+                               uip_ntohs(UIP_ND6_OPT_6CO_BUF->lifetime) * 60UL,
+                               packetbuf_addr(PACKETBUF_ADDR_SENDER));
+      }
+      break;
+#endif /* UIP_ND6_RA_6CO */
     default:
       PRINTF("ND option not supported in RA");
       break;
@@ -1021,17 +1085,14 @@ ra_input(void)
 
 #if UIP_CONF_IPV6_QUEUE_PKT
   /* If the nbr just became reachable (e.g. it was in NBR_INCOMPLETE state
-   * and we got a SLLAO), check if we had buffered a pkt for it */
+   * and we got a SLLAO), check if we had buffered pkts for it */
   /*  if((nbr != NULL) && (nbr->queue_buf_len != 0)) {
     uip_len = nbr->queue_buf_len;
     memcpy(UIP_IP_BUF, nbr->queue_buf, uip_len);
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(nbr != NULL && uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+  if(nbr != NULL && uip_packetqueue_load(&nbr->packethandle)) {
     return;
   }
 
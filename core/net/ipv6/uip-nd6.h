@@ -158,6 +158,21 @@
 #endif
 /** @} */
 
+/** \name RFC 6775 6LoWPAN Context Option Constants  */
+/** @{ */
+/* Read the 6LoWPAN Context Option of received RAs into the
+   sicslowpan context table, and advertise that table in sent RAs.
+   Needs SICSLOWPAN_CONF_DYNAMIC_CONTEXTS. */
+#ifndef UIP_CONF_ND6_RA_6CO
+#define UIP_ND6_RA_6CO                  0
+#else
+#define UIP_ND6_RA_6CO                  UIP_CONF_ND6_RA_6CO
+#endif
+
+#define UIP_ND6_6CO_FLAG_C              0x10
+#define UIP_ND6_6CO_CID_MASK            0x0f
+/** @} */
+
 
 /** \name ND6 option types */
 /** @{ */
@@ -168,6 +183,7 @@
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_6CO                 34
 /** @} */
 
 /** \name ND6 option types */
@@ -192,6 +208,7 @@
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_6CO_LEN            16 /* for contexts up to 64 bits */
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -306,6 +323,17 @@ typedef struct uip_nd6_opt_prefix_info {
   uip_ipaddr_t prefix;
 } uip_nd6_opt_prefix_info ;
 
+/** \brief ND option 6LoWPAN context */
+typedef struct uip_nd6_opt_6co {
+  uint8_t type;
+  uint8_t len;
+  uint8_t preflen;
+  uint8_t flags_cid;
+  uint16_t reserved;
+  uint16_t lifetime;
+  uint8_t prefix[8];
+} uip_nd6_opt_6co;
+
 /** \brief ND option MTU */
 typedef struct uip_nd6_opt_mtu {
   uint8_t type;
@@ -78,6 +78,11 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#if UIP_TCP_BUFFERED || UIP_TCP_OOO
+#include "net/ip/tcpip.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#endif /* UIP_TCP_BUFFERED || UIP_TCP_OOO */
 
 #include <string.h>
 
@@ -174,9 +179,9 @@ uint8_t uip_ext_opt_offset = 0;
  * @{
  */
 /** Packet buffer for incoming and outgoing packets */
-#ifndef UIP_CONF_EXTERNAL_BUFFER
+#if !defined(UIP_CONF_EXTERNAL_BUFFER) && !UIP_BUF_POOL
 uip_buf_t uip_aligned_buf;
-#endif /* UIP_CONF_EXTERNAL_BUFFER */
+#endif /* !UIP_CONF_EXTERNAL_BUFFER && !UIP_BUF_POOL */
 
 /* The uip_appdata pointer points to application data. */
 void *uip_appdata;
@@ -239,6 +244,14 @@ static uint16_t lastport;
 #define TCP_OPT_MSS     2   /* Maximum segment size TCP option */
 
 #define TCP_OPT_MSS_LEN 4   /* Length of TCP MSS option. */
+
+#if UIP_TCP_OOO
+#define TCP_OPT_SACK_PERM     4 /* SACK permitted TCP option */
+#define TCP_OPT_SACK          5 /* SACK TCP option */
+
+#define TCP_OPT_SACK_PERM_LEN 2 /* Length of TCP SACK permitted option. */
+#define TCP_SACK_BLOCKS       4 /* Maximum number of SACK blocks sent. */
+#endif /* UIP_TCP_OOO */
 /** @} */
 /**
  * \name TCP variables
@@ -259,6 +272,51 @@ uint8_t uip_acc32[4];
 static uint8_t opt;
 static uint16_t tmp16;
 #endif /* UIP_TCP */
+
+#if UIP_TCP_BUFFERED
+/* Buffered mode flags, in addition to UIP_TCP_BUF_ON */
+#define TCP_BUF_RECOVERY 0x02 /* In NewReno fast recovery. */
+#define TCP_BUF_REXMIT   0x04 /* The first segment must be retransmitted. */
+#define TCP_BUF_CLOSE    0x08 /* Close when all data has been acked. */
+#define TCP_BUF_LOSS     0x10 /* Recovering from a retransmission timeout. */
+
+/* A segment kept for retransmission. Segments of a connection are
+   kept in sequence order in the list. */
+struct tcp_seg {
+  struct tcp_seg *next;
+  struct uip_conn *conn;
+  uint16_t offset;  /* Sequence number, relative to conn->snd_nxt. */
+  uint16_t len;
+  uint8_t data[UIP_TCP_MSS];
+};
+MEMB(tcp_seg_mem, struct tcp_seg, UIP_TCP_REXMIT_SEGMENTS);
+LIST(tcp_seg_list);
+
+/* Sequence number of the segment being sent, relative to snd_nxt. */
+#define TCP_SEQNO_AUTO 0xffff
+static uint16_t tcp_seqno_offset = TCP_SEQNO_AUTO;
+
+/* A buffered connection may be polled with data in flight */
+#define tcp_pollable(conn) (!uip_outstanding(conn) ||                  \
+                            (uip_tcp_buffered(conn) &&                 \
+                             uip_tcp_sendable(conn) > 0))
+#else /* UIP_TCP_BUFFERED */
+#define tcp_pollable(conn) (!uip_outstanding(conn))
+#endif /* UIP_TCP_BUFFERED */
+
+#if UIP_TCP_OOO
+/* A segment that arrived ahead of rcv_nxt. The most recently received
+   segment is first in the list. */
+struct tcp_ooo {
+  struct tcp_ooo *next;
+  struct uip_conn *conn;
+  uint8_t seqno[4];
+  uint16_t len;
+  uint8_t data[UIP_TCP_MSS];
+};
+MEMB(tcp_ooo_mem, struct tcp_ooo, UIP_TCP_OOO_SEGMENTS);
+LIST(tcp_ooo_list);
+#endif /* UIP_TCP_OOO */
 /** @} */
 
 /*---------------------------------------------------------------------------*/
@@ -320,6 +378,458 @@ uip_add32(uint8_t *op32, uint16_t op16)
 }
 #endif /* UIP_ARCH_ADD32 */
 #endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_BUFFERED
+static struct tcp_seg *
+tcp_seg_head(struct uip_conn *conn)
+{
+  struct tcp_seg *seg;
+
+  for(seg = list_head(tcp_seg_list); seg != NULL; seg = list_item_next(seg)) {
+    if(seg->conn == conn) {
+      return seg;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+tcp_seg_count(struct uip_conn *conn)
+{
+  struct tcp_seg *seg;
+  int count = 0;
+
+  for(seg = list_head(tcp_seg_list); seg != NULL; seg = list_item_next(seg)) {
+    if(seg->conn == conn) {
+      count++;
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_seg_free_all(struct uip_conn *conn)
+{
+  struct tcp_seg *seg, *next;
+
+  for(seg = list_head(tcp_seg_list); seg != NULL; seg = next) {
+    next = list_item_next(seg);
+    if(seg->conn == conn) {
+      list_remove(tcp_seg_list, seg);
+      memb_free(&tcp_seg_mem, seg);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Release the acknowledged data and move the remaining segments down
+   to the new snd_nxt. */
+static void
+tcp_seg_acked(struct uip_conn *conn, uint16_t acked)
+{
+  struct tcp_seg *seg, *next;
+  uint16_t n;
+
+  for(seg = list_head(tcp_seg_list); seg != NULL; seg = next) {
+    next = list_item_next(seg);
+    if(seg->conn != conn) {
+      continue;
+    }
+    if(seg->offset + seg->len <= acked) {
+      list_remove(tcp_seg_list, seg);
+      memb_free(&tcp_seg_mem, seg);
+    } else if(seg->offset < acked) {
+      n = acked - seg->offset;
+      memmove(seg->data, &seg->data[n], seg->len - n);
+      seg->len -= n;
+      seg->offset = 0;
+    } else {
+      seg->offset -= acked;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Keep a copy of the data the application has put in uip_sappdata. */
+static int
+tcp_seg_queue(struct uip_conn *conn, uint16_t len)
+{
+  struct tcp_seg *seg;
+
+  seg = memb_alloc(&tcp_seg_mem);
+  if(seg == NULL) {
+    return 0;
+  }
+  seg->conn = conn;
+  seg->offset = conn->len;
+  seg->len = len;
+  memcpy(seg->data, uip_sappdata, len);
+  list_add(tcp_seg_list, seg);
+  conn->len += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Put the first outstanding segment in uip_buf. */
+static int
+tcp_seg_load_head(struct uip_conn *conn)
+{
+  struct tcp_seg *seg;
+
+  seg = tcp_seg_head(conn);
+  conn->bufflags &= ~TCP_BUF_REXMIT;
+  if(seg == NULL) {
+    return 0;
+  }
+  memcpy(uip_sappdata, seg->data, seg->len);
+  uip_slen = seg->len;
+  tcp_seqno_offset = seg->offset;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_cc_init(struct uip_conn *conn)
+{
+  /* Initial window from RFC 3390. */
+  conn->cwnd = MIN(4 * conn->mss, MAX(2 * conn->mss, 4380));
+  conn->ssthresh = 0xffff;
+  conn->snd_wnd = conn->mss;
+  conn->recover = 0;
+  conn->dupacks = 0;
+  conn->bufflags &= ~(TCP_BUF_RECOVERY | TCP_BUF_REXMIT | TCP_BUF_CLOSE |
+                      TCP_BUF_LOSS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_cc_loss(struct uip_conn *conn)
+{
+  conn->ssthresh = MAX(conn->len / 2, 2 * conn->mss);
+}
+/*---------------------------------------------------------------------------*/
+/* NewReno (RFC 6582) congestion window update for an ACK that
+   acknowledged new data. */
+static void
+tcp_cc_ack(struct uip_conn *conn, uint16_t acked)
+{
+  uint16_t max = UIP_TCP_SEND_WINDOW * conn->mss;
+
+  conn->dupacks = 0;
+  if(conn->bufflags & TCP_BUF_LOSS) {
+    /* After a timeout, what was in flight is retransmitted one segment
+       per acknowledgement, as a receiver without an out-of-order
+       buffer has dropped it. */
+    if(acked >= conn->recover) {
+      conn->bufflags &= ~TCP_BUF_LOSS;
+    } else {
+      conn->recover -= acked;
+      conn->bufflags |= TCP_BUF_REXMIT;
+    }
+  }
+  if(conn->bufflags & TCP_BUF_RECOVERY) {
+    if(acked >= conn->recover) {
+      /* Full acknowledgement - leave fast recovery. */
+      conn->bufflags &= ~TCP_BUF_RECOVERY;
+      conn->cwnd = MIN(conn->ssthresh, conn->len + conn->mss);
+    } else {
+      /* Partial acknowledgement - the next segment was lost too. */
+      conn->recover -= acked;
+      conn->cwnd = conn->cwnd > acked ? conn->cwnd - acked : 0;
+      conn->cwnd += conn->mss;
+      conn->bufflags |= TCP_BUF_REXMIT;
+    }
+  } else if(conn->cwnd < conn->ssthresh) {
+    /* Slow start. */
+    conn->cwnd += MIN(acked, conn->mss);
+  } else {
+    /* Congestion avoidance. */
+    conn->cwnd += MAX(1, (uint32_t)conn->mss * conn->mss / conn->cwnd);
+  }
+  if(conn->cwnd > max) {
+    conn->cwnd = max;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_cc_dupack(struct uip_conn *conn)
+{
+  if(++conn->dupacks == 3 && !(conn->bufflags & TCP_BUF_RECOVERY)) {
+    /* Fast retransmit, and enter fast recovery. */
+    tcp_cc_loss(conn);
+    conn->recover = conn->len;
+    conn->cwnd = conn->ssthresh + 3 * conn->mss;
+    conn->bufflags |= TCP_BUF_RECOVERY | TCP_BUF_REXMIT;
+  } else if(conn->dupacks > 3 && (conn->bufflags & TCP_BUF_RECOVERY)) {
+    /* Each further duplicate means a segment has left the network. */
+    conn->cwnd += conn->mss;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_cc_timeout(struct uip_conn *conn)
+{
+  tcp_cc_loss(conn);
+  conn->cwnd = conn->mss;
+  conn->dupacks = 0;
+  conn->recover = conn->len;
+  conn->bufflags &= ~TCP_BUF_RECOVERY;
+  conn->bufflags |= TCP_BUF_LOSS;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_tcp_set_buffered(struct uip_conn *conn)
+{
+  conn->bufflags |= UIP_TCP_BUF_ON;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_tcp_sendable(struct uip_conn *conn)
+{
+  uint16_t wnd;
+
+  if(!(conn->bufflags & UIP_TCP_BUF_ON)) {
+    return conn->mss;
+  }
+  if((conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED ||
+     (conn->bufflags & TCP_BUF_CLOSE) ||
+     memb_numfree(&tcp_seg_mem) == 0 ||
+     tcp_seg_count(conn) >= UIP_TCP_SEND_WINDOW) {
+    return 0;
+  }
+  wnd = MIN(conn->cwnd, conn->snd_wnd);
+  if(conn->len >= wnd) {
+    return 0;
+  }
+  wnd -= conn->len;
+  if(wnd < conn->mss && conn->len > 0) {
+    /* Wait for a full segment while data is in flight. */
+    return 0;
+  }
+  return MIN(wnd, conn->mss);
+}
+#endif /* UIP_TCP_BUFFERED */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_BUFFERED || UIP_TCP_OOO
+static uint32_t
+tcp_seq_diff(const uint8_t *a, const uint8_t *b)
+{
+  return (((uint32_t)a[0] << 24) | ((uint32_t)a[1] << 16) |
+          ((uint32_t)a[2] << 8) | a[3]) -
+    (((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+     ((uint32_t)b[2] << 8) | b[3]);
+}
+#endif /* UIP_TCP_BUFFERED || UIP_TCP_OOO */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_OOO
+static void
+tcp_ooo_free_all(struct uip_conn *conn)
+{
+  struct tcp_ooo *seg, *next;
+
+  for(seg = list_head(tcp_ooo_list); seg != NULL; seg = next) {
+    next = list_item_next(seg);
+    if(seg->conn == conn) {
+      list_remove(tcp_ooo_list, seg);
+      memb_free(&tcp_ooo_mem, seg);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Keep the data of the incoming segment if it fits in the window
+   beyond rcv_nxt. */
+static void
+tcp_ooo_store(struct uip_conn *conn)
+{
+  struct tcp_ooo *seg;
+  uint32_t diff;
+
+  if(uip_len == 0 || uip_len > UIP_TCP_MSS ||
+     (conn->tcpstateflags & UIP_STOPPED) ||
+     (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN | TCP_URG)) != 0) {
+    return;
+  }
+  diff = tcp_seq_diff(UIP_TCP_BUF->seqno, conn->rcv_nxt);
+  if(diff == 0 || diff >= UIP_RECEIVE_WINDOW ||
+     diff + uip_len > UIP_RECEIVE_WINDOW) {
+    return;
+  }
+
+  for(seg = list_head(tcp_ooo_list); seg != NULL; seg = list_item_next(seg)) {
+    if(seg->conn == conn && seg->len >= uip_len &&
+       memcmp(seg->seqno, UIP_TCP_BUF->seqno, 4) == 0) {
+      /* We already have this one. */
+      return;
+    }
+  }
+
+  seg = memb_alloc(&tcp_ooo_mem);
+  if(seg == NULL) {
+    UIP_LOG("tcp: no out-of-order buffer.");
+    return;
+  }
+  seg->conn = conn;
+  memcpy(seg->seqno, UIP_TCP_BUF->seqno, 4);
+  seg->len = uip_len;
+  memcpy(seg->data, uip_appdata, uip_len);
+  list_push(tcp_ooo_list, seg);
+}
+/*---------------------------------------------------------------------------*/
+/* Return a buffered segment that starts at or before rcv_nxt, freeing
+   the ones that have been received in full meanwhile. */
+static struct tcp_ooo *
+tcp_ooo_next(struct uip_conn *conn)
+{
+  struct tcp_ooo *seg, *next;
+  int32_t diff;
+
+  for(seg = list_head(tcp_ooo_list); seg != NULL; seg = next) {
+    next = list_item_next(seg);
+    if(seg->conn != conn) {
+      continue;
+    }
+    diff = (int32_t)tcp_seq_diff(seg->seqno, conn->rcv_nxt);
+    if(diff <= 0) {
+      if(diff + seg->len > 0) {
+        return seg;
+      }
+      list_remove(tcp_ooo_list, seg);
+      memb_free(&tcp_ooo_mem, seg);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Put the next in-sequence buffered data into uip_appdata. The caller
+   advances rcv_nxt by uip_len. */
+static int
+tcp_ooo_load(struct uip_conn *conn)
+{
+  struct tcp_ooo *seg;
+  uint16_t offset;
+
+  seg = tcp_ooo_next(conn);
+  if(seg == NULL) {
+    return 0;
+  }
+  offset = tcp_seq_diff(conn->rcv_nxt, seg->seqno);
+  uip_len = seg->len - offset;
+  memcpy(uip_appdata, &seg->data[offset], uip_len);
+  list_remove(tcp_ooo_list, seg);
+  memb_free(&tcp_ooo_mem, seg);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Write a SACK option for the buffered data of the connection and
+   return its length. The first block holds the most recently received
+   segment, as required by RFC 2018. */
+static uint8_t
+tcp_ooo_sack(struct uip_conn *conn, uint8_t *opts)
+{
+  struct tcp_ooo *seg, *other;
+  uint16_t start[TCP_SACK_BLOCKS], end[TCP_SACK_BLOCKS];
+  uint16_t s, e, os, oe;
+  uint8_t i, n, grown;
+
+  n = 0;
+  for(seg = list_head(tcp_ooo_list);
+      seg != NULL && n < TCP_SACK_BLOCKS;
+      seg = list_item_next(seg)) {
+    /* Segments that reach rcv_nxt are about to be delivered. */
+    if(seg->conn != conn ||
+       (int32_t)tcp_seq_diff(seg->seqno, conn->rcv_nxt) <= 0) {
+      continue;
+    }
+    s = tcp_seq_diff(seg->seqno, conn->rcv_nxt);
+    e = s + seg->len;
+    for(i = 0; i < n; i++) {
+      if(s >= start[i] && e <= end[i]) {
+        break;
+      }
+    }
+    if(i < n) {
+      /* Already reported as part of a block. */
+      continue;
+    }
+
+    /* Grow the block with the segments that overlap or adjoin it. */
+    do {
+      grown = 0;
+      for(other = list_head(tcp_ooo_list); other != NULL;
+          other = list_item_next(other)) {
+        if(other->conn != conn ||
+           (int32_t)tcp_seq_diff(other->seqno, conn->rcv_nxt) <= 0) {
+          continue;
+        }
+        os = tcp_seq_diff(other->seqno, conn->rcv_nxt);
+        oe = os + other->len;
+        if(os <= e && oe >= s && (os < s || oe > e)) {
+          s = MIN(s, os);
+          e = MAX(e, oe);
+          grown = 1;
+        }
+      }
+    } while(grown);
+    start[n] = s;
+    end[n] = e;
+    n++;
+  }
+
+  if(n == 0) {
+    return 0;
+  }
+  opts[0] = TCP_OPT_NOOP;
+  opts[1] = TCP_OPT_NOOP;
+  opts[2] = TCP_OPT_SACK;
+  opts[3] = 2 + 8 * n;
+  for(i = 0; i < n; i++) {
+    uip_add32(conn->rcv_nxt, start[i]);
+    memcpy(&opts[4 + 8 * i], uip_acc32, 4);
+    uip_add32(conn->rcv_nxt, end[i]);
+    memcpy(&opts[8 + 8 * i], uip_acc32, 4);
+  }
+  return 4 + 8 * n;
+}
+/*---------------------------------------------------------------------------*/
+/* Check the options of an incoming SYN for SACK permitted. */
+static uint8_t
+tcp_sack_permitted(void)
+{
+  uint8_t *opts = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
+  uint16_t i, optlen;
+
+  optlen = ((UIP_TCP_BUF->tcpoffset >> 4) - 5) << 2;
+  for(i = 0; i < optlen;) {
+    if(opts[i] == TCP_OPT_END) {
+      break;
+    } else if(opts[i] == TCP_OPT_NOOP) {
+      ++i;
+    } else if(i + 1 >= optlen || opts[i + 1] == 0) {
+      /* Malformed options. */
+      break;
+    } else if(opts[i] == TCP_OPT_SACK_PERM &&
+              opts[i + 1] == TCP_OPT_SACK_PERM_LEN) {
+      return 1;
+    } else {
+      i += opts[i + 1];
+    }
+  }
+  return 0;
+}
+#endif /* UIP_TCP_OOO */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP
+static void
+tcp_rtt_estimate(struct uip_conn *conn)
+{
+  signed char m;
+  m = conn->rto - conn->timer;
+  /* This is taken directly from VJs original code in his paper */
+  m = m - (conn->sa >> 3);
+  conn->sa += m;
+  if(m < 0) {
+    m = -m;
+  }
+  m = m - (conn->sv >> 2);
+  conn->sv += m;
+  conn->rto = (conn->sa >> 3) + conn->sv;
+}
+#endif /* UIP_TCP */
 
 #if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
@@ -459,6 +969,16 @@ uip_init(void)
 #if UIP_CONF_IPV6_MULTICAST
   UIP_MCAST6.init();
 #endif
+
+#if UIP_TCP_BUFFERED
+  memb_init(&tcp_seg_mem);
+  list_init(tcp_seg_list);
+#endif /* UIP_TCP_BUFFERED */
+
+#if UIP_TCP_OOO
+  memb_init(&tcp_ooo_mem);
+  list_init(tcp_ooo_list);
+#endif /* UIP_TCP_OOO */
 }
 /*---------------------------------------------------------------------------*/
 #if UIP_TCP && UIP_ACTIVE_OPEN
@@ -519,6 +1039,14 @@ uip_connect(const uip_ipaddr_t *ripaddr, uint16_t rport)
   conn->initialmss = conn->mss = UIP_TCP_MSS;
 
   conn->len = 1;   /* TCP length of the SYN is one. */
+#if UIP_TCP_BUFFERED
+  tcp_seg_free_all(conn);
+  conn->bufflags = 0;
+#endif /* UIP_TCP_BUFFERED */
+#if UIP_TCP_OOO
+  tcp_ooo_free_all(conn);
+  conn->sack = 0;
+#endif /* UIP_TCP_OOO */
   conn->nrtx = 0;
   conn->timer = 1; /* Send the SYN next time around. */
   conn->rto = UIP_RTO;
@@ -954,8 +1482,33 @@ uip_process(uint8_t flag)
      particular connection. */
   if(flag == UIP_POLL_REQUEST) {
 #if UIP_TCP
+#if UIP_TCP_OOO
     if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
-       !uip_outstanding(uip_connr)) {
+       !(uip_connr->tcpstateflags & UIP_STOPPED) &&
+       tcp_ooo_load(uip_connr)) {
+      /* The gap before buffered out-of-order data has been filled, so
+         we hand the data to the application. */
+      uip_add_rcv_nxt(uip_len);
+      if(tcp_ooo_next(uip_connr) != NULL) {
+        tcpip_poll_tcp(uip_connr);
+      }
+      uip_flags = UIP_NEWDATA;
+      uip_slen = 0;
+      UIP_APPCALL();
+      goto appsend;
+    }
+#endif /* UIP_TCP_OOO */
+#if UIP_TCP_BUFFERED
+    if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+       (uip_connr->bufflags & TCP_BUF_REXMIT)) {
+      goto tcp_send_rexmit;
+    }
+#endif /* UIP_TCP_BUFFERED */
+    if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+       tcp_pollable(uip_connr)) {
+      /* A buffered connection is polled with data in flight, so what
+         was sent last must not be taken for new data. */
+      uip_slen = 0;
       uip_flags = UIP_POLL;
       UIP_APPCALL();
       goto appsend;
@@ -984,6 +1537,17 @@ uip_process(uint8_t flag)
       }
     }
 
+#if UIP_TCP_BUFFERED
+    if(uip_connr->tcpstateflags == UIP_CLOSED) {
+      tcp_seg_free_all(uip_connr);
+    }
+#endif /* UIP_TCP_BUFFERED */
+#if UIP_TCP_OOO
+    if(uip_connr->tcpstateflags == UIP_CLOSED) {
+      tcp_ooo_free_all(uip_connr);
+    }
+#endif /* UIP_TCP_OOO */
+
     /*
      * Check if the connection is in a state in which we simply wait
      * for the connection to time out. If so, we increase the
@@ -1051,6 +1615,13 @@ uip_process(uint8_t flag)
 #endif /* UIP_ACTIVE_OPEN */
 
             case UIP_ESTABLISHED:
+#if UIP_TCP_BUFFERED
+              if(uip_tcp_buffered(uip_connr)) {
+                /* uIP has the data of a buffered connection. */
+                tcp_cc_timeout(uip_connr);
+                goto tcp_send_rexmit;
+              }
+#endif /* UIP_TCP_BUFFERED */
               /*
                * In the ESTABLISHED state, we call upon the application
                * to do the actual retransmit after which we jump into
@@ -1746,6 +2317,14 @@ uip_process(uint8_t flag)
   uip_connr->snd_nxt[2] = iss[2];
   uip_connr->snd_nxt[3] = iss[3];
   uip_connr->len = 1;
+#if UIP_TCP_BUFFERED
+  tcp_seg_free_all(uip_connr);
+  uip_connr->bufflags = 0;
+#endif /* UIP_TCP_BUFFERED */
+#if UIP_TCP_OOO
+  tcp_ooo_free_all(uip_connr);
+  uip_connr->sack = tcp_sack_permitted();
+#endif /* UIP_TCP_OOO */
 
   /* rcv_nxt should be the seqno from the incoming packet + 1. */
   uip_connr->rcv_nxt[0] = UIP_TCP_BUF->seqno[0];
@@ -1807,6 +2386,19 @@ uip_process(uint8_t flag)
   UIP_TCP_BUF->optdata[3] = (UIP_TCP_MSS) & 255;
   uip_len = UIP_IPTCPH_LEN + TCP_OPT_MSS_LEN;
   UIP_TCP_BUF->tcpoffset = ((UIP_TCPH_LEN + TCP_OPT_MSS_LEN) / 4) << 4;
+#if UIP_TCP_OOO
+  /* We offer SACK in our SYN, and accept it in the SYNACK if the
+     remote host offered it. */
+  if(!(UIP_TCP_BUF->flags & TCP_ACK) || uip_connr->sack) {
+    uip_buf[uip_len + UIP_LLH_LEN] = TCP_OPT_NOOP;
+    uip_buf[uip_len + UIP_LLH_LEN + 1] = TCP_OPT_NOOP;
+    uip_buf[uip_len + UIP_LLH_LEN + 2] = TCP_OPT_SACK_PERM;
+    uip_buf[uip_len + UIP_LLH_LEN + 3] = TCP_OPT_SACK_PERM_LEN;
+    uip_len += 4;
+    UIP_TCP_BUF->tcpoffset =
+      ((UIP_TCPH_LEN + TCP_OPT_MSS_LEN + 4) / 4) << 4;
+  }
+#endif /* UIP_TCP_OOO */
   goto tcp_send;
 
   /* This label will be jumped to if we found an active connection. */
@@ -1832,6 +2424,12 @@ uip_process(uint8_t flag)
      calculated by subtracing the length of the TCP header (in
      c) and the length of the IP header (20 bytes). */
   uip_len = uip_len - c - UIP_IPH_LEN;
+#if UIP_TCP_OOO
+  /* The data follows the TCP options, if any. With SACK, the peer puts
+     options on data segments. uip_sappdata stays where the reply is
+     built, after a header without options. */
+  uip_appdata = &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN + c];
+#endif /* UIP_TCP_OOO */
 
   /* First, check if the sequence number of the incoming packet is
      what we're expecting next. If not, we send out an ACK with the
@@ -1855,6 +2453,11 @@ uip_process(uint8_t flag)
           goto tcp_send_syn;
         }
       }
+#if UIP_TCP_OOO
+      if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+        tcp_ooo_store(uip_connr);
+      }
+#endif /* UIP_TCP_OOO */
       goto tcp_send_ack;
     }
   }
@@ -1863,6 +2466,37 @@ uip_process(uint8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+#if UIP_TCP_BUFFERED
+  if(uip_tcp_buffered(uip_connr)) {
+    if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+      uint32_t acked;
+
+      /* Any amount of the outstanding data may be acknowledged. */
+      acked = tcp_seq_diff(UIP_TCP_BUF->ackno, uip_connr->snd_nxt);
+      if(acked > 0 && acked <= uip_connr->len) {
+        uip_add32(uip_connr->snd_nxt, acked);
+        uip_connr->snd_nxt[0] = uip_acc32[0];
+        uip_connr->snd_nxt[1] = uip_acc32[1];
+        uip_connr->snd_nxt[2] = uip_acc32[2];
+        uip_connr->snd_nxt[3] = uip_acc32[3];
+        uip_connr->len -= acked;
+        tcp_seg_acked(uip_connr, acked);
+
+        if(uip_connr->nrtx == 0) {
+          tcp_rtt_estimate(uip_connr);
+        }
+        tcp_cc_ack(uip_connr, acked);
+        uip_connr->nrtx = 0;
+        uip_flags = UIP_ACKDATA;
+        uip_connr->timer = uip_connr->rto;
+      } else if(acked == 0 && uip_len == 0 &&
+                (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN)) == 0 &&
+                (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+        tcp_cc_dupack(uip_connr);
+      }
+    }
+  } else
+#endif /* UIP_TCP_BUFFERED */
   if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
@@ -1878,18 +2512,7 @@ uip_process(uint8_t flag)
 
       /* Do RTT estimation, unless we have done retransmissions. */
       if(uip_connr->nrtx == 0) {
-        signed char m;
-        m = uip_connr->rto - uip_connr->timer;
-        /* This is taken directly from VJs original code in his paper */
-        m = m - (uip_connr->sa >> 3);
-        uip_connr->sa += m;
-        if(m < 0) {
-          m = -m;
-        }
-        m = m - (uip_connr->sv >> 2);
-        uip_connr->sv += m;
-        uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
-
+        tcp_rtt_estimate(uip_connr);
       }
       /* Set the acknowledged flag. */
       uip_flags = UIP_ACKDATA;
@@ -1917,6 +2540,9 @@ uip_process(uint8_t flag)
         uip_connr->tcpstateflags = UIP_ESTABLISHED;
         uip_flags = UIP_CONNECTED;
         uip_connr->len = 0;
+#if UIP_TCP_BUFFERED
+        tcp_cc_init(uip_connr);
+#endif /* UIP_TCP_BUFFERED */
         if(uip_len > 0) {
           uip_flags |= UIP_NEWDATA;
           uip_add_rcv_nxt(uip_len);
@@ -1971,6 +2597,9 @@ uip_process(uint8_t flag)
             }
           }
         }
+#if UIP_TCP_OOO
+        uip_connr->sack = tcp_sack_permitted();
+#endif /* UIP_TCP_OOO */
         uip_connr->tcpstateflags = UIP_ESTABLISHED;
         uip_connr->rcv_nxt[0] = UIP_TCP_BUF->seqno[0];
         uip_connr->rcv_nxt[1] = UIP_TCP_BUF->seqno[1];
@@ -1979,6 +2608,9 @@ uip_process(uint8_t flag)
         uip_add_rcv_nxt(1);
         uip_flags = UIP_CONNECTED | UIP_NEWDATA;
         uip_connr->len = 0;
+#if UIP_TCP_BUFFERED
+        tcp_cc_init(uip_connr);
+#endif /* UIP_TCP_BUFFERED */
         uip_clear_buf();
         uip_slen = 0;
         UIP_APPCALL();
@@ -2051,6 +2683,13 @@ uip_process(uint8_t flag)
       if(uip_len > 0 && !(uip_connr->tcpstateflags & UIP_STOPPED)) {
         uip_flags |= UIP_NEWDATA;
         uip_add_rcv_nxt(uip_len);
+#if UIP_TCP_OOO
+        if(tcp_ooo_next(uip_connr) != NULL) {
+          /* Deliver the buffered data that follows once the
+             application has taken this segment. */
+          tcpip_poll_tcp(uip_connr);
+        }
+#endif /* UIP_TCP_OOO */
       }
 
       /* Check if the available buffer space advertised by the other end
@@ -2066,6 +2705,9 @@ uip_process(uint8_t flag)
          "persistent timer" and uses the retransmission mechanim.
       */
       tmp16 = ((uint16_t)UIP_TCP_BUF->wnd[0] << 8) + (uint16_t)UIP_TCP_BUF->wnd[1];
+#if UIP_TCP_BUFFERED
+      uip_connr->snd_wnd = tmp16 == 0 ? uip_connr->initialmss : tmp16;
+#endif /* UIP_TCP_BUFFERED */
       if(tmp16 > uip_connr->initialmss ||
          tmp16 == 0) {
         tmp16 = uip_connr->initialmss;
@@ -2101,6 +2743,19 @@ uip_process(uint8_t flag)
           goto tcp_send_nodata;
         }
 
+#if UIP_TCP_BUFFERED
+        if(uip_tcp_buffered(uip_connr)) {
+          if((uip_flags & UIP_CLOSE) && uip_outstanding(uip_connr)) {
+            /* Hold the FIN back until all data has been acknowledged. */
+            uip_connr->bufflags |= TCP_BUF_CLOSE;
+            uip_flags = UIP_NEWDATA;
+          } else if((uip_connr->bufflags & TCP_BUF_CLOSE) &&
+                    !uip_outstanding(uip_connr)) {
+            uip_flags |= UIP_CLOSE;
+          }
+        }
+#endif /* UIP_TCP_BUFFERED */
+
         if(uip_flags & UIP_CLOSE) {
           uip_slen = 0;
           uip_connr->len = 1;
@@ -2110,6 +2765,34 @@ uip_process(uint8_t flag)
           goto tcp_send_nodata;
         }
 
+#if UIP_TCP_BUFFERED
+        if(uip_tcp_buffered(uip_connr)) {
+          /* Keep a copy of the new data and send it after what is
+             already in flight. */
+          if(uip_slen > 0) {
+            tmp16 = uip_tcp_sendable(uip_connr);
+            if(uip_slen > tmp16) {
+              uip_slen = tmp16;
+            }
+            if(uip_slen > 0 && tcp_seg_queue(uip_connr, uip_slen)) {
+              tcp_seqno_offset = uip_connr->len - uip_slen;
+            } else {
+              uip_slen = 0;
+            }
+          }
+          if(uip_connr->bufflags & TCP_BUF_REXMIT) {
+            if(uip_slen == 0) {
+              goto tcp_send_rexmit;
+            }
+            tcpip_poll_tcp(uip_connr);
+          } else if(uip_slen > 0 && uip_tcp_sendable(uip_connr) > 0) {
+            /* Come back for more while the window is open. */
+            tcpip_poll_tcp(uip_connr);
+          }
+          goto apprexmit;
+        }
+#endif /* UIP_TCP_BUFFERED */
+
         /* If uip_slen > 0, the application has data to be sent. */
         if(uip_slen > 0) {
 
@@ -2150,6 +2833,11 @@ uip_process(uint8_t flag)
            packet had new data in it, we must send out a packet. */
         if(uip_slen > 0 && uip_connr->len > 0) {
           /* Add the length of the IP and TCP headers. */
+#if UIP_TCP_BUFFERED
+          if(uip_tcp_buffered(uip_connr)) {
+            uip_len = uip_slen + UIP_TCPIP_HLEN;
+          } else
+#endif /* UIP_TCP_BUFFERED */
           uip_len = uip_connr->len + UIP_TCPIP_HLEN;
           /* We always set the ACK flag in response packets. */
           UIP_TCP_BUF->flags = TCP_ACK | TCP_PSH;
@@ -2164,6 +2852,25 @@ uip_process(uint8_t flag)
           goto tcp_send_noopts;
         }
       }
+#if UIP_TCP_BUFFERED
+      if(uip_tcp_buffered(uip_connr)) {
+        if(uip_connr->bufflags & TCP_BUF_REXMIT) {
+        tcp_send_rexmit:
+          /* Retransmit the first outstanding segment. */
+          if(tcp_seg_load_head(uip_connr)) {
+            if(uip_tcp_sendable(uip_connr) > 0) {
+              tcpip_poll_tcp(uip_connr);
+            }
+            goto apprexmit;
+          }
+        } else if(!(uip_flags & UIP_POLL) &&
+                  uip_tcp_sendable(uip_connr) > 0) {
+          /* The window may have opened. Not after a poll that had
+             nothing to send, that would poll the connection forever. */
+          tcpip_poll_tcp(uip_connr);
+        }
+      }
+#endif /* UIP_TCP_BUFFERED */
       goto drop;
     case UIP_LAST_ACK:
       /* We can close this connection if the peer has acknowledged our
@@ -2242,6 +2949,15 @@ uip_process(uint8_t flag)
 
  tcp_send_noopts:
   UIP_TCP_BUF->tcpoffset = (UIP_TCPH_LEN / 4) << 4;
+#if UIP_TCP_OOO
+  /* Report buffered out-of-order data in pure ACKs. */
+  if(uip_len == UIP_IPTCPH_LEN && uip_connr->sack &&
+     (UIP_TCP_BUF->flags & (TCP_SYN | TCP_RST)) == 0) {
+    c = tcp_ooo_sack(uip_connr, &uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN]);
+    uip_len += c;
+    UIP_TCP_BUF->tcpoffset = ((UIP_TCPH_LEN + c) / 4) << 4;
+  }
+#endif /* UIP_TCP_OOO */
 
   /* We're done with the input processing. We are now ready to send a
      reply. Our job is to fill in all the fields of the TCP and IP
@@ -2255,10 +2971,29 @@ uip_process(uint8_t flag)
   UIP_TCP_BUF->ackno[2] = uip_connr->rcv_nxt[2];
   UIP_TCP_BUF->ackno[3] = uip_connr->rcv_nxt[3];
 
+#if UIP_TCP_BUFFERED
+  /* Segments of a buffered connection are sent after the data in
+     flight, and so are ACKs so that they fall within the window of
+     the receiver. */
+  if(tcp_seqno_offset == TCP_SEQNO_AUTO) {
+    tcp_seqno_offset = 0;
+    if(uip_tcp_buffered(uip_connr) &&
+       (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN)) == 0) {
+      tcp_seqno_offset = uip_connr->len;
+    }
+  }
+  uip_add32(uip_connr->snd_nxt, tcp_seqno_offset);
+  tcp_seqno_offset = TCP_SEQNO_AUTO;
+  UIP_TCP_BUF->seqno[0] = uip_acc32[0];
+  UIP_TCP_BUF->seqno[1] = uip_acc32[1];
+  UIP_TCP_BUF->seqno[2] = uip_acc32[2];
+  UIP_TCP_BUF->seqno[3] = uip_acc32[3];
+#else /* UIP_TCP_BUFFERED */
   UIP_TCP_BUF->seqno[0] = uip_connr->snd_nxt[0];
   UIP_TCP_BUF->seqno[1] = uip_connr->snd_nxt[1];
   UIP_TCP_BUF->seqno[2] = uip_connr->snd_nxt[2];
   UIP_TCP_BUF->seqno[3] = uip_connr->snd_nxt[3];
+#endif /* UIP_TCP_BUFFERED */
 
   UIP_TCP_BUF->srcport  = uip_connr->lport;
   UIP_TCP_BUF->destport = uip_connr->rport;
@@ -2314,6 +3049,9 @@ uip_process(uint8_t flag)
   uip_clear_buf();
   uip_ext_bitmap = 0;
   uip_flags = 0;
+#if UIP_TCP_BUFFERED
+  tcp_seqno_offset = TCP_SEQNO_AUTO;
+#endif /* UIP_TCP_BUFFERED */
   return;
 }
 /*---------------------------------------------------------------------------*/
@@ -2348,7 +3086,8 @@ uip_send(const void *data, int len)
         memcpy((char *)&uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN],
                (data), uip_slen);
       } else {
-        memcpy(uip_sappdata, (data), uip_slen);
+        /* data may be the received data, further on in uip_buf */
+        memmove(uip_sappdata, (data), uip_slen);
       }
     }
   }
@@ -49,6 +49,7 @@
 #include "net/netstack.h"
 #include "net/rime/rime.h"
 #include "sys/compower.h"
+#include "sys/energest.h"
 #include "sys/pt.h"
 #include "sys/rtimer.h"
 
@@ -78,11 +79,33 @@
 #define RDC_CONF_MCU_SLEEP           0
 #endif
 
+/* Keep sending to a receiver that is still awake from the previous
+   frame of a burst, without waking it up again */
+#ifdef CONTIKIMAC_CONF_WITH_BURST
+#define WITH_BURST                   CONTIKIMAC_CONF_WITH_BURST
+#else /* CONTIKIMAC_CONF_WITH_BURST */
+#define WITH_BURST                   0
+#endif /* CONTIKIMAC_CONF_WITH_BURST */
+/* Raise the channel check rate when traffic is observed */
+#ifdef CONTIKIMAC_CONF_WITH_ADAPTIVE_CCR
+#define WITH_ADAPTIVE_CCR            CONTIKIMAC_CONF_WITH_ADAPTIVE_CCR
+#else /* CONTIKIMAC_CONF_WITH_ADAPTIVE_CCR */
+#define WITH_ADAPTIVE_CCR            0
+#endif /* CONTIKIMAC_CONF_WITH_ADAPTIVE_CCR */
+
 #if NETSTACK_RDC_CHANNEL_CHECK_RATE >= 64
 #undef WITH_PHASE_OPTIMIZATION
 #define WITH_PHASE_OPTIMIZATION 0
 #endif
 
+/* With an adaptive channel check rate, neighbors may lock onto one of
+   the additional channel checks, which disappears when the rate decays.
+   Phase optimization is therefore not used together with it. */
+#if WITH_ADAPTIVE_CCR
+#undef WITH_PHASE_OPTIMIZATION
+#define WITH_PHASE_OPTIMIZATION 0
+#endif
+
 /* CYCLE_TIME for channel cca checks, in rtimer ticks. */
 #ifdef CONTIKIMAC_CONF_CYCLE_TIME
 #define CYCLE_TIME (CONTIKIMAC_CONF_CYCLE_TIME)
@@ -112,6 +135,37 @@ static int we_are_receiving_burst = 0;
 #define INTER_PACKET_DEADLINE               CLOCK_SECOND / 32
 #endif
 
+/* BURST_DETECT_TIME is the maximum time between two unicast
+   transmissions to the same neighbor for them to be considered part
+   of a burst. The frames of a burst are sent with FRAME_PENDING set,
+   which keeps the receiver awake for INTER_PACKET_DEADLINE. */
+#ifdef CONTIKIMAC_CONF_BURST_DETECT_TIME
+#define BURST_DETECT_TIME                   CONTIKIMAC_CONF_BURST_DETECT_TIME
+#else
+#define BURST_DETECT_TIME                   CLOCK_SECOND / 4
+#endif
+
+/* With WITH_ADAPTIVE_CCR, the channel check rate is adapted once per
+   second: it is doubled (up to ADAPTIVE_CCR_MAX_SHIFT times) after a
+   second in which a packet was received, and halved after
+   ADAPTIVE_CCR_DECAY_SECONDS seconds without traffic. */
+#ifdef CONTIKIMAC_CONF_ADAPTIVE_CCR_MAX_SHIFT
+#define ADAPTIVE_CCR_MAX_SHIFT              CONTIKIMAC_CONF_ADAPTIVE_CCR_MAX_SHIFT
+#else
+#define ADAPTIVE_CCR_MAX_SHIFT              2
+#endif
+
+#ifdef CONTIKIMAC_CONF_ADAPTIVE_CCR_DECAY_SECONDS
+#define ADAPTIVE_CCR_DECAY_SECONDS          CONTIKIMAC_CONF_ADAPTIVE_CCR_DECAY_SECONDS
+#else
+#define ADAPTIVE_CCR_DECAY_SECONDS          1
+#endif
+
+#if WITH_ADAPTIVE_CCR && \
+  (NETSTACK_RDC_CHANNEL_CHECK_RATE << ADAPTIVE_CCR_MAX_SHIFT) > 128
+#error ContikiMAC: NETSTACK_RDC_CHANNEL_CHECK_RATE << CONTIKIMAC_CONF_ADAPTIVE_CCR_MAX_SHIFT must not exceed 128
+#endif
+
 /* ContikiMAC performs periodic channel checks. Each channel check
    consists of two or more CCA checks. CCA_COUNT_MAX is the number of
    CCAs to be done for each periodic channel check. The default is
@@ -264,6 +318,29 @@ static struct compower_activity current_packet;
 
 #define DEFAULT_STREAM_TIME (4 * CYCLE_TIME)
 
+#if CONTIKIMAC_WITH_STATS
+struct contikimac_stats contikimac_stats;
+#endif /* CONTIKIMAC_WITH_STATS */
+
+#if WITH_BURST
+/* The neighbor we last sent a unicast frame to, and when */
+static linkaddr_t burst_receiver;
+static clock_time_t burst_last_tx;
+/* Non-zero if that frame was acknowledged and had FRAME_PENDING set,
+   i.e., the receiver keeps its radio on for the next one */
+static uint8_t burst_receiver_awake;
+#endif /* WITH_BURST */
+
+#if WITH_ADAPTIVE_CCR
+/* The current channel check rate is NETSTACK_RDC_CHANNEL_CHECK_RATE << ccr_shift */
+static volatile uint8_t ccr_shift;
+static volatile uint8_t ccr_traffic_seen;
+static uint16_t ccr_idle_seconds;
+#define CURRENT_CYCLE_TIME (CYCLE_TIME >> ccr_shift)
+#else /* WITH_ADAPTIVE_CCR */
+#define CURRENT_CYCLE_TIME CYCLE_TIME
+#endif /* WITH_ADAPTIVE_CCR */
+
 #if CONTIKIMAC_CONF_BROADCAST_RATE_LIMIT
 static struct timer broadcast_rate_timer;
 static int broadcast_rate_counter;
@@ -359,6 +436,29 @@ powercycle_turn_radio_on(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if WITH_ADAPTIVE_CCR
+/* Called once per second: returns the channel check rate shift to use
+   for the next second, based on whether packets were received since
+   the last call. */
+static uint8_t
+adapt_channel_check_rate(void)
+{
+  uint8_t shift = ccr_shift;
+
+  if(ccr_traffic_seen) {
+    ccr_traffic_seen = 0;
+    ccr_idle_seconds = 0;
+    if(shift < ADAPTIVE_CCR_MAX_SHIFT) {
+      shift++;
+    }
+  } else if(shift > 0 && ++ccr_idle_seconds >= ADAPTIVE_CCR_DECAY_SECONDS) {
+    ccr_idle_seconds = 0;
+    shift--;
+  }
+  return shift;
+}
+#endif /* WITH_ADAPTIVE_CCR */
+/*---------------------------------------------------------------------------*/
 static void
 powercycle_wrapper(struct rtimer *t, void *ptr)
 {
@@ -386,6 +486,22 @@ powercycle(struct rtimer *t, void *ptr)
     static uint8_t count;
 
 #if SYNC_CYCLE_STARTS
+#if WITH_ADAPTIVE_CCR
+    {
+      /* The rate changes at a second boundary, where the cycle phases
+         of all rates are aligned */
+      if(sync_cycle_phase++ == (NETSTACK_RDC_CHANNEL_CHECK_RATE << ccr_shift)) {
+        sync_cycle_phase = 0;
+        sync_cycle_start += RTIMER_ARCH_SECOND;
+        cycle_start = sync_cycle_start;
+        ccr_shift = adapt_channel_check_rate();
+      } else {
+        cycle_start = sync_cycle_start +
+          ((unsigned long)(sync_cycle_phase * RTIMER_ARCH_SECOND)) /
+          (NETSTACK_RDC_CHANNEL_CHECK_RATE << ccr_shift);
+      }
+    }
+#else /* WITH_ADAPTIVE_CCR */
     /* Compute cycle start when RTIMER_ARCH_SECOND is not a multiple
        of CHANNEL_CHECK_RATE */
     if(sync_cycle_phase++ == NETSTACK_RDC_CHANNEL_CHECK_RATE) {
@@ -399,8 +515,18 @@ powercycle(struct rtimer *t, void *ptr)
       cycle_start = sync_cycle_start + (sync_cycle_phase*RTIMER_ARCH_SECOND)/NETSTACK_RDC_CHANNEL_CHECK_RATE;
 #endif
     }
+#endif /* WITH_ADAPTIVE_CCR */
 #else
-    cycle_start += CYCLE_TIME;
+    cycle_start += CURRENT_CYCLE_TIME;
+#if WITH_ADAPTIVE_CCR
+    {
+      static uint8_t ccr_cycles;
+      if(++ccr_cycles >= (NETSTACK_RDC_CHANNEL_CHECK_RATE << ccr_shift)) {
+        ccr_cycles = 0;
+        ccr_shift = adapt_channel_check_rate();
+      }
+    }
+#endif /* WITH_ADAPTIVE_CCR */
 #endif
 
     packet_seen = 0;
@@ -483,7 +609,7 @@ powercycle(struct rtimer *t, void *ptr)
       }
     }
 
-    if(RTIMER_CLOCK_LT(RTIMER_NOW() - cycle_start, CYCLE_TIME - CHECK_TIME * 4)) {
+    if(RTIMER_CLOCK_LT(RTIMER_NOW() - cycle_start, CURRENT_CYCLE_TIME - CHECK_TIME * 4)) {
       /* Schedule the next powercycle interrupt, or sleep the mcu
 	 until then.  Sleeping will not exit from this interrupt, so
 	 ensure an occasional wake cycle or foreground processing will
@@ -491,14 +617,14 @@ powercycle(struct rtimer *t, void *ptr)
 #if RDC_CONF_MCU_SLEEP
       static uint8_t sleepcycle;
       if((sleepcycle++ < 16) && !we_are_sending && !radio_is_on) {
-        rtimer_arch_sleep(CYCLE_TIME - (RTIMER_NOW() - cycle_start));
+        rtimer_arch_sleep(CURRENT_CYCLE_TIME - (RTIMER_NOW() - cycle_start));
       } else {
         sleepcycle = 0;
-        schedule_powercycle_fixed(t, CYCLE_TIME + cycle_start);
+        schedule_powercycle_fixed(t, CURRENT_CYCLE_TIME + cycle_start);
         PT_YIELD(&pt);
       }
 #else
-      schedule_powercycle_fixed(t, CYCLE_TIME + cycle_start);
+      schedule_powercycle_fixed(t, CURRENT_CYCLE_TIME + cycle_start);
       PT_YIELD(&pt);
 #endif
     }
@@ -549,6 +675,9 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
   int len;
   uint8_t seqno;
 #endif
+#if CONTIKIMAC_WITH_STATS
+  unsigned long radio_time;
+#endif
   
   /* Exit if RDC and radio were explicitly turned off */
    if(!contikimac_is_on && !contikimac_keep_radio_on) {
@@ -607,6 +736,7 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
                      CYCLE_TIME, GUARD_TIME,
                      mac_callback, mac_callback_ptr, buf_list);
     if(ret == PHASE_DEFERRED) {
+      CONTIKIMAC_STATS_ADD(phase_deferred);
       return MAC_TX_DEFERRED;
     }
     if(ret != PHASE_UNKNOWN) {
@@ -637,6 +767,11 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
      the radio was doing a channel check. */
   off();
 
+#if CONTIKIMAC_WITH_STATS
+  radio_time = energest_type_time(ENERGEST_TYPE_TRANSMIT) +
+    energest_type_time(ENERGEST_TYPE_LISTEN);
+#endif
+
 
   strobes = 0;
 
@@ -803,6 +938,26 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
     ret = MAC_TX_OK;
   }
 
+#if CONTIKIMAC_WITH_STATS
+  if(!is_broadcast) {
+    contikimac_stats.unicast_tx++;
+    contikimac_stats.unicast_strobes += strobes;
+    if(got_strobe_ack) {
+      contikimac_stats.unicast_ok++;
+      contikimac_stats.unicast_ok_radio_time +=
+        energest_type_time(ENERGEST_TYPE_TRANSMIT) +
+        energest_type_time(ENERGEST_TYPE_LISTEN) - radio_time;
+    }
+    if(is_known_receiver && collisions == 0) {
+      if(got_strobe_ack) {
+        contikimac_stats.phase_hits++;
+      } else {
+        contikimac_stats.phase_misses++;
+      }
+    }
+  }
+#endif /* CONTIKIMAC_WITH_STATS */
+
 #if WITH_PHASE_OPTIMIZATION
   if(is_known_receiver && got_strobe_ack) {
     PRINTF("no miss %d wake-ups %d\n",
@@ -812,7 +967,7 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
 
   if(!is_broadcast) {
     if(collisions == 0 && is_receiver_awake == 0) {
-      phase_update(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+      phase_update(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), CYCLE_TIME,
 		   encounter_time, ret);
     }
   }
@@ -821,6 +976,35 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
   return ret;
 }
 /*---------------------------------------------------------------------------*/
+#if WITH_BURST
+/* Returns non-zero if a unicast to receiver continues a burst, in
+   which case its frame should be sent with FRAME_PENDING set */
+static int
+burst_is_active(const linkaddr_t *receiver)
+{
+  return linkaddr_cmp(receiver, &burst_receiver) &&
+    clock_time() - burst_last_tx < BURST_DETECT_TIME;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if receiver is expected to still be awake after the
+   previous frame of a burst. We allow for half of the receiver's
+   INTER_PACKET_DEADLINE to account for the ctimer granularity. */
+static int
+burst_receiver_is_awake(const linkaddr_t *receiver)
+{
+  return burst_receiver_awake && linkaddr_cmp(receiver, &burst_receiver) &&
+    clock_time() - burst_last_tx < INTER_PACKET_DEADLINE / 2;
+}
+/*---------------------------------------------------------------------------*/
+static void
+burst_update(const linkaddr_t *receiver, int pending, int status)
+{
+  linkaddr_copy(&burst_receiver, receiver);
+  burst_last_tx = clock_time();
+  burst_receiver_awake = pending && status == MAC_TX_OK;
+}
+#endif /* WITH_BURST */
+/*---------------------------------------------------------------------------*/
 static void
 qsend_packet(mac_callback_t sent, void *ptr)
 {
@@ -838,6 +1022,10 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
   int ret;
   int is_receiver_awake;
   int pending;
+#if WITH_BURST
+  int is_burst;
+  linkaddr_t receiver;
+#endif /* WITH_BURST */
   
   if(buf_list == NULL) {
     return;
@@ -851,6 +1039,12 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
     return;
   }
   
+#if WITH_BURST
+  linkaddr_copy(&receiver, queuebuf_addr(buf_list->buf, PACKETBUF_ADDR_RECEIVER));
+  is_burst = !linkaddr_cmp(&receiver, &linkaddr_null) &&
+    burst_is_active(&receiver);
+#endif /* WITH_BURST */
+
   /* Create and secure frames in advance */
   curr = buf_list;
   do {
@@ -858,9 +1052,17 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
     queuebuf_to_packetbuf(curr->buf);
     if(!packetbuf_attr(PACKETBUF_ATTR_IS_CREATED_AND_SECURED)) {
       /* create and secure this frame */
+#if WITH_BURST
+      /* In a burst, the last frame also has FRAME_PENDING set so that
+         the receiver stays awake for the frames that will follow */
+      if(next != NULL || is_burst) {
+        packetbuf_set_attr(PACKETBUF_ATTR_PENDING, 1);
+      }
+#else /* WITH_BURST */
       if(next != NULL) {
         packetbuf_set_attr(PACKETBUF_ATTR_PENDING, 1);
       }
+#endif /* WITH_BURST */
       packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
       if(NETSTACK_FRAMER.create() < 0) {
         PRINTF("contikimac: framer failed\n");
@@ -874,8 +1076,13 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
     curr = next;
   } while(next != NULL);
   
-  /* The receiver needs to be awoken before we send */
+  /* The receiver needs to be awoken before we send, unless it is still
+     awake from the previous frame of a burst */
+#if WITH_BURST
+  is_receiver_awake = burst_receiver_is_awake(&receiver);
+#else /* WITH_BURST */
   is_receiver_awake = 0;
+#endif /* WITH_BURST */
   curr = buf_list;
   do { /* A loop sending a burst of packets from buf_list */
     next = list_item_next(curr);
@@ -887,6 +1094,11 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
 
     /* Send the current packet */
     ret = send_packet(sent, ptr, curr, is_receiver_awake);
+#if WITH_BURST
+    if(ret != MAC_TX_DEFERRED && !packetbuf_holds_broadcast()) {
+      burst_update(&receiver, pending, ret);
+    }
+#endif /* WITH_BURST */
     if(ret != MAC_TX_DEFERRED) {
       mac_call_sent_callback(sent, ptr, ret, 1);
     }
@@ -920,14 +1132,6 @@ input_packet(void)
   static struct ctimer ct;
   int duplicate = 0;
 
-#if CONTIKIMAC_SEND_SW_ACK
-  int original_datalen;
-  uint8_t *original_dataptr;
-
-  original_datalen = packetbuf_datalen();
-  original_dataptr = packetbuf_dataptr();
-#endif
-
   if(!we_are_receiving_burst) {
     off();
   }
@@ -949,6 +1153,10 @@ input_packet(void)
       /* This is a regular packet that is destined to us or to the
          broadcast address. */
 
+#if WITH_ADAPTIVE_CCR
+      ccr_traffic_seen = 1;
+#endif /* WITH_ADAPTIVE_CCR */
+
       /* If FRAME_PENDING is set, we are receiving a packets in a burst */
       we_are_receiving_burst = packetbuf_attr(PACKETBUF_ATTR_PENDING);
       if(we_are_receiving_burst) {
@@ -989,22 +1197,20 @@ input_packet(void)
       PRINTDEBUG("contikimac: data (%u)\n", packetbuf_datalen());
 
 #if CONTIKIMAC_SEND_SW_ACK
-      {
-        frame802154_t info154;
-        frame802154_parse(original_dataptr, original_datalen, &info154);
-        if(info154.fcf.frame_type == FRAME802154_DATAFRAME &&
-            info154.fcf.ack_required != 0 &&
-            linkaddr_cmp((linkaddr_t *)&info154.dest_addr,
-                &linkaddr_node_addr)) {
-          uint8_t ackdata[ACK_LEN] = {0, 0, 0};
-
-          we_are_sending = 1;
-          ackdata[0] = FRAME802154_ACKFRAME;
-          ackdata[1] = 0;
-          ackdata[2] = info154.seq;
-          NETSTACK_RADIO.send(ackdata, ACK_LEN);
-          we_are_sending = 0;
-        }
+      /* The framer has already parsed the header into packetbuf
+         attributes, no need to parse it again */
+      if(packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME &&
+         packetbuf_attr(PACKETBUF_ATTR_MAC_ACK) != 0 &&
+         linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                      &linkaddr_node_addr)) {
+        uint8_t ackdata[ACK_LEN] = {0, 0, 0};
+
+        we_are_sending = 1;
+        ackdata[0] = FRAME802154_ACKFRAME;
+        ackdata[1] = 0;
+        ackdata[2] = (uint8_t)packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+        NETSTACK_RADIO.send(ackdata, ACK_LEN);
+        we_are_sending = 0;
       }
 #endif /* CONTIKIMAC_SEND_SW_ACK */
 
@@ -46,4 +46,41 @@
 
 extern const struct rdc_driver contikimac_driver;
 
+#ifdef CONTIKIMAC_CONF_WITH_STATS
+#define CONTIKIMAC_WITH_STATS CONTIKIMAC_CONF_WITH_STATS
+#else /* CONTIKIMAC_CONF_WITH_STATS */
+#define CONTIKIMAC_WITH_STATS 0
+#endif /* CONTIKIMAC_CONF_WITH_STATS */
+
+/**
+ * ContikiMAC transmission statistics. The radio time is taken from
+ * the energest TRANSMIT and LISTEN counters, in rtimer ticks, and is
+ * only accounted for when ENERGEST_CONF_ON is set.
+ */
+struct contikimac_stats {
+  /** Number of unicast transmissions that were attempted */
+  unsigned long unicast_tx;
+  /** Number of unicast transmissions that were acknowledged */
+  unsigned long unicast_ok;
+  /** Total number of strobes sent for unicast transmissions */
+  unsigned long unicast_strobes;
+  /** Unicast transmissions to a neighbor with a known phase that were
+      acknowledged, not counting those that ran into a collision */
+  unsigned long phase_hits;
+  /** Unicast transmissions to a neighbor with a known phase that were
+      not acknowledged, not counting those that ran into a collision */
+  unsigned long phase_misses;
+  /** Transmissions deferred until the expected phase of the neighbor */
+  unsigned long phase_deferred;
+  /** Radio-on time spent on acknowledged unicast transmissions */
+  unsigned long unicast_ok_radio_time;
+};
+
+#if CONTIKIMAC_WITH_STATS
+extern struct contikimac_stats contikimac_stats;
+#define CONTIKIMAC_STATS_ADD(x) contikimac_stats.x++
+#else /* CONTIKIMAC_WITH_STATS */
+#define CONTIKIMAC_STATS_ADD(x)
+#endif /* CONTIKIMAC_WITH_STATS */
+
 #endif /* CONTIKIMAC_H */
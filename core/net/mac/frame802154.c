@@ -452,6 +452,30 @@ frame802154_create(frame802154_t *p, uint8_t *buf)
   return (int)pos;
 }
 /*----------------------------------------------------------------------------*/
+/**
+ *   \brief Decodes the Frame Control Field of a frame. This is all
+ *   that is needed to find out the type, version, or addressing modes
+ *   of a frame, without parsing the whole header.
+ *
+ *   \param data The input data from the radio chip, at least 2 bytes long.
+ *   \param pfcf The frame802154_fcf_t struct to store the decoded FCF.
+ */
+void
+frame802154_parse_fcf(uint8_t *data, frame802154_fcf_t *pfcf)
+{
+  pfcf->frame_type = data[0] & 7;
+  pfcf->security_enabled = (data[0] >> 3) & 1;
+  pfcf->frame_pending = (data[0] >> 4) & 1;
+  pfcf->ack_required = (data[0] >> 5) & 1;
+  pfcf->panid_compression = (data[0] >> 6) & 1;
+
+  pfcf->sequence_number_suppression = data[1] & 1;
+  pfcf->ie_list_present = (data[1] >> 1) & 1;
+  pfcf->dest_addr_mode = (data[1] >> 2) & 3;
+  pfcf->frame_version = (data[1] >> 4) & 3;
+  pfcf->src_addr_mode = (data[1] >> 6) & 3;
+}
+/*----------------------------------------------------------------------------*/
 /**
  *   \brief Parses an input frame.  Scans the input frame to find each
  *   section, and stores the information of each section in a
@@ -480,17 +504,7 @@ frame802154_parse(uint8_t *data, int len, frame802154_t *pf)
   p = data;
 
   /* decode the FCF */
-  fcf.frame_type = p[0] & 7;
-  fcf.security_enabled = (p[0] >> 3) & 1;
-  fcf.frame_pending = (p[0] >> 4) & 1;
-  fcf.ack_required = (p[0] >> 5) & 1;
-  fcf.panid_compression = (p[0] >> 6) & 1;
-
-  fcf.sequence_number_suppression = p[1] & 1;
-  fcf.ie_list_present = (p[1] >> 1) & 1;
-  fcf.dest_addr_mode = (p[1] >> 2) & 3;
-  fcf.frame_version = (p[1] >> 4) & 3;
-  fcf.src_addr_mode = (p[1] >> 6) & 3;
+  frame802154_parse_fcf(p, &fcf);
 
   /* copy fcf and seqNum */
   memcpy(&pf->fcf, &fcf, sizeof(frame802154_fcf_t));
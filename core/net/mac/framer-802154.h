@@ -40,7 +40,18 @@
 #define FRAMER_802154_H_
 
 #include "net/mac/framer.h"
+#include "net/mac/frame802154.h"
 
 extern const struct framer framer_802154;
 
+/**
+ * \brief Hands over the header of the frame in packetbuf, already
+ *        parsed by frame802154_parse(), so that the next call to
+ *        framer_802154.parse() does not parse it again. Must be
+ *        called after the frame is copied into packetbuf.
+ * \param frame The parsed header
+ * \param hdr_len The header length returned by frame802154_parse()
+ */
+void framer_802154_set_parsed(const frame802154_t *frame, int hdr_len);
+
 #endif /* FRAMER_802154_H_ */
@@ -265,14 +265,6 @@ send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
 static void
 packet_input(void)
 {
-#if NULLRDC_SEND_802154_ACK
-  int original_datalen;
-  uint8_t *original_dataptr;
-
-  original_datalen = packetbuf_datalen();
-  original_dataptr = packetbuf_dataptr();
-#endif
-
 #if NULLRDC_802154_AUTOACK
   if(packetbuf_datalen() == ACK_LEN) {
     /* Ignore ack packets */
@@ -305,20 +297,18 @@ packet_input(void)
 #endif /* NULLRDC_802154_AUTOACK */
  
 #if NULLRDC_SEND_802154_ACK
-    {
-      frame802154_t info154;
-      frame802154_parse(original_dataptr, original_datalen, &info154);
-      if(info154.fcf.frame_type == FRAME802154_DATAFRAME &&
-         info154.fcf.ack_required != 0 &&
-         linkaddr_cmp((linkaddr_t *)&info154.dest_addr,
-                      &linkaddr_node_addr)) {
-        uint8_t ackdata[ACK_LEN] = {0, 0, 0};
-
-        ackdata[0] = FRAME802154_ACKFRAME;
-        ackdata[1] = 0;
-        ackdata[2] = info154.seq;
-        NETSTACK_RADIO.send(ackdata, ACK_LEN);
-      }
+    /* The framer has already parsed the header into packetbuf
+       attributes, no need to parse it again */
+    if(packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME &&
+       packetbuf_attr(PACKETBUF_ATTR_MAC_ACK) != 0 &&
+       linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                    &linkaddr_node_addr)) {
+      uint8_t ackdata[ACK_LEN] = {0, 0, 0};
+
+      ackdata[0] = FRAME802154_ACKFRAME;
+      ackdata[1] = 0;
+      ackdata[2] = (uint8_t)packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+      NETSTACK_RADIO.send(ackdata, ACK_LEN);
     }
 #endif /* NULLRDC_SEND_ACK */
     if(!duplicate) {
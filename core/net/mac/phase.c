@@ -44,16 +44,32 @@
 #include "net/queuebuf.h"
 #include "net/nbr-table.h"
 
-#if PHASE_CONF_DRIFT_CORRECT
+#ifdef PHASE_CONF_DRIFT_CORRECT
 #define PHASE_DRIFT_CORRECT PHASE_CONF_DRIFT_CORRECT
 #else
-#define PHASE_DRIFT_CORRECT 0
+#define PHASE_DRIFT_CORRECT 1
+#endif
+
+/* The drift estimate is kept in fixed point, in 1/PHASE_DRIFT_SCALE
+   rtimer ticks per cycle, since the drift between two crystals is
+   typically well below one rtimer tick per cycle. */
+#define PHASE_DRIFT_SCALE      256
+
+/* Only intervals spanning at least PHASE_DRIFT_MIN_CYCLES cycles are
+   used to estimate the drift. Over shorter intervals, the jitter of
+   the strobe that got acknowledged dominates the measured offset. */
+#ifdef PHASE_CONF_DRIFT_MIN_CYCLES
+#define PHASE_DRIFT_MIN_CYCLES PHASE_CONF_DRIFT_MIN_CYCLES
+#else
+#define PHASE_DRIFT_MIN_CYCLES 8
 #endif
 
 struct phase {
   rtimer_clock_t time;
 #if PHASE_DRIFT_CORRECT
-  rtimer_clock_t drift;
+  clock_time_t sync_clock;
+  int16_t drift;
+  uint8_t drift_samples;
 #endif
   uint8_t noacks;
   struct timer noacks_timer;
@@ -77,6 +93,9 @@ struct phase_queueitem {
 MEMB(queued_packets_memb, struct phase_queueitem, PHASE_QUEUESIZE);
 NBR_TABLE(struct phase, nbr_phase);
 
+/* Non-zero while a deferred packet is being sent */
+static uint8_t sending_deferred;
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -87,9 +106,76 @@ NBR_TABLE(struct phase, nbr_phase);
 #define PRINTDEBUG(...)
 #endif
 /*---------------------------------------------------------------------------*/
+#if PHASE_DRIFT_CORRECT
+/* Number of cycles that have elapsed since the phase was last
+   synchronized. The rtimer may wrap several times over long
+   intervals, so the count is derived from the clock instead. */
+static uint32_t
+cycles_since_sync(const struct phase *e, rtimer_clock_t cycle_time)
+{
+  clock_time_t elapsed;
+  uint32_t rate;
+
+  elapsed = clock_time() - e->sync_clock;
+  rate = RTIMER_ARCH_SECOND / cycle_time;
+  return ((uint32_t)elapsed * rate + CLOCK_SECOND / 2) / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+/* The accumulated drift, in rtimer ticks, that we expect since the
+   phase was last synchronized. */
+static int32_t
+expected_drift(const struct phase *e, rtimer_clock_t cycle_time)
+{
+  if(e->drift_samples == 0) {
+    return 0;
+  }
+  return (int32_t)e->drift * (int32_t)cycles_since_sync(e, cycle_time) /
+    PHASE_DRIFT_SCALE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_drift(struct phase *e, rtimer_clock_t time, rtimer_clock_t cycle_time)
+{
+  uint32_t cycles;
+  int32_t offset, sample;
+
+  cycles = cycles_since_sync(e, cycle_time);
+  if(cycles < PHASE_DRIFT_MIN_CYCLES) {
+    return;
+  }
+
+  /* The offset between the new phase and the old one, folded into
+     [-cycle_time / 2, cycle_time / 2). */
+  if(!(cycle_time & (cycle_time - 1))) {
+    offset = (rtimer_clock_t)(time - e->time) & (cycle_time - 1);
+  } else {
+    offset = (rtimer_clock_t)(time - e->time) % cycle_time;
+  }
+  if(offset >= cycle_time / 2) {
+    offset -= cycle_time;
+  }
+
+  sample = offset * PHASE_DRIFT_SCALE / (int32_t)cycles;
+  if(sample > 32767) {
+    sample = 32767;
+  } else if(sample < -32768) {
+    sample = -32768;
+  }
+
+  /* Exponentially weighted moving average, with alpha = 1/4, once we
+     have a first sample. */
+  if(e->drift_samples == 0) {
+    e->drift = sample;
+    e->drift_samples = 1;
+  } else {
+    e->drift = (int16_t)(((int32_t)e->drift * 3 + sample) / 4);
+  }
+}
+#endif /* PHASE_DRIFT_CORRECT */
+/*---------------------------------------------------------------------------*/
 void
-phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
-             int mac_status)
+phase_update(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
+             rtimer_clock_t time, int mac_status)
 {
   struct phase *e;
 
@@ -98,7 +184,8 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
   if(e != NULL) {
     if(mac_status == MAC_TX_OK) {
 #if PHASE_DRIFT_CORRECT
-      e->drift = time-e->time;
+      update_drift(e, time, cycle_time);
+      e->sync_clock = clock_time();
 #endif
       e->time = time;
     }
@@ -126,9 +213,11 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
       if(e) {
         e->time = time;
 #if PHASE_DRIFT_CORRECT
-      e->drift = 0;
+        e->sync_clock = clock_time();
+        e->drift = 0;
+        e->drift_samples = 0;
 #endif
-      e->noacks = 0;
+        e->noacks = 0;
       }
     }
   }
@@ -139,6 +228,7 @@ send_packet(void *ptr)
 {
   struct phase_queueitem *p = ptr;
 
+  sending_deferred = 1;
   if(p->buf_list == NULL) {
     queuebuf_to_packetbuf(p->q);
     queuebuf_free(p->q);
@@ -146,6 +236,7 @@ send_packet(void *ptr)
   } else {
     NETSTACK_RDC.send_list(p->mac_callback, p->mac_callback_ptr, p->buf_list);
   }
+  sending_deferred = 0;
 
   memb_free(&queued_packets_memb, p);
 }
@@ -186,14 +277,9 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
     sync = (e == NULL) ? now : e->time;
 
 #if PHASE_DRIFT_CORRECT
-    {
-      int32_t s;
-      if(e->drift > cycle_time) {
-        s = e->drift % cycle_time / (e->drift / cycle_time);  /* drift per cycle */
-        s = s * (now - sync) / cycle_time;                    /* estimated drift to now */
-        sync += s;                                            /* add it in */
-      }
-    }
+    /* Move the expected phase by the drift we have accumulated since
+       we last heard from the neighbor. */
+    sync += (rtimer_clock_t)expected_drift(e, cycle_time);
 #endif
 
     /* Check if cycle_time is a power of two */
@@ -206,6 +292,14 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
     }
 
     if(wait < guard_time) {
+      /* A deferred packet is sent right away: its timer fires slightly
+         late whenever the clock is as fine as the rtimer, and waiting
+         for the next phase would defer it again and again. Otherwise,
+         we are too close to the phase to start with the full guard
+         time, and wait for the next one. */
+      if(sending_deferred) {
+        return PHASE_SEND_NOW;
+      }
       wait += cycle_time;
     }
 
@@ -345,21 +345,18 @@ tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offset)
   return 1;
 }
 /*---------------------------------------------------------------------------*/
-/* Parse a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
+/* Parse the Information Elements of an EB whose header was parsed
+ * already, by frame802154_parse, into frame. frame_hdr_len is the value
+ * frame802154_parse returned. */
 int
-tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
-    frame802154_t *frame, struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
+tsch_packet_parse_eb_ies(const uint8_t *buf, int buf_size,
+    const frame802154_t *frame, int frame_hdr_len,
+    struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
 {
   uint8_t curr_len = 0;
   int ret;
 
-  if(frame == NULL || buf_size < 0) {
-    return 0;
-  }
-
-  /* Parse 802.15.4-2006 frame, i.e. all fields before Information Elements */
-  if((ret = frame802154_parse((uint8_t *)buf, buf_size, frame)) == 0) {
-    PRINTF("TSCH:! parse_eb: failed to parse frame\n");
+  if(frame == NULL || buf_size < 0 || frame_hdr_len == 0) {
     return 0;
   }
 
@@ -376,9 +373,9 @@ tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
   }
 
   if(hdr_len != NULL) {
-    *hdr_len = ret;
+    *hdr_len = frame_hdr_len;
   }
-  curr_len += ret;
+  curr_len += frame_hdr_len;
 
   if(ies != NULL) {
     memset(ies, 0, sizeof(struct ieee802154_ies));
@@ -411,3 +408,23 @@ tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
   return curr_len;
 }
 /*---------------------------------------------------------------------------*/
+/* Parse a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
+int
+tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
+    frame802154_t *frame, struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
+{
+  int ret;
+
+  if(frame == NULL || buf_size < 0) {
+    return 0;
+  }
+
+  /* Parse 802.15.4-2006 frame, i.e. all fields before Information Elements */
+  if((ret = frame802154_parse((uint8_t *)buf, buf_size, frame)) == 0) {
+    PRINTF("TSCH:! parse_eb: failed to parse frame\n");
+    return 0;
+  }
+
+  return tsch_packet_parse_eb_ies(buf, buf_size, frame, ret, ies, hdr_len, frame_without_mic);
+}
+/*---------------------------------------------------------------------------*/
@@ -96,6 +96,10 @@ int tsch_packet_create_eb(uint8_t *buf, int buf_size,
     uint8_t seqno, uint8_t *hdr_len, uint8_t *tsch_sync_ie_ptr);
 /* Update ASN in EB packet */
 int tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offset);
+/* Parse the IEs of an EB whose header was parsed already */
+int tsch_packet_parse_eb_ies(const uint8_t *buf, int buf_size,
+    const frame802154_t *frame, int frame_hdr_len,
+    struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic);
 /* Parse EB and extract ASN and join priority */
 int tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
     frame802154_t *frame, struct ieee802154_ies *ies,
@@ -243,6 +243,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
             p->ptr = ptr;
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
+            p->is_static = 0;
             /* Add to ringbuf (actual add committed through atomic operation) */
             n->tx_array[put_index] = p;
             ringbufindex_put(&n->tx_ringbuf);
@@ -258,6 +259,35 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/* Add a static packet to neighbor queue, as tsch_queue_add_packet does, but
+ * with no memb or queuebuf allocation: the packet is reused by its creator */
+int
+tsch_queue_add_static_packet(const linkaddr_t *addr, struct tsch_packet *p)
+{
+  struct tsch_neighbor *n = NULL;
+  int16_t put_index = -1;
+  if(!tsch_is_locked() && p != NULL && p->qb != NULL) {
+    n = tsch_queue_add_nbr(addr);
+    if(n != NULL) {
+      put_index = ringbufindex_peek_put(&n->tx_ringbuf);
+      if(put_index != -1) {
+#ifdef TSCH_CALLBACK_PACKET_READY
+        TSCH_CALLBACK_PACKET_READY();
+#endif
+        p->ret = MAC_TX_DEFERRED;
+        p->transmissions = 0;
+        p->is_static = 1;
+        /* Add to ringbuf (actual add committed through atomic operation) */
+        n->tx_array[put_index] = p;
+        ringbufindex_put(&n->tx_ringbuf);
+        return 1;
+      }
+    }
+  }
+  PRINTF("TSCH-queue:! add static packet failed: %u %p %d %p\n", tsch_is_locked(), n, put_index, p);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 /* Returns the number of packets currently in the queue */
 int
 tsch_queue_packet_count(const linkaddr_t *addr)
@@ -294,7 +324,7 @@ tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n)
 void
 tsch_queue_free_packet(struct tsch_packet *p)
 {
-  if(p != NULL) {
+  if(p != NULL && !p->is_static) {
     queuebuf_free(p->qb);
     memb_free(&packet_memb, p);
   }
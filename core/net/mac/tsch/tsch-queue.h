@@ -120,6 +120,7 @@ struct tsch_packet {
   uint8_t ret; /* status -- MAC return code */
   uint8_t header_len; /* length of header and header IEs (needed for link-layer security) */
   uint8_t tsch_sync_ie_offset; /* Offset within the frame used for quick update of EB ASN and join priority */
+  uint8_t is_static; /* owned by its creator, which allocated its queuebuf: never freed by the queue */
 };
 
 /* TSCH neighbor information */
@@ -159,6 +160,9 @@ struct tsch_neighbor *tsch_queue_get_time_source(void);
 int tsch_queue_update_time_source(const linkaddr_t *new_addr);
 /* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic) */
 struct tsch_packet *tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr);
+/* Add a static packet, with its queuebuf already set, to a neighbor queue,
+ * without allocating anything. Returns 1 on success, 0 otherwise */
+int tsch_queue_add_static_packet(const linkaddr_t *addr, struct tsch_packet *p);
 /* Returns the number of packets currently a given neighbor queue */
 int tsch_queue_packet_count(const linkaddr_t *addr);
 /* Remove first packet from a neighbor queue. The packet is stored in a separate
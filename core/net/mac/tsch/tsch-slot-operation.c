@@ -791,6 +791,12 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
               tsch_schedule_keepalive();
             }
 
+            /* Keep the parsed header with the frame, so that it is not
+             * parsed again when the frame is processed */
+            current_input->frame = frame;
+            current_input->frame.payload_len = current_input->len - header_len;
+            current_input->hdr_len = header_len;
+
             /* Add current input to ringbuf */
             ringbufindex_put(&input_ringbuf);
 
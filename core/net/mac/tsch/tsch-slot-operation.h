@@ -90,6 +90,8 @@ struct input_packet {
   struct asn_t rx_asn; /* ASN when the packet was received */
   int len; /* Packet len */
   uint16_t rssi; /* RSSI for this packet */
+  frame802154_t frame; /* Header, as parsed at reception */
+  uint8_t hdr_len; /* Length of the parsed header */
 };
 
 /***** External Variables *****/
@@ -155,6 +155,24 @@ static clock_time_t tsch_current_eb_period;
 /* timer for sending keepalive messages */
 static struct ctimer keepalive_timer;
 
+/* Non-zero if the last keepalive was skipped because of queued packets */
+static uint8_t keepalive_skipped;
+
+#if TSCH_EB_WITH_TEMPLATE
+/* An EB created after association, whose queuebuf is kept and enqueued again
+ * for every EB we send, with only the sequence number patched in place.
+ * eb_template_valid is 0 when the EB needs to be (re-)created. */
+static struct tsch_packet eb_template;
+static uint8_t eb_template_valid;
+#define EB_TEMPLATE_INVALIDATE() (eb_template_valid = 0)
+#else /* TSCH_EB_WITH_TEMPLATE */
+#define EB_TEMPLATE_INVALIDATE()
+#endif /* TSCH_EB_WITH_TEMPLATE */
+
+#if TSCH_WITH_STATS
+struct tsch_stats tsch_stats;
+#endif /* TSCH_WITH_STATS */
+
 /* TSCH processes and protothreads */
 PT_THREAD(tsch_scan(struct pt *pt));
 PROCESS(tsch_process, "TSCH: main process");
@@ -172,12 +190,14 @@ tsch_set_coordinator(int enable)
 {
   tsch_is_coordinator = enable;
   tsch_set_eb_period(TSCH_EB_PERIOD);
+  EB_TEMPLATE_INVALIDATE();
 }
 /*---------------------------------------------------------------------------*/
 void
 tsch_set_pan_secured(int enable)
 {
   tsch_is_pan_secured = TSCH_SECURITY_ENABLED && enable;
+  EB_TEMPLATE_INVALIDATE();
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -212,6 +232,8 @@ tsch_reset(void)
   for(i = 0; i < tsch_ts_elements_count; i++) {
     tsch_timing[i] = US_TO_RTIMERTICKS(tsch_default_timing_us[i]);
   }
+  /* PAN ID, timing and hopping sequence may change at next association */
+  EB_TEMPLATE_INVALIDATE();
 #ifdef TSCH_CALLBACK_LEAVING_NETWORK
   TSCH_CALLBACK_LEAVING_NETWORK();
 #endif
@@ -243,6 +265,21 @@ keepalive_send()
 {
   if(tsch_is_associated) {
     struct tsch_neighbor *n = tsch_queue_get_time_source();
+    if(!keepalive_skipped && tsch_queue_packet_count(&n->addr) > 0) {
+      /* A packet to the time source is already queued, and its ACK will
+       * resynchronize us. Skip this keepalive, but not the next one in a
+       * row, in case that packet is not acknowledged. */
+      keepalive_skipped = 1;
+#if TSCH_WITH_STATS
+      tsch_stats.keepalives_skipped++;
+#endif /* TSCH_WITH_STATS */
+      tsch_schedule_keepalive();
+      return;
+    }
+    keepalive_skipped = 0;
+#if TSCH_WITH_STATS
+    tsch_stats.keepalives_sent++;
+#endif /* TSCH_WITH_STATS */
     /* Simply send an empty packet */
     packetbuf_clear();
     packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &n->addr);
@@ -265,24 +302,24 @@ tsch_schedule_keepalive()
 }
 /*---------------------------------------------------------------------------*/
 static void
-eb_input(struct input_packet *current_input)
+eb_input(struct input_packet *current_input, const frame802154_t *eb_frame, int hdr_len)
 {
   /* PRINTF("TSCH: EB received\n"); */
-  frame802154_t frame;
   /* Verify incoming EB (does its ASN match our Rx time?),
    * and update our join priority. */
   struct ieee802154_ies eb_ies;
 
-  if(tsch_packet_parse_eb(current_input->payload, current_input->len,
-                          &frame, &eb_ies, NULL, 1)) {
+  /* The header was parsed at rx time, only the IEs are left */
+  if(tsch_packet_parse_eb_ies(current_input->payload, current_input->len,
+                              eb_frame, hdr_len, &eb_ies, NULL, 1)) {
     /* PAN ID check and authentication done at rx time */
 
 #if TSCH_AUTOSELECT_TIME_SOURCE
     if(!tsch_is_coordinator) {
       /* Maintain EB received counter for every neighbor */
-      struct eb_stat *stat = (struct eb_stat *)nbr_table_get_from_lladdr(eb_stats, &frame.src_addr);
+      struct eb_stat *stat = (struct eb_stat *)nbr_table_get_from_lladdr(eb_stats, &eb_frame->src_addr);
       if(stat == NULL) {
-        stat = (struct eb_stat *)nbr_table_add_lladdr(eb_stats, &frame.src_addr);
+        stat = (struct eb_stat *)nbr_table_add_lladdr(eb_stats, &eb_frame->src_addr);
       }
       if(stat != NULL) {
         stat->rx_count++;
@@ -312,7 +349,7 @@ eb_input(struct input_packet *current_input)
 
     struct tsch_neighbor *n = tsch_queue_get_time_source();
     /* Did the EB come from our time source? */
-    if(n != NULL && linkaddr_cmp((linkaddr_t *)&frame.src_addr, &n->addr)) {
+    if(n != NULL && linkaddr_cmp((linkaddr_t *)&eb_frame->src_addr, &n->addr)) {
       /* Check for ASN drift */
       int32_t asn_diff = ASN_DIFF(current_input->rx_asn, eb_ies.ie_asn);
       if(asn_diff != 0) {
@@ -349,11 +386,13 @@ tsch_rx_process_pending()
   /* Loop on accessing (without removing) a pending input packet */
   while((input_index = ringbufindex_peek_get(&input_ringbuf)) != -1) {
     struct input_packet *current_input = &input_array[input_index];
-    frame802154_t frame;
-    uint8_t ret = frame802154_parse(current_input->payload, current_input->len, &frame);
-    int is_data = ret && frame.fcf.frame_type == FRAME802154_DATAFRAME;
-    int is_eb = ret
-      && frame.fcf.frame_version == FRAME802154_IEEE802154E_2012
+    /* The header was parsed and checked at rx time. Keep a copy, as the
+     * slot operation may reuse the input once it is removed from the
+     * ringbuf. */
+    frame802154_t frame = current_input->frame;
+    int hdr_len = current_input->hdr_len;
+    int is_data = frame.fcf.frame_type == FRAME802154_DATAFRAME;
+    int is_eb = frame.fcf.frame_version == FRAME802154_IEEE802154E_2012
       && frame.fcf.frame_type == FRAME802154_BEACONFRAME;
 
     if(is_data) {
@@ -361,6 +400,8 @@ tsch_rx_process_pending()
       /* Copy to packetbuf for processing */
       packetbuf_copyfrom(current_input->payload, current_input->len);
       packetbuf_set_attr(PACKETBUF_ATTR_RSSI, current_input->rssi);
+      /* Hand the parsed header over to the framer */
+      framer_802154_set_parsed(&frame, hdr_len);
     }
 
     /* Remove input from ringbuf */
@@ -370,7 +411,7 @@ tsch_rx_process_pending()
       /* Pass to upper layers */
       packet_input();
     } else if(is_eb) {
-      eb_input(current_input);
+      eb_input(current_input, &frame, hdr_len);
     }
   }
 }
@@ -574,6 +615,7 @@ tsch_associate(const struct input_packet *input_eb, rtimer_clock_t timestamp)
       /* Update global flags */
       tsch_is_associated = 1;
       tsch_is_pan_secured = frame.fcf.security_enabled;
+      EB_TEMPLATE_INVALIDATE();
 
       /* Association done, schedule keepalive messages */
       tsch_schedule_keepalive();
@@ -609,6 +651,13 @@ PT_THREAD(tsch_scan(struct pt *pt))
 
   static struct input_packet input_eb;
   static struct etimer scan_timer;
+#if TSCH_WITH_STATS
+  static clock_time_t scan_start;
+  static unsigned long scan_rx_count;
+
+  scan_start = clock_time();
+  scan_rx_count = 0;
+#endif /* TSCH_WITH_STATS */
 
   ASN_INIT(current_asn, 0, 0);
 
@@ -654,6 +703,9 @@ PT_THREAD(tsch_scan(struct pt *pt))
 
       /* Read packet */
       input_eb.len = NETSTACK_RADIO.read(input_eb.payload, TSCH_PACKET_MAX_LEN);
+#if TSCH_WITH_STATS
+      scan_rx_count++;
+#endif /* TSCH_WITH_STATS */
 
       /* Parse EB and attempt to associate */
       PRINTF("TSCH: association: received packet (%u bytes) on channel %u\n", input_eb.len, current_channel);
@@ -664,6 +716,13 @@ PT_THREAD(tsch_scan(struct pt *pt))
     if(tsch_is_associated) {
       /* End of association, turn the radio off */
       NETSTACK_RADIO.off();
+#if TSCH_WITH_STATS
+      tsch_stats.associations++;
+      tsch_stats.last_association_time = clock_time() - scan_start;
+      tsch_stats.last_association_rx_count = scan_rx_count;
+      PRINTF("TSCH: associated after %lu ticks, %lu packets received\n",
+             (unsigned long)tsch_stats.last_association_time, scan_rx_count);
+#endif /* TSCH_WITH_STATS */
     } else if(!tsch_is_coordinator) {
       /* Go back to scanning */
       etimer_reset(&scan_timer);
@@ -708,6 +767,32 @@ PROCESS_THREAD(tsch_process, ev, data)
   PROCESS_END();
 }
 
+/*---------------------------------------------------------------------------*/
+/* Create an EB with the current sequence number in packetbuf.
+ * Returns its length, or a negative value on failure */
+static int
+eb_create(uint8_t *hdr_len, uint8_t *tsch_sync_ie_offset)
+{
+  int eb_len;
+
+  packetbuf_clear();
+  packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_BEACONFRAME);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, tsch_packet_seqno);
+#if TSCH_SECURITY_ENABLED
+  if(tsch_is_pan_secured) {
+    /* Set security level, key id and index */
+    packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, TSCH_SECURITY_KEY_SEC_LEVEL_EB);
+    packetbuf_set_attr(PACKETBUF_ATTR_KEY_ID_MODE, FRAME802154_1_BYTE_KEY_ID_MODE); /* Use 1-byte key index */
+    packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX, TSCH_SECURITY_KEY_INDEX_EB);
+  }
+#endif /* TSCH_SECURITY_ENABLED */
+  eb_len = tsch_packet_create_eb(packetbuf_dataptr(), PACKETBUF_SIZE,
+      tsch_packet_seqno, hdr_len, tsch_sync_ie_offset);
+  if(eb_len > 0) {
+    packetbuf_set_datalen(eb_len);
+  }
+  return eb_len;
+}
 /*---------------------------------------------------------------------------*/
 /* A periodic process to send TSCH Enhanced Beacons (EB) */
 PROCESS_THREAD(tsch_send_eb_process, ev, data)
@@ -738,27 +823,57 @@ PROCESS_THREAD(tsch_send_eb_process, ev, data)
         int eb_len;
         uint8_t hdr_len = 0;
         uint8_t tsch_sync_ie_offset;
-        /* Prepare the EB packet and schedule it to be sent */
-        packetbuf_clear();
+#if TSCH_WITH_STATS
+        rtimer_clock_t eb_start = RTIMER_NOW();
+#endif /* TSCH_WITH_STATS */
         /* We don't use seqno 0 */
         if(++tsch_packet_seqno == 0) {
           tsch_packet_seqno++;
         }
-        packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_BEACONFRAME);
-        packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, tsch_packet_seqno);
-#if TSCH_SECURITY_ENABLED
-        if(tsch_is_pan_secured) {
-          /* Set security level, key id and index */
-          packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, TSCH_SECURITY_KEY_SEC_LEVEL_EB);
-          packetbuf_set_attr(PACKETBUF_ATTR_KEY_ID_MODE, FRAME802154_1_BYTE_KEY_ID_MODE); /* Use 1-byte key index */
-          packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX, TSCH_SECURITY_KEY_INDEX_EB);
+#if TSCH_EB_WITH_TEMPLATE
+        if(!eb_template_valid) {
+          /* (Re-)create the template, with all Information Elements, in a
+           * queuebuf that we keep */
+          queuebuf_free(eb_template.qb);
+          eb_template.qb = NULL;
+          eb_len = eb_create(&hdr_len, &tsch_sync_ie_offset);
+          if(eb_len > 0) {
+            eb_template.qb = queuebuf_new_from_packetbuf();
+            eb_template.sent = NULL;
+            eb_template.ptr = NULL;
+            eb_template.header_len = hdr_len;
+            eb_template.tsch_sync_ie_offset = tsch_sync_ie_offset;
+            eb_template_valid = eb_template.qb != NULL;
+          }
+#if TSCH_WITH_STATS
+          tsch_stats.eb_created++;
+#endif /* TSCH_WITH_STATS */
         }
-#endif /* TSCH_SECURITY_ENABLED */
-        eb_len = tsch_packet_create_eb(packetbuf_dataptr(), PACKETBUF_SIZE,
-            tsch_packet_seqno, &hdr_len, &tsch_sync_ie_offset);
-        if(eb_len != 0) {
+        if(eb_template_valid) {
+#if !FRAME802154_SUPPR_SEQNO
+          /* The sequence number follows the two-byte FCF. The EB is not in
+           * the queue, so the slot operation does not use it meanwhile */
+          ((uint8_t *)queuebuf_dataptr(eb_template.qb))[2] = tsch_packet_seqno;
+#endif /* !FRAME802154_SUPPR_SEQNO */
+          /* Enqueue the EB, without copying or allocating anything */
+          if(!tsch_queue_add_static_packet(&tsch_eb_address, &eb_template)) {
+            PRINTF("TSCH:! could not enqueue EB packet\n");
+          } else {
+            PRINTF("TSCH: enqueue EB packet %u %u\n",
+                   queuebuf_datalen(eb_template.qb), eb_template.header_len);
+#if TSCH_WITH_STATS
+            tsch_stats.eb_generated++;
+            tsch_stats.eb_generation_time += (rtimer_clock_t)(RTIMER_NOW() - eb_start);
+#endif /* TSCH_WITH_STATS */
+          }
+        }
+#else /* TSCH_EB_WITH_TEMPLATE */
+        eb_len = eb_create(&hdr_len, &tsch_sync_ie_offset);
+#if TSCH_WITH_STATS
+        tsch_stats.eb_created++;
+#endif /* TSCH_WITH_STATS */
+        if(eb_len > 0) {
           struct tsch_packet *p;
-          packetbuf_set_datalen(eb_len);
           /* Enqueue EB packet */
           if(!(p = tsch_queue_add_packet(&tsch_eb_address, NULL, NULL))) {
             PRINTF("TSCH:! could not enqueue EB packet\n");
@@ -766,8 +881,13 @@ PROCESS_THREAD(tsch_send_eb_process, ev, data)
             PRINTF("TSCH: enqueue EB packet %u %u\n", eb_len, hdr_len);
             p->tsch_sync_ie_offset = tsch_sync_ie_offset;
             p->header_len = hdr_len;
+#if TSCH_WITH_STATS
+            tsch_stats.eb_generated++;
+            tsch_stats.eb_generation_time += (rtimer_clock_t)(RTIMER_NOW() - eb_start);
+#endif /* TSCH_WITH_STATS */
           }
         }
+#endif /* TSCH_EB_WITH_TEMPLATE */
       }
     }
     if(tsch_current_eb_period > 0) {
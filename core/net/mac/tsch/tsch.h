@@ -38,6 +38,7 @@
 #include "contiki.h"
 #include "net/mac/mac.h"
 #include "net/mac/tsch/tsch-security.h"
+#include "net/mac/tsch/tsch-packet.h"
 
 /******** Configuration *******/
 
@@ -130,6 +131,47 @@
 #define TSCH_AUTOSELECT_TIME_SOURCE 0
 #endif /* TSCH_CONF_EB_AUTOSELECT */
 
+/* Build EBs from a template that is created once after association, rather
+ * than creating all Information Elements for every EB. The template keeps its
+ * queuebuf and is enqueued again for every EB, without any allocation or copy,
+ * which takes one queuebuf for good. ASN and join priority are patched in at
+ * transmission time as for any EB. Off by default. Ignored
+ * with the slotframe and link IE, whose content follows the schedule. */
+#ifdef TSCH_CONF_EB_WITH_TEMPLATE
+#define TSCH_EB_WITH_TEMPLATE \
+  (TSCH_CONF_EB_WITH_TEMPLATE && !TSCH_PACKET_EB_WITH_SLOTFRAME_AND_LINK)
+#else
+#define TSCH_EB_WITH_TEMPLATE 0
+#endif
+
+/* Collect statistics on EB generation, keepalives and association, see struct tsch_stats */
+#ifdef TSCH_CONF_WITH_STATS
+#define TSCH_WITH_STATS TSCH_CONF_WITH_STATS
+#else
+#define TSCH_WITH_STATS 0
+#endif
+
+/*********** Statistics *********/
+
+struct tsch_stats {
+  /* Number of EBs enqueued for transmission */
+  unsigned long eb_generated;
+  /* Number of times all EB Information Elements were created */
+  unsigned long eb_created;
+  /* Total time spent preparing and enqueuing EBs, in rtimer ticks */
+  unsigned long eb_generation_time;
+  /* Number of associations */
+  unsigned long associations;
+  /* Time from the start of the last scan to association, in clock ticks */
+  clock_time_t last_association_time;
+  /* Number of packets received during the last scan */
+  unsigned long last_association_rx_count;
+  /* Number of keepalives sent, and skipped because a packet to the time
+   * source was queued */
+  unsigned long keepalives_sent;
+  unsigned long keepalives_skipped;
+};
+
 /*********** Callbacks *********/
 
 /* Called by TSCH when joining a network */
@@ -152,6 +194,10 @@ extern int tsch_is_associated;
 extern int tsch_is_pan_secured;
 /* The TSCH MAC driver */
 extern const struct mac_driver tschmac_driver;
+#if TSCH_WITH_STATS
+/* TSCH statistics */
+extern struct tsch_stats tsch_stats;
+#endif /* TSCH_WITH_STATS */
 
 /********** Functions *********/
 
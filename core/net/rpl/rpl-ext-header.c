@@ -193,6 +193,18 @@ set_rpl_opt(unsigned uip_ext_opt_offset)
   }
 }
 /*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+dest_route_lookup(void)
+{
+#if UIP_DS6_FLOW_NB > 0
+  /* The outcome is kept in the flow cache, and for tcpip_ipv6_output()
+     when the packet is forwarded. */
+  return uip_ds6_flow_route_lookup();
+#else /* UIP_DS6_FLOW_NB > 0 */
+  return uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
+#endif /* UIP_DS6_FLOW_NB > 0 */
+}
+/*---------------------------------------------------------------------------*/
 int
 rpl_update_header_empty(void)
 {
@@ -254,9 +266,13 @@ rpl_update_header_empty(void)
        general not go back up again. If this happens, a
        RPL_HDR_OPT_FWD_ERR should be flagged. */
     if((UIP_EXT_HDR_OPT_RPL_BUF->flags & RPL_HDR_OPT_DOWN)) {
-      if(uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr) == NULL) {
+      if(dest_route_lookup() == NULL) {
         UIP_EXT_HDR_OPT_RPL_BUF->flags |= RPL_HDR_OPT_FWD_ERR;
         PRINTF("RPL forwarding error\n");
+#if UIP_DS6_FLOW_NB > 0
+        /* The packet is dropped before the DAO below is sent */
+        uip_ds6_flow_done();
+#endif /* UIP_DS6_FLOW_NB > 0 */
         /* We should send back the packet to the originating parent,
            but it is not feasible yet, so we send a No-Path DAO instead */
         PRINTF("RPL generate No-Path DAO\n");
@@ -271,7 +287,7 @@ rpl_update_header_empty(void)
       /* Set the down extension flag correctly as described in Section
          11.2 of RFC6550. If the packet progresses along a DAO route,
          the down flag should be set. */
-      if(uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr) == NULL) {
+      if(dest_route_lookup() == NULL) {
         /* No route was found, so this packet will go towards the RPL
            root. If so, we should not set the down flag. */
         UIP_EXT_HDR_OPT_RPL_BUF->flags &= ~RPL_HDR_OPT_DOWN;
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Bytes copied and time per request for parsing a CoAP request
+ *         and serializing its response, on the native platform.
+ *
+ *         Each request is a GET with a token, three Uri-Path segments,
+ *         a Uri-Query, Accept, and Block2. The response has a token,
+ *         an ETag, Content-Format, Max-Age, Block2, and a payload that
+ *         the handler writes into the transaction buffer, behind the
+ *         space for the header, as with the REST engine.
+ *
+ *         The program compares:
+ *         - the engine path, coap_parse_message() and
+ *           coap_serialize_message(), which moves the payload down to
+ *           the header,
+ *         - the engine path with coap_serialize_message_in_place(),
+ *           which writes the header back to front, ending in front of
+ *           the payload, as the engine does for its responses,
+ *         - a streaming path, which reads the request with the option
+ *           iterator and writes the response with coap_writer_t.
+ *
+ *         Copied bytes are counted by wrapping memcpy() and memmove()
+ *         at link time (see the Makefile), and only counted when they
+ *         are read from one of the two message buffers. Writing option
+ *         values from the application into the response is the
+ *         serialization itself and is not counted. Build with COPIES=0
+ *         to time the paths without the wrappers. The paths take turns
+ *         over TRIALS trials, and the fastest trial of each counts.
+ *
+ *         Arguments: payload=<n>, the response payload size in bytes
+ *         (default and at most REST_MAX_CHUNK_SIZE), rounds=<n>, the
+ *         number of requests timed (default 1000000)
+ */
+
+#include "contiki.h"
+#include "er-coap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static uint8_t request_buf[COAP_MAX_PACKET_SIZE + 1];
+static uint8_t response_buf[COAP_MAX_PACKET_SIZE + 1];
+static uint8_t request[COAP_MAX_PACKET_SIZE + 1];
+static size_t request_len;
+static int payload_len = REST_MAX_CHUNK_SIZE;
+
+/* Each path is timed this many times, and the fastest time counts */
+#define TRIALS 5
+
+static const uint8_t token[] = { 0xca, 0xfe, 0x00, 0x01 };
+static const uint8_t etag[] = { 0x12, 0x34 };
+
+static unsigned long copied;
+/*---------------------------------------------------------------------------*/
+#if COPIES
+static int
+in_message(const void *p)
+{
+  const uint8_t *b = p;
+
+  return (b >= request_buf && b < request_buf + sizeof(request_buf)) ||
+    (b >= response_buf && b < response_buf + sizeof(response_buf));
+}
+
+void *__real_memcpy(void *dst, const void *src, size_t n);
+void *__real_memmove(void *dst, const void *src, size_t n);
+
+void *
+__wrap_memcpy(void *dst, const void *src, size_t n)
+{
+  if(in_message(src)) {
+    copied += n;
+  }
+  return __real_memcpy(dst, src, n);
+}
+void *
+__wrap_memmove(void *dst, const void *src, size_t n)
+{
+  if(in_message(src)) {
+    copied += n;
+  }
+  return __real_memmove(dst, src, n);
+}
+#else /* COPIES */
+#define __real_memcpy memcpy
+#endif /* COPIES */
+/*---------------------------------------------------------------------------*/
+/* Builds the request with the streaming writer */
+static void
+make_request(void)
+{
+  coap_writer_t writer;
+
+  coap_writer_init(&writer, request, sizeof(request));
+  coap_writer_header(&writer, COAP_TYPE_CON, COAP_GET, 0x1234,
+                     token, sizeof(token));
+  coap_writer_array_option(&writer, COAP_OPTION_URI_PATH,
+                           (const uint8_t *)"sensors/temperature/avg", 23,
+                           '/');
+  coap_writer_array_option(&writer, COAP_OPTION_URI_QUERY,
+                           (const uint8_t *)"unit=c", 6, '&');
+  coap_writer_int_option(&writer, COAP_OPTION_ACCEPT,
+                         REST.type.APPLICATION_JSON);
+  coap_writer_int_option(&writer, COAP_OPTION_BLOCK2, 0x02);
+  request_len = writer.len;
+  if(writer.error) {
+    printf("request: FAILED\n");
+    exit(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* What a resource handler writes, straight into the transaction buffer.
+   This is not a copy made by the CoAP code, so it is not counted. */
+static void
+write_payload(uint8_t *payload)
+{
+  static uint8_t data[REST_MAX_CHUNK_SIZE];
+
+  if(data[0] == 0) {
+    memset(data, '0', sizeof(data));
+  }
+  __real_memcpy(payload, data, payload_len);
+}
+/*---------------------------------------------------------------------------*/
+/* The engine: parse the request, let the handler fill in the response,
+   serialize it. Returns the length, with the start in *offset. */
+static size_t
+engine_path(int in_place, uint16_t *offset)
+{
+  static coap_packet_t message[1];
+  static coap_packet_t response[1];
+  uint8_t *payload = response_buf + COAP_MAX_HEADER_SIZE;
+  const char *path;
+  size_t len;
+
+  /* The request arrives in the receive buffer */
+  __real_memcpy(request_buf, request, request_len);
+
+  if(coap_parse_message(message, request_buf, request_len) != NO_ERROR ||
+     coap_get_header_uri_path(message, &path) != 23) {
+    return 0;
+  }
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, message->mid);
+  coap_set_token(response, message->token, message->token_len);
+
+  write_payload(payload);
+  coap_set_header_etag(response, etag, sizeof(etag));
+  coap_set_header_content_format(response, REST.type.APPLICATION_JSON);
+  coap_set_header_max_age(response, 30);
+  coap_set_header_block2(response, 0, 1, 64);
+  coap_set_payload(response, payload, payload_len);
+
+  *offset = 0;
+  if(in_place) {
+    len = coap_serialize_message_in_place(response, response_buf, offset);
+  } else {
+    len = coap_serialize_message(response, response_buf);
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the request with the option iterator and writes the response
+   with the streaming writer, payload last */
+static size_t
+streaming_path(uint16_t *offset)
+{
+  coap_option_iterator_t it;
+  coap_writer_t writer;
+  uint8_t *payload;
+  unsigned int accept = 0;
+  int segments = 0;
+  int ret;
+
+  __real_memcpy(request_buf, request, request_len);
+
+  if(coap_option_iterator_init(&it, request_buf, request_len) != NO_ERROR) {
+    return 0;
+  }
+  while((ret = coap_option_iterator_next(&it)) > 0) {
+    if(it.number == COAP_OPTION_URI_PATH) {
+      segments++;
+    } else if(it.number == COAP_OPTION_ACCEPT && it.length == 1) {
+      accept = it.value[0];
+    }
+  }
+  if(ret < 0 || segments != 3 || accept != REST.type.APPLICATION_JSON) {
+    return 0;
+  }
+
+  *offset = 0;
+  coap_writer_init(&writer, response_buf, sizeof(response_buf));
+  coap_writer_header(&writer, COAP_TYPE_ACK, CONTENT_2_05,
+                     request_buf[2] << 8 | request_buf[3],
+                     request_buf + COAP_HEADER_LEN,
+                     request_buf[0] & COAP_HEADER_TOKEN_LEN_MASK);
+  coap_writer_array_option(&writer, COAP_OPTION_ETAG, etag, sizeof(etag),
+                           '\0');
+  coap_writer_int_option(&writer, COAP_OPTION_CONTENT_FORMAT,
+                         REST.type.APPLICATION_JSON);
+  coap_writer_int_option(&writer, COAP_OPTION_MAX_AGE, 30);
+  coap_writer_int_option(&writer, COAP_OPTION_BLOCK2, 0x0a);
+  payload = coap_writer_payload(&writer);
+  if(payload == NULL || writer.len + payload_len > sizeof(response_buf)) {
+    return 0;
+  }
+  write_payload(payload);
+  return writer.len + payload_len;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_benchmark_process, "CoAP benchmark");
+AUTOSTART_PROCESSES(&coap_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_benchmark_process, ev, data)
+{
+  static const char *names[] = {
+    "parse, serialize        ",
+    "parse, serialize in place",
+    "iterator, writer        "
+  };
+  static uint8_t reference[COAP_MAX_PACKET_SIZE];
+  static size_t reference_len;
+  long rounds = 1000000;
+  uint16_t offset;
+  size_t len;
+  double start, elapsed;
+  double best[3];
+  int trial;
+  long i;
+  int path;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "payload=", 8) == 0) {
+      payload_len = atoi(contiki_argv[i] + 8);
+    } else if(strncmp(contiki_argv[i], "rounds=", 7) == 0) {
+      rounds = atol(contiki_argv[i] + 7);
+    }
+  }
+  if(payload_len < 1 || payload_len > REST_MAX_CHUNK_SIZE) {
+    payload_len = REST_MAX_CHUNK_SIZE;
+  }
+
+  make_request();
+  printf("request: %u bytes, response payload: %d bytes\n",
+         (unsigned)request_len, payload_len);
+
+  for(path = 0; path < 3; path++) {
+    copied = 0;
+    len = path < 2 ? engine_path(path, &offset) : streaming_path(&offset);
+    if(len == 0) {
+      printf("%s: FAILED\n", names[path]);
+      exit(1);
+    }
+    /* All paths must give the same response */
+    if(path == 0) {
+      __real_memcpy(reference, response_buf + offset, len);
+      reference_len = len;
+    } else if(len != reference_len ||
+              memcmp(reference, response_buf + offset, len) != 0) {
+      printf("%s: response differs\n", names[path]);
+      exit(1);
+    }
+    printf("%s: response %u bytes at +%u", names[path], (unsigned)len,
+           offset);
+    if(COPIES) {
+      printf(", %lu bytes copied", copied);
+    }
+    printf("\n");
+  }
+
+  /* The paths take turns, so that a slow phase of the host does not
+     count against only one of them */
+  for(trial = 0; trial < TRIALS; trial++) {
+    for(path = 0; path < 3; path++) {
+      start = now();
+      for(i = 0; i < rounds; i++) {
+        if(path < 2) {
+          engine_path(path, &offset);
+        } else {
+          streaming_path(&offset);
+        }
+      }
+      elapsed = (now() - start) * 1e9 / rounds;
+      if(trial == 0 || elapsed < best[path]) {
+        best[path] = elapsed;
+      }
+    }
+  }
+  for(path = 0; path < 3; path++) {
+    printf("%s: %6.1f ns per request\n", names[path], best[path]);
+  }
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Time per operation on the CoAP transaction and observer tables
+ *         with N peers, on the native platform.
+ *
+ *         The program plays a server with N peers, each on its own
+ *         port, and times:
+ *         - sending a CON to every peer, which opens a transaction and
+ *           starts its retransmission timer,
+ *         - the ACK of every peer, in random order: finding the
+ *           transaction by MID and clearing it, as the engine does,
+ *         - the observe registration of every peer, through
+ *           coap_observe_handler(), as the engine does for a GET with
+ *           Observe 0,
+ *         - the cancellation of every peer, in random order, by token.
+ *
+ *         coap_send_message() is wrapped at link time (see the
+ *         Makefile), so that messages are counted and not sent. The
+ *         program checks that every ACK found its transaction, and
+ *         that every cancellation found its observer.
+ *
+ *         Arguments: peers=<n>, the number of peers (default 1000, at
+ *         most COAP_MAX_OPEN_TRANSACTIONS and COAP_MAX_OBSERVERS)
+ */
+
+#include "contiki.h"
+#include "er-coap.h"
+#include "er-coap-observe.h"
+#include "er-coap-transactions.h"
+#include "rest-engine.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+/* Peers use ports from here on */
+#define FIRST_PORT 20000
+
+#define MAX_PEERS (COAP_MAX_OPEN_TRANSACTIONS < COAP_MAX_OBSERVERS ? \
+                   COAP_MAX_OPEN_TRANSACTIONS : COAP_MAX_OBSERVERS)
+
+/* Each phase is run this many times, and the fastest time counts */
+#define TRIALS 5
+
+static int peers = 1000;
+static uip_ipaddr_t peer_addr;
+static uint16_t mids[MAX_PEERS];
+static int order[MAX_PEERS];
+
+static unsigned long sent;
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(void *request, void *response, uint8_t *buffer,
+                uint16_t preferred_size, int32_t *offset)
+{
+}
+EVENT_RESOURCE(res_value, "obs", res_get_handler, NULL, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+void
+__wrap_coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+                         uint16_t length)
+{
+  sent++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+shuffle(void)
+{
+  int i, j, k;
+
+  for(i = 0; i < peers; i++) {
+    order[i] = i;
+  }
+  for(i = peers - 1; i > 0; i--) {
+    j = random_rand() % (i + 1);
+    k = order[i];
+    order[i] = order[j];
+    order[j] = k;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A separate response, or a notification, to every peer */
+static void
+send_all(void)
+{
+  static coap_packet_t message[1];
+  coap_transaction_t *t;
+  int i;
+
+  for(i = 0; i < peers; i++) {
+    mids[i] = coap_get_mid();
+    t = coap_new_transaction(mids[i], &peer_addr,
+                             uip_htons(FIRST_PORT + i));
+    if(t == NULL) {
+      printf("send: no transaction for peer %d\n", i);
+      exit(1);
+    }
+    coap_init_message(message, COAP_TYPE_CON, CONTENT_2_05, mids[i]);
+    t->packet_len = coap_serialize_message(message, t->packet);
+    coap_send_transaction(t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The ACK of every peer, as the engine handles it */
+static void
+ack_all(void)
+{
+  coap_transaction_t *t;
+  int i;
+
+  for(i = 0; i < peers; i++) {
+    t = coap_get_transaction_by_mid(mids[order[i]]);
+    if(t == NULL) {
+      printf("ack: no transaction for peer %d\n", order[i]);
+      exit(1);
+    }
+    coap_clear_transaction(t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+register_all(void)
+{
+  static coap_packet_t request[1];
+  static coap_packet_t response[1];
+  uint8_t token[2];
+  int i;
+
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, &peer_addr);
+  for(i = 0; i < peers; i++) {
+    UIP_UDP_BUF->srcport = uip_htons(FIRST_PORT + i);
+    token[0] = i >> 8;
+    token[1] = i;
+    coap_init_message(request, COAP_TYPE_CON, COAP_GET, coap_get_mid());
+    coap_set_token(request, token, sizeof(token));
+    coap_set_header_uri_path(request, res_value.url);
+    coap_set_header_observe(request, 0);
+    coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, request->mid);
+    coap_observe_handler(&res_value, request, response);
+    if(!IS_OPTION(response, COAP_OPTION_OBSERVE)) {
+      printf("register: no observer for peer %d\n", i);
+      exit(1);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cancel_all(void)
+{
+  uint8_t token[2];
+  int i;
+
+  for(i = 0; i < peers; i++) {
+    token[0] = order[i] >> 8;
+    token[1] = order[i];
+    if(coap_remove_observer_by_token(&peer_addr,
+                                     uip_htons(FIRST_PORT + order[i]),
+                                     token, sizeof(token)) != 1) {
+      printf("cancel: no observer for peer %d\n", order[i]);
+      exit(1);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_load_benchmark_process, "CoAP load benchmark");
+AUTOSTART_PROCESSES(&coap_load_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_load_benchmark_process, ev, data)
+{
+  static void (*const phases[])(void) = {
+    send_all, ack_all, register_all, cancel_all
+  };
+  static const char *names[] = {
+    "send CON", "ACK     ", "register", "cancel  "
+  };
+  double start, elapsed;
+  double best[4];
+  int trial;
+  int phase;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "peers=", 6) == 0) {
+      peers = atoi(contiki_argv[i] + 6);
+    }
+  }
+  if(peers < 1 || peers > MAX_PEERS) {
+    peers = MAX_PEERS;
+  }
+
+  /* The CONs are kept as transactions of this process */
+  coap_register_as_transaction_handler();
+  rest_activate_resource(&res_value, "obs");
+  uip_ip6addr(&peer_addr, 0xfe80, 0, 0, 0, 0, 0, 0, 1);
+
+  for(trial = 0; trial < TRIALS; trial++) {
+    shuffle();
+    for(phase = 0; phase < 4; phase++) {
+      start = now();
+      phases[phase]();
+      elapsed = (now() - start) * 1e9 / peers;
+      if(trial == 0 || elapsed < best[phase]) {
+        best[phase] = elapsed;
+      }
+    }
+  }
+  printf("%d peers, %lu messages sent\n", peers, sent);
+  for(phase = 0; phase < 4; phase++) {
+    printf("%s: %8.1f ns per peer\n", names[phase], best[phase]);
+  }
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
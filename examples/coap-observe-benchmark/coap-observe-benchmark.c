@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Handler calls, bytes sent and time per change for notifying
+ *         the observers of a CoAP resource, on the native platform.
+ *
+ *         The program registers N observers of one resource through
+ *         coap_observe_handler(), as the engine does for a GET with
+ *         Observe 0, each from its own port. Every third observer
+ *         asks for no format, text/plain or application/json with
+ *         Accept. Each change then calls coap_notify_observers().
+ *
+ *         coap_send_message() is wrapped at link time (see the
+ *         Makefile), so that notifications are counted and not sent.
+ *         The first change is checked: every observer must get one
+ *         notification with its token and, in the format it asked
+ *         for. The CON refreshes are cleared after each change, as if
+ *         they had been acknowledged.
+ *
+ *         Arguments: observers=<n>, the number of observers (default
+ *         100, at most COAP_MAX_OBSERVERS), size=<n>, the payload size
+ *         in bytes (default 64), rounds=<n>, the number of changes
+ *         timed (default 10000)
+ */
+
+#include "contiki.h"
+#include "er-coap.h"
+#include "er-coap-observe.h"
+#include "er-coap-transactions.h"
+#include "rest-engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+/* Observers use ports from here on, and their number as token */
+#define FIRST_PORT 20000
+
+static int observers = 100;
+static int size = 64;
+
+/* What each observer asks for, and what it got */
+#define NO_ACCEPT -1
+static int accept[COAP_MAX_OBSERVERS];
+static int received[COAP_MAX_OBSERVERS];
+static int wrong_format;
+
+static unsigned long handler_calls;
+static unsigned long sent;
+static unsigned long bytes_sent;
+static int check;
+/*---------------------------------------------------------------------------*/
+static void res_get_handler(void *request, void *response, uint8_t *buffer,
+                            uint16_t preferred_size, int32_t *offset);
+
+EVENT_RESOURCE(res_value, "title=\"Value\";obs", res_get_handler,
+               NULL, NULL, NULL, NULL);
+
+/* Writes the value as text or as JSON, padded to size bytes */
+static void
+res_get_handler(void *request, void *response, uint8_t *buffer,
+                uint16_t preferred_size, int32_t *offset)
+{
+  static unsigned int value;
+  unsigned int format;
+  int len;
+
+  handler_calls++;
+  if(!REST.get_header_accept(request, &format)) {
+    format = REST.type.TEXT_PLAIN;
+  }
+  if(format == REST.type.TEXT_PLAIN) {
+    len = snprintf((char *)buffer, preferred_size, "%u", value);
+  } else if(format == REST.type.APPLICATION_JSON) {
+    len = snprintf((char *)buffer, preferred_size, "{\"v\":%u}", value);
+  } else {
+    REST.set_response_status(response, REST.status.NOT_ACCEPTABLE);
+    return;
+  }
+  if(len < size && size <= preferred_size) {
+    memset(buffer + len, ' ', size - len);
+    len = size;
+  }
+  value++;
+  REST.set_header_content_type(response, format);
+  REST.set_response_payload(response, buffer, len);
+}
+/*---------------------------------------------------------------------------*/
+void
+__wrap_coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+                         uint16_t length)
+{
+  static coap_packet_t message[1];
+  static uint8_t copy[COAP_MAX_PACKET_SIZE];
+  unsigned int expected;
+  int i;
+
+  sent++;
+  bytes_sent += length;
+  if(!check) {
+    return;
+  }
+  i = uip_ntohs(port) - FIRST_PORT;
+  memcpy(copy, data, length);
+  if(i < 0 || i >= observers ||
+     coap_parse_message(message, copy, length) != NO_ERROR ||
+     message->token_len != 1 || message->token[0] != i) {
+    printf("notification to an unknown observer\n");
+    exit(1);
+  }
+  received[i]++;
+  expected = accept[i] == NO_ACCEPT ? REST.type.TEXT_PLAIN : accept[i];
+  if(message->content_format != expected) {
+    wrong_format++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A GET with Observe 0 from observer i, as the engine would handle it */
+static void
+register_observer(int i)
+{
+  static coap_packet_t request[1];
+  static coap_packet_t response[1];
+  uint8_t token = i;
+
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 1);
+  UIP_UDP_BUF->srcport = uip_htons(FIRST_PORT + i);
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, coap_get_mid());
+  coap_set_token(request, &token, 1);
+  coap_set_header_uri_path(request, res_value.url);
+  coap_set_header_observe(request, 0);
+  accept[i] = i % 3 == 0 ? NO_ACCEPT
+    : i % 3 == 1 ? REST.type.TEXT_PLAIN : REST.type.APPLICATION_JSON;
+  if(accept[i] != NO_ACCEPT) {
+    coap_set_header_accept(request, accept[i]);
+  }
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, request->mid);
+  coap_observe_handler(&res_value, request, response);
+}
+/*---------------------------------------------------------------------------*/
+/* The CON refreshes are acknowledged */
+static void
+clear_transactions(void)
+{
+  coap_observer_t *obs;
+  coap_transaction_t *t;
+
+  for(obs = list_head(coap_get_observers()); obs; obs = obs->next) {
+    t = coap_get_transaction_by_mid(obs->last_mid);
+    if(t != NULL) {
+      coap_clear_transaction(t);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_observe_benchmark_process, "CoAP observe benchmark");
+AUTOSTART_PROCESSES(&coap_observe_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_observe_benchmark_process, ev, data)
+{
+  long rounds = 10000;
+  double elapsed, start;
+  long i;
+
+  PROCESS_BEGIN();
+
+  /* The CON refreshes are kept as transactions of this process */
+  coap_register_as_transaction_handler();
+  rest_activate_resource(&res_value, "obs");
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "observers=", 10) == 0) {
+      observers = atoi(contiki_argv[i] + 10);
+    } else if(strncmp(contiki_argv[i], "size=", 5) == 0) {
+      size = atoi(contiki_argv[i] + 5);
+    } else if(strncmp(contiki_argv[i], "rounds=", 7) == 0) {
+      rounds = atol(contiki_argv[i] + 7);
+    }
+  }
+  if(observers < 1 || observers > COAP_MAX_OBSERVERS) {
+    observers = COAP_MAX_OBSERVERS;
+  }
+
+  for(i = 0; i < observers; i++) {
+    register_observer(i);
+  }
+  if(list_length(coap_get_observers()) != observers) {
+    printf("registered %d of %d observers\n",
+           list_length(coap_get_observers()), observers);
+    exit(1);
+  }
+
+  check = 1;
+  coap_notify_observers(&res_value);
+  clear_transactions();
+  check = 0;
+  for(i = 0; i < observers; i++) {
+    if(received[i] != 1) {
+      printf("observer %ld got %d notifications\n", i, received[i]);
+      exit(1);
+    }
+  }
+  printf("%d observers, %d-byte payload\n", observers, size);
+  printf("per change: %lu handler calls, %lu notifications, %lu bytes, "
+         "%d in the wrong format\n",
+         handler_calls, sent, bytes_sent, wrong_format);
+
+  elapsed = 0;
+  for(i = 0; i < rounds; i++) {
+    start = now();
+    coap_notify_observers(&res_value);
+    elapsed += now() - start;
+    clear_transactions();
+  }
+  printf("%.1f us per change, %.0f ns per observer\n",
+         elapsed * 1e6 / rounds, elapsed * 1e9 / rounds / observers);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
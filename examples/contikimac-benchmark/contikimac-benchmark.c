@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Radio duty cycle of ContikiMAC on the native platform, with
+ *         a simulated radio and a modelled peer (see sim-radio.c).
+ *
+ *         In tx mode, the node sends unicasts to the peer, whose clock
+ *         drifts from ours. In rx mode, the peer sends to the node.
+ *         Packets come in groups of count, gap ms apart, one group
+ *         every interval seconds, for duration seconds of virtual
+ *         time. Groups start at a random time within the first second
+ *         of their interval.
+ *
+ *         Arguments: mode=<tx|rx>, drift=<ppm> (default 40),
+ *         interval=<s> (default 10), count=<n> (default 1),
+ *         gap=<ms> (default 100), size=<bytes> (default 40),
+ *         duration=<s> (default 3600), seed=<n> (default 1)
+ */
+
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "net/mac/mac.h"
+#include "net/mac/contikimac/contikimac.h"
+#include "sys/energest.h"
+#include "lib/random.h"
+#include "sim-radio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static const linkaddr_t node_addr = { { 1, 0 } };
+static const linkaddr_t peer_addr = { { 2, 0 } };
+
+static int rx_mode;
+static long drift = 40;
+static unsigned long interval = 10;
+static int count = 1;
+static unsigned long gap = 100;
+static int size = 40;
+static unsigned long duration = 3600;
+static unsigned short seed = 1;
+
+static unsigned long sent_packets;
+static unsigned long acked;
+static unsigned long failed;
+static unsigned long received;
+
+/*---------------------------------------------------------------------------*/
+/* The network layer only counts what it gets */
+static void
+sink_init(void)
+{
+  queuebuf_init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+sink_input(void)
+{
+  received++;
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver sink_driver = {
+  "sink",
+  sink_init,
+  sink_input
+};
+/*---------------------------------------------------------------------------*/
+static void
+parse_args(void)
+{
+  int i;
+  const char *arg;
+
+  for(i = 1; i < contiki_argc; i++) {
+    arg = contiki_argv[i];
+    if(strcmp(arg, "mode=rx") == 0) {
+      rx_mode = 1;
+    } else if(strcmp(arg, "mode=tx") == 0) {
+      rx_mode = 0;
+    } else if(strncmp(arg, "drift=", 6) == 0) {
+      drift = atol(arg + 6);
+    } else if(strncmp(arg, "interval=", 9) == 0) {
+      interval = strtoul(arg + 9, NULL, 10);
+    } else if(strncmp(arg, "count=", 6) == 0) {
+      count = atoi(arg + 6);
+    } else if(strncmp(arg, "gap=", 4) == 0) {
+      gap = strtoul(arg + 4, NULL, 10);
+    } else if(strncmp(arg, "size=", 5) == 0) {
+      size = atoi(arg + 5);
+    } else if(strncmp(arg, "duration=", 9) == 0) {
+      duration = strtoul(arg + 9, NULL, 10);
+    } else if(strncmp(arg, "seed=", 5) == 0) {
+      seed = atoi(arg + 5);
+    } else {
+      printf("unknown argument %s\n", arg);
+      exit(1);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+sent(void *ptr, int status, int transmissions)
+{
+  if(status == MAC_TX_OK) {
+    acked++;
+  } else {
+    failed++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(void)
+{
+  sent_packets++;
+  if(rx_mode) {
+    sim_radio_peer_send(size);
+    return;
+  }
+  packetbuf_clear();
+  memset(packetbuf_dataptr(), 0, size);
+  packetbuf_set_datalen(size);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &peer_addr);
+  NETSTACK_MAC.send(sent, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_results(clock_time_t elapsed)
+{
+  if(rx_mode) {
+    printf("rx: %lu packets, %lu received, %lu strobe trains not picked up\n",
+           sent_packets, received, sim_radio_stats.peer_failed);
+    if(sim_radio_stats.peer_delivered > 0) {
+      printf("peer: %.1f frames and %.2f ms of strobes per packet, "
+             "latency %.1f ms\n",
+             (double)sim_radio_stats.peer_frames /
+             sim_radio_stats.peer_delivered,
+             1000.0 * sim_radio_stats.peer_strobe_time /
+             sim_radio_stats.peer_delivered / CLOCK_SECOND,
+             1000.0 * sim_radio_stats.peer_latency /
+             sim_radio_stats.peer_delivered / CLOCK_SECOND);
+    }
+  } else {
+    printf("tx: %lu packets, %lu acked, %lu failed\n",
+           sent_packets, acked, failed);
+    printf("ContikiMAC: %lu unicasts, %lu acked, %.1f strobes each\n",
+           contikimac_stats.unicast_tx, contikimac_stats.unicast_ok,
+           contikimac_stats.unicast_tx == 0 ? 0.0 :
+           (double)contikimac_stats.unicast_strobes /
+           contikimac_stats.unicast_tx);
+    printf("phase: %lu hits, %lu misses, %lu deferred\n",
+           contikimac_stats.phase_hits, contikimac_stats.phase_misses,
+           contikimac_stats.phase_deferred);
+    if(contikimac_stats.unicast_ok > 0) {
+      printf("radio on per acked unicast: %.2f ms\n",
+             1000.0 * contikimac_stats.unicast_ok_radio_time /
+             contikimac_stats.unicast_ok / RTIMER_ARCH_SECOND);
+    }
+  }
+  printf("duty cycle: %.3f %% over %lu s\n",
+         100.0 * sim_radio_on_time() / elapsed, elapsed / CLOCK_SECOND);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(contikimac_benchmark_process, "ContikiMAC benchmark");
+AUTOSTART_PROCESSES(&contikimac_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(contikimac_benchmark_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t start, next_group;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  parse_args();
+  random_init(seed);
+  linkaddr_set_node_addr((linkaddr_t *)&node_addr);
+  sim_radio_set_peer(&peer_addr, drift);
+
+  printf("mode %s, drift %ld ppm, %d packets every %lu s, %lu ms apart, "
+         "%d bytes\n", rx_mode ? "rx" : "tx", drift, count, interval,
+         gap, size);
+
+  /* Let the phase of the node settle for a few cycles */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  start = next_group = clock_time();
+  while(clock_time() - start < duration * CLOCK_SECOND) {
+    for(i = 0; i < count; i++) {
+      if(i > 0) {
+        etimer_set(&et, gap * CLOCK_SECOND / 1000);
+        PROCESS_WAIT_UNTIL(etimer_expired(&et));
+      }
+      send_packet();
+    }
+    /* Groups start at a random time within the first second of their
+       interval, so that they do not keep the same phase to the
+       channel checks */
+    next_group += interval * CLOCK_SECOND;
+    etimer_set(&et, next_group + random_rand() % CLOCK_SECOND - clock_time());
+    PROCESS_WAIT_UNTIL(etimer_expired(&et));
+  }
+
+  print_results(clock_time() - start);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* The clock runs at the rate of the rtimer of a typical mote, and the
+   rtimer at the rate of the clock (see cpu/native/rtimer-arch.h) */
+#undef CLOCK_CONF_SECOND
+#define CLOCK_CONF_SECOND 32768
+
+#define NETSTACK_CONF_NETWORK sink_driver
+#define NETSTACK_CONF_MAC     csma_driver
+#define NETSTACK_CONF_RDC     contikimac_driver
+#define NETSTACK_CONF_FRAMER  framer_802154
+#define NETSTACK_CONF_RADIO   sim_radio_driver
+
+#define CONTIKIMAC_CONF_WITH_STATS 1
+#define ENERGEST_CONF_ON           1
+
+/* Set with PHASE, DRIFT, BURST and CCR in the Makefile */
+#define CONTIKIMAC_CONF_WITH_PHASE_OPTIMIZATION CONTIKIMAC_BENCHMARK_PHASE
+#define PHASE_CONF_DRIFT_CORRECT          CONTIKIMAC_BENCHMARK_DRIFT
+#define CONTIKIMAC_CONF_WITH_BURST        CONTIKIMAC_BENCHMARK_BURST
+#define CONTIKIMAC_CONF_WITH_ADAPTIVE_CCR CONTIKIMAC_BENCHMARK_CCR
+
+#endif /* PROJECT_CONF_H_ */
@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A simulated radio, a virtual clock and a modelled ContikiMAC
+ *         peer, to measure the radio duty cycle of ContikiMAC on the
+ *         native platform.
+ *
+ *         clock_time() and rtimer_arch_schedule() are wrapped at link
+ *         time (see the Makefile). The clock is virtual: every read
+ *         takes one tick, so that busy-waiting loops make progress,
+ *         and when no process has anything to do, the clock skips to
+ *         the next rtimer, etimer or event of the peer. The rtimer and
+ *         the clock both run at CLOCK_SECOND, so they share one time.
+ */
+
+#include "contiki.h"
+#include "dev/radio.h"
+#include "net/mac/frame802154.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "sys/energest.h"
+#include "lib/random.h"
+#include "sim-radio.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ContikiMAC timing with the defaults of contikimac.c, for the peer */
+#define CYCLE_TIME            (CLOCK_SECOND / NETSTACK_RDC_CHANNEL_CHECK_RATE)
+#define CCA_PERIOD            (CLOCK_SECOND / 8192 + CLOCK_SECOND / 2000)
+#define CCA_COUNT             2
+#define CCA_COUNT_TX          6
+#define INTER_PACKET_INTERVAL (CLOCK_SECOND / 2500)
+#define INTER_PACKET_DEADLINE (CLOCK_SECOND / 32)
+#define STROBE_TIME           (CYCLE_TIME + 2 * CCA_COUNT * CCA_PERIOD)
+
+/* 250 kbit/s, with the PHY header and the FCS */
+#define AIRTIME(len)          (((len) + 8) * CLOCK_SECOND / 31250)
+
+#define FRAME_PENDING         0x10
+#define FRAME_ACK_REQUEST     0x20
+
+#define MAX_FRAME_LEN         127
+#define PEER_QUEUE_SIZE       64
+
+#define BEFORE(a, b)          ((long)((a) - (b)) < 0)
+
+struct sim_radio_stats sim_radio_stats;
+
+static clock_time_t now;
+
+static uint8_t rtimer_pending;
+static clock_time_t rtimer_due;
+
+static uint8_t radio_is_on;
+static clock_time_t on_since;
+
+static uint8_t tx_buf[MAX_FRAME_LEN];
+static uint8_t rx_buf[MAX_FRAME_LEN];
+static int rx_len;
+static uint8_t rx_pending;
+
+struct peer_packet {
+  clock_time_t arrival;
+  int len;
+  uint8_t buf[MAX_FRAME_LEN];
+};
+
+static struct {
+  linkaddr_t addr;
+  /* The wake-ups of the peer, in ticks of our clock */
+  double phase;
+  double cycle;
+  /* Receiving: listening for the rest of a strobe train, or awake
+     after a frame with FRAME_PENDING until awake_until */
+  uint8_t listening;
+  uint8_t awake;
+  clock_time_t awake_until;
+  /* Sending: a strobe train to us that started at train_start */
+  struct peer_packet queue[PEER_QUEUE_SIZE];
+  int queue_head;
+  int queue_len;
+  uint8_t sending;
+  clock_time_t train_start;
+  uint8_t seqno;
+} peer;
+
+static int hook_fd = -1;
+
+PROCESS(sim_radio_process, "Simulated radio");
+/*---------------------------------------------------------------------------*/
+clock_time_t
+__wrap_clock_time(void)
+{
+  return ++now;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+__wrap_clock_seconds(void)
+{
+  return now / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+void
+__wrap_rtimer_arch_schedule(rtimer_clock_t t)
+{
+  rtimer_due = now + (signed short)(t - (rtimer_clock_t)now);
+  rtimer_pending = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the peer checks the channel in [start, end) */
+static int
+peer_checks(clock_time_t start, clock_time_t end)
+{
+  long k, i;
+  int j;
+  double c;
+
+  k = (long)((start - peer.phase) / peer.cycle);
+  for(i = k - 1; i <= k + 1; i++) {
+    for(j = 0; j < CCA_COUNT; j++) {
+      c = peer.phase + i * peer.cycle + j * CCA_PERIOD;
+      if(c >= start && c < end) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* A frame from us was on the air in [start, end) */
+static void
+peer_receive(clock_time_t start, clock_time_t end)
+{
+  if(!(tx_buf[0] & FRAME_ACK_REQUEST)) {
+    return;
+  }
+  if(peer.listening || (peer.awake && BEFORE(start, peer.awake_until))) {
+    rx_buf[0] = FRAME802154_ACKFRAME;
+    rx_buf[1] = 0;
+    rx_buf[2] = tx_buf[2];
+    rx_len = 3;
+    rx_pending = 1;
+    peer.listening = 0;
+    peer.awake = (tx_buf[0] & FRAME_PENDING) != 0;
+    peer.awake_until = end + INTER_PACKET_DEADLINE;
+  } else if(peer_checks(start, end)) {
+    /* The peer stays on and receives the next frame in full */
+    peer.listening = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+peer_airtime(void)
+{
+  return AIRTIME(peer.queue[peer.queue_head].len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+peer_start_train(clock_time_t t)
+{
+  /* The peer checks the channel before the first strobe */
+  peer.train_start = t + CCA_COUNT_TX * CCA_PERIOD;
+  peer.sending = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The start of the first frame of the train that starts at or after t,
+   or of the frame on the air at t if any */
+static clock_time_t
+peer_frame_after(clock_time_t t, int on_air)
+{
+  clock_time_t period;
+  unsigned long i;
+
+  if(!BEFORE(peer.train_start, t)) {
+    return peer.train_start;
+  }
+  period = peer_airtime() + INTER_PACKET_INTERVAL;
+  i = (t - peer.train_start) / period;
+  if(on_air && t - peer.train_start - i * period < peer_airtime()) {
+    return peer.train_start + i * period;
+  }
+  if((t - peer.train_start) % period != 0) {
+    i++;
+  }
+  return peer.train_start + i * period;
+}
+/*---------------------------------------------------------------------------*/
+static int
+peer_on_air(void)
+{
+  clock_time_t s;
+
+  if(!peer.sending || BEFORE(now, peer.train_start)) {
+    return 0;
+  }
+  s = peer_frame_after(now, 1);
+  return !BEFORE(s, peer.train_start + STROBE_TIME) ? 0 :
+    !BEFORE(now, s) && BEFORE(now, s + peer_airtime());
+}
+/*---------------------------------------------------------------------------*/
+static void
+peer_update(void)
+{
+  struct peer_packet *p;
+  clock_time_t s, end, period;
+
+  while(peer.sending) {
+    p = &peer.queue[peer.queue_head];
+    period = peer_airtime() + INTER_PACKET_INTERVAL;
+    if(radio_is_on) {
+      /* We receive the first frame that starts once our radio is on */
+      s = peer_frame_after(on_since, 0);
+      end = s + peer_airtime();
+      if(BEFORE(s, peer.train_start + STROBE_TIME) && !BEFORE(now, end)) {
+        memcpy(rx_buf, p->buf, p->len);
+        rx_len = p->len;
+        rx_pending = 1;
+        process_poll(&sim_radio_process);
+        sim_radio_stats.peer_delivered++;
+        sim_radio_stats.peer_latency += end - p->arrival;
+        sim_radio_stats.peer_frames += (s - peer.train_start) / period + 1;
+        sim_radio_stats.peer_strobe_time += end - peer.train_start;
+        peer.queue_head = (peer.queue_head + 1) % PEER_QUEUE_SIZE;
+        peer.sending = --peer.queue_len > 0;
+        if(peer.sending) {
+          peer_start_train(end + INTER_PACKET_INTERVAL);
+        }
+        continue;
+      }
+    }
+    if(!BEFORE(now, peer.train_start + STROBE_TIME)) {
+      /* Not picked up: the peer tries again */
+      sim_radio_stats.peer_failed++;
+      sim_radio_stats.peer_frames += (STROBE_TIME - 1) / period + 1;
+      sim_radio_stats.peer_strobe_time += STROBE_TIME;
+      peer_start_train(now);
+    }
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+peer_next_event(clock_time_t *next)
+{
+  clock_time_t t;
+
+  if(!peer.sending) {
+    return;
+  }
+  t = peer.train_start + STROBE_TIME;
+  if(radio_is_on) {
+    t = peer_frame_after(on_since, 0) + peer_airtime();
+  }
+  if(BEFORE(t, *next)) {
+    *next = t;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Called once per round of the main loop, after the processes have
+   run */
+static void
+advance(void)
+{
+  clock_time_t next;
+
+  peer_update();
+  if(rtimer_pending && !BEFORE(now, rtimer_due)) {
+    rtimer_pending = 0;
+    rtimer_run_next();
+    return;
+  }
+  if(process_nevents() > 0) {
+    return;
+  }
+
+  /* Nothing to do until the next event */
+  next = now + CLOCK_SECOND;
+  if(rtimer_pending && BEFORE(rtimer_due, next)) {
+    next = rtimer_due;
+  }
+  if(etimer_pending() && BEFORE(etimer_next_expiration_time(), next)) {
+    next = etimer_next_expiration_time();
+  }
+  peer_next_event(&next);
+  if(BEFORE(now, next)) {
+    now = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  /* The write end of an empty pipe: select() returns at once */
+  FD_SET(hook_fd, wset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  if(FD_ISSET(hook_fd, wset)) {
+    advance();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback hook_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_set_peer(const linkaddr_t *addr, long drift_ppm)
+{
+  linkaddr_copy(&peer.addr, addr);
+  peer.cycle = CYCLE_TIME * (1 + drift_ppm / 1e6);
+  peer.phase = random_rand() % CYCLE_TIME;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_peer_send(int len)
+{
+  struct peer_packet *p;
+
+  if(peer.queue_len == PEER_QUEUE_SIZE) {
+    return;
+  }
+  p = &peer.queue[(peer.queue_head + peer.queue_len) % PEER_QUEUE_SIZE];
+
+  packetbuf_clear();
+  memset(packetbuf_dataptr(), 0, len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &peer.addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+  if(++peer.seqno == 0) {
+    peer.seqno++;
+  }
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, peer.seqno);
+  if(NETSTACK_FRAMER.create() < 0 || packetbuf_totlen() > MAX_FRAME_LEN) {
+    return;
+  }
+  memcpy(p->buf, packetbuf_hdrptr(), packetbuf_totlen());
+  p->len = packetbuf_totlen();
+  p->arrival = now;
+
+  peer_update();
+  if(peer.queue_len++ == 0) {
+    peer_start_train(now);
+  }
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+sim_radio_on_time(void)
+{
+  return sim_radio_stats.radio_on + (radio_is_on ? now - on_since : 0);
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  int fds[2];
+
+  if(pipe(fds) == 0) {
+    hook_fd = fds[1];
+    select_set_callback(hook_fd, &hook_callback);
+  }
+  process_start(&sim_radio_process, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short payload_len)
+{
+  if(payload_len > MAX_FRAME_LEN) {
+    return 1;
+  }
+  memcpy(tx_buf, payload, payload_len);
+  /* A new strobe train */
+  peer.listening = 0;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit(unsigned short transmit_len)
+{
+  clock_time_t start;
+
+  if(radio_is_on) {
+    ENERGEST_OFF(ENERGEST_TYPE_LISTEN);
+  } else {
+    sim_radio_stats.radio_on += AIRTIME(transmit_len);
+  }
+  ENERGEST_ON(ENERGEST_TYPE_TRANSMIT);
+  start = now;
+  now += AIRTIME(transmit_len);
+  ENERGEST_OFF(ENERGEST_TYPE_TRANSMIT);
+  if(radio_is_on) {
+    ENERGEST_ON(ENERGEST_TYPE_LISTEN);
+  }
+
+  peer_receive(start, now);
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short payload_len)
+{
+  prepare(payload, payload_len);
+  return transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_packet(void *buf, unsigned short buf_len)
+{
+  int len;
+
+  peer_update();
+  if(!rx_pending) {
+    return 0;
+  }
+  len = rx_len < buf_len ? rx_len : buf_len;
+  memcpy(buf, rx_buf, len);
+  rx_pending = 0;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  peer_update();
+  return !peer_on_air();
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  peer_update();
+  return radio_is_on && peer_on_air() &&
+    !BEFORE(peer_frame_after(now, 1), on_since);
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  peer_update();
+  return rx_pending;
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  if(!radio_is_on) {
+    peer_update();
+    radio_is_on = 1;
+    on_since = now;
+    ENERGEST_ON(ENERGEST_TYPE_LISTEN);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  if(radio_is_on) {
+    peer_update();
+    radio_is_on = 0;
+    sim_radio_stats.radio_on += now - on_since;
+    ENERGEST_OFF(ENERGEST_TYPE_LISTEN);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver sim_radio_driver = {
+  init,
+  prepare,
+  transmit,
+  send,
+  read_packet,
+  channel_clear,
+  receiving_packet,
+  pending_packet,
+  on,
+  off,
+  get_value,
+  set_value,
+  get_object,
+  set_object
+};
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(sim_radio_process, ev, data)
+{
+  int len;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    packetbuf_clear();
+    len = read_packet(packetbuf_dataptr(), PACKETBUF_SIZE);
+    if(len > 0) {
+      packetbuf_set_datalen(len);
+      NETSTACK_RDC.input();
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A simulated radio, a virtual clock and a modelled ContikiMAC
+ *         peer, to measure the radio duty cycle of ContikiMAC on the
+ *         native platform.
+ */
+
+#ifndef SIM_RADIO_H_
+#define SIM_RADIO_H_
+
+#include "contiki.h"
+#include "dev/radio.h"
+#include "net/linkaddr.h"
+
+struct sim_radio_stats {
+  /** Ticks during which the radio of the node was on */
+  unsigned long radio_on;
+  /** Packets of the peer received by the node */
+  unsigned long peer_delivered;
+  /** Frames transmitted by the peer, strobes included */
+  unsigned long peer_frames;
+  /** Ticks the peer spent strobing, from the first frame of a train
+      to the end of the last */
+  unsigned long peer_strobe_time;
+  /** Strobe trains of the peer that were not picked up */
+  unsigned long peer_failed;
+  /** Ticks from the arrival of a packet at the peer to its reception */
+  unsigned long peer_latency;
+};
+
+extern struct sim_radio_stats sim_radio_stats;
+
+extern const struct radio_driver sim_radio_driver;
+
+/**
+ * \brief      Set up the peer of the node
+ * \param addr The address of the peer
+ * \param drift_ppm How much slower the clock of the peer runs, in ppm
+ *
+ *             The peer wakes up every ContikiMAC cycle of its own clock,
+ *             at a random phase, and acknowledges the first frame it
+ *             receives in full once awake. After a frame with
+ *             FRAME_PENDING set, it stays awake for the next one.
+ */
+void sim_radio_set_peer(const linkaddr_t *addr, long drift_ppm);
+
+/**
+ * \brief      Make the peer send a packet of len bytes to the node
+ *
+ *             The peer strobes the packet, without knowing the phase
+ *             of the node, until it is received. Packets that arrive
+ *             while the peer is busy are queued.
+ */
+void sim_radio_peer_send(int len);
+
+/**
+ * \brief      Radio-on time of the node so far, in clock ticks
+ */
+unsigned long sim_radio_on_time(void);
+
+#endif /* SIM_RADIO_H_ */
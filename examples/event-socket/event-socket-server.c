@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A TCP and UDP echo server that serves all its connections
+ *         from a single process with event sockets
+ *
+ *         Each TCP connection only costs an event socket and its
+ *         buffers. The server has UIP_CONNS sockets listening on the
+ *         same port and echoes what it reads from the ready sockets.
+ *
+ *         The server talks to the host through a tun device, see
+ *         tun-interface.c, so it has to be run as root:
+ *
+ *           sudo ./event-socket-server.native
+ *
+ *         scaling-client.py then measures how the server copes with
+ *         many connections, e.g., 250 connections that each echo 100
+ *         messages:
+ *
+ *           ./scaling-client.py -c 250 -m 100
+ */
+
+#include "contiki-net.h"
+#include "net/ipv6/uip-ds6.h"
+
+#include <stdio.h>
+
+#define PORT 7
+
+#define NUM_SOCKETS UIP_CONNS
+
+/* Must be a power of two, and larger than the TCP receive window */
+#define INPUT_BUF_SIZE 1024
+#define OUTPUT_BUF_SIZE 512
+
+static struct event_socket_set set;
+
+static struct event_socket sockets[NUM_SOCKETS];
+static uint8_t inputbufs[NUM_SOCKETS][INPUT_BUF_SIZE];
+static uint8_t outputbufs[NUM_SOCKETS][OUTPUT_BUF_SIZE];
+
+static struct event_socket udp;
+static uint8_t udp_inputbuf[2048];
+
+static struct etimer stats_timer;
+static unsigned long connections, bytes, datagrams;
+static uint16_t active, max_active;
+
+PROCESS(event_socket_server_process, "Event socket echo server");
+AUTOSTART_PROCESSES(&event_socket_server_process);
+/*---------------------------------------------------------------------------*/
+static void
+echo(struct event_socket *s)
+{
+  uint8_t buf[OUTPUT_BUF_SIZE];
+  int len;
+
+  /* Only read what there is room to echo, so that a client that does
+     not read its echo gets stopped by the window. */
+  len = event_socket_read(s, buf,
+                          MIN(sizeof(buf), tcp_socket_max_sendlen(&s->s.tcp)));
+  if(len > 0) {
+    event_socket_write(s, buf, len);
+    bytes += len;
+  }
+
+  /* Wait for room if there is more to echo. */
+  if(event_socket_readable(s) > 0) {
+    event_socket_watch(s, EVENT_SOCKET_DEFAULT_WATCH | EVENT_SOCKET_WRITABLE);
+  } else {
+    event_socket_watch(s, EVENT_SOCKET_DEFAULT_WATCH);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_echo(struct event_socket *s)
+{
+  uint8_t buf[UIP_BUFSIZE];
+  uip_ipaddr_t addr;
+  uint16_t port;
+  int len;
+
+  while((len = event_socket_recvfrom(s, buf, sizeof(buf),
+                                     &addr, &port)) >= 0) {
+    event_socket_sendto(s, buf, len, &addr, port);
+    datagrams++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(event_socket_server_process, ev, data)
+{
+  struct event_socket *s;
+  uip_ipaddr_t addr;
+  uint8_t events;
+  int i;
+
+  PROCESS_BEGIN();
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  event_socket_set_init(&set);
+  for(i = 0; i < NUM_SOCKETS; i++) {
+    event_socket_tcp_register(&sockets[i], &set, NULL,
+                              inputbufs[i], INPUT_BUF_SIZE,
+                              outputbufs[i], OUTPUT_BUF_SIZE);
+    event_socket_listen(&sockets[i], PORT);
+  }
+  event_socket_udp_register(&udp, &set, NULL,
+                            udp_inputbuf, sizeof(udp_inputbuf));
+  event_socket_bind(&udp, PORT);
+
+  printf("Echo server on [fdee::2]:%d with %d TCP sockets\n",
+         PORT, NUM_SOCKETS);
+
+  etimer_set(&stats_timer, 10 * CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_EVENT();
+
+    if(ev == PROCESS_EVENT_TIMER && data == &stats_timer) {
+      printf("connections %lu active %u max %u bytes %lu datagrams %lu\n",
+             connections, active, max_active, bytes, datagrams);
+      etimer_reset(&stats_timer);
+    }
+
+    while((s = event_socket_set_next(&set, &events)) != NULL) {
+      if(s == &udp) {
+        udp_echo(s);
+        continue;
+      }
+      if(events & EVENT_SOCKET_CONNECTED) {
+        connections++;
+        if(++active > max_active) {
+          max_active = active;
+        }
+      }
+      if(events & (EVENT_SOCKET_READABLE | EVENT_SOCKET_WRITABLE)) {
+        echo(s);
+      }
+      if(events & EVENT_SOCKET_CLOSED) {
+        active--;
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
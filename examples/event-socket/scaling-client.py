@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+#
+# Connection-scaling benchmark for the event socket echo server.
+#
+# Opens a number of TCP connections to the server at the same time,
+# sends messages over all of them and waits for each echo before
+# sending the next message on that connection. Reports the time to
+# connect, the echo rate and the round-trip times.
+#
+# Usage: scaling-client.py [-a addr] [-p port] [-c connections]
+#                          [-m messages] [-s size] [-u]
+
+import argparse
+import asyncio
+import time
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+async def tcp_client(args, data, rtts, connected):
+    reader, writer = await asyncio.open_connection(args.addr, args.port)
+    connected.append(time.monotonic())
+    await start.wait()
+    for i in range(args.messages):
+        t = time.monotonic()
+        writer.write(data)
+        if await reader.readexactly(len(data)) != data:
+            raise RuntimeError("echo differs from what was sent")
+        rtts.append(time.monotonic() - t)
+    writer.close()
+
+class UdpClient(asyncio.DatagramProtocol):
+    def __init__(self, args, data, rtts, done):
+        self.args, self.data, self.rtts, self.done = args, data, rtts, done
+        self.count = 0
+    def connection_made(self, transport):
+        self.transport = transport
+        self.send()
+    def send(self):
+        self.t = time.monotonic()
+        self.transport.sendto(self.data)
+    def datagram_received(self, data, addr):
+        self.rtts.append(time.monotonic() - self.t)
+        self.count += 1
+        if self.count == self.args.messages:
+            self.done.set_result(True)
+        else:
+            self.send()
+
+async def main(args):
+    global start
+    start = asyncio.Event()
+    data = bytes(i & 0xff for i in range(args.size))
+    rtts = []
+    loop = asyncio.get_running_loop()
+
+    if args.udp:
+        done = loop.create_future()
+        t0 = time.monotonic()
+        transport, _ = await loop.create_datagram_endpoint(
+            lambda: UdpClient(args, data, rtts, done),
+            remote_addr=(args.addr, args.port))
+        await asyncio.wait_for(done, 60)
+        transport.close()
+        elapsed = time.monotonic() - t0
+        print("udp: %d datagrams of %d bytes in %.2f s, %.0f/s" %
+              (args.messages, args.size, elapsed, args.messages / elapsed))
+    else:
+        connected = []
+        t0 = time.monotonic()
+        clients = [asyncio.ensure_future(tcp_client(args, data, rtts,
+                                                    connected))
+                   for i in range(args.connections)]
+        while len(connected) < args.connections:
+            await asyncio.sleep(0.01)
+        print("tcp: %d connections in %.2f s" %
+              (args.connections, max(connected) - t0))
+        t1 = time.monotonic()
+        start.set()
+        await asyncio.gather(*clients)
+        elapsed = time.monotonic() - t1
+        total = args.connections * args.messages
+        print("tcp: %d echoes of %d bytes in %.2f s, %.0f/s, %.0f kB/s" %
+              (total, args.size, elapsed, total / elapsed,
+               total * args.size / elapsed / 1000))
+    print("rtt: median %.1f ms, 99th percentile %.1f ms, max %.1f ms" %
+          (percentile(rtts, 50) * 1000, percentile(rtts, 99) * 1000,
+           max(rtts) * 1000))
+
+parser = argparse.ArgumentParser()
+parser.add_argument("-a", "--addr", default="fdee::2")
+parser.add_argument("-p", "--port", type=int, default=7)
+parser.add_argument("-c", "--connections", type=int, default=100)
+parser.add_argument("-m", "--messages", type=int, default=100)
+parser.add_argument("-s", "--size", type=int, default=64)
+parser.add_argument("-u", "--udp", action="store_true")
+asyncio.run(main(parser.parse_args()))
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A uIP fallback interface that sends all packets through a
+ *         Linux tun device, so that the host can talk to the native
+ *         node directly
+ */
+
+#include "contiki-net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <err.h>
+#include <sys/ioctl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#ifdef TUN_CONF_DEV
+#define TUN_DEV TUN_CONF_DEV
+#else
+#define TUN_DEV "tun0"
+#endif
+
+/* The address of the host end, with the prefix that is routed to the
+   node */
+#ifdef TUN_CONF_HOST_ADDR
+#define TUN_HOST_ADDR TUN_CONF_HOST_ADDR
+#else
+#define TUN_HOST_ADDR "fdee::1/64"
+#endif
+
+static int tunfd = -1;
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(tunfd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  int size;
+
+  if(FD_ISSET(tunfd, rset)) {
+    size = read(tunfd, &uip_buf[UIP_LLH_LEN], UIP_BUFSIZE - UIP_LLH_LEN);
+    if(size > 0) {
+      uip_len = size;
+      tcpip_input();
+    }
+  }
+}
+static const struct select_callback tun_select_callback = {
+  set_fd,
+  handle_fd
+};
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  struct ifreq ifr;
+  char cmd[128];
+
+  tunfd = open("/dev/net/tun", O_RDWR);
+  if(tunfd < 0) {
+    err(1, "tun: open");
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  strncpy(ifr.ifr_name, TUN_DEV, IFNAMSIZ - 1);
+  if(ioctl(tunfd, TUNSETIFF, (void *)&ifr) < 0) {
+    err(1, "tun: TUNSETIFF");
+  }
+
+  snprintf(cmd, sizeof(cmd), "ip link set dev %s up && "
+           "ip -6 addr add %s dev %s nodad", TUN_DEV, TUN_HOST_ADDR, TUN_DEV);
+  printf("%s\n", cmd);
+  if(system(cmd) != 0) {
+    fprintf(stderr, "tun: could not configure %s\n", TUN_DEV);
+  }
+
+  select_set_callback(tunfd, &tun_select_callback);
+}
+/*---------------------------------------------------------------------------*/
+static int
+output(void)
+{
+  if(uip_len > 0 &&
+     write(tunfd, &uip_buf[UIP_LLH_LEN], uip_len) != uip_len) {
+    return -1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const struct uip_fallback_interface tun_interface = {
+  init, output
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Cost of the 802.15.4 header parses on the TSCH receive path,
+ *         on the native platform.
+ *
+ *         TSCH parses each frame in the slot operation, when it is
+ *         received. Before the parsed header was kept with the frame,
+ *         tsch_rx_process_pending() parsed it again to find its type,
+ *         and the framer parsed it a third time to set the packetbuf
+ *         attributes. Now the framer gets the header parsed in the
+ *         slot operation through framer_802154_set_parsed(). The
+ *         program runs both paths over the same frames, counts the
+ *         calls to frame802154_parse() (wrapped at link time, see the
+ *         Makefile), checks that both paths give the same packetbuf
+ *         attributes, and times them.
+ *
+ *         Arguments: frames=<n>, the number of distinct frames
+ *         (default 64), rounds=<n>, the number of times they are all
+ *         received (default 200000 / frames)
+ */
+
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/mac/frame802154.h"
+#include "net/mac/framer-802154.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+#define PAN_ID 0xabcd
+
+/* A received frame, as the TSCH slot operation keeps it */
+struct rx_frame {
+  uint8_t payload[127];
+  int len;
+  frame802154_t frame;
+  int hdr_len;
+};
+
+static struct rx_frame *frames;
+static unsigned long parse_calls;
+/*---------------------------------------------------------------------------*/
+int __real_frame802154_parse(uint8_t *data, int length, frame802154_t *pf);
+
+int
+__wrap_frame802154_parse(uint8_t *data, int length, frame802154_t *pf)
+{
+  parse_calls++;
+  return __real_frame802154_parse(data, length, pf);
+}
+/*---------------------------------------------------------------------------*/
+/* Builds data frames with long and short addresses, unicast and
+   broadcast, and 10 to 100 bytes of payload */
+static void
+make_frames(int n)
+{
+  frame802154_t params;
+  int i, j, hdr_len, payload_len;
+
+  frames = calloc(n, sizeof(struct rx_frame));
+  if(frames == NULL) {
+    printf("out of memory\n");
+    exit(1);
+  }
+  for(i = 0; i < n; i++) {
+    memset(&params, 0, sizeof(params));
+    params.fcf.frame_type = FRAME802154_DATAFRAME;
+    params.fcf.frame_version = FRAME802154_IEEE802154_2006;
+    params.fcf.panid_compression = 1;
+    params.fcf.src_addr_mode = FRAME802154_LONGADDRMODE;
+    params.seq = i;
+    params.dest_pid = PAN_ID;
+    params.src_pid = PAN_ID;
+    for(j = 0; j < 8; j++) {
+      params.src_addr[j] = i + j;
+    }
+    if(i % 4 == 0) {
+      params.fcf.dest_addr_mode = FRAME802154_SHORTADDRMODE;
+      params.dest_addr[0] = 0xff;
+      params.dest_addr[1] = 0xff;
+    } else {
+      params.fcf.dest_addr_mode = FRAME802154_LONGADDRMODE;
+      params.fcf.ack_required = 1;
+      for(j = 0; j < 8; j++) {
+        params.dest_addr[j] = 0x80 + i + j;
+      }
+    }
+    payload_len = 10 + (i * 7) % 91;
+    hdr_len = frame802154_create(&params, frames[i].payload);
+    for(j = 0; j < payload_len; j++) {
+      frames[i].payload[hdr_len + j] = i * j;
+    }
+    frames[i].len = hdr_len + payload_len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* What the slot operation does with a received frame */
+static int
+slot_rx(struct rx_frame *in)
+{
+  in->hdr_len = frame802154_parse(in->payload, in->len, &in->frame);
+  return in->hdr_len > 0 && frame802154_check_dest_panid(&in->frame);
+}
+/*---------------------------------------------------------------------------*/
+/* Adds the packetbuf attributes set by the framer to a checksum */
+static unsigned long
+attr_sum(unsigned long sum)
+{
+  const uint8_t *a;
+  int i;
+
+  sum = sum * 31 + packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+  sum = sum * 31 + packetbuf_attr(PACKETBUF_ATTR_MAC_ACK);
+  sum = sum * 31 + packetbuf_datalen();
+  a = packetbuf_addr(PACKETBUF_ADDR_SENDER)->u8;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    sum = sum * 31 + a[i];
+  }
+  a = packetbuf_addr(PACKETBUF_ADDR_RECEIVER)->u8;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    sum = sum * 31 + a[i];
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* tsch_rx_process_pending() and the framer, parsing the frame again */
+static unsigned long
+process_reparse(struct rx_frame *in, unsigned long sum)
+{
+  frame802154_t frame;
+
+  if(frame802154_parse(in->payload, in->len, &frame) &&
+     frame.fcf.frame_type == FRAME802154_DATAFRAME) {
+    packetbuf_copyfrom(in->payload, in->len);
+    if(framer_802154.parse() > 0) {
+      sum = attr_sum(sum);
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* tsch_rx_process_pending() and the framer, using the parsed header */
+static unsigned long
+process_reuse(struct rx_frame *in, unsigned long sum)
+{
+  if(in->frame.fcf.frame_type == FRAME802154_DATAFRAME) {
+    packetbuf_copyfrom(in->payload, in->len);
+    framer_802154_set_parsed(&in->frame, in->hdr_len);
+    if(framer_802154.parse() > 0) {
+      sum = attr_sum(sum);
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(frame802154_benchmark_process, "802.15.4 parse benchmark");
+AUTOSTART_PROCESSES(&frame802154_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(frame802154_benchmark_process, ev, data)
+{
+  int n = 64;
+  long rounds = 0;
+  unsigned long sum_reparse, sum_reuse, calls;
+  double start, t_reparse, t_reuse;
+  long i;
+  int j, ok;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "frames=", 7) == 0) {
+      n = atoi(contiki_argv[i] + 7);
+    } else if(strncmp(contiki_argv[i], "rounds=", 7) == 0) {
+      rounds = atol(contiki_argv[i] + 7);
+    }
+  }
+  if(n < 1) {
+    n = 1;
+  }
+  if(rounds < 1) {
+    rounds = 200000 / n + 1;
+  }
+
+  frame802154_set_pan_id(PAN_ID);
+  make_frames(n);
+  for(j = 0; j < n; j++) {
+    if(!slot_rx(&frames[j])) {
+      printf("frame %d: FAILED to parse\n", j);
+      exit(1);
+    }
+  }
+
+  /* Parses per frame, after the one in the slot operation */
+  parse_calls = 0;
+  sum_reparse = 1;
+  for(j = 0; j < n; j++) {
+    sum_reparse = process_reparse(&frames[j], sum_reparse);
+  }
+  calls = parse_calls;
+  parse_calls = 0;
+  sum_reuse = 1;
+  for(j = 0; j < n; j++) {
+    sum_reuse = process_reuse(&frames[j], sum_reuse);
+  }
+  printf("%d frames, parses per frame after the slot operation:\n", n);
+  printf("  parsed again:       %.2f\n", (double)calls / n);
+  printf("  header handed over: %.2f\n", (double)parse_calls / n);
+  printf("packetbuf attributes: %s\n",
+         sum_reparse == sum_reuse ? "same" : "FAILED");
+
+  /* A header handed over for another frame must not be used */
+  framer_802154_set_parsed(&frames[0].frame, frames[0].hdr_len);
+  packetbuf_copyfrom(frames[1].payload, frames[1].len);
+  parse_calls = 0;
+  ok = framer_802154.parse() > 0 && parse_calls == 1 &&
+    packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) == frames[1].frame.seq;
+  printf("header of another frame: %s\n", ok ? "not used" : "FAILED");
+
+  start = now();
+  for(i = 0; i < rounds; i++) {
+    for(j = 0; j < n; j++) {
+      slot_rx(&frames[j]);
+      sum_reparse = process_reparse(&frames[j], sum_reparse);
+    }
+  }
+  t_reparse = now() - start;
+
+  start = now();
+  for(i = 0; i < rounds; i++) {
+    for(j = 0; j < n; j++) {
+      slot_rx(&frames[j]);
+      sum_reuse = process_reuse(&frames[j], sum_reuse);
+    }
+  }
+  t_reuse = now() - start;
+
+  printf("receive path, ns per frame (checksums %lx %lx):\n",
+         sum_reparse & 0xff, sum_reuse & 0xff);
+  printf("  parsed again:       %6.1f\n", t_reparse * 1e9 / (rounds * n));
+  printf("  header handed over: %6.1f\n", t_reuse * 1e9 / (rounds * n));
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
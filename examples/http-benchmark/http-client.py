@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+#
+# Page rate client for the HTTP benchmark.
+#
+# Fetches a page from the node over and over for a number of seconds
+# and reports the pages per second, and the bytes and packets per page
+# on the tun device. By default every page has its own connection.
+# With -k, requests are sent one at a time on a kept connection, and
+# with -p, in batches of pipelined requests. Static pages are checked
+# against apps/webserver/httpd-fs, after gzip decoding.
+#
+# Usage: http-client.py [-a addr] [-t seconds] [-z] [-k] [-p depth] [-q]
+#                       [path]
+
+import argparse
+import gzip
+import os
+import socket
+import time
+
+FSDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                     '../../apps/webserver/httpd-fs')
+TUN_DEV = 'tun0'
+
+def stat(name):
+    path = '/sys/class/net/%s/statistics/%s' % (TUN_DEV, name)
+    with open(path) as f:
+        return int(f.read())
+
+def counters():
+    return (stat('rx_bytes') + stat('tx_bytes'),
+            stat('rx_packets') + stat('tx_packets'))
+
+class Reader:
+    def __init__(self, sock, quickack):
+        self.sock = sock
+        self.quickack = quickack
+        self.buf = b''
+
+    def fill(self):
+        if self.quickack:
+            # Linux clears the option after a while, so set it every time
+            self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_QUICKACK, 1)
+        data = self.sock.recv(65536)
+        if not data:
+            raise EOFError
+        self.buf += data
+
+    def line(self):
+        while b'\r\n' not in self.buf:
+            self.fill()
+        line, _, self.buf = self.buf.partition(b'\r\n')
+        return line
+
+    def read(self, n):
+        while len(self.buf) < n:
+            self.fill()
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def rest(self):
+        try:
+            while True:
+                self.fill()
+        except EOFError:
+            pass
+        data, self.buf = self.buf, b''
+        return data
+
+def response(reader):
+    status = reader.line()
+    headers = {}
+    while True:
+        line = reader.line()
+        if not line:
+            break
+        name, _, value = line.partition(b':')
+        headers[name.strip().lower()] = value.strip()
+    if b'content-length' in headers:
+        body = reader.read(int(headers[b'content-length']))
+    elif headers.get(b'transfer-encoding') == b'chunked':
+        body = b''
+        while True:
+            size = int(reader.line().split(b';')[0], 16)
+            if size == 0:
+                while reader.line():
+                    pass
+                break
+            body += reader.read(size)
+            reader.read(2)
+    else:
+        body = reader.rest()
+    return status, headers, body
+
+def expected(status, path):
+    if status.split()[1] == b'404':
+        path = '/404.html'
+    elif path == '/':
+        path = '/index.html'
+    if path.endswith('.shtml'):
+        # Generated by scripts, not checked
+        return None
+    with open(FSDIR + path, 'rb') as f:
+        return f.read()
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-a', '--addr', default='fdee::2')
+    parser.add_argument('-t', '--time', type=float, default=10)
+    parser.add_argument('-z', '--gzip', action='store_true',
+                        help='send Accept-Encoding: gzip')
+    parser.add_argument('-k', '--keepalive', action='store_true',
+                        help='keep the connection open between pages')
+    parser.add_argument('-p', '--pipeline', type=int, default=0,
+                        help='send this many requests at a time; implies -k')
+    parser.add_argument('-q', '--quickack', action='store_true',
+                        help='ACK every segment at once')
+    parser.add_argument('path', nargs='?', default='/index.html')
+    args = parser.parse_args()
+
+    depth = max(args.pipeline, 1)
+    keepalive = args.keepalive or args.pipeline > 0
+    request = 'GET %s HTTP/1.1\r\nHost: [%s]\r\n' % (args.path, args.addr)
+    if args.gzip:
+        request += 'Accept-Encoding: gzip\r\n'
+    if not keepalive:
+        request += 'Connection: close\r\n'
+    request = (request + '\r\n').encode()
+
+    bytes0, packets0 = counters()
+    start = time.monotonic()
+    pages = 0
+    connections = 0
+    sock = None
+    while time.monotonic() - start < args.time:
+        if sock is None:
+            sock = socket.create_connection((args.addr, 80))
+            reader = Reader(sock, args.quickack)
+            connections += 1
+        try:
+            sock.sendall(request * depth)
+            for i in range(depth):
+                status, headers, body = response(reader)
+                pages += 1
+        except (EOFError, ConnectionResetError):
+            # The server closes when its request queue is full; the
+            # requests it did not answer are sent again
+            sock.close()
+            sock = None
+            continue
+        if not keepalive or headers.get(b'connection') == b'close':
+            sock.close()
+            sock = None
+    elapsed = time.monotonic() - start
+    bytes1, packets1 = counters()
+    if sock is not None:
+        sock.close()
+
+    encoded = headers.get(b'content-encoding') == b'gzip'
+    if encoded:
+        body = gzip.decompress(body)
+    page = expected(status, args.path)
+    check = 'unchecked' if page is None else \
+            'intact' if body == page else 'CORRUPT'
+
+    print('%s: %.1f pages/s, %d bytes/page, %.1f packets/page, '
+          '%d connections, %s, body %d bytes %s' %
+          (status.decode(), pages / elapsed, (bytes1 - bytes0) / pages,
+           (packets1 - packets0) / pages, connections,
+           'gzip' if encoded else 'identity', len(body), check))
+
+main()
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+#
+# HTTP/1.1 server for the http-socket benchmark.
+#
+# Answers every POST with a small JSON document, with a Content-Length
+# header, and keeps the connection open unless the client asks to
+# close it. Under /chunked the answer is sent with chunked
+# transfer-encoding, and under /nocontent it is a 204 without a body.
+#
+# Usage: http-server.py [port]
+
+import http.server
+import socket
+import socketserver
+import sys
+
+BODY = b'{"ok":true,"next":60}'
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    # Send the header and the body in one segment, as a real server
+    # would, and not wait for the ACK of the header (Nagle)
+    wbufsize = 8192
+
+    def log_message(self, *args):
+        pass
+
+    def do_POST(self):
+        self.rfile.read(int(self.headers.get('Content-Length', 0)))
+        if self.path == '/nocontent':
+            self.send_response(204)
+            self.end_headers()
+            return
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        if self.path == '/chunked':
+            self.send_header('Transfer-Encoding', 'chunked')
+            self.end_headers()
+            for i in range(0, len(BODY), 8):
+                chunk = BODY[i:i + 8]
+                self.wfile.write(b'%x\r\n%s\r\n' % (len(chunk), chunk))
+            self.wfile.write(b'0\r\n\r\n')
+        else:
+            self.send_header('Content-Length', str(len(BODY)))
+            self.end_headers()
+            self.wfile.write(BODY)
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    address_family = socket.AF_INET6
+    daemon_threads = True
+
+port = int(sys.argv[1]) if len(sys.argv) > 1 else 8080
+Server(('::', port), Handler).serve_forever()
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Request rate of the http-socket client on a native node over
+ *         an emulated link.
+ *
+ *         The node POSTs a small JSON document to http-server.py on
+ *         the host a number of times, one request at a time, and
+ *         prints the time and the packets it sent per request. With
+ *         keep-alive, the requests share one connection. Without it,
+ *         every request opens a new connection, and the next one
+ *         starts when the previous one has closed.
+ *
+ *         The node talks to the host through a tun device, see
+ *         tcp-benchmark/tun-link.c, so it has to be run as root.
+ *
+ *         Arguments, besides those of tun-link.c:
+ *         url=<url>      where to POST (default http://[fdee::1]:8080/)
+ *         n=<requests>   number of requests (default 100)
+ *         keepalive=<0|1> keep the connection open (default 1)
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "http-socket.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TUN_STATISTICS "/sys/class/net/tun0/statistics/"
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static struct http_socket s;
+static const char *url = "http://[fdee::1]:8080/";
+static int requests = 100;
+static int keepalive = 1;
+
+static const char postdata[] = "{\"t\":21.5,\"h\":40}";
+
+static int done, closed, failed;
+static unsigned long body_bytes;
+
+PROCESS(http_socket_benchmark_process, "http-socket benchmark");
+AUTOSTART_PROCESSES(&http_socket_benchmark_process);
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+/* Packets that the host received from the node */
+static unsigned long
+packets_from_node(void)
+{
+  FILE *f;
+  unsigned long n = 0;
+
+  f = fopen(TUN_STATISTICS "rx_packets", "r");
+  if(f != NULL) {
+    if(fscanf(f, "%lu", &n) != 1) {
+      n = 0;
+    }
+    fclose(f);
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+callback(struct http_socket *hs, void *ptr, http_socket_event_t ev,
+         const uint8_t *data, uint16_t datalen)
+{
+  if(ev == HTTP_SOCKET_DATA) {
+    body_bytes += datalen;
+  } else if(ev == HTTP_SOCKET_DONE) {
+    done = 1;
+  } else if(ev == HTTP_SOCKET_CLOSED) {
+    closed = 1;
+  } else if(ev != HTTP_SOCKET_HEADER) {
+    printf("Request failed with event %d\n", ev);
+    failed = 1;
+  }
+  process_poll(&http_socket_benchmark_process);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(http_socket_benchmark_process, ev, data)
+{
+  static struct etimer et;
+  static double start, elapsed;
+  static unsigned long packets;
+  static int i, completed;
+  uip_ipaddr_t addr;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "url=", 4) == 0) {
+      url = contiki_argv[i] + 4;
+    } else if(strncmp(contiki_argv[i], "n=", 2) == 0) {
+      requests = atoi(contiki_argv[i] + 2);
+    } else if(strncmp(contiki_argv[i], "keepalive=", 10) == 0) {
+      keepalive = atoi(contiki_argv[i] + 10);
+    }
+  }
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  /* Give the host time to bring up the tun device */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  http_socket_init(&s);
+  http_socket_set_keepalive(&s, keepalive);
+
+  printf("%d POSTs to %s, keep-alive %s\n", requests, url,
+         keepalive ? "on" : "off");
+
+  start = now();
+  packets = packets_from_node();
+  for(i = 0; i < requests && !failed; i++) {
+    done = closed = 0;
+    http_socket_post(&s, url, postdata, sizeof(postdata) - 1,
+                     "application/json", callback, NULL);
+    if(keepalive) {
+      PROCESS_WAIT_UNTIL(done || failed);
+    } else {
+      /* The socket can only be used again once it has closed */
+      PROCESS_WAIT_UNTIL((done && closed) || failed);
+    }
+    completed += done;
+  }
+  elapsed = now() - start;
+  packets = packets_from_node() - packets;
+
+  /* Close a kept connection, so that the host does not keep it. uIP
+     sends the FIN at the next periodic poll. */
+  http_socket_close(&s);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  printf("%d/%d requests completed: %.1f ms/request, "
+         "%.1f packets/request from the node, %lu body bytes\n",
+         completed, requests, elapsed * 1000 / requests,
+         (double)packets / requests, body_bytes);
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
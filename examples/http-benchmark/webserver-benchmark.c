@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         The Contiki web server on a native node, behind an emulated
+ *         link, for http-client.py to measure.
+ *
+ *         The node talks to the host through a tun device, see
+ *         tcp-benchmark/tun-link.c, so it has to be run as root.
+ *
+ *         Arguments: those of tun-link.c, e.g. delay=<ms>
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "webserver-nogui.h"
+
+#include <stdio.h>
+
+PROCESS(webserver_benchmark_process, "Web server benchmark");
+AUTOSTART_PROCESSES(&webserver_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(webserver_benchmark_process, ev, data)
+{
+  uip_ipaddr_t addr;
+
+  PROCESS_BEGIN();
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  process_start(&webserver_nogui_process, NULL);
+
+  printf("Web server on [fdee::2]:80, MSS %d\n", UIP_TCP_MSS);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Forwarding rate of an RPL root, with and without the flow
+ *         cache, on the native platform.
+ *
+ *         The node is the root of an RPL DAG with host routes through
+ *         8 neighbors. UDP packets with an RPL hop-by-hop option are
+ *         fed to tcpip_input() and forwarded to a counting output
+ *         function, in a round robin over a number of flows.
+ *
+ *         Arguments: flows=<n> packets=<n> nohbh churn
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/rpl/rpl-private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NEIGHBORS 8
+#define ROUTES    UIP_CONF_MAX_ROUTES
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static unsigned long forwarded;
+static unsigned long nexthops;
+
+static uint8_t packet[UIP_BUFSIZE];
+static int packet_len;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+output(const uip_lladdr_t *lladdr)
+{
+  /* A checksum of the next hops, to compare runs with and without
+     the cache */
+  forwarded++;
+  nexthops = nexthops * 31 + lladdr->addr[7];
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+host_addr(uip_ipaddr_t *addr, int i)
+{
+  uip_ip6addr(addr, 0xaaaa, 0, 0, 0, 0, 0, 0, 0x100 + i);
+}
+/*---------------------------------------------------------------------------*/
+static void
+neighbor_addr(uip_ipaddr_t *addr, int i)
+{
+  uip_ip6addr(addr, 0xfe80, 0, 0, 0, 0, 0, 0, 2 + i % NEIGHBORS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+setup(int hbh)
+{
+  uip_ipaddr_t addr, prefix;
+  uip_lladdr_t lladdr;
+  uip_ds6_nbr_t *nbr;
+  rpl_dag_t *dag;
+  int i;
+
+  uip_ip6addr(&prefix, 0xaaaa, 0, 0, 0, 0, 0, 0, 0);
+  uip_ip6addr(&addr, 0xaaaa, 0, 0, 0, 0, 0, 0, 1);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+  dag = rpl_set_root(RPL_DEFAULT_INSTANCE, &addr);
+  rpl_set_prefix(dag, &prefix, 64);
+
+  for(i = 0; i < NEIGHBORS; i++) {
+    memset(&lladdr, 0, sizeof(lladdr));
+    lladdr.addr[0] = 0x02;
+    lladdr.addr[7] = 2 + i;
+    neighbor_addr(&addr, i);
+    nbr = uip_ds6_nbr_add(&addr, &lladdr, 0, NBR_REACHABLE);
+    stimer_set(&nbr->reachable, 100000);
+  }
+  for(i = 0; i < ROUTES; i++) {
+    host_addr(&addr, i);
+    neighbor_addr(&prefix, i);
+    uip_ds6_route_add(&addr, 128, &prefix);
+  }
+  tcpip_set_outputfunc(output);
+
+  /* IPv6 header, RPL hop-by-hop option, UDP header and 32 bytes */
+  packet[0] = 0x60;
+  packet[7] = 64;
+  uip_ip6addr((uip_ipaddr_t *)&packet[8], 0xaaaa, 0, 0, 0, 0, 0, 0, 0x99);
+  packet_len = UIP_IPH_LEN;
+  if(hbh) {
+    packet[6] = UIP_PROTO_HBHO;
+    packet[40] = UIP_PROTO_UDP;
+    packet[42] = UIP_EXT_HDR_OPT_RPL;
+    packet[43] = RPL_HDR_OPT_LEN;
+    packet[45] = RPL_DEFAULT_INSTANCE;
+    packet[46] = 0x02;
+    packet_len += RPL_HOP_BY_HOP_LEN;
+  } else {
+    packet[6] = UIP_PROTO_UDP;
+  }
+  packet[packet_len + 1] = packet[packet_len + 3] = 0x34;
+  packet[packet_len] = packet[packet_len + 2] = 0x12;
+  packet[packet_len + 5] = UIP_UDPH_LEN + 32;
+  packet_len += UIP_UDPH_LEN + 32;
+  packet[5] = packet_len - UIP_IPH_LEN;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(flow_cache_benchmark_process, "Flow cache benchmark");
+AUTOSTART_PROCESSES(&flow_cache_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(flow_cache_benchmark_process, ev, data)
+{
+  static int flows = 1, packets = 4000000, hbh = 1, churn = 0;
+  uip_ipaddr_t addr, nexthop;
+  double start;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "flows=", 6) == 0) {
+      flows = atoi(contiki_argv[i] + 6);
+    } else if(strncmp(contiki_argv[i], "packets=", 8) == 0) {
+      packets = atoi(contiki_argv[i] + 8);
+    } else if(strcmp(contiki_argv[i], "nohbh") == 0) {
+      hbh = 0;
+    } else if(strcmp(contiki_argv[i], "churn") == 0) {
+      churn = 1;
+    }
+  }
+  if(flows < 1 || flows > ROUTES) {
+    flows = ROUTES;
+  }
+
+  setup(hbh);
+
+  start = now();
+  for(i = 0; i < packets; i++) {
+    memcpy(uip_buf, packet, packet_len);
+    host_addr(&UIP_IP_BUF->destipaddr, ROUTES - 1 - i % flows);
+    uip_len = packet_len;
+    tcpip_input();
+    if(churn && i % 1000 == 999) {
+      /* Move a route to another neighbor */
+      host_addr(&addr, ROUTES - 1 - (i / 1000) % flows);
+      neighbor_addr(&nexthop, i / 1000);
+      uip_ds6_route_add(&addr, 128, &nexthop);
+    }
+  }
+
+  printf("flow cache %d entries, %d flows%s%s: forwarded %lu of %d, "
+         "%.2f Mpps, next hops %08lx\n", UIP_DS6_FLOW_NB, flows,
+         hbh ? ", hop-by-hop option" : "", churn ? ", route churn" : "",
+         forwarded, packets, forwarded / (now() - start) / 1e6,
+         nexthops & 0xffffffffUL);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A native 6LoWPAN line network, one process per node, to see
+ *         which frames are compressed with a context learned from a
+ *         Router Advertisement, and that every hop can read them.
+ *
+ *         Nodes exchange frames through files, one frame per line.
+ *         Each run of a node reads the frames in its input file, sends
+ *         what it has to send and exits. See README.md.
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ip/simple-udp.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UDP_PORT 1234
+#define SINK 4
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static FILE *out;
+static struct simple_udp_connection udp;
+/*---------------------------------------------------------------------------*/
+/* A MAC driver that appends frames to a file: sender, receiver (0 for
+   broadcast) and the frame in hex */
+static void
+file_mac_send(mac_callback_t sent, void *ptr)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  uint8_t *data = packetbuf_dataptr();
+  int i;
+
+  printf("node %u: %u bytes to %u\n", linkaddr_node_addr.u8[7],
+         packetbuf_datalen(), dest->u8[7]);
+  if(out != NULL) {
+    fprintf(out, "%u %u ", linkaddr_node_addr.u8[7], dest->u8[7]);
+    for(i = 0; i < packetbuf_datalen(); i++) {
+      fprintf(out, "%02x", data[i]);
+    }
+    fprintf(out, "\n");
+  }
+  mac_call_sent_callback(sent, ptr, MAC_TX_OK, 1);
+}
+static void
+file_mac_init(void)
+{
+}
+static void
+file_mac_input(void)
+{
+}
+static int
+file_mac_on(void)
+{
+  return 1;
+}
+static int
+file_mac_off(int keep_radio_on)
+{
+  return 1;
+}
+static unsigned short
+file_mac_channel_check_interval(void)
+{
+  return 0;
+}
+const struct mac_driver file_mac_driver = {
+  "file", file_mac_init, file_mac_send, file_mac_input,
+  file_mac_on, file_mac_off, file_mac_channel_check_interval
+};
+/*---------------------------------------------------------------------------*/
+static void
+input_frames(const char *name)
+{
+  static char line[2 * PACKETBUF_SIZE + 16];
+  FILE *in;
+  unsigned int from, to, byte;
+  int n, len;
+  char *hex;
+  linkaddr_t addr;
+
+  in = fopen(name, "r");
+  if(in == NULL) {
+    perror(name);
+    return;
+  }
+  while(fgets(line, sizeof(line), in) != NULL) {
+    if(sscanf(line, "%u %u %n", &from, &to, &n) != 2) {
+      continue;
+    }
+    if(to != 0 && to != linkaddr_node_addr.u8[7]) {
+      continue;
+    }
+    packetbuf_clear();
+    hex = line + n;
+    for(len = 0; sscanf(hex + 2 * len, "%2x", &byte) == 1; len++) {
+      ((uint8_t *)packetbuf_dataptr())[len] = byte;
+    }
+    packetbuf_set_datalen(len);
+    memset(&addr, 0, sizeof(addr));
+    addr.u8[7] = from;
+    packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &addr);
+    addr.u8[7] = to;
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, to ? &addr : &linkaddr_null);
+    NETSTACK_NETWORK.input();
+  }
+  fclose(in);
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_ipaddr(uip_ipaddr_t *ipaddr, uint16_t prefix, uint8_t id)
+{
+  uip_lladdr_t lladdr;
+
+  memset(&lladdr, 0, sizeof(lladdr));
+  lladdr.addr[7] = id;
+  uip_ip6addr(ipaddr, prefix, prefix == 0xfe80 ? 0 : 0x1234, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(ipaddr, &lladdr);
+}
+/*---------------------------------------------------------------------------*/
+/* Take the link-layer address of node id, and the addresses that go with it */
+static void
+set_node(uint8_t id)
+{
+  linkaddr_t addr;
+  uip_ipaddr_t ipaddr;
+
+  uip_ds6_addr_rm(uip_ds6_get_link_local(-1));
+  memset(&addr, 0, sizeof(addr));
+  addr.u8[7] = id;
+  linkaddr_set_node_addr(&addr);
+  memcpy(&uip_lladdr, &addr, sizeof(uip_lladdr));
+  node_ipaddr(&ipaddr, 0xfe80, id);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+#if ROUTER
+  node_ipaddr(&ipaddr, 0xfd00, id);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_MANUAL);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Send packets for the sink to node via */
+static void
+add_route(uint8_t via)
+{
+  uip_ipaddr_t sink, nexthop;
+  uip_lladdr_t lladdr;
+  uip_ds6_nbr_t *nbr;
+
+  memset(&lladdr, 0, sizeof(lladdr));
+  lladdr.addr[7] = via;
+  node_ipaddr(&sink, 0xfd00, SINK);
+  node_ipaddr(&nexthop, 0xfe80, via);
+  nbr = uip_ds6_nbr_add(&nexthop, &lladdr, 1, NBR_REACHABLE);
+  stimer_set(&nbr->reachable, 3600);
+  uip_ds6_route_add(&sink, 128, &nexthop);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr, uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr, uint16_t receiver_port,
+         const uint8_t *data, uint16_t datalen)
+{
+  printf("node %u: received \"%.*s\"\n", linkaddr_node_addr.u8[7],
+         datalen, (const char *)data);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(lowpan_contexts_process, "6LoWPAN contexts");
+AUTOSTART_PROCESSES(&lowpan_contexts_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lowpan_contexts_process, ev, data)
+{
+  uip_ipaddr_t ipaddr;
+  int i;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  /* id=<n> ctx via=<n> out=<file> in=<file> ra send, in that order */
+  for(i = 1; i < contiki_argc; i++) {
+    const char *arg = contiki_argv[i];
+
+    if(strncmp(arg, "id=", 3) == 0) {
+      set_node(atoi(arg + 3));
+#if ROUTER
+      if(linkaddr_node_addr.u8[7] < SINK) {
+        add_route(linkaddr_node_addr.u8[7] + 1);
+      }
+#endif
+    } else if(strcmp(arg, "ctx") == 0) {
+      /* set at boot on every router */
+      uip_ip6addr(&ipaddr, 0xfd00, 0x1234, 0, 0, 0, 0, 0, 0);
+      sicslowpan_context_set(1, ipaddr.u8, 64, 1, 3600, NULL);
+    } else if(strncmp(arg, "via=", 4) == 0) {
+      add_route(atoi(arg + 4));
+    } else if(strncmp(arg, "in=", 3) == 0) {
+      input_frames(arg + 3);
+    } else if(strncmp(arg, "out=", 4) == 0) {
+      out = fopen(arg + 4, "w");
+    } else if(strcmp(arg, "ra") == 0) {
+#if ROUTER
+      uip_ip6addr(&ipaddr, 0xfd00, 0x1234, 0, 0, 0, 0, 0, 0);
+      uip_ds6_prefix_add(&ipaddr, 64, 1, UIP_ND6_RA_FLAG_AUTONOMOUS,
+                         86400, 14400);
+      uip_nd6_ra_output(NULL);
+      tcpip_ipv6_output();
+#endif
+    } else if(strcmp(arg, "send") == 0) {
+      node_ipaddr(&ipaddr, 0xfd00, SINK);
+      simple_udp_sendto(&udp, "hello", 5, &ipaddr);
+    }
+  }
+
+  printf("node %u: %lu addresses compressed with a context, "
+         "%lu packets with an unknown context\n", linkaddr_node_addr.u8[7],
+         sicslowpan_stats.ctx_addr, sicslowpan_stats.ctx_unknown);
+  if(out != NULL) {
+    fclose(out);
+  }
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Build the host and router firmware and send one UDP packet from the
+# host (node 1) to the sink (node 4) over routers 2 and 3. Node 2 sends
+# the Router Advertisement with the context. Frames go through files in
+# a temporary directory.
+set -e
+cd "$(dirname "$0")"
+rm -rf obj_native
+make ROUTER=1 TARGET=native >/dev/null && mv lowpan-contexts.native router.native
+rm -rf obj_native
+make ROUTER=0 TARGET=native >/dev/null && mv lowpan-contexts.native host.native
+
+T=$(mktemp -d)
+run() {
+  ./"$@" | grep '^node'
+}
+
+echo "== node 2 advertises context 1"
+run router.native id=2 ctx out=$T/ra ra
+
+echo "== host sends through node 2, which knows the context"
+run host.native id=1 via=2 out=$T/h in=$T/ra send
+run router.native id=2 ctx out=$T/r1 in=$T/h
+run router.native id=3 ctx out=$T/r2 in=$T/r1
+run router.native id=4 ctx in=$T/r2
+
+echo "== host sends through node 3, which does not have the context"
+run host.native id=1 via=3 out=$T/h in=$T/ra send
+run router.native id=3 out=$T/r2 in=$T/h
+run router.native id=4 in=$T/r2
+
+rm -rf $T
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Cost of queueing a packet for neighbor discovery, with and
+ *         without the uIP buffer pool, on the native platform.
+ *
+ *         First, three UDP packets are sent to a neighbor whose link
+ *         address is not known yet. They must be queued, and must go
+ *         out after the next packet once the neighbor is reachable.
+ *         Then uip_packetqueue_store() and uip_packetqueue_load() are
+ *         timed for packets of several sizes, and the loaded packet is
+ *         compared with the stored one.
+ *
+ *         Arguments: count=<n>, the number of store and load pairs per
+ *         size (default 1000000)
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ip/simple-udp.h"
+#include "net/ip/uip-packetqueue.h"
+#include "net/ipv6/uip-ds6.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static struct simple_udp_connection conn;
+static char sent[8][9];
+static int nsent;
+
+static const int sizes[] = { 100, 640, 1280 };
+/*---------------------------------------------------------------------------*/
+static uint8_t
+output(const uip_lladdr_t *lladdr)
+{
+  /* Keep the payloads of the UDP packets that go out */
+  if(UIP_IP_BUF->proto == UIP_PROTO_UDP && nsent < 8) {
+    memcpy(sent[nsent], &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN], 8);
+    sent[nsent][8] = '\0';
+    nsent++;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_queue(void)
+{
+  static const char *expected[] = { "packet-D", "packet-A",
+                                    "packet-B", "packet-C" };
+  uip_ipaddr_t addr, peer;
+  uip_lladdr_t lladdr;
+  uip_ds6_nbr_t *nbr;
+  int i;
+
+  uip_ip6addr(&addr, 0xfd77, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+  uip_ip6addr(&peer, 0xfd77, 0, 0, 0, 0, 0, 0, 1);
+  uip_ds6_defrt_add(&peer, 0);
+  simple_udp_register(&conn, 1234, NULL, 1234, NULL);
+
+  memset(&lladdr, 1, sizeof(lladdr));
+  nbr = uip_ds6_nbr_add(&peer, &lladdr, 0, NBR_INCOMPLETE);
+  simple_udp_sendto(&conn, "packet-A", 8, &peer);
+  simple_udp_sendto(&conn, "packet-B", 8, &peer);
+  simple_udp_sendto(&conn, "packet-C", 8, &peer);
+  printf("neighbor incomplete: %d sent, %d queued\n", nsent,
+         uip_packetqueue_len(&nbr->packethandle));
+  if(nsent != 0) {
+    return 0;
+  }
+
+  nbr->state = NBR_STALE;
+  simple_udp_sendto(&conn, "packet-D", 8, &peer);
+  printf("neighbor stale: sent");
+  for(i = 0; i < nsent; i++) {
+    printf(" %s", sent[i]);
+  }
+  printf("\n");
+#if UIP_BUF_POOL
+  printf("free buffers: %d\n", uip_bufpool_numfree());
+#endif /* UIP_BUF_POOL */
+
+  for(i = 0; i < 4; i++) {
+    if(i >= nsent || strcmp(sent[i], expected[i]) != 0) {
+      return 0;
+    }
+  }
+  return nsent == 4;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(int size, long count)
+{
+  static struct uip_packetqueue_handle handle;
+  uint8_t packet[UIP_BUFSIZE];
+  double start;
+  long i;
+  int j;
+
+  for(j = 0; j < size; j++) {
+    packet[j] = j * 7;
+  }
+  uip_packetqueue_new(&handle);
+
+  start = now();
+  for(i = 0; i < count; i++) {
+    uip_len = size;
+    uip_packetqueue_store(&handle, CLOCK_SECOND);
+    uip_packetqueue_load(&handle);
+  }
+  printf("%4d bytes: %6.1f ns per store and load\n", size,
+         (now() - start) * 1e9 / count);
+
+  /* The packet must come back as it was */
+  memcpy(&uip_buf[UIP_LLH_LEN], packet, size);
+  uip_len = size;
+  uip_packetqueue_store(&handle, CLOCK_SECOND);
+  memset(&uip_buf[UIP_LLH_LEN], 0, size);
+  uip_len = 0;
+  if(!uip_packetqueue_load(&handle) || uip_len != size ||
+     memcmp(&uip_buf[UIP_LLH_LEN], packet, size) != 0) {
+    printf("%4d bytes: loaded packet differs\n", size);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(packetqueue_benchmark_process, "Packet queue benchmark");
+AUTOSTART_PROCESSES(&packetqueue_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(packetqueue_benchmark_process, ev, data)
+{
+  long count = 1000000;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "count=", 6) == 0) {
+      count = atol(contiki_argv[i] + 6);
+    }
+  }
+
+  tcpip_set_outputfunc(output);
+
+  printf("buffer pool: %d buffers\n", UIP_BUF_POOL);
+  printf("queueing: %s\n", check_queue() ? "ok" : "FAILED");
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    run(sizes[i], count);
+  }
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
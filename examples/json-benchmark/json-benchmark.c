@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Parse rate of the streaming JSON parser (jsonstream), fed in
+ *         chunks, and of jsonparse, which needs the whole document in
+ *         RAM, on the native platform.
+ *
+ *         The document is an array of objects with numbers and
+ *         strings. jsonparse has no negative numbers, so there are
+ *         none. It is also fed to jsonstream in chunks of 1 to 39
+ *         bytes, which must give the same elements as one chunk, and
+ *         in a damaged form, which must be rejected.
+ *
+ *         Arguments: objects=<n> (default 3000), chunk=<n>, the chunk
+ *         size in bytes (default 64), rounds=<n>, the number of times
+ *         the document is parsed for the rate (default 200)
+ */
+
+#include "contiki.h"
+#include "jsonparse.h"
+#include "jsonstream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static char *document;
+static int document_len;
+/*---------------------------------------------------------------------------*/
+static void
+make_document(int objects)
+{
+  int i;
+
+  document = malloc(objects * 64 + 16);
+  if(document == NULL) {
+    printf("out of memory\n");
+    exit(1);
+  }
+  document_len = sprintf(document, "{\"items\":[");
+  for(i = 0; i < objects; i++) {
+    document_len += sprintf(document + document_len,
+                            "%s{\"id\":%d,\"name\":\"sensor-%d\","
+                            "\"value\":%d.%d}",
+                            i > 0 ? "," : "", i, i, i % 40, i % 10);
+  }
+  document_len += sprintf(document + document_len, "]}");
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the document in chunks and returns a checksum of the elements
+   and their values, or 0 on a parse error. */
+static unsigned long
+parse_stream(const char *data, int len, int chunk)
+{
+  static struct jsonstream_state state;
+  unsigned long sum = 1;
+  const char *value;
+  int pos, n, type;
+
+  jsonstream_setup(&state, NULL, NULL);
+  for(pos = 0; pos < len; pos += n) {
+    n = len - pos < chunk ? len - pos : chunk;
+    jsonstream_set_input(&state, data + pos, n);
+    while((type = jsonstream_next(&state)) != JSONSTREAM_MORE) {
+      if(type == JSONSTREAM_ERROR) {
+        return 0;
+      }
+      sum = sum * 31 + type;
+      if(type == JSON_TYPE_STRING || type == JSON_TYPE_NUMBER ||
+         type == JSON_TYPE_PAIR_NAME) {
+        for(value = jsonstream_get_value(&state); *value != '\0'; value++) {
+          sum = sum * 31 + *value;
+        }
+      }
+    }
+  }
+  return jsonstream_is_complete(&state) ? sum : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if jsonparse got to the end of the document */
+static int
+parse_whole(const char *data, int len)
+{
+  static struct jsonparse_state state;
+
+  jsonparse_setup(&state, data, len);
+  while(jsonparse_next(&state) != 0) {
+    /* Only the parse is timed */
+  }
+  return state.pos >= len && state.error == JSON_ERROR_OK;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(json_benchmark_process, "JSON benchmark");
+AUTOSTART_PROCESSES(&json_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(json_benchmark_process, ev, data)
+{
+  int objects = 3000;
+  int chunk = 64;
+  long rounds = 200;
+  unsigned long sum;
+  double start;
+  long i;
+  char *c;
+  int ok;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "objects=", 8) == 0) {
+      objects = atoi(contiki_argv[i] + 8);
+    } else if(strncmp(contiki_argv[i], "chunk=", 6) == 0) {
+      chunk = atoi(contiki_argv[i] + 6);
+    } else if(strncmp(contiki_argv[i], "rounds=", 7) == 0) {
+      rounds = atol(contiki_argv[i] + 7);
+    }
+  }
+  if(chunk < 1) {
+    chunk = 1;
+  }
+
+  make_document(objects);
+  printf("document: %d objects, %d bytes\n", objects, document_len);
+
+  /* The elements must not depend on where the chunks are split */
+  sum = parse_stream(document, document_len, document_len);
+  ok = sum != 0;
+  for(i = 1; i < 40; i++) {
+    if(parse_stream(document, document_len, i) != sum) {
+      ok = 0;
+    }
+  }
+  printf("chunks of 1 to 39 bytes: %s\n", ok ? "same elements" : "FAILED");
+
+  /* A document cut short or with a bad separator must be rejected */
+  ok = parse_stream(document, document_len - 1, chunk) == 0;
+  c = strchr(document, ':');
+  *c = '=';
+  ok = ok && parse_stream(document, document_len, chunk) == 0;
+  *c = ':';
+  printf("damaged document: %s\n", ok ? "rejected" : "FAILED");
+
+  printf("jsonparse: %s\n", parse_whole(document, document_len) ?
+         "whole document parsed" : "FAILED");
+
+  start = now();
+  for(i = 0; i < rounds; i++) {
+    parse_stream(document, document_len, chunk);
+  }
+  printf("jsonstream, %d-byte chunks: %6.1f MB/s\n", chunk,
+         document_len * rounds / (now() - start) / 1e6);
+
+  start = now();
+  for(i = 0; i < rounds; i++) {
+    parse_whole(document, document_len);
+  }
+  printf("jsonparse, whole document:  %6.1f MB/s\n",
+         document_len * rounds / (now() - start) / 1e6);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Payload size and read rate of the OMA LWM2M TLV and SenML CBOR
+ *         formats, for reads through the LWM2M engine on the native
+ *         platform.
+ *
+ *         The objects are those of the engine and the IPSO objects: the
+ *         device (object 3), an IPSO temperature sensor (object 3303)
+ *         and one IPSO light control per LED (object 3311). Each read
+ *         is a CoAP GET handled by lwm2m_engine_handler(), of one
+ *         instance or of the whole object, with the format in the
+ *         Content-Format option as the engine expects it. The SenML CBOR
+ *         and TLV payloads of the temperature are read back to check
+ *         them. Single resources are read too, as TLV, which the
+ *         engine finds by a binary search of the resources.
+ *
+ *         Arguments: count=<n>, the number of times each read is done
+ *         for the rate (default 200000), size=<n>, the size of the
+ *         response buffer given to the engine (default 256). A payload
+ *         that does not fit is answered with 4.13.
+ */
+
+#include "contiki.h"
+#include "er-coap.h"
+#include "ipso-objects.h"
+#include "lwm2m-device.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-senml-cbor.h"
+#include "oma-tlv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* 21.5 degrees Celsius */
+#define TEMPERATURE 21500
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static coap_packet_t request[1];
+static coap_packet_t response[1];
+static uint8_t buffer[REST_MAX_CHUNK_SIZE];
+static uint16_t size = sizeof(buffer);
+/*---------------------------------------------------------------------------*/
+static int
+read_temperature(int32_t *value)
+{
+  *value = TEMPERATURE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const struct ipso_objects_sensor benchmark_temperature = {
+  NULL, read_temperature
+};
+/*---------------------------------------------------------------------------*/
+/* Does one GET of the path and returns the payload length, or -1 if the
+   engine answered with an error */
+static int
+read_path(const char *path, unsigned int format)
+{
+  const lwm2m_object_t *object;
+  int32_t offset = 0;
+
+  object = lwm2m_engine_get_object(atoi(path));
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, path);
+  coap_set_header_content_format(request, format);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+  lwm2m_engine_handler(object, request, response, buffer, size, &offset);
+  if(response->code != CONTENT_2_05) {
+    return -1;
+  }
+  return response->payload_len;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the temperature in a read of /3303/0 in either format */
+static int
+check_temperature(unsigned int format)
+{
+  lwm2m_context_t ctx;
+  oma_tlv_t tlv;
+  int32_t value;
+  size_t pos, len;
+  int plen;
+
+  plen = read_path("3303/0", format);
+  if(plen <= 0) {
+    return 0;
+  }
+  if(format == LWM2M_SENML_CBOR) {
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.object_id = 3303;
+    ctx.resource_id = 5700;
+    return lwm2m_senml_cbor_reader.read_float32fix(&ctx, response->payload,
+                                                   plen, &value,
+                                                   LWM2M_FLOAT32_BITS) > 0
+      && value == TEMPERATURE * LWM2M_FLOAT32_FRAC / 1000;
+  }
+  for(pos = 0; pos < plen; pos += len) {
+    len = oma_tlv_read(&tlv, &response->payload[pos], plen - pos);
+    if(len == 0) {
+      return 0;
+    }
+    if(tlv.type == OMA_TLV_TYPE_RESOURCE && tlv.id == 5700) {
+      return oma_tlv_float32_to_fix(&tlv, &value, LWM2M_FLOAT32_BITS)
+        && value == TEMPERATURE * LWM2M_FLOAT32_FRAC / 1000;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(const char *path, int formats_count, long count)
+{
+  static const unsigned int formats[] = { LWM2M_TLV, LWM2M_SENML_CBOR };
+  double start;
+  int f, len;
+  long i;
+
+  for(f = 0; f < formats_count; f++) {
+    len = read_path(path, formats[f]);
+    if(len < 0) {
+      printf("%-12s %-10s FAILED (%u.%02u)\n", path,
+             f == 0 ? "TLV" : "SenML CBOR",
+             response->code >> 5, response->code & 0x1f);
+      continue;
+    }
+    start = now();
+    for(i = 0; i < count; i++) {
+      read_path(path, formats[f]);
+    }
+    printf("%-12s %-10s %4d bytes %6.2f M reads/s\n", path,
+           f == 0 ? "TLV" : "SenML CBOR", len,
+           count / (now() - start) / 1e6);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(lwm2m_format_benchmark_process, "LWM2M format benchmark");
+AUTOSTART_PROCESSES(&lwm2m_format_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lwm2m_format_benchmark_process, ev, data)
+{
+  long count = 200000;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "count=", 6) == 0) {
+      count = atol(contiki_argv[i] + 6);
+    } else if(strncmp(contiki_argv[i], "size=", 5) == 0) {
+      size = atoi(contiki_argv[i] + 5);
+      if(size > sizeof(buffer)) {
+        size = sizeof(buffer);
+      }
+    }
+  }
+
+  lwm2m_device_init();
+  ipso_temperature_init();
+  ipso_leds_control_init();
+
+  printf("temperature read back: TLV %s, SenML CBOR %s\n",
+         check_temperature(LWM2M_TLV) ? "ok" : "FAILED",
+         check_temperature(LWM2M_SENML_CBOR) ? "ok" : "FAILED");
+
+  run("3/0", 2, count);
+  run("3303/0", 2, count);
+  run("3303", 2, count);
+  run("3311/0", 2, count);
+  run("3311", 2, count);
+  run("3/0/13", 1, count);
+  run("3303/0/5602", 1, count);
+  run("3311/2/5852", 1, count);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Publish rate and round-trip time of the MQTT client against a
+ *         broker on the host, on the native platform. The node talks to
+ *         the host through the emulated link of the TCP benchmark.
+ *
+ *         In rate mode, count messages are published as fast as
+ *         mqtt_ready() allows, and the rate is taken when the last one
+ *         is acknowledged: by PUBACK or PUBCOMP for QoS 1 and 2, and by
+ *         TCP for QoS 0. When no acknowledgement arrives for two
+ *         seconds, the node prints the messages in flight and exits,
+ *         as if it lost power. With persistence, the next run sends
+ *         them again; resume mode only waits for them.
+ *
+ *         In rtt mode, the node subscribes to its topic, and the time
+ *         from mqtt_publish() to the arrival of the message from the
+ *         broker is taken, one message at a time.
+ *
+ *         Built with COPIES=1, the bytes that memcpy() and memmove()
+ *         copy are counted, except the copies of whole packets out of
+ *         uip_buf, which are made by the emulated link.
+ *
+ *         Arguments: mode=<rate|rtt|resume> (default rate),
+ *         count=<n> (default 1000), qos=<0|1|2> (default 1),
+ *         size=<n>, the payload size in bytes (default 64), gather=1
+ *         to publish with mqtt_publish_gather(), and the arguments of
+ *         tun-link.c
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "mqtt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BROKER_ADDR "fdee::1"
+#define BROKER_PORT 1883
+#define TOPIC       "bench/data"
+#define MAX_SIZE    1024
+#define STALL_TIME  (2 * CLOCK_SECOND)
+
+/* Waits until cond is true or nothing has happened for STALL_TIME. The
+   timer wakes the process up at every tick. */
+#define WAIT_UNTIL_OR_STALLED(cond)                 \
+  while(!(cond) && !stalled()) {                    \
+    PROCESS_WAIT_EVENT();                           \
+    if(etimer_expired(&et)) {                       \
+      etimer_reset(&et);                            \
+    }                                               \
+  }
+
+/* Ends a run. The broker would otherwise keep the connection, and
+   the next run uses the same port and sequence numbers. */
+#define DISCONNECT_AND_EXIT()                       \
+  do {                                              \
+    closing = 1;                                    \
+    mqtt_disconnect(&conn);                         \
+    WAIT_UNTIL_OR_STALLED(!connected);              \
+    exit(0);                                        \
+  } while(0)
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static struct mqtt_connection conn;
+static uint8_t payload[MAX_SIZE];
+static struct mqtt_gather parts[2];
+static char client_id[] = "mqtt-benchmark";
+
+static enum { MODE_RATE, MODE_RTT, MODE_RESUME } mode = MODE_RATE;
+static long count = 1000;
+static mqtt_qos_level_t qos = MQTT_QOS_LEVEL_1;
+static int size = 64;
+static int gather;
+
+static long acked;
+static long echoed;
+static int connected;
+static int closing;
+static int subscribed;
+static int restored;
+static clock_time_t progress;
+static struct etimer et;
+
+PROCESS(mqtt_benchmark_process, "MQTT benchmark");
+AUTOSTART_PROCESSES(&mqtt_benchmark_process);
+/*---------------------------------------------------------------------------*/
+#if COPIES
+static unsigned long copied;
+
+void *__real_memcpy(void *dest, const void *src, size_t n);
+void *__real_memmove(void *dest, const void *src, size_t n);
+
+void *
+__wrap_memcpy(void *dest, const void *src, size_t n)
+{
+  if(src != &uip_buf[UIP_LLH_LEN]) {
+    copied += n;
+  }
+  return __real_memcpy(dest, src, n);
+}
+
+void *
+__wrap_memmove(void *dest, const void *src, size_t n)
+{
+  copied += n;
+  return __real_memmove(dest, src, n);
+}
+#endif /* COPIES */
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  switch(event) {
+  case MQTT_EVENT_SUBACK:
+    subscribed = 1;
+    break;
+  case MQTT_EVENT_PUBACK:
+    acked++;
+    break;
+  case MQTT_EVENT_PUBLISH:
+    if(((struct mqtt_message *)data)->payload_left == 0) {
+      echoed++;
+    }
+    break;
+  case MQTT_EVENT_CONNECTED:
+    connected = 1;
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    if(connected && !closing) {
+      printf("disconnected from the broker\n");
+      exit(1);
+    }
+    connected = 0;
+    break;
+  default:
+    break;
+  }
+  progress = clock_time();
+  process_poll(&mqtt_benchmark_process);
+}
+/*---------------------------------------------------------------------------*/
+static int
+stalled(void)
+{
+  return clock_time() - progress > STALL_TIME;
+}
+/*---------------------------------------------------------------------------*/
+static mqtt_status_t
+publish(void)
+{
+  mqtt_status_t status;
+
+  if(gather) {
+    status = mqtt_publish_gather(&conn, NULL, TOPIC, parts, 2, qos,
+                                 MQTT_RETAIN_OFF);
+  } else {
+    status = mqtt_publish(&conn, NULL, TOPIC, payload, size, qos,
+                          MQTT_RETAIN_OFF);
+  }
+  if(status == MQTT_STATUS_OK) {
+    progress = clock_time();
+  }
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_inflight(void)
+{
+  int i;
+
+  printf("%d messages in flight:", conn.inflight_count);
+  for(i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+    if(conn.inflight[i].mid != 0) {
+      printf(" %u", conn.inflight[i].mid);
+    }
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_benchmark_process, ev, data)
+{
+  static double start, rtt, rtt_min, rtt_max;
+  static long sent;
+  uip_ipaddr_t addr;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "mode=", 5) == 0) {
+      if(strcmp(contiki_argv[i] + 5, "rtt") == 0) {
+        mode = MODE_RTT;
+      } else if(strcmp(contiki_argv[i] + 5, "resume") == 0) {
+        mode = MODE_RESUME;
+      }
+    } else if(strncmp(contiki_argv[i], "count=", 6) == 0) {
+      count = atol(contiki_argv[i] + 6);
+    } else if(strncmp(contiki_argv[i], "qos=", 4) == 0) {
+      qos = atoi(contiki_argv[i] + 4);
+    } else if(strncmp(contiki_argv[i], "size=", 5) == 0) {
+      size = atoi(contiki_argv[i] + 5);
+    } else if(strncmp(contiki_argv[i], "gather=", 7) == 0) {
+      gather = atoi(contiki_argv[i] + 7);
+    }
+  }
+  if(size > MAX_SIZE) {
+    size = MAX_SIZE;
+  }
+  for(i = 0; i < size; i++) {
+    payload[i] = 'a' + i % 26;
+  }
+  /* Two parts, as for a header and a body kept apart */
+  parts[0].data = payload;
+  parts[0].len = size / 2;
+  parts[1].data = &payload[size / 2];
+  parts[1].len = size - size / 2;
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  mqtt_register(&conn, &mqtt_benchmark_process, client_id, mqtt_event,
+                UIP_TCP_MSS);
+  restored = conn.inflight_count;
+  if(restored > 0) {
+    printf("restored ");
+    print_inflight();
+  }
+  if(mode == MODE_RESUME && restored == 0) {
+    printf("nothing to resume\n");
+    exit(0);
+  }
+
+  etimer_set(&et, 1);
+  progress = clock_time();
+  /* The broker may still hold the connection of an earlier run on the
+     same port, the first attempt is then reset */
+  WAIT_UNTIL_OR_STALLED(mqtt_connect(&conn, BROKER_ADDR, BROKER_PORT, 60)
+                        == MQTT_STATUS_OK && mqtt_connected(&conn));
+  if(!mqtt_connected(&conn)) {
+    printf("no connection to [%s]:%u\n", BROKER_ADDR, BROKER_PORT);
+    exit(1);
+  }
+  start = now();
+  printf("connected to [%s]:%u, in-flight window %d, %s\n", BROKER_ADDR,
+         BROKER_PORT, MQTT_INFLIGHT_WINDOW,
+         MQTT_PERSISTENCE ? "persistence on" : "persistence off");
+
+  if(mode == MODE_RESUME) {
+    WAIT_UNTIL_OR_STALLED(acked == restored);
+    printf("%ld of %d restored messages acknowledged in %.1f ms\n",
+           acked, restored, (now() - start) * 1000);
+    DISCONNECT_AND_EXIT();
+  }
+
+  if(mode == MODE_RTT) {
+    mqtt_subscribe(&conn, NULL, TOPIC, MQTT_QOS_LEVEL_0);
+    WAIT_UNTIL_OR_STALLED(subscribed);
+    rtt = 0;
+    rtt_min = 1e9;
+    rtt_max = 0;
+    for(sent = 0; sent < count; sent++) {
+      WAIT_UNTIL_OR_STALLED(mqtt_ready(&conn) && acked == sent * (qos > 0));
+      start = now();
+      publish();
+      WAIT_UNTIL_OR_STALLED(echoed > sent);
+      if(stalled()) {
+        printf("no echo of message %ld\n", sent);
+        exit(1);
+      }
+      start = now() - start;
+      rtt += start;
+      rtt_min = start < rtt_min ? start : rtt_min;
+      rtt_max = start > rtt_max ? start : rtt_max;
+    }
+    printf("round trip, QoS %d, %d-byte payload: min %.0f us, "
+           "mean %.0f us, max %.0f us\n", qos, size, rtt_min * 1e6,
+           rtt / count * 1e6, rtt_max * 1e6);
+    DISCONNECT_AND_EXIT();
+  }
+
+  /* Rate mode. Restored messages are sent again before the new ones. */
+  WAIT_UNTIL_OR_STALLED(acked == restored);
+  acked = 0;
+#if COPIES
+  copied = 0;
+#endif /* COPIES */
+  start = now();
+  for(sent = 0; sent < count && !stalled();) {
+    if(mqtt_ready(&conn) && publish() == MQTT_STATUS_OK) {
+      sent++;
+    }
+    PROCESS_WAIT_EVENT();
+    if(etimer_expired(&et)) {
+      etimer_reset(&et);
+    }
+  }
+  /* The last acknowledgements, by TCP for QoS 0 */
+  WAIT_UNTIL_OR_STALLED(qos > 0 ? acked == sent :
+                        tcp_socket_queuelen(&conn.socket) == 0);
+  start = now() - start;
+  if(stalled()) {
+    printf("no acknowledgement for %d s after %ld messages, ",
+           (int)(STALL_TIME / CLOCK_SECOND), sent);
+    print_inflight();
+    exit(0);
+  }
+  printf("QoS %d, %d-byte payload%s: %ld messages in %.3f s, %.0f msg/s\n",
+         qos, size, gather ? ", gathered" : "", sent, start, sent / start);
+#if COPIES
+  printf("copied %.1f bytes per message, %.2f per payload byte\n",
+         (double)copied / sent, (double)copied / sent / size);
+#endif /* COPIES */
+  DISCONNECT_AND_EXIT();
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+#
+# Stand-in MQTT broker for the MQTT benchmark.
+#
+# Speaks enough MQTT 3.1 for the Contiki client: CONNECT, PUBLISH with
+# QoS 0, 1 and 2, SUBSCRIBE, UNSUBSCRIBE, PINGREQ and DISCONNECT. A
+# PUBLISH is sent on with QoS 0 to the connections that subscribed to
+# its topic. Sessions are not kept, as the client keeps its in-flight
+# messages itself. With --hold, the first connection gets no PUBACK or
+# PUBREC after the given number of publishes, so that its messages stay
+# in flight. Prints the publishes, with DUP flag and in total, of every
+# connection when it closes.
+#
+# Usage: mqtt-broker.py [-p port] [--hold n]
+
+import argparse
+import socket
+import socketserver
+import struct
+import threading
+
+lock = threading.Lock()
+subscribers = {}
+connections = 0
+
+class Handler(socketserver.BaseRequestHandler):
+    def setup(self):
+        global connections
+        self.sock = self.request
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buf = b''
+        self.topics = set()
+        self.publishes = 0
+        self.dups = 0
+        with lock:
+            connections += 1
+            self.number = connections
+        self.hold = self.server.hold if self.number == 1 else None
+
+    def fill(self):
+        # Acknowledge every segment at once, with one segment in flight the
+        # node waits for each ACK
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_QUICKACK, 1)
+        data = self.sock.recv(65536)
+        if not data:
+            raise EOFError
+        self.buf += data
+
+    def packet(self):
+        while True:
+            length, shift, pos = 0, 0, 1
+            while pos < len(self.buf):
+                length |= (self.buf[pos] & 0x7f) << shift
+                shift += 7
+                pos += 1
+                if not self.buf[pos - 1] & 0x80:
+                    break
+            else:
+                self.fill()
+                continue
+            if len(self.buf) < pos + length:
+                self.fill()
+                continue
+            fhdr, body = self.buf[0], self.buf[pos:pos + length]
+            self.buf = self.buf[pos + length:]
+            return fhdr, body
+
+    def send(self, data):
+        try:
+            self.sock.sendall(data)
+        except OSError:
+            pass
+
+    def publish(self, fhdr, body):
+        qos = (fhdr >> 1) & 3
+        topic_len, = struct.unpack('>H', body[:2])
+        topic = body[2:2 + topic_len]
+        pos = 2 + topic_len
+        self.publishes += 1
+        if fhdr & 0x08:
+            self.dups += 1
+        if qos > 0:
+            mid = body[pos:pos + 2]
+            pos += 2
+            if self.hold is None or self.publishes <= self.hold:
+                self.send(bytes([0x40 if qos == 1 else 0x50, 2]) + mid)
+        with lock:
+            targets = list(subscribers.get(topic, ()))
+        for target in targets:
+            payload = body[pos:]
+            out = struct.pack('>H', len(topic)) + topic + payload
+            target.send(bytes([0x30]) + encode_length(len(out)) + out)
+
+    def handle(self):
+        try:
+            while True:
+                fhdr, body = self.packet()
+                kind = fhdr & 0xf0
+                if kind == 0x10:
+                    self.send(b'\x20\x02\x00\x00')
+                elif kind == 0x30:
+                    self.publish(fhdr, body)
+                elif kind == 0x60:
+                    self.send(b'\x70\x02' + body[:2])
+                elif kind == 0x80:
+                    pos, granted = 2, b''
+                    while pos < len(body):
+                        n, = struct.unpack('>H', body[pos:pos + 2])
+                        topic = body[pos + 2:pos + 2 + n]
+                        pos += n + 3
+                        self.topics.add(topic)
+                        with lock:
+                            subscribers.setdefault(topic, set()).add(self)
+                        granted += b'\x00'
+                    self.send(bytes([0x90, 2 + len(granted)]) + body[:2] +
+                              granted)
+                elif kind == 0xa0:
+                    self.send(b'\xb0\x02' + body[:2])
+                elif kind == 0xc0:
+                    self.send(b'\xd0\x00')
+                elif kind == 0xe0:
+                    break
+        except (EOFError, OSError):
+            pass
+
+    def finish(self):
+        with lock:
+            for topic in self.topics:
+                subscribers[topic].discard(self)
+        print('connection %d: %d publishes, %d with DUP flag' %
+              (self.number, self.publishes, self.dups), flush=True)
+
+def encode_length(n):
+    out = b''
+    while True:
+        b = n & 0x7f
+        n >>= 7
+        out += bytes([b | (0x80 if n else 0)])
+        if not n:
+            return out
+
+class Server(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    address_family = socket.AF_INET6
+    allow_reuse_address = True
+    daemon_threads = True
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-p', '--port', type=int, default=1883)
+    parser.add_argument('--hold', type=int, default=None,
+                        help='publishes of the first connection to '
+                        'acknowledge before holding back the rest')
+    args = parser.parse_args()
+    server = Server(('::', args.port), Handler)
+    server.hold = args.hold
+    server.serve_forever()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+#
+# DNS server for the resolver benchmark.
+#
+# Answers AAAA queries for any name with fdee::99. Names that start
+# with "short" have a TTL of 8 s, the others 300 s. Names that start
+# with "nx" get NXDOMAIN and names that start with "nodata" get an
+# empty answer, both with an SOA record whose minimum is 60 s. Every
+# query is logged, so the number of queries can be counted.
+#
+# Usage: dns-server.py [-s | -f] [-d ms] [-n queries] address
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+def parse_name(packet, offset):
+    labels = []
+    while packet[offset]:
+        length = packet[offset]
+        labels.append(packet[offset + 1:offset + 1 + length].decode())
+        offset += 1 + length
+    return '.'.join(labels), offset + 1
+
+def soa():
+    rdata = b'\x02ns\x00\x04host\x00' + struct.pack('!IIIII', 1, 2, 3, 4, 60)
+    return b'\xc0\x0c' + struct.pack('!HHIH', 6, 1, 3600, len(rdata)) + rdata
+
+def answer(query, args):
+    qid = struct.unpack('!H', query[:2])[0]
+    name, offset = parse_name(query, 12)
+    question = query[12:offset + 4]
+    rcode, answers, authority = 0, [], []
+    if args.servfail:
+        rcode = 2
+    elif name.startswith('nx'):
+        rcode = 3
+        authority.append(soa())
+    elif name.startswith('nodata'):
+        authority.append(soa())
+    else:
+        ttl = 8 if name.startswith('short') else 300
+        answers.append(b'\xc0\x0c' + struct.pack('!HHIH', 28, 1, ttl, 16) +
+                       socket.inet_pton(socket.AF_INET6, 'fdee::99'))
+    header = struct.pack('!HHHHHH', qid, 0x8180 | rcode, 1,
+                         len(answers), len(authority), 0)
+    return header + question + b''.join(answers) + b''.join(authority)
+
+def reply(sock, query, source, args):
+    time.sleep(args.delay / 1000)
+    sock.sendto(answer(query, args), source)
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-s', '--silent', action='store_true',
+                        help='never answer')
+    parser.add_argument('-f', '--servfail', action='store_true',
+                        help='answer every query with SERVFAIL')
+    parser.add_argument('-d', '--delay', type=int, default=0,
+                        help='answer after this many ms')
+    parser.add_argument('-n', '--queries', type=int, default=0,
+                        help='stop answering after this many queries')
+    parser.add_argument('address')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    # The node adds the address when it starts
+    for i in range(50):
+        try:
+            sock.bind((args.address, 53))
+            break
+        except OSError:
+            time.sleep(0.1)
+    else:
+        sys.exit('cannot bind to %s' % args.address)
+
+    count = 0
+    while True:
+        query, source = sock.recvfrom(2048)
+        count += 1
+        print('%.3f query %d %s' % (time.monotonic(), count,
+                                    parse_name(query, 12)[0]), flush=True)
+        if args.silent or (args.queries and count > args.queries):
+            continue
+        threading.Thread(target=reply,
+                         args=(sock, query, source, args)).start()
+
+main()
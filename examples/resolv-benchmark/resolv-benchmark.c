@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Lookup times of the DNS resolver on a native node over an
+ *         emulated link, against dns-server.py on the host.
+ *
+ *         The node talks to the host through a tun device, see
+ *         tcp-benchmark/tun-link.c, so it has to be run as root. It
+ *         uses fdee::1 as nameserver, and fdee::3 as well with ns2=1.
+ *
+ *         Arguments, besides those of tun-link.c:
+ *         test=parallel  resolve four names at once and print the time
+ *         test=one       resolve name=<name> and print the time and the
+ *                        status; with expire=1, also how long the answer
+ *                        stays cached
+ *         test=prefetch  look up short.test every 100 ms for 30 s, and
+ *                        count the lookups that found no address
+ *         ns2=1          use a second nameserver
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ip/resolv.h"
+#include "net/ip/uip-nameserver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SECOND_NAMESERVER "fdee::3/64"
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static const char *test = "parallel";
+static const char *name = "a.test";
+static int ns2;
+static int expire;
+
+static const char *parallel_names[] = {
+  "a.test", "b.test", "c.test", "d.test"
+};
+
+PROCESS(resolv_benchmark_process, "Resolver benchmark");
+AUTOSTART_PROCESSES(&resolv_benchmark_process);
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+status_name(resolv_status_t status)
+{
+  switch(status) {
+  case RESOLV_STATUS_CACHED:
+    return "cached";
+  case RESOLV_STATUS_UNCACHED:
+    return "uncached";
+  case RESOLV_STATUS_EXPIRED:
+    return "expired";
+  case RESOLV_STATUS_NOT_FOUND:
+    return "not found";
+  case RESOLV_STATUS_RESOLVING:
+    return "resolving";
+  default:
+    return "error";
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+parallel_cached(void)
+{
+  int i, n;
+
+  for(i = n = 0; i < sizeof(parallel_names) / sizeof(parallel_names[0]); i++) {
+    n += resolv_lookup(parallel_names[i], NULL) == RESOLV_STATUS_CACHED;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(resolv_benchmark_process, ev, data)
+{
+  static struct etimer et;
+  static double start, found;
+  static int i, cached, missed;
+  static resolv_status_t status;
+  uip_ipaddr_t addr;
+  char cmd[64];
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "test=", 5) == 0) {
+      test = contiki_argv[i] + 5;
+    } else if(strncmp(contiki_argv[i], "name=", 5) == 0) {
+      name = contiki_argv[i] + 5;
+    } else if(strncmp(contiki_argv[i], "ns2=", 4) == 0) {
+      ns2 = atoi(contiki_argv[i] + 4);
+    } else if(strncmp(contiki_argv[i], "expire=", 7) == 0) {
+      expire = atoi(contiki_argv[i] + 7);
+    }
+  }
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 1);
+  uip_nameserver_update(&addr, UIP_NAMESERVER_INFINITE_LIFETIME);
+  if(ns2) {
+    /* The second nameserver is another address of the host end */
+    snprintf(cmd, sizeof(cmd), "ip -6 addr add %s dev tun0 nodad",
+             SECOND_NAMESERVER);
+    if(system(cmd) != 0) {
+      fprintf(stderr, "could not add %s\n", SECOND_NAMESERVER);
+    }
+    uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 3);
+    uip_nameserver_update(&addr, UIP_NAMESERVER_INFINITE_LIFETIME);
+  }
+
+  /* Give the DNS servers time to start */
+  etimer_set(&et, CLOCK_SECOND * 3);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  start = now();
+  if(strcmp(test, "parallel") == 0) {
+    for(i = 0; i < sizeof(parallel_names) / sizeof(parallel_names[0]); i++) {
+      resolv_query(parallel_names[i]);
+    }
+    PROCESS_WAIT_UNTIL(ev == resolv_event_found && parallel_cached() == i);
+    printf("%d names resolved in %.1f ms\n", i, (now() - start) * 1000);
+
+  } else if(strcmp(test, "one") == 0) {
+    resolv_query(name);
+    PROCESS_WAIT_UNTIL(ev == resolv_event_found &&
+                       resolv_lookup(name, NULL) != RESOLV_STATUS_RESOLVING);
+    found = now();
+    status = resolv_lookup(name, NULL);
+    printf("%s: %s after %.1f ms\n", name, status_name(status),
+           (found - start) * 1000);
+
+    if(expire) {
+      /* How long the answer is kept, checked every 100 ms */
+      etimer_set(&et, CLOCK_SECOND / 10);
+      while(status == resolv_lookup(name, NULL) && now() - found < 600) {
+        PROCESS_WAIT_UNTIL(etimer_expired(&et));
+        etimer_reset(&et);
+      }
+      printf("%s: %s for %.1f s, then %s\n", name, status_name(status),
+             now() - found, status_name(resolv_lookup(name, NULL)));
+    }
+
+  } else if(strcmp(test, "prefetch") == 0) {
+    /* A user of the name that looks it up every 100 ms, and queries it
+       when it has no address for it */
+    etimer_set(&et, CLOCK_SECOND / 10);
+    for(i = 0; i < 300; i++) {
+      PROCESS_WAIT_UNTIL(etimer_expired(&et));
+      etimer_reset(&et);
+      status = resolv_lookup("short.test", NULL);
+      if(status == RESOLV_STATUS_CACHED) {
+        cached++;
+      } else {
+        missed++;
+        if(status != RESOLV_STATUS_RESOLVING) {
+          resolv_query("short.test");
+        }
+      }
+    }
+    printf("short.test: %d lookups cached, %d without an address\n",
+           cached, missed);
+
+  } else {
+    printf("Unknown test %s\n", test);
+  }
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
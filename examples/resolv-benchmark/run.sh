@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# Runs one resolver test: starts the node and a DNS server on each
+# nameserver address, waits for the node to finish, and prints its
+# results and the number of queries that each server got.
+#
+# Usage: sudo ./run.sh "<node arguments>" "<server 1 options>"
+#                      ["<server 2 options>"]
+#
+# A second server option string also passes ns2=1 to the node.
+
+NODE_ARGS=$1
+NS1_ARGS=$2
+NS2_ARGS=$3
+
+if [ $# -ge 3 ]; then
+  NODE_ARGS="$NODE_ARGS ns2=1"
+fi
+
+./resolv-benchmark.native $NODE_ARGS > node.log 2>&1 &
+NODE=$!
+./dns-server.py $NS1_ARGS fdee::1 > ns1.log 2>&1 &
+NS1=$!
+if [ $# -ge 3 ]; then
+  ./dns-server.py $NS2_ARGS fdee::3 > ns2.log 2>&1 &
+  NS2=$!
+fi
+
+wait $NODE
+kill $NS1 $NS2 2>/dev/null
+
+grep -v "^Contiki\|^Rime\|^MAC\|^ip \|^Tentative" node.log
+echo "queries: nameserver 1 $(grep -c query ns1.log)" \
+  "${NS2:+nameserver 2 $(grep -c query ns2.log)}"
+rm -f node.log ns1.log ns2.log
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Time per request for finding the resource of a CoAP request in
+ *         the REST engine, on the native platform.
+ *
+ *         The program activates an IPSO-like object tree: objects
+ *         3300 and up, four instances each, and the resources 5700,
+ *         5701, 5601 and 5602 of each instance, until there are N
+ *         resources. A parent resource, "fw", with HAS_SUB_RESOURCES,
+ *         is activated last, as a gateway would after its object tree.
+ *
+ *         The requests are a GET for every resource, one for a path
+ *         below "fw", and one for a path that does not exist, in turn.
+ *         Each is parsed once, and rest_invoke_restful_service() is
+ *         timed on the parsed request, so that only the dispatch and
+ *         the handler call count. The handlers count their calls, and
+ *         the program checks that every request found its resource.
+ *
+ *         Arguments: resources=<n>, the number of resources in the
+ *         object tree (default 64, at most MAX_RESOURCES),
+ *         rounds=<n>, the number of passes over all requests timed
+ *         (default about a million requests)
+ */
+
+#include "contiki.h"
+#include "er-coap.h"
+#include "rest-engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+#define MAX_RESOURCES 1024
+
+/* Each pass is timed this many times, and the fastest time counts */
+#define TRIALS 5
+
+static const int resource_ids[] = { 5700, 5701, 5601, 5602 };
+#define INSTANCES 4
+
+static resource_t resources[MAX_RESOURCES];
+static char paths[MAX_RESOURCES][16];
+static int resource_count = 64;
+
+/* The resources, "fw/image/1" and "3300/9/5700" */
+#define REQUESTS (MAX_RESOURCES + 2)
+static coap_packet_t requests[REQUESTS];
+static int request_count;
+
+static unsigned long leaf_calls;
+static unsigned long parent_calls;
+/*---------------------------------------------------------------------------*/
+static void
+leaf_handler(void *request, void *response, uint8_t *buffer,
+             uint16_t preferred_size, int32_t *offset)
+{
+  leaf_calls++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+parent_handler(void *request, void *response, uint8_t *buffer,
+               uint16_t preferred_size, int32_t *offset)
+{
+  parent_calls++;
+}
+PARENT_RESOURCE(res_fw, "title=\"Firmware\"", parent_handler,
+                NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+add_request(const char *path)
+{
+  coap_packet_t *request = &requests[request_count++];
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, request_count);
+  coap_set_header_uri_path(request, path);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends every request once, returns the number found */
+static int
+dispatch_all(void)
+{
+  static coap_packet_t response[1];
+  static uint8_t buffer[REST_MAX_CHUNK_SIZE];
+  int32_t offset;
+  int found = 0;
+  int i;
+
+  for(i = 0; i < request_count; i++) {
+    offset = 0;
+    found += rest_invoke_restful_service(&requests[i], response, buffer,
+                                         sizeof(buffer), &offset);
+  }
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(rest_dispatch_benchmark_process, "REST dispatch benchmark");
+AUTOSTART_PROCESSES(&rest_dispatch_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rest_dispatch_benchmark_process, ev, data)
+{
+  long rounds = 0;
+  double start, elapsed, best = 0;
+  int trial;
+  int found;
+  long i;
+
+  PROCESS_BEGIN();
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "resources=", 10) == 0) {
+      resource_count = atoi(contiki_argv[i] + 10);
+    } else if(strncmp(contiki_argv[i], "rounds=", 7) == 0) {
+      rounds = atol(contiki_argv[i] + 7);
+    }
+  }
+  if(resource_count < 1 || resource_count > MAX_RESOURCES) {
+    resource_count = MAX_RESOURCES;
+  }
+
+  for(i = 0; i < resource_count; i++) {
+    snprintf(paths[i], sizeof(paths[i]), "%ld/%ld/%d",
+             3300 + i / (INSTANCES * 4), i / 4 % INSTANCES,
+             resource_ids[i % 4]);
+    resources[i].flags = NO_FLAGS;
+    resources[i].attributes = "";
+    resources[i].get_handler = leaf_handler;
+    rest_activate_resource(&resources[i], paths[i]);
+    add_request(paths[i]);
+  }
+  rest_activate_resource(&res_fw, "fw");
+  add_request("fw/image/1");
+  add_request("3300/9/5700");
+
+  found = dispatch_all();
+  if(found != resource_count + 1 || leaf_calls != resource_count ||
+     parent_calls != 1) {
+    printf("dispatch: FAILED, %d found, %lu leaf and %lu parent calls\n",
+           found, leaf_calls, parent_calls);
+    exit(1);
+  }
+  printf("%d resources, %d requests per pass\n", resource_count,
+         request_count);
+  if(rounds < 1) {
+    rounds = 1000000 / request_count + 1;
+  }
+
+  for(trial = 0; trial < TRIALS; trial++) {
+    start = now();
+    for(i = 0; i < rounds; i++) {
+      dispatch_all();
+    }
+    elapsed = (now() - start) * 1e9 / rounds / request_count;
+    if(trial == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  printf("%.1f ns per request\n", best);
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
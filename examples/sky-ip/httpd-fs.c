@@ -66,7 +66,8 @@ loop:
 }
 /*-----------------------------------------------------------------------------------*/
 int
-httpd_fs_open(const char *name, struct httpd_fs_file *file)
+httpd_fs_open_accept(const char *name, struct httpd_fs_file *file,
+                     uint8_t accept)
 {
 #if HTTPD_FS_STATISTICS
   uint16_t i = 0;
@@ -80,6 +81,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
     if(httpd_fs_strcmp(name, f->name) == 0) {
       file->data = f->data;
       file->len = f->len - 1;
+      file->encoding = 0;
 #if HTTPD_FS_STATISTICS
       ++count[i];
 #endif /* HTTPD_FS_STATISTICS */
@@ -93,6 +95,12 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
   return 0;
 }
 /*-----------------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  return httpd_fs_open_accept(name, file, 0);
+}
+/*-----------------------------------------------------------------------------------*/
 void
 httpd_fs_init(void)
 {
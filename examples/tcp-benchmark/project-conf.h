@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Full-sized IPv6 packets, one TCP segment each */
+#undef UIP_CONF_BUFFER_SIZE
+#define UIP_CONF_BUFFER_SIZE       1280
+#undef UIP_CONF_TCP_MSS
+#define UIP_CONF_TCP_MSS           1220
+
+/* Segments in flight, set with WINDOW in the Makefile */
+#define UIP_CONF_TCP_SEND_WINDOW   TCP_BENCHMARK_WINDOW
+
+/* Out-of-order segments kept, set with OOO in the Makefile. The
+   receive window is one MSS, or covers the out-of-order buffers,
+   unless it is set with RWND. */
+#define UIP_CONF_TCP_OOO_SEGMENTS  TCP_BENCHMARK_OOO
+#undef UIP_CONF_RECEIVE_WINDOW
+#ifdef TCP_BENCHMARK_RWND
+#define UIP_CONF_RECEIVE_WINDOW    TCP_BENCHMARK_RWND
+#endif
+
+/* All traffic goes through the tun interface, without a radio and
+   without RPL. */
+#undef UIP_CONF_IPV6_RPL
+#define UIP_CONF_IPV6_RPL          0
+#undef UIP_FALLBACK_INTERFACE
+#define UIP_FALLBACK_INTERFACE     tun_link
+
+#endif /* PROJECT_CONF_H_ */
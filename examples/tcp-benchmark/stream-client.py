@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+#
+# Throughput client for the TCP benchmark.
+#
+# Reads the stream that the node sends on port 5001 for a number of
+# seconds, checks that it is the repeated 1024-byte pattern, and
+# reports the rate. With -s, sends the pattern to port 5002 instead
+# and waits for the node to close; the node checks the stream and
+# prints its own rate.
+#
+# Usage: stream-client.py [-a addr] [-t seconds] [-s]
+
+import argparse
+import socket
+import time
+
+PATTERN = bytes(ord('a') + i % 26 for i in range(1024))
+
+def receive(args):
+    s = socket.create_connection((args.addr, 5001))
+    start = time.monotonic()
+    received = 0
+    intact = True
+    while time.monotonic() - start < args.time:
+        data = s.recv(65536)
+        if not data:
+            break
+        pos = 0
+        while pos < len(data):
+            offset = (received + pos) % len(PATTERN)
+            n = min(len(data) - pos, len(PATTERN) - offset)
+            if data[pos:pos + n] != PATTERN[offset:offset + n]:
+                intact = False
+            pos += n
+        received += len(data)
+    elapsed = time.monotonic() - start
+    s.close()
+
+    print('received %d bytes in %.1f s: %.0f kB/s, stream %s' %
+          (received, elapsed, received / elapsed / 1000,
+           'intact' if intact else 'CORRUPT'))
+
+def send(args):
+    s = socket.create_connection((args.addr, 5002))
+    data = PATTERN * 64
+    start = time.monotonic()
+    sent = 0
+    while time.monotonic() - start < args.time:
+        s.sendall(data)
+        sent += len(data)
+    # The node closes once it has read everything
+    s.shutdown(socket.SHUT_WR)
+    s.settimeout(60)
+    s.recv(1)
+    elapsed = time.monotonic() - start
+    s.close()
+
+    print('sent %d bytes in %.1f s: %.0f kB/s' %
+          (sent, elapsed, sent / elapsed / 1000))
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-a', '--addr', default='fdee::2')
+    parser.add_argument('-t', '--time', type=float, default=10)
+    parser.add_argument('-s', '--send', action='store_true')
+    args = parser.parse_args()
+
+    if args.send:
+        send(args)
+    else:
+        receive(args)
+
+main()
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         TCP throughput of a native node over an emulated link.
+ *
+ *         A client that connects to port 5001 gets an endless stream
+ *         of a repeated 1024-byte pattern, sent through tcp-socket, so
+ *         that stream-client.py can check it. A client that connects
+ *         to port 5002 sends the same stream to the node, which checks
+ *         it and prints the rate when the client closes.
+ *
+ *         The node talks to the host through a tun device, see
+ *         tun-link.c, so it has to be run as root.
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ip/tcp-socket.h"
+
+#include <stdio.h>
+
+#define SEND_PORT    5001
+#define RECEIVE_PORT 5002
+
+static struct tcp_socket send_socket;
+static uint8_t send_inputbuf[128];
+static uint8_t send_outputbuf[8192];
+
+static struct tcp_socket receive_socket;
+static uint8_t receive_inputbuf[2048];
+static uint8_t receive_outputbuf[64];
+
+static uint8_t pattern[1024];
+static int pattern_pos;
+
+static unsigned long received;
+static clock_time_t receive_start;
+static int intact;
+
+PROCESS(tcp_benchmark_process, "TCP benchmark");
+AUTOSTART_PROCESSES(&tcp_benchmark_process);
+/*---------------------------------------------------------------------------*/
+static void
+fill(struct tcp_socket *s)
+{
+  int len;
+
+  while((len = tcp_socket_send(s, &pattern[pattern_pos],
+                               sizeof(pattern) - pattern_pos)) > 0) {
+    pattern_pos = (pattern_pos + len) % sizeof(pattern);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_input(struct tcp_socket *s, void *ptr, const uint8_t *inputptr,
+           int inputdatalen)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t ev)
+{
+  if(ev == TCP_SOCKET_CONNECTED) {
+    printf("Sending\n");
+    pattern_pos = 0;
+    fill(s);
+  } else if(ev == TCP_SOCKET_DATA_SENT) {
+    fill(s);
+  } else if(ev == TCP_SOCKET_CLOSED || ev == TCP_SOCKET_ABORTED) {
+    printf("Send connection %s\n",
+           ev == TCP_SOCKET_CLOSED ? "closed" : "aborted");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+receive_input(struct tcp_socket *s, void *ptr, const uint8_t *inputptr,
+              int inputdatalen)
+{
+  int i;
+
+  for(i = 0; i < inputdatalen; i++) {
+    if(inputptr[i] != pattern[(received + i) % sizeof(pattern)]) {
+      intact = 0;
+    }
+  }
+  received += inputdatalen;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t ev)
+{
+  clock_time_t elapsed;
+
+  if(ev == TCP_SOCKET_CONNECTED) {
+    received = 0;
+    intact = 1;
+    receive_start = clock_time();
+  } else if(ev == TCP_SOCKET_CLOSED || ev == TCP_SOCKET_ABORTED) {
+    elapsed = clock_time() - receive_start;
+    printf("Received %lu bytes in %lu ms: %lu kB/s, stream %s\n",
+           received, (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+           elapsed > 0 ? received * CLOCK_SECOND / elapsed / 1000 : 0,
+           intact ? "intact" : "CORRUPT");
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tcp_benchmark_process, ev, data)
+{
+  uip_ipaddr_t addr;
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < sizeof(pattern); i++) {
+    pattern[i] = 'a' + i % 26;
+  }
+
+  uip_ip6addr(&addr, 0xfdee, 0, 0, 0, 0, 0, 0, 2);
+  uip_ds6_addr_add(&addr, 0, ADDR_MANUAL);
+
+  tcp_socket_register(&send_socket, NULL,
+                      send_inputbuf, sizeof(send_inputbuf),
+                      send_outputbuf, sizeof(send_outputbuf),
+                      send_input, send_event);
+  tcp_socket_listen(&send_socket, SEND_PORT);
+
+  tcp_socket_register(&receive_socket, NULL,
+                      receive_inputbuf, sizeof(receive_inputbuf),
+                      receive_outputbuf, sizeof(receive_outputbuf),
+                      receive_input, receive_event);
+  tcp_socket_listen(&receive_socket, RECEIVE_PORT);
+
+  printf("TCP benchmark on [fdee::2], send window %d segments, "
+         "receive window %d bytes, %d out-of-order segments, MSS %d\n",
+         UIP_TCP_SEND_WINDOW, UIP_RECEIVE_WINDOW, UIP_TCP_OOO_SEGMENTS,
+         UIP_TCP_MSS);
+
+  PROCESS_WAIT_UNTIL(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A uIP fallback interface that sends all packets through a
+ *         Linux tun device, with an emulated link in between: packets
+ *         from the node are delayed, and packets in both directions
+ *         can be dropped at random.
+ *
+ *         Arguments: delay=<ms>, the one-way delay of packets from the
+ *         node, loss=<n> and rloss=<n>, the number of packets in 1000
+ *         that are dropped on the way from and to the node. Only
+ *         packets longer than 100 bytes are dropped, so that the loss
+ *         hits data segments and not ACKs.
+ */
+
+#include "contiki-net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <err.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#ifdef TUN_CONF_DEV
+#define TUN_DEV TUN_CONF_DEV
+#else
+#define TUN_DEV "tun0"
+#endif
+
+/* The address of the host end, with the prefix that is routed to the
+   node */
+#ifdef TUN_CONF_HOST_ADDR
+#define TUN_HOST_ADDR TUN_CONF_HOST_ADDR
+#else
+#define TUN_HOST_ADDR "fdee::1/64"
+#endif
+
+/* Packets that can be on their way to the host at the same time */
+#define QUEUE_SIZE 256
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static int tunfd = -1;
+
+static struct {
+  double due;
+  uint16_t len;
+  uint8_t data[UIP_BUFSIZE];
+} queue[QUEUE_SIZE];
+static int head, tail;
+
+static double delay;
+static int loss, rloss;
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+/*---------------------------------------------------------------------------*/
+static int
+drop(int len, int permille)
+{
+  return permille > 0 && len > 100 && rand() % 1000 < permille;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  double t;
+
+  /* Send the packets that are due. The main loop waits at most 1 ms
+     in select(), which is the resolution of the delay. */
+  t = now();
+  while(head != tail && queue[head].due <= t) {
+    if(write(tunfd, queue[head].data, queue[head].len) != queue[head].len) {
+      perror("tun: write");
+    }
+    head = (head + 1) % QUEUE_SIZE;
+  }
+
+  FD_SET(tunfd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  int size;
+
+  if(FD_ISSET(tunfd, rset)) {
+    size = read(tunfd, &uip_buf[UIP_LLH_LEN], UIP_BUFSIZE - UIP_LLH_LEN);
+    if(size > 0 && !drop(size, rloss)) {
+      uip_len = size;
+      tcpip_input();
+    }
+  }
+}
+static const struct select_callback tun_select_callback = {
+  set_fd,
+  handle_fd
+};
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  struct ifreq ifr;
+  char cmd[128];
+  int i;
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "delay=", 6) == 0) {
+      delay = atoi(contiki_argv[i] + 6) / 1000.0;
+    } else if(strncmp(contiki_argv[i], "loss=", 5) == 0) {
+      loss = atoi(contiki_argv[i] + 5);
+    } else if(strncmp(contiki_argv[i], "rloss=", 6) == 0) {
+      rloss = atoi(contiki_argv[i] + 6);
+    }
+  }
+
+  tunfd = open("/dev/net/tun", O_RDWR);
+  if(tunfd < 0) {
+    err(1, "tun: open");
+  }
+
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  strncpy(ifr.ifr_name, TUN_DEV, IFNAMSIZ - 1);
+  if(ioctl(tunfd, TUNSETIFF, (void *)&ifr) < 0) {
+    err(1, "tun: TUNSETIFF");
+  }
+
+  snprintf(cmd, sizeof(cmd), "ip link set dev %s up mtu %d && "
+           "ip -6 addr add %s dev %s nodad",
+           TUN_DEV, UIP_LINK_MTU, TUN_HOST_ADDR, TUN_DEV);
+  printf("%s\n", cmd);
+  if(system(cmd) != 0) {
+    fprintf(stderr, "tun: could not configure %s\n", TUN_DEV);
+  }
+
+  select_set_callback(tunfd, &tun_select_callback);
+}
+/*---------------------------------------------------------------------------*/
+static int
+output(void)
+{
+  if(uip_len == 0 || drop(uip_len, loss)) {
+    return 0;
+  }
+  if((tail + 1) % QUEUE_SIZE == head) {
+    /* The link is full */
+    return 0;
+  }
+  queue[tail].due = now() + delay;
+  queue[tail].len = uip_len;
+  memcpy(queue[tail].data, &uip_buf[UIP_LLH_LEN], uip_len);
+  tail = (tail + 1) % QUEUE_SIZE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const struct uip_fallback_interface tun_link = {
+  init, output
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A radio for the native platform that lets a few native nodes
+ *         on one host hear each other, to run the Cooja test firmware
+ *         without Cooja. Node N (argument id=N, default 1) listens on
+ *         UDP port UDP_RADIO_PORT + N on the loopback interface and
+ *         sends each frame to the ports of all other nodes. It takes
+ *         the link-layer address Cooja gives mote N.
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "dev/radio.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef UDP_RADIO_CONF_PORT
+#define UDP_RADIO_PORT UDP_RADIO_CONF_PORT
+#else
+#define UDP_RADIO_PORT 38000
+#endif
+
+#ifdef UDP_RADIO_CONF_NODES
+#define UDP_RADIO_NODES UDP_RADIO_CONF_NODES
+#else
+#define UDP_RADIO_NODES 2
+#endif
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+static int fd = -1;
+static int id = 1;
+
+PROCESS(udp_radio_process, "UDP radio");
+/*---------------------------------------------------------------------------*/
+static void
+port_addr(struct sockaddr_in *sin, int node)
+{
+  memset(sin, 0, sizeof(*sin));
+  sin->sin_family = AF_INET;
+  sin->sin_port = htons(UDP_RADIO_PORT + node);
+  sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(fd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  int len;
+
+  if(!FD_ISSET(fd, rset)) {
+    return;
+  }
+  packetbuf_clear();
+  len = recv(fd, packetbuf_dataptr(), PACKETBUF_SIZE, 0);
+  if(len > 0) {
+    packetbuf_set_datalen(len);
+    NETSTACK_RDC.input();
+  }
+}
+static const struct select_callback udp_radio_fd = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+static int
+radio_init(void)
+{
+  struct sockaddr_in sin;
+  linkaddr_t addr;
+  int i;
+
+  for(i = 1; i < contiki_argc; i++) {
+    if(strncmp(contiki_argv[i], "id=", 3) == 0) {
+      id = atoi(contiki_argv[i] + 3);
+    }
+  }
+
+  /* Cooja mote N has link-layer address 00:0N:00:0N:00:0N:00:0N */
+  memset(&addr, 0, sizeof(addr));
+  for(i = 1; i < LINKADDR_SIZE; i += 2) {
+    addr.u8[i] = id;
+  }
+  linkaddr_set_node_addr(&addr);
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  port_addr(&sin, id);
+  if(fd < 0 || bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+    perror("udp-radio");
+    exit(1);
+  }
+  select_set_callback(fd, &udp_radio_fd);
+  process_start(&udp_radio_process, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short payload_len)
+{
+  struct sockaddr_in sin;
+  int node;
+
+  for(node = 1; node <= UDP_RADIO_NODES; node++) {
+    if(node != id) {
+      port_addr(&sin, node);
+      sendto(fd, payload, payload_len, 0, (struct sockaddr *)&sin,
+             sizeof(sin));
+    }
+  }
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_prepare(const void *payload, unsigned short payload_len)
+{
+  return 1;
+}
+static int
+radio_transmit(unsigned short transmit_len)
+{
+  return RADIO_TX_OK;
+}
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  return 0;
+}
+static int
+radio_channel_clear(void)
+{
+  return 1;
+}
+static int
+radio_receiving_packet(void)
+{
+  return 0;
+}
+static int
+radio_pending_packet(void)
+{
+  return 0;
+}
+static int
+radio_on(void)
+{
+  return 1;
+}
+static int
+radio_off(void)
+{
+  return 1;
+}
+static radio_result_t
+radio_get_value(radio_param_t param, radio_value_t *value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+static radio_result_t
+radio_set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+static radio_result_t
+radio_get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+static radio_result_t
+radio_set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver udp_radio_driver = {
+  radio_init, radio_prepare, radio_transmit, radio_send, radio_read,
+  radio_channel_clear, radio_receiving_packet, radio_pending_packet,
+  radio_on, radio_off, radio_get_value, radio_set_value, radio_get_object,
+  radio_set_object
+};
+/*---------------------------------------------------------------------------*/
+/* The native main() sets the IPv6 link-layer address, and the
+   link-local address from it, after the radio is initialized. Once
+   the system runs, take the address of the node instead. */
+PROCESS_THREAD(udp_radio_process, ev, data)
+{
+  uip_ipaddr_t ipaddr;
+
+  PROCESS_BEGIN();
+
+  PROCESS_PAUSE();
+
+  memcpy(&uip_lladdr, &linkaddr_node_addr, sizeof(uip_lladdr));
+  uip_ds6_addr_rm(uip_ds6_get_link_local(-1));
+  uip_create_linklocal_prefix(&ipaddr);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Sends a burst of UDP packets to a neighbor whose link-layer
+ *         address is not known yet, to check that the ND6 queue holds
+ *         all of them during address resolution.
+ */
+
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+
+#include <stdio.h>
+
+#define UDP_PORT 61618
+
+#ifndef BURST
+#define BURST 3
+#endif
+
+static struct simple_udp_connection unicast_connection;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(udp_process, "ND6 queue sender process");
+AUTOSTART_PROCESSES(&udp_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(udp_process, ev, data)
+{
+  static struct etimer periodic_timer;
+  static int i;
+  uip_ipaddr_t addr;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&unicast_connection, UDP_PORT,
+                      NULL, UDP_PORT,
+                      NULL);
+
+  etimer_set(&periodic_timer, 10 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+
+  /* Send a burst to the link-local address of node 1, which is not in
+     the neighbor cache yet. All of it must be queued during address
+     resolution and sent when the NA arrives. */
+  printf("Sending burst of %d\n", BURST);
+  uip_ip6addr(&addr, 0xfe80, 0, 0, 0, 0x0201, 0x0001, 0x0001, 0x0001);
+  for(i = 0; i < BURST; i++) {
+    simple_udp_sendto(&unicast_connection, "Burst", 5, &addr);
+  }
+
+  etimer_set(&periodic_timer, 5 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+#if UIP_STATISTICS
+  printf("ND6 queue: queued %u flushed %u dropped %u\n",
+         (unsigned)uip_stat.nd6.queued, (unsigned)uip_stat.nd6.flushed,
+         (unsigned)uip_stat.nd6.qdrop);
+#endif /* UIP_STATISTICS */
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -1,7 +1,20 @@
 #undef UIP_CONF_ND6_SEND_NA
 #define UIP_CONF_ND6_SEND_NA 1
 
+#if CONTIKI_TARGET_NATIVE
+/* Run the nodes without Cooja, see ../common/udp-radio.c */
+#undef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO udp_radio_driver
+#endif /* CONTIKI_TARGET_NATIVE */
+
 #ifdef BUFSIZE
 #undef UIP_CONF_BUFFER_SIZE
 #define UIP_CONF_BUFFER_SIZE BUFSIZE
 #endif /* BUFSIZE */
+
+#ifdef ND6_QUEUE
+#undef UIP_CONF_STATISTICS
+#define UIP_CONF_STATISTICS 1
+#define UIP_PACKETQUEUE_CONF_NUM ND6_QUEUE
+#define UIP_PACKETQUEUE_CONF_PER_HANDLE ND6_QUEUE
+#endif /* ND6_QUEUE */
@@ -0,0 +1,18 @@
+TIMEOUT(60000, log.log("last message: " + msg + "\n"));
+
+data = 0;
+while(true) {
+    YIELD();
+    if(msg.startsWith('Data')) {
+        data++;
+        log.log("Heard " + data + " data messages\n");
+    }
+    if(msg.startsWith('ND6 queue')) {
+        log.log(msg + "\n");
+        if(data == 3 && msg.contains('flushed 3 dropped 0')) {
+            log.testOK();
+        } else {
+            log.testFailed();
+        }
+    }
+}
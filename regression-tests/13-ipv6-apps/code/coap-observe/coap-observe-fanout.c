@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Registers three observers with pmax=1 on one resource. Each
+ *         rate-limited round must run the GET handler once and send
+ *         the notification to all three observers.
+ */
+
+#include "contiki.h"
+#include "er-coap-engine.h"
+#include "er-coap-observe.h"
+
+#include <stdio.h>
+
+#define OBSERVERS 3
+
+static int generated;
+
+static void get_handler(void *request, void *response, uint8_t *buffer,
+                        uint16_t preferred_size, int32_t *offset);
+
+RESOURCE(res_sensor, "title=\"Sensor\";obs", get_handler, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+get_handler(void *request, void *response, uint8_t *buffer,
+            uint16_t preferred_size, int32_t *offset)
+{
+  generated++;
+  REST.set_response_payload(response, "21.5", 4);
+}
+/*---------------------------------------------------------------------------*/
+/* Registers an observer as if the request came from port 5000 + i */
+static void
+observe(int i)
+{
+  static coap_packet_t request[1];
+  static coap_packet_t response[1];
+  uint8_t token = i;
+
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xaaaa, 0, 0, 0, 0, 0, 0, 2);
+  UIP_UDP_BUF->srcport = UIP_HTONS(5000 + i);
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, "sensor");
+  coap_set_header_uri_query(request, "pmax=1");
+  coap_set_header_observe(request, 0);
+  coap_set_token(request, &token, 1);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+  coap_observe_handler(&res_sensor, request, response);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_observe_fanout, "Observe fan-out");
+AUTOSTART_PROCESSES(&coap_observe_fanout);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_observe_fanout, ev, data)
+{
+  static struct etimer et;
+  coap_observer_t *obs;
+  int i, notified;
+
+  PROCESS_BEGIN();
+
+  coap_init_engine();
+  for(i = 0; i < OBSERVERS; i++) {
+    observe(i);
+  }
+
+  etimer_set(&et, CLOCK_SECOND * 3 + CLOCK_SECOND / 2);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  /* each observer counts the registration and its notifications */
+  notified = 0;
+  for(obs = list_head(coap_get_observers()); obs != NULL; obs = obs->next) {
+    notified += obs->obs_counter - 1;
+  }
+  printf("%d rounds, %d notifications\n", generated, notified);
+  if(generated >= 2 && notified == generated * OBSERVERS) {
+    printf("TEST OK\n");
+  } else {
+    printf("TEST FAILED\n");
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
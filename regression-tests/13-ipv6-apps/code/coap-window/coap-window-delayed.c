@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Fetches a block-wise resource with a Block2 window wider than
+ *         COAP_MAX_ATTEMPTS. The blocks past the end are refused before
+ *         the final block is answered, which must not fail the transfer.
+ *         Responses are handed to the open transactions directly, so no
+ *         server is needed.
+ */
+
+#include "contiki.h"
+#include "er-coap-engine.h"
+
+#include <stdio.h>
+
+#define BLOCKS 3
+
+static uip_ipaddr_t server_ipaddr;
+static uint8_t received;
+static uint8_t failed;
+static uint8_t send_final;
+/*---------------------------------------------------------------------------*/
+static void
+chunk_handler(void *response)
+{
+  uint32_t num = 0;
+
+  if(response == NULL) {
+    failed = 1;
+    return;
+  }
+  coap_get_header_block2(response, &num, NULL, NULL, NULL);
+  printf("Block %lu\n", (unsigned long)num);
+  received |= 1 << num;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Answers the open block requests: blocks past the end are refused, and
+ * the final block is answered only when send_final is set. Returns the
+ * number of requests answered.
+ */
+static int
+answer_requests(void)
+{
+  static coap_packet_t packet[1];
+  static uint8_t payload[REST_MAX_CHUNK_SIZE];
+  coap_transaction_t *t;
+  restful_response_handler callback;
+  void *callback_data;
+  uint32_t num;
+  uint16_t mid;
+  int answered = 0;
+
+  mid = 0;
+  do {
+    t = coap_get_transaction_by_mid(mid);
+    if(t != NULL) {
+      num = 0;
+      coap_parse_message(packet, t->packet, t->packet_len);
+      coap_get_header_block2(packet, &num, NULL, NULL, NULL);
+      if(num < BLOCKS - 1 || (num == BLOCKS - 1 && send_final)) {
+        coap_init_message(packet, COAP_TYPE_ACK, CONTENT_2_05, mid);
+        coap_set_header_block2(packet, num, num < BLOCKS - 1,
+                               sizeof(payload));
+        coap_set_payload(packet, payload, sizeof(payload));
+      } else if(num >= BLOCKS) {
+        coap_init_message(packet, COAP_TYPE_ACK, BAD_OPTION_4_02, mid);
+      } else {
+        continue;
+      }
+      callback = t->callback;
+      callback_data = t->callback_data;
+      coap_clear_transaction(t);
+      callback(callback_data, packet);
+      answered++;
+    }
+  } while(++mid != 0);
+  return answered;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_window_client, "Windowed Block2 client");
+PROCESS(coap_window_server, "Windowed Block2 responder");
+AUTOSTART_PROCESSES(&coap_window_client, &coap_window_server);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_window_server, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    etimer_set(&et, CLOCK_SECOND / 8);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    if(answer_requests() == 0) {
+      /* all other requests are answered, now send the final block */
+      send_final = 1;
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_window_client, ev, data)
+{
+  static coap_packet_t request[1];
+
+  PROCESS_BEGIN();
+
+  uip_ip6addr(&server_ipaddr, 0xaaaa, 0, 0, 0, 0, 0, 0, 1);
+  coap_init_engine();
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, "large");
+  COAP_WINDOWED_REQUEST(&server_ipaddr, UIP_HTONS(COAP_DEFAULT_PORT), request, chunk_handler);
+
+  if(!failed && received == (1 << BLOCKS) - 1) {
+    printf("TEST OK\n");
+  } else {
+    printf("TEST FAILED: received %02x%s\n", received,
+           failed ? ", failed" : "");
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026, Contiki contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Activates REST resources more than once and checks that requests
+ *         are still dispatched to the right resource.
+ */
+
+#include "contiki.h"
+#include "rest-engine.h"
+#include "er-coap.h"
+
+#include <stdio.h>
+
+static char served;
+/*---------------------------------------------------------------------------*/
+static void
+get_a(void *request, void *response, uint8_t *buffer,
+      uint16_t preferred_size, int32_t *offset)
+{
+  served = 'a';
+}
+static void
+get_b(void *request, void *response, uint8_t *buffer,
+      uint16_t preferred_size, int32_t *offset)
+{
+  served = 'b';
+}
+static void
+get_c(void *request, void *response, uint8_t *buffer,
+      uint16_t preferred_size, int32_t *offset)
+{
+  served = 'c';
+}
+RESOURCE(res_a, "", get_a, NULL, NULL, NULL);
+RESOURCE(res_b, "", get_b, NULL, NULL, NULL);
+RESOURCE(res_c, "", get_c, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static int
+dispatch(const char *path, char expected)
+{
+  static coap_packet_t request[1];
+  static coap_packet_t response[1];
+  static uint8_t buffer[REST_MAX_CHUNK_SIZE];
+  int32_t offset = 0;
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 1);
+  coap_set_header_uri_path(request, path);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 1);
+  served = 0;
+  rest_invoke_restful_service(request, response, buffer, sizeof(buffer),
+                              &offset);
+  if(served != expected) {
+    printf("%s: served by '%c', expected '%c'\n", path,
+           served ? served : '-', expected ? expected : '-');
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(rest_engine_activate_process, "REST engine activation test");
+AUTOSTART_PROCESSES(&rest_engine_activate_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rest_engine_activate_process, ev, data)
+{
+  static int resources;
+  int ok = 1;
+
+  PROCESS_BEGIN();
+
+  rest_init_engine();
+
+  rest_activate_resource(&res_a, "test/a");
+  rest_activate_resource(&res_b, "test/b");
+  rest_activate_resource(&res_c, "test/c");
+  resources = list_length(rest_get_resources());
+
+  /* first and last in the chain */
+  rest_activate_resource(&res_a, "test/a");
+  rest_activate_resource(&res_c, "test/c");
+  ok &= list_length(rest_get_resources()) == resources;
+  ok &= dispatch("test/a", 'a');
+  ok &= dispatch("test/b", 'b');
+  ok &= dispatch("test/c", 'c');
+  ok &= dispatch("test/d", 0);
+
+  /* move a resource to another path */
+  rest_activate_resource(&res_b, "test/d");
+  ok &= list_length(rest_get_resources()) == resources;
+  ok &= dispatch("test/a", 'a');
+  ok &= dispatch("test/b", 0);
+  ok &= dispatch("test/c", 'c');
+  ok &= dispatch("test/d", 'b');
+
+  printf(ok ? "TEST OK\n" : "TEST FAILED\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/